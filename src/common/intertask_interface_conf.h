@@ -29,6 +29,8 @@
 #ifndef FILE_INTERTASK_INTERFACE_CONF_SEEN
 #define FILE_INTERTASK_INTERFACE_CONF_SEEN
 
+#include <stdint.h>
+
 /*******************************************************************************
  * Intertask Interface Constants
  ******************************************************************************/
@@ -39,4 +41,44 @@
 #define ITTI_QUEUE_MAX_ELEMENTS  (64 * 1024)
 #define ITTI_DUMP_MAX_CON        (5)    /* Max connections in parallel */
 
+/* Max number of messages retrieved by a task per itti_receive_msg_batch() call */
+#define ITTI_RECEIVE_BATCH_SIZE  (32)
+
+/*******************************************************************************
+ * Intertask Interface runtime configuration (INTERTASK_INTERFACE section of
+ * mme.conf/spgw.conf)
+ ******************************************************************************/
+
+#define ITTI_CONFIG_MAX_TASK_QUEUES    (32)
+#define ITTI_CONFIG_MAX_MEMORY_POOLS   (8)
+#define ITTI_CONFIG_TASK_NAME_SIZE     (32)
+
+#define ITTI_CONFIG_TRACE_FILE_NAME_SIZE (256)
+
+/* Task queues are lfds710 bounded queues: the size must be a power of 2 */
+#define ITTI_CONFIG_QUEUE_SIZE_MIN     (2)
+#define ITTI_CONFIG_QUEUE_SIZE_MAX     (1024 * 1024)
+
+typedef struct itti_task_queue_config_s {
+  char          task_name[ITTI_CONFIG_TASK_NAME_SIZE]; ///< Task name as in tasks_def.h, ex: "TASK_MME_APP"
+  uint32_t      queue_size;                            ///< Number of messages per priority level
+} itti_task_queue_config_t;
+
+typedef struct itti_memory_pool_config_s {
+  uint32_t      item_size;                             ///< Size of the items of the pool in bytes
+  uint32_t      items;                                 ///< Number of items of the pool
+} itti_memory_pool_config_t;
+
+typedef struct itti_config_s {
+  /* Tasks not listed keep the queue size of tasks_def.h */
+  int                       nb_task_queues;
+  itti_task_queue_config_t  task_queues[ITTI_CONFIG_MAX_TASK_QUEUES];
+  /* Sorted by increasing item size, the built-in pools are used if none is configured */
+  int                       nb_memory_pools;
+  itti_memory_pool_config_t memory_pools[ITTI_CONFIG_MAX_MEMORY_POOLS];
+  /* Flight recorder of the last messages (intertask_interface_trace.h), disabled if no file name */
+  char                      trace_file_name[ITTI_CONFIG_TRACE_FILE_NAME_SIZE];
+  uint64_t                  trace_size;                ///< Size of the ring in bytes, a power of 2
+} itti_config_t;
+
 #endif /* FILE_INTERTASK_INTERFACE_CONF_SEEN */
@@ -24,10 +24,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <malloc.h>
@@ -38,6 +40,7 @@
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
+#include "intertask_interface_trace.h"
 
 #include "memory_pools.h"
 
@@ -79,14 +82,6 @@ typedef enum task_state_s {
   TASK_STATE_NOT_CONFIGURED, TASK_STATE_STARTING, TASK_STATE_READY, TASK_STATE_ENDED, TASK_STATE_MAX,
 } task_state_t;
 
-/* This list acts as a FIFO of messages received by tasks (RRC, NAS, ...) */
-typedef struct message_list_s {
-  MessageDef                             *msg;  ///< Pointer to the message
-
-  message_number_t                        message_number;       ///< Unique message number
-  uint32_t                                message_priority;     ///< Message priority
-} message_list_t;
-
 typedef struct thread_desc_s {
   /*
    * pthread associated with the thread
@@ -129,21 +124,80 @@ typedef struct thread_desc_s {
    * Flag to mark real time thread
    */
   unsigned                                real_time;
+  //#endif
 
   /*
-   * Counter to indicate from RTAI threads that messages are pending for the thread
+   * Set by the first sender enqueuing a message in an empty queue, cleared
+   * * * by the receiver when it finds its queue empty. Only the sender
+   * * * performing the 0 -> 1 transition writes to task_event_fd.
    */
-  unsigned                                messages_pending;
-  //#endif
+  volatile uint32_t                       receiver_awake;
+
+  /*
+   * Number of writes to task_event_fd performed/avoided by senders.
+   */
+  uint64_t                                wakeups_signalled;
+  uint64_t                                wakeups_avoided;
 } thread_desc_t;
 
+/*
+ * Messages of a task are queued in one FIFO per priority level, the receiver
+ * drains the levels from the highest to the lowest priority. Order is only
+ * kept within a level: messages that must not overtake each other (ex: the
+ * SCTP association lifecycle and its SCTP_DATA_IND) need the same level.
+ */
+typedef enum itti_queue_level_e {
+  ITTI_QUEUE_LEVEL_HIGH = 0,   ///< MESSAGE_PRIORITY_MAX_LEAST and above (TERMINATE_MESSAGE, ERROR_LOG, ...)
+  ITTI_QUEUE_LEVEL_MED_PLUS,   ///< Above MESSAGE_PRIORITY_MED (TIMER_HAS_EXPIRED, ...)
+  ITTI_QUEUE_LEVEL_LOW,        ///< MESSAGE_PRIORITY_MED and below (bulk of the signalling)
+  ITTI_QUEUE_LEVEL_MAX,
+} itti_queue_level_t;
+
 typedef struct task_desc_s {
   /*
-   * Queue of messages belonging to the task
+   * Queues of messages belonging to the task, one per priority level
    */
-  struct lfds710_queue_bmm_state         message_queue
+  struct lfds710_queue_bmm_state         message_queue[ITTI_QUEUE_LEVEL_MAX]
           __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
-  struct lfds710_queue_bmm_element      *qbmme;
+  struct lfds710_queue_bmm_element      *qbmme[ITTI_QUEUE_LEVEL_MAX];
+
+  /*
+   * Number of elements of each priority level queue, from tasks_def.h or from
+   * * * the INTERTASK_INTERFACE configuration.
+   */
+  uint32_t                                queue_size;
+
+  /*
+   * Number of messages queued for the task (all priority levels). Incremented
+   * * * before a message is enqueued so that it never underflows.
+   */
+  volatile uint32_t                       queue_depth;
+
+  /*
+   * Backpressure: callback invoked on the sender side when queue_depth reaches
+   * * * high_watermark and on the receiver side when it falls back to
+   * * * low_watermark. A high_watermark of 0 disables the watermarks.
+   */
+  uint32_t                                high_watermark;
+  uint32_t                                low_watermark;
+  volatile uint32_t                       overloaded;
+  itti_queue_watermark_cb_t               watermark_cb;
+
+  /*
+   * Number of messages that could not be enqueued because a queue was full
+   */
+  uint64_t                                queue_full_count;
+
+  /*
+   * Statistics: messages_in and max_queue_depth are updated by the senders,
+   * * * the other counters only by the thread of the task.
+   */
+  uint64_t                                messages_in;
+  uint64_t                                max_queue_depth;
+  uint64_t                                messages_out;
+  uint64_t                                latency_total_us;
+  uint64_t                                latency_max_us;
+  uint64_t                                latency_histogram[ITTI_LATENCY_HISTOGRAM_BUCKETS];
 } task_desc_t;
 
 typedef struct itti_desc_s {
@@ -165,8 +219,6 @@ typedef struct itti_desc_s {
   const task_info_t                      *tasks_info;
   const message_info_t                   *messages_info;
 
-  itti_lte_time_t                         lte_time;
-
   int                                     running;
 
   volatile uint32_t                       created_tasks;
@@ -174,6 +226,12 @@ typedef struct itti_desc_s {
   volatile int                            wait_tasks;
 
   memory_pools_handle_t                   memory_pools_handle;
+  itti_free_msg_content_t                 free_msg_content;
+
+  /*
+   * Handler time per message id, indexed by MessagesIds
+   */
+  itti_message_statistics_t              *messages_statistics;
 
   uint64_t                                vcd_poll_msg;
   uint64_t                                vcd_receive_msg;
@@ -182,6 +240,67 @@ typedef struct itti_desc_s {
 
 static itti_desc_t                      itti_desc;
 
+/*
+ * Messages returned by the last receive call of the current thread: the
+ * handler time of a message is measured when its receiver frees it.
+ */
+typedef struct itti_handled_messages_s {
+  int                                     nb_messages;
+  MessageDef                             *messages[ITTI_RECEIVE_BATCH_SIZE];
+  MessagesIds                             message_ids[ITTI_RECEIVE_BATCH_SIZE];
+  uint64_t                                handler_start_us;
+} itti_handled_messages_t;
+
+static __thread itti_handled_messages_t itti_handled_messages;
+
+static inline                           uint64_t
+itti_get_time_us (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static inline void
+itti_update_max (
+  uint64_t * max,
+  uint64_t value)
+{
+  uint64_t                                current_max = *max;
+
+  while ((value > current_max) && (!__sync_bool_compare_and_swap (max, current_max, value))) {
+    current_max = *max;
+  }
+}
+
+static void
+itti_account_handled_message (
+  void *ptr)
+{
+  int                                     i;
+
+  for (i = 0; i < itti_handled_messages.nb_messages; i++) {
+    if (itti_handled_messages.messages[i] == ptr) {
+      itti_message_statistics_t              *statistics = &itti_desc.messages_statistics[itti_handled_messages.message_ids[i]];
+      uint64_t                                now_us = itti_get_time_us ();
+      uint64_t                                handler_time_us = now_us - itti_handled_messages.handler_start_us;
+
+      /*
+       * Messages of a batch are handled one after the other: the next one
+       * * * starts being handled now.
+       */
+      itti_handled_messages.handler_start_us = now_us;
+      itti_handled_messages.messages[i] = NULL;
+      __sync_fetch_and_add (&statistics->handled, 1);
+      __sync_fetch_and_add (&statistics->handler_time_total_us, handler_time_us);
+      itti_update_max (&statistics->handler_time_max_us, handler_time_us);
+      return;
+    }
+  }
+}
+
 void                                   *
 itti_malloc (
   task_id_t origin_task_id,
@@ -220,6 +339,11 @@ itti_free (
   int                                     result = EXIT_SUCCESS;
 
   AssertFatal (ptr != NULL, "Trying to free a NULL pointer (%d)!\n", task_id);
+
+  if (itti_handled_messages.nb_messages > 0) {
+    itti_account_handled_message (ptr);
+  }
+
   result = memory_pools_free (itti_desc.memory_pools_handle, ptr, task_id);
   AssertError (result == EXIT_SUCCESS, {
                }, "Failed to free memory at %p (%d)!\n", ptr, task_id);
@@ -252,8 +376,28 @@ void
 itti_print_DEBUG ()
 {
  char                                   *statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
+ task_id_t                               task_id;
+ uint64_t                                wakeups_signalled = 0;
+ uint64_t                                wakeups_avoided = 0;
+
  OAILOG_INFO(LOG_ITTI, "Periodic memory pools statistics:\n%s", statistics);
  free_wrapper ((void**)&statistics);
+
+ for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+   if (TASK_GET_PARENT_TASK_ID (task_id) == TASK_UNKNOWN) {
+     itti_get_wakeup_statistics (task_id, &wakeups_signalled, &wakeups_avoided);
+     OAILOG_INFO(LOG_ITTI, "Task %s event fd wakeups signalled %"PRIu64" avoided %"PRIu64", queue depth %u%s, queue full %"PRIu64"\n",
+         itti_get_task_name (task_id), wakeups_signalled, wakeups_avoided,
+         itti_get_queue_depth (task_id), itti_is_task_overloaded (task_id) ? " (overloaded)" : "", itti_get_queue_full_count (task_id));
+   }
+ }
+}
+
+uint32_t
+itti_get_allocated_items (
+  void)
+{
+  return memory_pools_allocated_items (itti_desc.memory_pools_handle);
 }
 
 static inline                           message_number_t
@@ -276,6 +420,18 @@ itti_get_message_priority (
   return (itti_desc.messages_info[message_id].priority);
 }
 
+static inline                           itti_queue_level_t
+itti_get_queue_level (
+  uint32_t priority)
+{
+  if (priority >= MESSAGE_PRIORITY_MAX_LEAST) {
+    return ITTI_QUEUE_LEVEL_HIGH;
+  } else if (priority > MESSAGE_PRIORITY_MED) {
+    return ITTI_QUEUE_LEVEL_MED_PLUS;
+  }
+  return ITTI_QUEUE_LEVEL_LOW;
+}
+
 const char                             *
 itti_get_message_name (
   MessagesIds message_id)
@@ -317,15 +473,6 @@ itti_get_current_task_id (
 }
 
 
-void
-itti_update_lte_time (
-    __time_t    seconds,
-  __suseconds_t useconds)
-{
-  itti_desc.lte_time.time.tv_sec = seconds;
-  itti_desc.lte_time.time.tv_usec = useconds;
-}
-
 int
 itti_send_broadcast_message (
   MessageDef * message_p)
@@ -403,6 +550,42 @@ itti_alloc_new_message_sized (
   return temp;
 }
 
+MessageDef                             *
+itti_alloc_new_message_with_buffer (
+  task_id_t origin_task_id,
+  MessagesIds message_id,
+  MessageHeaderSize buffer_size,
+  void **buffer)
+{
+  MessageDef                             *temp = NULL;
+  MessageHeaderSize                       size = 0;
+  uint32_t                                buffer_offset = 0;
+
+  AssertFatal (message_id < itti_desc.messages_id_max, "Message id (%d) is out of range (%d)!\n", message_id, itti_desc.messages_id_max);
+  size = itti_desc.messages_info[message_id].size;
+  buffer_offset = ITTI_MSG_BUFFER_OFFSET (size);
+  AssertFatal ((buffer_offset - sizeof (MessageHeader) + buffer_size) <= (MessageHeaderSize) ~0, "Buffer of %u bytes too big for message %d!\n", buffer_size, message_id);
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_ALLOC_MSG, size);
+
+  if (origin_task_id == TASK_UNKNOWN) {
+    origin_task_id = itti_get_current_task_id ();
+  }
+
+  temp = itti_malloc (origin_task_id, TASK_UNKNOWN, buffer_offset + buffer_size);
+
+  /*
+   * Only the message is cleared, the buffer is written by the caller
+   */
+  memset (&temp->ittiMsg, 0, buffer_offset - sizeof (MessageHeader));
+
+  temp->ittiMsgHeader.messageId = message_id;
+  temp->ittiMsgHeader.originTaskId = origin_task_id;
+  temp->ittiMsgHeader.ittiMsgSize = buffer_offset - sizeof (MessageHeader) + buffer_size;
+  *buffer = (uint8_t *) temp + buffer_offset;
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_ALLOC_MSG, 0);
+  return temp;
+}
+
 MessageDef                             *
 itti_alloc_new_message (
   task_id_t origin_task_id,
@@ -411,18 +594,67 @@ itti_alloc_new_message (
   return itti_alloc_new_message_sized (origin_task_id, message_id, itti_desc.messages_info[message_id].size);
 }
 
-int
-itti_send_msg_to_task (
+static inline int
+itti_enqueue_message (
+  task_id_t task_id,
+  MessageDef * message,
+  uint32_t priority)
+{
+  uint32_t                                queue_depth;
+
+  queue_depth = __sync_add_and_fetch (&itti_desc.tasks[task_id].queue_depth, 1);
+
+  if (lfds710_queue_bmm_enqueue (&itti_desc.tasks[task_id].message_queue[itti_get_queue_level (priority)], NULL, message) == 0) {
+    /*
+     * The queue of this priority level is full
+     */
+    __sync_fetch_and_sub (&itti_desc.tasks[task_id].queue_depth, 1);
+    __sync_fetch_and_add (&itti_desc.tasks[task_id].queue_full_count, 1);
+    return 0;
+  }
+
+  __sync_fetch_and_add (&itti_desc.tasks[task_id].messages_in, 1);
+  itti_update_max (&itti_desc.tasks[task_id].max_queue_depth, queue_depth);
+
+  if ((itti_desc.tasks[task_id].high_watermark) && (queue_depth >= itti_desc.tasks[task_id].high_watermark)) {
+    /*
+     * Only the sender performing the transition notifies the overload
+     */
+    if (__sync_bool_compare_and_swap (&itti_desc.tasks[task_id].overloaded, 0, 1)) {
+      itti_desc.tasks[task_id].watermark_cb (task_id, true, queue_depth);
+    }
+  }
+
+  return 1;
+}
+
+static void
+itti_free_dropped_message (
+  task_id_t origin_task_id,
+  MessageDef * const message)
+{
+  /*
+   * The message owns its content (bstrings, UDP buffers, ...), free it as the destination task would
+   */
+  if (itti_desc.free_msg_content) {
+    itti_desc.free_msg_content (message);
+  }
+  itti_free (origin_task_id, message);
+}
+
+static int
+itti_send_msg_to_task_internal (
   task_id_t destination_task_id,
   instance_t instance,
-  MessageDef * message)
+  MessageDef * message,
+  bool drop_if_full)
 {
   thread_id_t                             destination_thread_id;
   task_id_t                               origin_task_id;
-  message_list_t                         *new;
   uint32_t                                priority;
   message_number_t                        message_number;
   uint32_t                                message_id;
+  uint64_t                                now_us;
 
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_or_and_fetch (&itti_desc.vcd_send_msg, 1L << destination_task_id));
   AssertFatal (message != NULL, "Message is NULL!\n");
@@ -430,8 +662,12 @@ itti_send_msg_to_task (
   destination_thread_id = TASK_GET_THREAD_ID (destination_task_id);
   message->ittiMsgHeader.destinationTaskId = destination_task_id;
   message->ittiMsgHeader.instance = instance;
-  message->ittiMsgHeader.lte_time.time.tv_sec = itti_desc.lte_time.time.tv_sec;
-  message->ittiMsgHeader.lte_time.time.tv_usec = itti_desc.lte_time.time.tv_usec;
+  /*
+   * Enqueue time, for the latency statistics of the destination task
+   */
+  now_us = itti_get_time_us ();
+  message->ittiMsgHeader.lte_time.time.tv_sec = now_us / 1000000;
+  message->ittiMsgHeader.lte_time.time.tv_usec = now_us % 1000000;
   message_id = message->ittiMsgHeader.messageId;
   AssertFatal (message_id < itti_desc.messages_id_max, "Message id (%d) is out of range (%d)!\n", message_id, itti_desc.messages_id_max);
   origin_task_id = ITTI_MSG_ORIGIN_ID (message);
@@ -440,6 +676,7 @@ itti_send_msg_to_task (
    * Increment the global message number
    */
   message_number = itti_increment_message_number ();
+  ITTI_TRACE_MESSAGE (message, message_number);
 
   if (destination_task_id != TASK_UNKNOWN) {
     VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_IN);
@@ -448,7 +685,7 @@ itti_send_msg_to_task (
     if (itti_desc.threads[destination_thread_id].task_state == TASK_STATE_ENDED) {
       ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d can not be sent from %s to queue (%u:%s), ended destination task!\n",
                   itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
-      itti_free (origin_task_id, message); // In case of issues free the memory allocated for message
+      itti_free_dropped_message (origin_task_id, message); // In case of issues free the memory allocated for message
     } else {
       /*
        * We cannot send a message if the task is not running
@@ -457,33 +694,55 @@ itti_send_msg_to_task (
                    "Task %s Cannot send message %s (%d) to thread %d, it is not in ready state (%d)!\n",
                    itti_get_task_name (origin_task_id), itti_desc.messages_info[message_id].name, message_id, destination_thread_id, itti_desc.threads[destination_thread_id].task_state);
       /*
-       * Allocate new list element
-       */
-      new = (message_list_t *) itti_malloc (origin_task_id, destination_task_id, sizeof (struct message_list_s));
-      /*
-       * Fill in members
+       * Fill in queue members, the message itself is the queue element:
+       * * * no extra allocation is needed to enqueue it.
        */
-      new->msg = message;
-      new->message_number = message_number;
-      new->message_priority = priority;
+      message->ittiMsgHeader.messageNumber = message_number;
+      message->ittiMsgHeader.messagePriority = priority;
       /*
        * Enqueue message in destination task queue
        */
-      lfds710_queue_bmm_enqueue (&itti_desc.tasks[destination_task_id].message_queue, NULL, new);
+      if (itti_enqueue_message (destination_task_id, message, priority) == 0) {
+        VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
+        VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_and_and_fetch (&itti_desc.vcd_send_msg, ~(1L << destination_task_id)));
+
+        if (!drop_if_full) {
+          /*
+           * The caller keeps the ownership of the message
+           */
+          ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d not sent from %s to queue (%u:%s), queue full!\n",
+                      itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
+          return ITTI_QUEUE_FULL;
+        }
+
+        OAILOG_ERROR (LOG_ITTI, " Message %s, number %lu with priority %d dropped from %s to queue (%u:%s), queue full!\n",
+                      itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
+        itti_free_dropped_message (origin_task_id, message);
+        return -1;
+      }
       VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
       {
         /*
          * Only use event fd for tasks, subtasks will pool the queue
          */
         if (TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN) {
-          ssize_t                                 write_ret;
-          eventfd_t                               sem_counter = 1;
-
           /*
-           * Call to write for an event fd must be of 8 bytes
+           * Signal the receiver only if it may be sleeping, i.e. on the
+           * * * transition of its queue from empty to non-empty.
            */
-          write_ret = write (itti_desc.threads[destination_thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
-          AssertFatal (write_ret == sizeof (sem_counter), "Write to task message FD (%d) failed (%d/%d)\n", destination_thread_id, (int)write_ret, (int)sizeof (sem_counter));
+          if (__sync_bool_compare_and_swap (&itti_desc.threads[destination_thread_id].receiver_awake, 0, 1)) {
+            ssize_t                                 write_ret;
+            eventfd_t                               sem_counter = 1;
+
+            /*
+             * Call to write for an event fd must be of 8 bytes
+             */
+            write_ret = write (itti_desc.threads[destination_thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
+            AssertFatal (write_ret == sizeof (sem_counter), "Write to task message FD (%d) failed (%d/%d)\n", destination_thread_id, (int)write_ret, (int)sizeof (sem_counter));
+            __sync_fetch_and_add (&itti_desc.threads[destination_thread_id].wakeups_signalled, 1);
+          } else {
+            __sync_fetch_and_add (&itti_desc.threads[destination_thread_id].wakeups_avoided, 1);
+          }
         }
       }
 
@@ -503,6 +762,183 @@ itti_send_msg_to_task (
   return 0;
 }
 
+int
+itti_send_msg_to_task (
+  task_id_t destination_task_id,
+  instance_t instance,
+  MessageDef * message)
+{
+  return itti_send_msg_to_task_internal (destination_task_id, instance, message, true);
+}
+
+int
+itti_try_send_msg_to_task (
+  task_id_t destination_task_id,
+  instance_t instance,
+  MessageDef * message)
+{
+  return itti_send_msg_to_task_internal (destination_task_id, instance, message, false);
+}
+
+void
+itti_set_queue_watermarks (
+  task_id_t task_id,
+  uint32_t high_watermark,
+  uint32_t low_watermark,
+  itti_queue_watermark_cb_t callback)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  AssertFatal ((high_watermark == 0) || (callback != NULL), "No watermark callback for task %s!\n", itti_get_task_name (task_id));
+  AssertFatal (low_watermark < high_watermark || high_watermark == 0, "Low watermark (%u) must be below high watermark (%u) for task %s!\n",
+               low_watermark, high_watermark, itti_get_task_name (task_id));
+  /*
+   * Disable the watermarks while they are updated
+   */
+  itti_desc.tasks[task_id].high_watermark = 0;
+  __sync_synchronize ();
+  itti_desc.tasks[task_id].watermark_cb = callback;
+  itti_desc.tasks[task_id].low_watermark = low_watermark;
+  __sync_synchronize ();
+  itti_desc.tasks[task_id].high_watermark = high_watermark;
+}
+
+uint32_t
+itti_get_queue_size (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return itti_desc.tasks[task_id].queue_size;
+}
+
+uint32_t
+itti_get_queue_depth (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return __sync_fetch_and_add (&itti_desc.tasks[task_id].queue_depth, 0);
+}
+
+bool
+itti_is_task_overloaded (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return (__sync_fetch_and_add (&itti_desc.tasks[task_id].overloaded, 0) != 0);
+}
+
+uint64_t
+itti_get_queue_full_count (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  return __sync_fetch_and_add (&itti_desc.tasks[task_id].queue_full_count, 0);
+}
+
+void
+itti_get_wakeup_statistics (
+  task_id_t task_id,
+  uint64_t * wakeups_signalled,
+  uint64_t * wakeups_avoided)
+{
+  thread_id_t                             thread_id;
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  thread_id = TASK_GET_THREAD_ID (task_id);
+  *wakeups_signalled = __sync_fetch_and_add (&itti_desc.threads[thread_id].wakeups_signalled, 0);
+  *wakeups_avoided = __sync_fetch_and_add (&itti_desc.threads[thread_id].wakeups_avoided, 0);
+}
+
+void
+itti_get_task_statistics (
+  task_id_t task_id,
+  itti_task_statistics_t * statistics)
+{
+  task_desc_t                            *task;
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  AssertFatal (statistics != NULL, "Statistics is NULL!\n");
+  task = &itti_desc.tasks[task_id];
+  statistics->messages_in = __sync_fetch_and_add (&task->messages_in, 0);
+  statistics->messages_out = __sync_fetch_and_add (&task->messages_out, 0);
+  statistics->queue_depth = itti_get_queue_depth (task_id);
+  statistics->max_queue_depth = (uint32_t) __sync_fetch_and_add (&task->max_queue_depth, 0);
+  statistics->queue_full_count = itti_get_queue_full_count (task_id);
+  statistics->latency_total_us = task->latency_total_us;
+  statistics->latency_max_us = task->latency_max_us;
+  memcpy (statistics->latency_histogram, task->latency_histogram, sizeof (statistics->latency_histogram));
+}
+
+void
+itti_get_message_statistics (
+  MessagesIds message_id,
+  itti_message_statistics_t * statistics)
+{
+  AssertFatal (message_id < itti_desc.messages_id_max, "Message id (%d) is out of range (%d)!\n", message_id, itti_desc.messages_id_max);
+  AssertFatal (statistics != NULL, "Statistics is NULL!\n");
+  statistics->handled = __sync_fetch_and_add (&itti_desc.messages_statistics[message_id].handled, 0);
+  statistics->handler_time_total_us = __sync_fetch_and_add (&itti_desc.messages_statistics[message_id].handler_time_total_us, 0);
+  statistics->handler_time_max_us = __sync_fetch_and_add (&itti_desc.messages_statistics[message_id].handler_time_max_us, 0);
+}
+
+void
+itti_print_statistics (
+  void)
+{
+  itti_task_statistics_t                  task_statistics;
+  itti_message_statistics_t               message_statistics;
+  task_id_t                               task_id;
+  MessagesIds                             message_id;
+  char                                    histogram[ITTI_LATENCY_HISTOGRAM_BUCKETS * 40];
+  char                                   *statistics = NULL;
+  int                                     offset = 0;
+  int                                     i;
+
+  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    itti_get_task_statistics (task_id, &task_statistics);
+
+    if (task_statistics.messages_in == 0) {
+      continue;
+    }
+
+    OAILOG_INFO (LOG_ITTI, "Task %s messages in %"PRIu64" out %"PRIu64", queue depth %u max %u, queue full %"PRIu64", latency avg %"PRIu64" us max %"PRIu64" us\n",
+                 itti_get_task_name (task_id), task_statistics.messages_in, task_statistics.messages_out,
+                 task_statistics.queue_depth, task_statistics.max_queue_depth, task_statistics.queue_full_count,
+                 (task_statistics.messages_out) ? task_statistics.latency_total_us / task_statistics.messages_out : 0, task_statistics.latency_max_us);
+    offset = 0;
+    histogram[0] = '\0';
+
+    for (i = 0; i < ITTI_LATENCY_HISTOGRAM_BUCKETS; i++) {
+      if (task_statistics.latency_histogram[i] == 0) {
+        continue;
+      }
+
+      if (i < ITTI_LATENCY_HISTOGRAM_BUCKETS - 1) {
+        offset += snprintf (&histogram[offset], sizeof (histogram) - offset, " <%uus:%"PRIu64, 1U << i, task_statistics.latency_histogram[i]);
+      } else {
+        offset += snprintf (&histogram[offset], sizeof (histogram) - offset, " >=%uus:%"PRIu64, 1U << (i - 1), task_statistics.latency_histogram[i]);
+      }
+    }
+
+    OAILOG_INFO (LOG_ITTI, "Task %s latency histogram%s\n", itti_get_task_name (task_id), histogram);
+  }
+
+  for (message_id = 0; message_id < itti_desc.messages_id_max; message_id++) {
+    itti_get_message_statistics (message_id, &message_statistics);
+
+    if (message_statistics.handled == 0) {
+      continue;
+    }
+
+    OAILOG_INFO (LOG_ITTI, "Message %s handled %"PRIu64", handler time avg %"PRIu64" us max %"PRIu64" us\n",
+                 itti_get_message_name (message_id), message_statistics.handled,
+                 message_statistics.handler_time_total_us / message_statistics.handled, message_statistics.handler_time_max_us);
+  }
+
+  statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
+  OAILOG_DEBUG (LOG_ITTI, "Memory pools statistics:\n%s", statistics);
+  free_wrapper ((void**)&statistics);
+}
+
 void
 itti_subscribe_event_fd (
   task_id_t task_id,
@@ -573,86 +1009,211 @@ itti_get_events (
   return itti_desc.threads[thread_id].epoll_nb_events;
 }
 
+static inline int
+itti_dequeue_message (
+  task_id_t task_id,
+  MessageDef ** message)
+{
+  itti_queue_level_t                      level;
+
+  /*
+   * Highest priority first: each message is taken from the first non empty
+   * * * queue so that a high priority message never waits behind lower ones.
+   */
+  for (level = ITTI_QUEUE_LEVEL_HIGH; level < ITTI_QUEUE_LEVEL_MAX; level++) {
+    if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue[level], NULL, (void **)message) == 1) {
+      uint32_t                                queue_depth = __sync_sub_and_fetch (&itti_desc.tasks[task_id].queue_depth, 1);
+
+      if ((itti_desc.tasks[task_id].overloaded) && (queue_depth <= itti_desc.tasks[task_id].low_watermark)) {
+        if (__sync_bool_compare_and_swap (&itti_desc.tasks[task_id].overloaded, 1, 0)) {
+          itti_desc.tasks[task_id].watermark_cb (task_id, false, queue_depth);
+        }
+      }
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static inline int
+itti_dequeue_messages (
+  task_id_t task_id,
+  MessageDef ** received_msgs,
+  int max_msgs)
+{
+  int                                     nb_msgs = 0;
+
+  while (nb_msgs < max_msgs) {
+    MessageDef                             *message = NULL;
+
+    if (itti_dequeue_message (task_id, &message) == 0) {
+      /*
+       * All queues are empty
+       */
+      break;
+    }
+
+    AssertFatal (message != NULL, "Message from message queue is NULL!\n");
+    received_msgs[nb_msgs++] = message;
+  }
+
+  return nb_msgs;
+}
+
 static inline void
+itti_account_received_messages (
+  task_id_t task_id,
+  MessageDef ** received_msgs,
+  int nb_msgs,
+  bool track_handling)
+{
+  task_desc_t                            *task = &itti_desc.tasks[task_id];
+  uint64_t                                now_us;
+  int                                     i;
+
+  if (track_handling) {
+    itti_handled_messages.nb_messages = 0;
+  }
+
+  if (nb_msgs == 0) {
+    return;
+  }
+
+  /*
+   * Only the thread of the task updates these counters
+   */
+  now_us = itti_get_time_us ();
+  __sync_fetch_and_add (&task->messages_out, nb_msgs);
+
+  for (i = 0; i < nb_msgs; i++) {
+    uint64_t                                enqueue_us = ((uint64_t) received_msgs[i]->ittiMsgHeader.lte_time.time.tv_sec * 1000000) + received_msgs[i]->ittiMsgHeader.lte_time.time.tv_usec;
+    uint64_t                                latency_us = (now_us > enqueue_us) ? now_us - enqueue_us : 0;
+    int                                     bucket = (latency_us) ? 64 - __builtin_clzll (latency_us) : 0;
+
+    if (bucket >= ITTI_LATENCY_HISTOGRAM_BUCKETS) {
+      bucket = ITTI_LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+
+    task->latency_histogram[bucket]++;
+    task->latency_total_us += latency_us;
+
+    if (latency_us > task->latency_max_us) {
+      task->latency_max_us = latency_us;
+    }
+
+    if ((track_handling) && (i < ITTI_RECEIVE_BATCH_SIZE)) {
+      itti_handled_messages.messages[i] = received_msgs[i];
+      itti_handled_messages.message_ids[i] = received_msgs[i]->ittiMsgHeader.messageId;
+      itti_handled_messages.nb_messages = i + 1;
+    }
+  }
+
+  if (track_handling) {
+    itti_handled_messages.handler_start_us = now_us;
+  }
+}
+
+static inline int
 itti_receive_msg_internal_event_fd (
   task_id_t task_id,
   uint8_t polling,
-  MessageDef ** received_msg)
+  MessageDef ** received_msgs,
+  int max_msgs)
 {
   thread_id_t                             thread_id;
   int                                     epoll_ret = 0;
   int                                     epoll_timeout = 0;
+  int                                     nb_other_events = 0;
+  int                                     nb_msgs = 0;
   int                                     i;
 
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
-  AssertFatal (received_msg != NULL, "Received message is NULL!\n");
+  AssertFatal (received_msgs != NULL, "Received message is NULL!\n");
+  AssertFatal (max_msgs > 0, "Invalid number of messages to receive (%d)!\n", max_msgs);
   thread_id = TASK_GET_THREAD_ID (task_id);
-  *received_msg = NULL;
-
-  if (polling) {
-    /*
-     * In polling mode we set the timeout to 0 causing epoll_wait to return
-     * * * immediately.
-     */
-    epoll_timeout = 0;
-  } else {
-    /*
-     * timeout = -1 causes the epoll_wait to wait indefinitely.
-     */
-    epoll_timeout = -1;
-  }
 
   do {
-    epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
-  } while (epoll_ret < 0 && errno == EINTR);
+    itti_desc.threads[thread_id].epoll_nb_events = 0;
+    nb_msgs = itti_dequeue_messages (task_id, received_msgs, max_msgs);
 
-  if (epoll_ret < 0) {
-    AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
-  }
+    if (nb_msgs == 0) {
+      /*
+       * Queue found empty: from now on senders have to signal the event fd.
+       * * * Check the queue again to not miss a message enqueued before the
+       * * * flag was cleared.
+       */
+      __sync_fetch_and_and (&itti_desc.threads[thread_id].receiver_awake, 0);
+      nb_msgs = itti_dequeue_messages (task_id, received_msgs, max_msgs);
 
-  if (epoll_ret == 0 && polling) {
-    /*
-     * No data to read -> return
-     */
-    return;
-  }
+      if (nb_msgs > 0) {
+        __sync_bool_compare_and_swap (&itti_desc.threads[thread_id].receiver_awake, 0, 1);
+      }
+    }
 
-  itti_desc.threads[thread_id].epoll_nb_events = epoll_ret;
+    if ((nb_msgs > 0) && (itti_desc.threads[thread_id].nb_events == 1)) {
+      /*
+       * Only the ITTI event fd is monitored, no need to check it
+       */
+      return nb_msgs;
+    }
 
-  for (i = 0; i < epoll_ret; i++) {
-    /*
-     * Check if there is an event for ITTI for the event fd
-     */
-    if ((itti_desc.threads[thread_id].events[i].events & EPOLLIN) && (itti_desc.threads[thread_id].events[i].data.fd == itti_desc.threads[thread_id].task_event_fd)) {
-      struct message_list_s                  *message = NULL;
-      eventfd_t                               sem_counter;
-      ssize_t                                 read_ret;
-      int                                     result = EXIT_SUCCESS;
+    if ((polling) || (nb_msgs > 0)) {
+      /*
+       * In polling mode (or if messages have already been retrieved) we set
+       * * * the timeout to 0 causing epoll_wait to return immediately.
+       */
+      epoll_timeout = 0;
+    } else {
+      /*
+       * timeout = -1 causes the epoll_wait to wait indefinitely.
+       */
+      epoll_timeout = -1;
+    }
+
+    do {
+      epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
+    } while (epoll_ret < 0 && errno == EINTR);
+
+    if (epoll_ret < 0) {
+      AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
+    }
+
+    itti_desc.threads[thread_id].epoll_nb_events = epoll_ret;
+    nb_other_events = epoll_ret;
 
+    for (i = 0; i < epoll_ret; i++) {
       /*
-       * Read will always return 1
+       * Check if there is an event for ITTI for the event fd
        */
-      read_ret = read (itti_desc.threads[thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
-      AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD (%d) failed (%d/%d)!\n", thread_id, (int)read_ret, (int)sizeof (sem_counter));
+      if ((itti_desc.threads[thread_id].events[i].events & EPOLLIN) && (itti_desc.threads[thread_id].events[i].data.fd == itti_desc.threads[thread_id].task_event_fd)) {
+        eventfd_t                               sem_counter;
+        ssize_t                                 read_ret;
 
-      if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 0) {
         /*
-         * No element in list -> this should not happen
+         * Reset the event fd counter, the queue is drained until empty
          */
-        AssertFatal (0, "No message in queue for task %d while there are %d events and some for the messages queue!\n", task_id, epoll_ret);
-      }
+        read_ret = read (itti_desc.threads[thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
+        AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD (%d) failed (%d/%d)!\n", thread_id, (int)read_ret, (int)sizeof (sem_counter));
+        /*
+         * Mark that the event has been processed
+         */
+        itti_desc.threads[thread_id].events[i].events &= ~EPOLLIN;
+        nb_other_events--;
 
-      AssertFatal (message != NULL, "Message from message queue is NULL!\n");
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (message->msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-      /*
-       * Mark that the event has been processed
-       */
-      itti_desc.threads[thread_id].events[i].events &= ~EPOLLIN;
-      return;
+        if (nb_msgs == 0) {
+          nb_msgs = itti_dequeue_messages (task_id, received_msgs, max_msgs);
+        }
+        break;
+      }
     }
-  }
+    /*
+     * A wakeup may be spurious (message already retrieved before the event fd
+     * * * was read): in blocking mode wait again unless other fds have events.
+     */
+  } while ((nb_msgs == 0) && (nb_other_events == 0) && (!polling));
+
+  return nb_msgs;
 }
 
 void
@@ -660,11 +1221,28 @@ itti_receive_msg (
   task_id_t task_id,
   MessageDef ** received_msg)
 {
+  AssertFatal (received_msg != NULL, "Received message is NULL!\n");
+  *received_msg = NULL;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
-  itti_receive_msg_internal_event_fd (task_id, 0, received_msg);
+  itti_account_received_messages (task_id, received_msg, itti_receive_msg_internal_event_fd (task_id, 0, received_msg, 1), true);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
 }
 
+int
+itti_receive_msg_batch (
+  task_id_t task_id,
+  MessageDef ** received_msgs,
+  int max_msgs)
+{
+  int                                     nb_msgs = 0;
+
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
+  nb_msgs = itti_receive_msg_internal_event_fd (task_id, 0, received_msgs, max_msgs);
+  itti_account_received_messages (task_id, received_msgs, nb_msgs, true);
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
+  return nb_msgs;
+}
+
 void
 itti_poll_msg (
   task_id_t task_id,
@@ -673,17 +1251,11 @@ itti_poll_msg (
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
   *received_msg = NULL;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
-  {
-    struct message_list_s                  *message;
-
-    if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 1) {
-      int                                     result;
-
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-    }
-  }
+  /*
+   * Sub-tasks are polled from the thread of another task: do not reset the
+   * * * handler time tracking of that task.
+   */
+  itti_account_received_messages (task_id, received_msg, itti_dequeue_message (task_id, received_msg), false);
 
   if (*received_msg == NULL) {
     ITTI_DEBUG (ITTI_DEBUG_POLL, " No message in queue[(%u:%s)]\n", task_id, itti_get_task_name (task_id));
@@ -801,6 +1373,58 @@ itti_terminate_tasks (
   pthread_exit (NULL);
 }
 
+static uint32_t
+itti_get_configured_queue_size (
+  task_id_t task_id,
+  const itti_config_t * const itti_config)
+{
+  int                                     i = 0;
+
+  if (itti_config) {
+    for (i = 0; i < itti_config->nb_task_queues; i++) {
+      if (strcmp (itti_config->task_queues[i].task_name, itti_desc.tasks_info[task_id].name) == 0) {
+        return itti_config->task_queues[i].queue_size;
+      }
+    }
+  }
+
+  return itti_desc.tasks_info[task_id].queue_size;
+}
+
+static void
+itti_check_config (
+  const itti_config_t * const itti_config)
+{
+  task_id_t                               task_id;
+  int                                     i = 0;
+
+  AssertFatal ((itti_config->nb_task_queues >= 0) && (itti_config->nb_task_queues <= ITTI_CONFIG_MAX_TASK_QUEUES),
+               "Bad number of ITTI task queues configured (%d/%d)!\n", itti_config->nb_task_queues, ITTI_CONFIG_MAX_TASK_QUEUES);
+  AssertFatal ((itti_config->nb_memory_pools >= 0) && (itti_config->nb_memory_pools <= ITTI_CONFIG_MAX_MEMORY_POOLS),
+               "Bad number of ITTI memory pools configured (%d/%d)!\n", itti_config->nb_memory_pools, ITTI_CONFIG_MAX_MEMORY_POOLS);
+
+  for (i = 0; i < itti_config->nb_task_queues; i++) {
+    uint32_t                                queue_size = itti_config->task_queues[i].queue_size;
+
+    for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+      if (strcmp (itti_config->task_queues[i].task_name, itti_desc.tasks_info[task_id].name) == 0) {
+        break;
+      }
+    }
+
+    AssertFatal (task_id < itti_desc.task_max, "Unknown task %s in ITTI task queues configuration!\n", itti_config->task_queues[i].task_name);
+    AssertFatal ((queue_size >= ITTI_CONFIG_QUEUE_SIZE_MIN) && (queue_size <= ITTI_CONFIG_QUEUE_SIZE_MAX) && ((queue_size & (queue_size - 1)) == 0),
+                 "Bad queue size %u for task %s, must be a power of 2 in [%u, %u]!\n",
+                 queue_size, itti_config->task_queues[i].task_name, ITTI_CONFIG_QUEUE_SIZE_MIN, ITTI_CONFIG_QUEUE_SIZE_MAX);
+  }
+
+  for (i = 0; i < itti_config->nb_memory_pools; i++) {
+    AssertFatal ((itti_config->memory_pools[i].items > 0) && (itti_config->memory_pools[i].item_size > 0),
+                 "Empty ITTI memory pool %d configured (%u items of %u bytes)!\n", i, itti_config->memory_pools[i].items, itti_config->memory_pools[i].item_size);
+    AssertFatal ((i == 0) || (itti_config->memory_pools[i].item_size > itti_config->memory_pools[i - 1].item_size),
+                 "ITTI memory pools must be sorted by increasing item size (pool %d: %u bytes)!\n", i, itti_config->memory_pools[i].item_size);
+  }
+}
 
 int
 itti_init (
@@ -810,10 +1434,14 @@ itti_init (
   const task_info_t * tasks_info,
   const message_info_t * messages_info,
   const char *const messages_definition_xml,
-  const char *const dump_file_name)
+  const char *const dump_file_name,
+  const itti_config_t * const itti_config,
+  itti_free_msg_content_t free_msg_content)
 {
   task_id_t                               task_id;
   thread_id_t                             thread_id;
+  uint64_t                                queues_reserved_size = 0;
+  uint64_t                                pools_reserved_size = 0;
 
   itti_desc.message_number = 1;
   ITTI_DEBUG (ITTI_DEBUG_INIT, " Init: %d tasks, %d threads, %d messages\n", task_max, thread_max, messages_id_max);
@@ -825,6 +1453,7 @@ itti_init (
   itti_desc.thread_max = thread_max;
   itti_desc.messages_id_max = messages_id_max;
   itti_desc.thread_handling_signals = false;
+  itti_desc.free_msg_content = free_msg_content;
   itti_desc.tasks_info = tasks_info;
   itti_desc.messages_info = messages_info;
   /*
@@ -836,6 +1465,14 @@ itti_init (
    * Allocates memory for threads info
    */
   itti_desc.threads = calloc (itti_desc.thread_max, sizeof (thread_desc_t));
+  /*
+   * Allocates memory for messages statistics
+   */
+  itti_desc.messages_statistics = calloc (itti_desc.messages_id_max, sizeof (itti_message_statistics_t));
+
+  if (itti_config) {
+    itti_check_config (itti_config);
+  }
 
   /*
    * Initializing each queue and related stuff
@@ -845,11 +1482,17 @@ itti_init (
                 itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ? "sub-" : "",
                 itti_desc.tasks_info[task_id].name,
                 itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ? " with parent " : "", itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ? itti_get_task_name (itti_desc.tasks_info[task_id].parent_task) : "");
-    ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
-    printf (" Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
-
-    itti_desc.tasks[task_id].qbmme = calloc(itti_desc.tasks_info[task_id].queue_size, sizeof(struct lfds710_queue_bmm_element));
-    lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue, itti_desc.tasks[task_id].qbmme, itti_desc.tasks_info[task_id].queue_size, NULL );
+    itti_desc.tasks[task_id].queue_size = itti_get_configured_queue_size (task_id, itti_config);
+    ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating queue of message of size %u\n", itti_desc.tasks[task_id].queue_size);
+    printf (" Creating queue of message of size %u\n", itti_desc.tasks[task_id].queue_size);
+
+    for (itti_queue_level_t level = ITTI_QUEUE_LEVEL_HIGH; level < ITTI_QUEUE_LEVEL_MAX; level++) {
+      itti_desc.tasks[task_id].qbmme[level] = calloc(itti_desc.tasks[task_id].queue_size, sizeof(struct lfds710_queue_bmm_element));
+      AssertFatal (itti_desc.tasks[task_id].qbmme[level] != NULL, "Failed to allocate queue of %u messages for task %s!\n",
+                   itti_desc.tasks[task_id].queue_size, itti_get_task_name (task_id));
+      lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue[level], itti_desc.tasks[task_id].qbmme[level], itti_desc.tasks[task_id].queue_size, NULL );
+    }
+    queues_reserved_size += (uint64_t)itti_desc.tasks[task_id].queue_size * ITTI_QUEUE_LEVEL_MAX * sizeof (struct lfds710_queue_bmm_element);
   }
 
   /*
@@ -866,7 +1509,11 @@ itti_init (
       AssertFatal (0, "Failed to create new epoll fd: %s!\n", strerror (errno));
     }
 
-    itti_desc.threads[thread_id].task_event_fd = eventfd (0, EFD_SEMAPHORE);
+    /*
+     * Not in semaphore mode: senders only signal the empty to non-empty
+     * * * transition of the queue, a single read resets the counter.
+     */
+    itti_desc.threads[thread_id].task_event_fd = eventfd (0, 0);
 
     if (itti_desc.threads[thread_id].task_event_fd == -1) {
       /*
@@ -875,6 +1522,9 @@ itti_init (
       AssertFatal (0, " eventfd failed: %s!\n", strerror (errno));
     }
 
+    itti_desc.threads[thread_id].receiver_awake = 0;
+    itti_desc.threads[thread_id].wakeups_signalled = 0;
+    itti_desc.threads[thread_id].wakeups_avoided = 0;
     itti_desc.threads[thread_id].nb_events = 1;
     itti_desc.threads[thread_id].events = calloc (1, sizeof (struct epoll_event));
     itti_desc.threads[thread_id].events->events = EPOLLIN | EPOLLERR;
@@ -898,12 +1548,21 @@ itti_init (
   itti_desc.created_tasks = 0;
   itti_desc.ready_tasks = 0;
 
-  itti_desc.memory_pools_handle = memory_pools_create (5);
-  memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + ITTI_QUEUE_MAX_ELEMENTS, 50);
-  memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + (2 * ITTI_QUEUE_MAX_ELEMENTS), 100);
-  memory_pools_add_pool (itti_desc.memory_pools_handle, 10000, 1000);
-  memory_pools_add_pool (itti_desc.memory_pools_handle, 400, 20050);
-  memory_pools_add_pool (itti_desc.memory_pools_handle, 100, 30050);
+  if ((itti_config) && (itti_config->nb_memory_pools > 0)) {
+    itti_desc.memory_pools_handle = memory_pools_create (itti_config->nb_memory_pools);
+
+    for (int i = 0; i < itti_config->nb_memory_pools; i++) {
+      memory_pools_add_pool (itti_desc.memory_pools_handle, itti_config->memory_pools[i].items, itti_config->memory_pools[i].item_size);
+    }
+  } else {
+    itti_desc.memory_pools_handle = memory_pools_create (5);
+    memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + ITTI_QUEUE_MAX_ELEMENTS, 50);
+    memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + (2 * ITTI_QUEUE_MAX_ELEMENTS), 100);
+    memory_pools_add_pool (itti_desc.memory_pools_handle, 10000, 1000);
+    memory_pools_add_pool (itti_desc.memory_pools_handle, 400, 20050);
+    memory_pools_add_pool (itti_desc.memory_pools_handle, 100, 30050);
+  }
+  pools_reserved_size = memory_pools_reserved_size (itti_desc.memory_pools_handle);
   {
     char                                   *statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
 
@@ -918,6 +1577,12 @@ itti_init (
   // Could not be launched before ITTI initialization
   shared_log_itti_connect();
   OAILOG_ITTI_CONNECT();
+  if ((itti_config) && (itti_config->trace_file_name[0])) {
+    // a failure only disables the trace
+    itti_trace_init (itti_config->trace_file_name, (itti_config->trace_size) ? itti_config->trace_size : ITTI_TRACE_DEFAULT_SIZE, messages_definition_xml);
+  }
+  OAILOG_INFO (LOG_ITTI, "ITTI memory reserved: %"PRIu64" bytes (task queues %"PRIu64" bytes, memory pools %"PRIu64" bytes)\n",
+               queues_reserved_size + pools_reserved_size, queues_reserved_size, pools_reserved_size);
   return 0;
 }
 
@@ -982,6 +1647,7 @@ itti_wait_tasks_end (
 
   OAILOG_INFO (LOG_ITTI,  "ready_tasks %d", ready_tasks);
   itti_desc.running = 0;
+  itti_trace_exit ();
   {
     char                                   *statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
 
@@ -60,15 +60,22 @@ const message_info_t messages_info[] = {
 
 #endif
 
+/** \brief Frees what a message owns (bstrings, buffers, ...), the message itself is freed by the caller
+ **/
+typedef void (*itti_free_msg_content_t)(MessageDef * const message_p);
+
 /** \brief Init function for the intertask interface. Init queues, Mutexes and Cond vars.
  * \param thread_max Maximum number of threads
  * \param messages_id_max Maximum message id
  * \param threads_name Pointer on the threads name information as created by this include file
  * \param messages_info Pointer on messages information as created by this include file
+ * \param itti_config Queue sizes and memory pools read from the configuration file, NULL for the built-in values
+ * \param free_msg_content Called on the messages dropped by ITTI, NULL if the messages own nothing
  **/
 int itti_init(task_id_t task_max, thread_id_t thread_max, MessagesIds messages_id_max, const task_info_t *tasks_info,
               const message_info_t *messages_info, const char * const messages_definition_xml,
-              const char * const dump_file_name);
+              const char * const dump_file_name, const itti_config_t * const itti_config,
+              itti_free_msg_content_t free_msg_content);
 
 #endif /* INTERTASK_INTERFACE_INIT_H_ */
 /* @} */
@@ -0,0 +1,101 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/** @brief Intertask Interface flight recorder
+   Every message sent between tasks is copied, header and payload, into a
+   circular trace file mapped in memory. The file survives a crash of the
+   process and is decoded offline by itti_trace_decoder (itti_analyzer
+   directory) with the messages definition XML.
+
+   File layout:
+   - itti_trace_file_header_t, then the messages definition XML if known,
+     padded to ITTI_TRACE_FILE_HEADER_ALIGN bytes,
+   - the ring, ring_size bytes.
+
+   A record never crosses the end of the ring, the space left before the
+   end is filled with a padding record. A record is valid only if its
+   commit word holds ITTI_TRACE_RECORD_MAGIC (ITTI_TRACE_PADDING_MAGIC) and
+   its position matches the offset where it is read: stale or partially
+   written records are skipped.
+   This header is also used by the decoder, it must not depend on ITTI types.
+*/
+
+#ifndef INTERTASK_INTERFACE_TRACE_H_
+#define INTERTASK_INTERFACE_TRACE_H_
+
+#include <stdint.h>
+
+#define ITTI_TRACE_FILE_MAGIC            "ITTITRC1"
+#define ITTI_TRACE_FILE_VERSION          (1)
+#define ITTI_TRACE_FILE_HEADER_ALIGN     (4096)
+#define ITTI_TRACE_RECORD_MAGIC          (0x49545452)   /* "ITTR" */
+#define ITTI_TRACE_PADDING_MAGIC         (0x49545450)   /* "ITTP" */
+#define ITTI_TRACE_RECORD_ALIGN          (16)
+
+/* Ring size when none is configured, a power of 2 */
+#define ITTI_TRACE_DEFAULT_SIZE          (64 * 1024 * 1024)
+#define ITTI_TRACE_MIN_SIZE              (1024 * 1024)
+
+typedef struct itti_trace_file_header_s {
+  char                                    magic[8];
+  uint32_t                                version;
+  uint32_t                                header_size;         /* offset of the ring in the file */
+  uint64_t                                ring_size;           /* power of 2 */
+  volatile uint64_t                       head;                /* bytes reserved since the start of the trace */
+  uint64_t                                start_realtime_us;   /* wall clock time when the trace started */
+  uint64_t                                start_monotonic_us;  /* CLOCK_MONOTONIC at the same time, the records are stamped with CLOCK_MONOTONIC */
+  uint32_t                                xml_offset;          /* messages definition XML, 0 if not known */
+  uint32_t                                xml_length;
+  volatile uint64_t                       skipped;             /* messages too big for the ring */
+} itti_trace_file_header_t;
+
+typedef struct itti_trace_record_s {
+  /* (magic << 32) | size of the record, written last. A padding record only has commit and position */
+  volatile uint64_t                       commit;
+  uint64_t                                position;            /* value of head when the record was reserved */
+  uint64_t                                time_us;
+  uint64_t                                message_number;
+  uint32_t                                message_id;
+  uint16_t                                origin_task_id;
+  uint16_t                                destination_task_id;
+  uint32_t                                payload_size;        /* MessageDef bytes following this header */
+  uint32_t                                reserved;
+} itti_trace_record_t;
+
+#define ITTI_TRACE_COMMIT(mAgIc, sIzE)   (((uint64_t)(mAgIc) << 32) | (uint32_t)(sIzE))
+#define ITTI_TRACE_COMMIT_MAGIC(cOmMiT)  ((uint32_t)((cOmMiT) >> 32))
+#define ITTI_TRACE_COMMIT_SIZE(cOmMiT)   ((uint32_t)(cOmMiT))
+
+#if !defined(ITTI_TRACE_FORMAT_ONLY)
+struct MessageDef_s;
+
+extern volatile int itti_trace_enabled;
+
+int itti_trace_init (const char * const file_name, const uint64_t ring_size, const char * const messages_definition_xml);
+
+void itti_trace_message (const struct MessageDef_s * const message, const uint64_t message_number);
+
+void itti_trace_exit (void);
+
+#  define ITTI_TRACE_MESSAGE(mSGpTR, nUMBER)  do { if (itti_trace_enabled) itti_trace_message(mSGpTR, nUMBER); } while (0)
+#endif
+
+#endif /* INTERTASK_INTERFACE_TRACE_H_ */
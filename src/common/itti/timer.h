@@ -24,22 +24,20 @@
 
 #include <signal.h>
 
-#define SIGTIMER SIGRTMIN
-
 typedef enum timer_type_s {
   TIMER_PERIODIC,
   TIMER_ONE_SHOT,
   TIMER_TYPE_MAX,
 } timer_type_t;
 
-int timer_handle_signal(siginfo_t *info);
-
 /** \brief Request a new timer
+ *  The interval is rounded up to the timer wheel tick (10 ms).
  *  \param interval_sec timer interval in seconds
  *  \param interval_us  timer interval in micro seconds
  *  \param task_id      task id of the task requesting the timer
  *  \param instance     instance of the task requesting the timer
  *  \param type         timer type
+ *  \param timer_arg    argument given back in the TIMER_HAS_EXPIRED message
  *  \param timer_id     unique timer identifier
  *  @returns -1 on failure, 0 otherwise
  **/
@@ -52,6 +50,24 @@ int timer_setup(
   void         *timer_arg,
   long         *timer_id);
 
+/** \brief Request a new timer that may expire up to slack_ms late
+ *  Timers with a slack are aligned on common ticks, their expiries are
+ *  notified with one TIMER_HAS_EXPIRED_BATCH message per task and tick
+ *  instead of TIMER_HAS_EXPIRED messages. Meant for supervision timers.
+ *  \param slack_ms     tolerated expiry delay in milli seconds
+ *  Other parameters as timer_setup
+ *  @returns -1 on failure, 0 otherwise
+ **/
+int timer_setup_with_slack(
+  uint32_t      interval_sec,
+  uint32_t      interval_us,
+  uint32_t      slack_ms,
+  task_id_t     task_id,
+  int32_t       instance,
+  timer_type_t  type,
+  void         *timer_arg,
+  long         *timer_id);
+
 /** \brief Remove the timer from list
  *  \param timer_id unique timer id
  *  @returns -1 on failure, 0 otherwise
@@ -60,8 +76,7 @@ int timer_setup(
 int timer_remove (long timer_id, void ** arg);
 #define timer_stop timer_remove
 
-/** \brief Initialize timer task and its API
- *  \param mme_config MME common configuration
+/** \brief Initialize timer task and its API, starts the TASK_TIMER thread
  *  @returns -1 on failure, 0 otherwise
  **/
 int timer_init(void);
@@ -21,3 +21,4 @@
 
 
 MESSAGE_DEF(TIMER_HAS_EXPIRED, MESSAGE_PRIORITY_MED_PLUS, timer_has_expired_t, timer_has_expired)
+MESSAGE_DEF(TIMER_HAS_EXPIRED_BATCH, MESSAGE_PRIORITY_MED_PLUS, timer_has_expired_batch_t, timer_has_expired_batch)
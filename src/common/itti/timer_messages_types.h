@@ -25,6 +25,7 @@
 //-------------------------------------------------------------------------------------------//
 // Defines to access message fields.
 #define TIMER_HAS_EXPIRED(mSGpTR)   (mSGpTR)->ittiMsg.timer_has_expired
+#define TIMER_HAS_EXPIRED_BATCH(mSGpTR)   (mSGpTR)->ittiMsg.timer_has_expired_batch
 
 //-------------------------------------------------------------------------------------------//
 typedef struct timer_has_expired_s {
@@ -32,4 +33,14 @@ typedef struct timer_has_expired_s {
   long  timer_id;
 } timer_has_expired_t;
 
+/* The message, header included (48 + 8 + 48 * 16 bytes on 64 bits), fits the
+   items of 1000 bytes of the default ITTI memory pools, fuller batches are split */
+#define TIMER_HAS_EXPIRED_BATCH_MAX_TIMERS   (48)
+
+/* Expiries of timers started with a slack, coalesced per task and tick */
+typedef struct timer_has_expired_batch_s {
+  int                 nb_timers;
+  timer_has_expired_t timers[TIMER_HAS_EXPIRED_BATCH_MAX_TIMERS];
+} timer_has_expired_batch_t;
+
 #endif /* TIMER_MESSAGES_TYPES_H_ */
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/* Offline decoder of the ITTI flight recorder (../itti/intertask_interface_trace.h):
+   prints the records still in the ring of a trace file, oldest first, dissected
+   with the messages definition XML embedded in the file or given with -x.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#include <libxml/parser.h>
+
+#include "xml_parse.h"
+#include "buffers.h"
+
+#include "rc.h"
+
+#define ITTI_TRACE_FORMAT_ONLY
+#include "intertask_interface_trace.h"
+
+int                                     debug_buffers = 0;
+int                                     debug_parser = 0;
+
+static gboolean
+itti_trace_decoder_print (
+  gpointer user_data,
+  gchar * text,
+  gint length)
+{
+  fwrite (text, 1, length, (FILE *) user_data);
+  return TRUE;
+}
+
+static char                            *
+itti_trace_decoder_read_xml (
+  const char *file_name,
+  int *size)
+{
+  FILE                                   *file;
+  char                                   *xml = NULL;
+  long                                    length;
+
+  if ((file = fopen (file_name, "r")) == NULL) {
+    fprintf (stderr, "Cannot open %s: %s\n", file_name, strerror (errno));
+    return NULL;
+  }
+
+  if ((fseek (file, 0, SEEK_END) == 0) && ((length = ftell (file)) > 0) && (fseek (file, 0, SEEK_SET) == 0)) {
+    xml = malloc (length + 1);
+
+    if (fread (xml, 1, length, file) == (size_t) length) {
+      xml[length] = '\0';
+      *size = length;
+    } else {
+      free (xml);
+      xml = NULL;
+    }
+  }
+
+  if (xml == NULL) {
+    fprintf (stderr, "Cannot read %s\n", file_name);
+  }
+
+  fclose (file);
+  return xml;
+}
+
+static void
+itti_trace_decoder_print_record (
+  const itti_trace_file_header_t * header,
+  const itti_trace_record_t * record)
+{
+  buffer_t                               *buffer = NULL;
+  uint64_t                                realtime_us = header->start_realtime_us + (record->time_us - header->start_monotonic_us);
+  time_t                                  seconds = (time_t) (realtime_us / 1000000);
+  struct tm                               today;
+  char                                    date[32];
+
+  localtime_r (&seconds, &today);
+  strftime (date, sizeof (date), "%Y-%m-%d %H:%M:%S", &today);
+  printf ("#%" PRIu64 " %s.%06u message %u task %u -> %u\n", record->message_number, date, (unsigned int)(realtime_us % 1000000),
+          record->message_id, record->origin_task_id, record->destination_task_id);
+  /*
+   * The payload is the MessageDef as sent by the task, dissected in place
+   */
+  buffer_new_from_data (&buffer, (uint8_t *) & record[1], record->payload_size, 1);
+  buffer->message_number = (uint32_t) record->message_number;
+  buffer->message_id = record->message_id;
+  dissect_signal_header (buffer, itti_trace_decoder_print, stdout);
+  dissect_signal (buffer, itti_trace_decoder_print, stdout);
+  printf ("\n");
+  free (buffer);
+}
+
+static int
+itti_trace_decoder_scan (
+  const itti_trace_file_header_t * header,
+  const uint8_t * ring)
+{
+  uint64_t                                head = header->head;
+  uint64_t                                position = (head > header->ring_size) ? head - header->ring_size : 0;
+  uint64_t                                mask = header->ring_size - 1;
+  uint64_t                                records = 0;
+  uint64_t                                invalid = 0;
+
+  while (position < head) {
+    const itti_trace_record_t              *record = (const itti_trace_record_t *)&ring[position & mask];
+    uint32_t                                magic = ITTI_TRACE_COMMIT_MAGIC (record->commit);
+    uint32_t                                size = ITTI_TRACE_COMMIT_SIZE (record->commit);
+
+    /*
+     * Stale, overwritten or partially written records do not carry their own position
+     */
+    if ((record->position != position) || (size < ITTI_TRACE_RECORD_ALIGN) || (size % ITTI_TRACE_RECORD_ALIGN)
+        || (((position & mask) + size) > header->ring_size) || ((position + size) > head)) {
+      position += ITTI_TRACE_RECORD_ALIGN;
+      invalid += ITTI_TRACE_RECORD_ALIGN;
+      continue;
+    }
+
+    if ((magic == ITTI_TRACE_RECORD_MAGIC) && (size >= sizeof (itti_trace_record_t)) && (size >= (sizeof (itti_trace_record_t) + record->payload_size))) {
+      itti_trace_decoder_print_record (header, record);
+      records++;
+    } else if (magic != ITTI_TRACE_PADDING_MAGIC) {
+      position += ITTI_TRACE_RECORD_ALIGN;
+      invalid += ITTI_TRACE_RECORD_ALIGN;
+      continue;
+    }
+
+    position += size;
+  }
+
+  fprintf (stderr, "%" PRIu64 " messages decoded, %" PRIu64 " bytes of invalid records, %" PRIu64 " messages too big for the trace\n",
+           records, invalid, header->skipped);
+  return RC_OK;
+}
+
+static void
+itti_trace_decoder_usage (
+  const char *name)
+{
+  fprintf (stderr, "Usage: %s [-x messages_definition.xml] trace_file\n", name);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  const char                             *xml_file_name = NULL;
+  const itti_trace_file_header_t         *header;
+  struct stat                             st;
+  void                                   *map;
+  char                                   *xml = NULL;
+  int                                     xml_size = 0;
+  int                                     fd;
+  int                                     opt;
+  int                                     ret;
+
+  while ((opt = getopt (argc, argv, "x:h")) != -1) {
+    switch (opt) {
+    case 'x':
+      xml_file_name = optarg;
+      break;
+
+    default:
+      itti_trace_decoder_usage (argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind != (argc - 1)) {
+    itti_trace_decoder_usage (argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if ((fd = open (argv[optind], O_RDONLY)) < 0) {
+    fprintf (stderr, "Cannot open %s: %s\n", argv[optind], strerror (errno));
+    return EXIT_FAILURE;
+  }
+
+  CHECK_FCT_POSIX (fstat (fd, &st));
+
+  if (st.st_size < (off_t) sizeof (itti_trace_file_header_t)) {
+    fprintf (stderr, "%s is not an ITTI trace file\n", argv[optind]);
+    return EXIT_FAILURE;
+  }
+
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (map == MAP_FAILED) {
+    fprintf (stderr, "Cannot map %s: %s\n", argv[optind], strerror (errno));
+    return EXIT_FAILURE;
+  }
+
+  header = (const itti_trace_file_header_t *)map;
+
+  if ((memcmp (header->magic, ITTI_TRACE_FILE_MAGIC, sizeof (header->magic)) != 0) || (header->version != ITTI_TRACE_FILE_VERSION)
+      || (header->ring_size & (header->ring_size - 1)) || (((uint64_t) header->header_size + header->ring_size) > (uint64_t) st.st_size)) {
+    fprintf (stderr, "%s is not an ITTI trace file (version %u)\n", argv[optind], ITTI_TRACE_FILE_VERSION);
+    return EXIT_FAILURE;
+  }
+
+  /*
+   * xml_parse_buffer() keeps the buffer
+   */
+  if (xml_file_name) {
+    xml = itti_trace_decoder_read_xml (xml_file_name, &xml_size);
+  } else if (header->xml_length) {
+    xml_size = header->xml_length;
+    xml = malloc (xml_size);
+    memcpy (xml, (const uint8_t *)map + header->xml_offset, xml_size);
+  } else {
+    fprintf (stderr, "No messages definition in %s, give one with -x\n", argv[optind]);
+  }
+
+  if (xml == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  LIBXML_TEST_VERSION;
+  xmlInitParser ();
+  CHECK_FCT (xml_parse_buffer (xml, xml_size));
+  ret = itti_trace_decoder_scan (header, (const uint8_t *)map + header->header_size);
+  xmlCleanupParser ();
+  munmap (map, st.st_size);
+  close (fd);
+  return (ret == RC_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
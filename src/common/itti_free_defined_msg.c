@@ -387,10 +387,15 @@ void itti_free_msg_content (MessageDef * const message_p)
     break;
 
   case UDP_INIT:
+    break;
+
   case UDP_DATA_REQ:
+    udp_buffer_unref (&message_p->ittiMsg.udp_data_req.buffer);
+    break;
+
   case UDP_DATA_IND:
-    /** Changed to stacked buffer. */
-   break;
+    udp_buffer_unref (&message_p->ittiMsg.udp_data_ind.buffer);
+    break;
 
   case S1AP_PATH_SWITCH_REQUEST_ACKNOWLEDGE:
     /** Bearer Contexts to be switched. */
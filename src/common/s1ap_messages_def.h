@@ -64,6 +64,8 @@ MESSAGE_DEF(S1AP_E_RABSETUP_RESPONSE_LOG    , MESSAGE_PRIORITY_MED, IttiMsgText
 MESSAGE_DEF(S1AP_E_RABMODIFY_RESPONSE_LOG   , MESSAGE_PRIORITY_MED, IttiMsgText                    , s1ap_e_rabmodify_response_log)
 MESSAGE_DEF(S1AP_E_RABRELEASE_RESPONSE_LOG  , MESSAGE_PRIORITY_MED, IttiMsgText                     , s1ap_e_rabrelease_response_log)
 MESSAGE_DEF(S1AP_PAGING_LOG                 , MESSAGE_PRIORITY_MED, IttiMsgText                     , s1ap_paging_log)
+MESSAGE_DEF(S1AP_OVERLOAD_START_LOG         , MESSAGE_PRIORITY_MED, IttiMsgText                     , s1ap_overload_start_log)
+MESSAGE_DEF(S1AP_OVERLOAD_STOP_LOG          , MESSAGE_PRIORITY_MED, IttiMsgText                     , s1ap_overload_stop_log)
 
 MESSAGE_DEF(S1AP_ENB_RESET_LOG             , MESSAGE_PRIORITY_MED, IttiMsgText                      , s1ap_enb_reset_log)
 MESSAGE_DEF(S1AP_ERROR_IND_LOG             , MESSAGE_PRIORITY_MED, IttiMsgText                      , s1ap_error_ind_log)
@@ -122,3 +124,6 @@ MESSAGE_DEF(S1AP_HANDOVER_NOTIFY           , MESSAGE_PRIORITY_MED, itti_s1ap_han
 
 /** Paging. */
 MESSAGE_DEF(S1AP_PAGING                    , MESSAGE_PRIORITY_MED, itti_s1ap_paging_t               ,    s1ap_paging)
+
+/* Queue of a S1AP user task crossed a watermark, high priority to bypass the backlog of S1AP */
+MESSAGE_DEF(S1AP_MME_OVERLOAD_IND          , MESSAGE_PRIORITY_MAX_LEAST, itti_s1ap_mme_overload_ind_t,  s1ap_mme_overload_ind)
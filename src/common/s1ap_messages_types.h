@@ -85,6 +85,7 @@
 
 /** S1AP Paging. */
 #define S1AP_PAGING(mSGpTR)                           (mSGpTR)->ittiMsg.s1ap_paging
+#define S1AP_MME_OVERLOAD_IND(mSGpTR)                 (mSGpTR)->ittiMsg.s1ap_mme_overload_ind
 
 // List of possible causes for MME generated UE context release command towards eNB
 enum s1cause {
@@ -486,4 +487,10 @@ typedef struct itti_s1ap_paging_s {
 
 } itti_s1ap_paging_t;
 
+typedef struct itti_s1ap_mme_overload_ind_s {
+  uint32_t                task_id;           /* task_id_t of the task whose queue crossed a watermark.                                           */
+  bool                    overloaded;        /* true: high watermark reached, false: back to the low watermark.                                  */
+  uint32_t                queue_depth;
+} itti_s1ap_mme_overload_ind_t;
+
 #endif /* FILE_S1AP_MESSAGES_TYPES_SEEN */
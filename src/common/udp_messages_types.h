@@ -29,8 +29,10 @@
 #ifndef FILE_UDP_MESSAGES_TYPES_SEEN
 #define FILE_UDP_MESSAGES_TYPES_SEEN
 
+#include "udp_buffer.h"
+
 #define UDP_INIT(mSGpTR)    (mSGpTR)->ittiMsg.udp_init
-#define UDP_DATA_MAX_MSG_LEN    (4096)  /**< Maximum supported gtpv2c packet length including header */
+#define UDP_DATA_MAX_MSG_LEN    UDP_BUFFER_SIZE  /**< Maximum supported gtpv2c packet length including header */
 
 typedef struct {
   struct in_addr  address;
@@ -38,7 +40,7 @@ typedef struct {
 } udp_init_t;
 
 typedef struct {
-  uint8_t  *buffer;
+  udp_buffer_t *buffer;          /**< STOLEN_REF, released by TASK_UDP once the datagram is sent */
   uint32_t  buffer_length;
   uint32_t  buffer_offset;
   uint16_t  local_port;
@@ -47,7 +49,7 @@ typedef struct {
 } udp_data_req_t;
 
 typedef struct {
-  uint8_t                       msgBuf[UDP_DATA_MAX_MSG_LEN];
+  udp_buffer_t *buffer;          /**< STOLEN_REF, the datagram is parsed in place by the receiving task */
   uint32_t  buffer_length;
   uint16_t  local_port;
   struct in_addr  peer_address;
@@ -47,6 +47,7 @@
 #include "NwGtpv2cMsg.h"
 #include "NwGtpv2cMsgIeParseInfo.h"
 #include "NwGtpv2cTunnel.h"
+#include "udp_buffer.h"
 
 /**
  * @file NwGtpv2cPrivate.h
@@ -140,7 +141,7 @@ typedef struct nw_gtpv2c_timeout_info_s {
  * GTPv2c Message Container Definition
  *--------------------------------------------------------------------------*/
 
-#define NW_GTPV2C_MAX_MSG_LEN                                    (4096)  /**< Maximum supported gtpv2c packet length including header */
+#define NW_GTPV2C_MAX_MSG_LEN                                    (UDP_BUFFER_SIZE)  /**< Maximum supported gtpv2c packet length including header */
 
 /**
  * NwGtpv2cMsgT holds gtpv2c messages to/from the peer.
@@ -162,7 +163,8 @@ typedef struct nw_gtpv2c_msg_s {
 
   bool                          isIeValid[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
   uint8_t                      *pIe[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
-  uint8_t                       msgBuf[NW_GTPV2C_MAX_MSG_LEN];
+  udp_buffer_t                 *buffer;         /**< Datagram received or sent by TASK_UDP, no copy */
+  uint8_t                      *msgBuf;         /**< buffer->data */
   nw_gtpv2c_stack_handle_t      hStack;
   struct nw_gtpv2c_msg_s*       next;
 } nw_gtpv2c_msg_t;
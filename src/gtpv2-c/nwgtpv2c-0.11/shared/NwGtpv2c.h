@@ -39,6 +39,7 @@
 #include <arpa/inet.h>
 #include "NwTypes.h"
 #include "NwError.h"
+#include "udp_buffer.h"
 
 /** @mainpage
 
@@ -390,7 +391,7 @@ typedef struct nw_gtpv2c_udp_entity_s {
   nw_gtpv2c_udp_handle_t        hUdp;
   uint16_t                      gtpv2cStandardPort;
   nw_rc_t (*udpDataReqCallback) ( NW_IN     nw_gtpv2c_udp_handle_t udpHandle,
-                                NW_IN     uint8_t* dataBuf,
+                                NW_IN     udp_buffer_t* dataBuf,  /* take a reference to keep it after returning */
                                 NW_IN     uint32_t dataSize,
                                 NW_IN     uint16_t localPort,
                                 NW_IN     struct in_addr * peerIp,
@@ -570,7 +571,8 @@ nwGtpv2cSetLogLevel( NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
  Process Data Request from UDP entity.
 
  @param[in] hGtpcStackHandle : Stack handle
- @param[in] udpData : Pointer to received UDP data.
+ @param[in] udpData : Received UDP datagram, parsed in place: the messages
+                      kept by the stack take their own reference on it.
  @param[in] udpDataLen : Received data length.
  @param[in] localPort : Received on local port.
  @param[in] dstPort : Received on port.
@@ -580,7 +582,7 @@ nwGtpv2cSetLogLevel( NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
 
 nw_rc_t
 nwGtpv2cProcessUdpReq( NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
-                       NW_IN uint8_t* udpData,
+                       NW_IN udp_buffer_t* udpData,
                        NW_IN uint32_t udpDataLen,
                        NW_IN uint16_t localPort,
                        NW_IN uint16_t peerPort,
@@ -246,14 +246,14 @@ nwGtpv2cMsgNew( NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
  * Allocate a gtpv2c message from data buffer.
  *
  * @param[in] hGtpcStackHandle : gtpv2c stack handle.
- * @param[in] pBuf: Buffer to be copied in this message.
- * @param[in] bufLen: Buffer length to be copied in this message.
+ * @param[in] pBuf: Buffer of this message, referenced and not copied.
+ * @param[in] bufLen: Message length in the buffer.
  * @param[out] phMsg : Pointer to message handle.
  */
 
 nw_rc_t
 nwGtpv2cMsgFromBufferNew( NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
-                          NW_IN uint8_t* pBuf,
+                          NW_IN udp_buffer_t* pBuf,
                           NW_IN uint32_t bufLen,
                           NW_OUT nw_gtpv2c_msg_handle_t *phMsg);
 
@@ -432,7 +432,7 @@ extern                                  "C" {
      * Call UDP data request callback
      */
     NW_ASSERT (thiz->udp.udpDataReqCallback != NULL);
-    rc = thiz->udp.udpDataReqCallback (thiz->udp.hUdp, pMsg->msgBuf, pMsg->msgLen, localPort, peerIp, peerPort);
+    rc = thiz->udp.udpDataReqCallback (thiz->udp.hUdp, pMsg->buffer, pMsg->msgLen, localPort, peerIp, peerPort);
     NW_ASSERT (NW_OK == rc);
     return rc;
   }
@@ -1029,10 +1029,11 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
   static nw_rc_t                            nwGtpv2cHandleInitialReq (
   NW_IN nw_gtpv2c_stack_t * thiz,
   NW_IN uint32_t msgType,
-  NW_IN uint8_t * msgBuf,
+  NW_IN udp_buffer_t * udpBuf,
   NW_IN uint32_t msgBufLen,
   NW_IN uint16_t peerPort,
   NW_IN struct in_addr *peerIp) {
+    uint8_t                                  *msgBuf = udpBuf->data;
     nw_rc_t                                   rc = NW_FAILURE;
     uint32_t                                  seqNum = 0;
     uint32_t                                  teidLocal = 0;
@@ -1069,7 +1070,7 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
 
     if (pTrxn) {
       pTrxn->localPort = thiz->udp.gtpv2cStandardPort;
-      rc = nwGtpv2cMsgFromBufferNew ((nw_gtpv2c_stack_handle_t) thiz, msgBuf, msgBufLen, &(hMsg));
+      rc = nwGtpv2cMsgFromBufferNew ((nw_gtpv2c_stack_handle_t) thiz, udpBuf, msgBufLen, &(hMsg));
       NW_ASSERT (thiz->pGtpv2cMsgIeParseInfo[msgType]);
       rc = nwGtpv2cMsgIeParse (thiz->pGtpv2cMsgIeParseInfo[msgType], hMsg, &error);
 
@@ -1093,11 +1094,12 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
   static nw_rc_t                            nwGtpv2cHandleTriggeredReq (
   NW_IN nw_gtpv2c_stack_t * thiz,
   NW_IN uint32_t msgType,
-  NW_IN uint8_t * msgBuf,
+  NW_IN udp_buffer_t * udpBuf,
   NW_IN uint32_t msgBufLen,
   NW_IN uint16_t localPort,
   NW_IN uint16_t peerPort,
   NW_IN struct in_addr* peerIp) {
+    uint8_t                                  *msgBuf = udpBuf->data;
     nw_rc_t                                   rc = NW_FAILURE;
     nw_gtpv2c_trxn_t                         *pTrxn = NULL,
                                               keyTrxn;
@@ -1156,7 +1158,7 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
 
     if (pTrxn) {
       pTrxn->localPort = localPort;
-      rc = nwGtpv2cMsgFromBufferNew ((nw_gtpv2c_stack_handle_t) thiz, msgBuf, msgBufLen, &(hMsg));
+      rc = nwGtpv2cMsgFromBufferNew ((nw_gtpv2c_stack_handle_t) thiz, udpBuf, msgBufLen, &(hMsg));
       NW_ASSERT (thiz->pGtpv2cMsgIeParseInfo[msgType]);
       rc = nwGtpv2cMsgIeParse (thiz->pGtpv2cMsgIeParseInfo[msgType], hMsg, &error);
 
@@ -1181,12 +1183,13 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
   static nw_rc_t                            nwGtpv2cHandleTriggeredRsp (
   NW_IN nw_gtpv2c_stack_t * thiz,
   NW_IN uint32_t msgType,
-  NW_IN uint8_t * msgBuf,
+  NW_IN udp_buffer_t * udpBuf,
   NW_IN uint32_t msgBufLen,
   NW_IN uint16_t localPort,
   NW_IN uint16_t peerPort,
   NW_IN struct in_addr* peerIp,
   NW_IN bool remove) {
+    uint8_t                                  *msgBuf = udpBuf->data;
     nw_rc_t                                   rc = NW_FAILURE;
     nw_gtpv2c_trxn_t                          *pTrxn = NULL,
                                             keyTrxn;
@@ -1229,7 +1232,7 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
       }
 
       NW_ASSERT (msgBuf && msgBufLen);
-      rc = nwGtpv2cMsgFromBufferNew ((nw_gtpv2c_stack_handle_t) thiz, msgBuf, msgBufLen, &(hMsg));
+      rc = nwGtpv2cMsgFromBufferNew ((nw_gtpv2c_stack_handle_t) thiz, udpBuf, msgBufLen, &(hMsg));
       NW_ASSERT (thiz->pGtpv2cMsgIeParseInfo[msgType]);
       rc = nwGtpv2cMsgIeParse (thiz->pGtpv2cMsgIeParseInfo[msgType], hMsg, &error);
 
@@ -1496,12 +1499,13 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
 
   nw_rc_t                                   nwGtpv2cProcessUdpReq (
   NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
-  NW_IN uint8_t * udpData,
+  NW_IN udp_buffer_t * udpBuf,
   NW_IN uint32_t udpDataLen,
   NW_IN uint16_t localPort,
   NW_IN uint16_t peerPort,
   NW_IN struct in_addr * peerIp) {
     nw_rc_t                                   rc = NW_FAILURE;
+    uint8_t                                  *udpData = udpBuf->data;
     nw_gtpv2c_stack_t                         *thiz = NULL;
     uint16_t                                msgType = 0;
 
@@ -1558,7 +1562,7 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
     case NW_GTP_CONTEXT_REQ:
       /** S11: Paging. */
     case NW_GTP_DOWNLINK_DATA_NOTIFICATION:
-      rc = nwGtpv2cHandleInitialReq(thiz, msgType, udpData, udpDataLen, peerPort, peerIp);
+      rc = nwGtpv2cHandleInitialReq(thiz, msgType, udpBuf, udpDataLen, peerPort, peerIp);
       break;
 
     /** May be initial request or triggered requests. */
@@ -1569,11 +1573,11 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
       /** Check the received port, if it is an Initial Request, a Triggered Request or a Triggered Response. */
       if(localPort == thiz->udp.gtpv2cStandardPort){
         /** Message received on standard port, checking for Initial Requests. */
-        rc = nwGtpv2cHandleInitialReq(thiz, msgType, udpData, udpDataLen, peerPort, peerIp);
+        rc = nwGtpv2cHandleInitialReq(thiz, msgType, udpBuf, udpDataLen, peerPort, peerIp);
         break;
       } else {
         /** Message received on high port, checking for triggered requests and responses. */
-        rc = nwGtpv2cHandleTriggeredReq(thiz, msgType, udpData, udpDataLen, localPort, peerPort, peerIp);
+        rc = nwGtpv2cHandleTriggeredReq(thiz, msgType, udpBuf, udpDataLen, localPort, peerPort, peerIp);
         break;
       }
     }
@@ -1596,10 +1600,10 @@ static nw_rc_t                            nwGtpv2cHandleUlpFindLocalTunnel (
     case NW_GTP_DELETE_INDIRECT_DATA_FORWARDING_TUNNEL_RSP:
     case NW_GTP_FORWARD_RELOCATION_COMPLETE_ACK:
     case NW_GTP_RELOCATION_CANCEL_RSP:
-      rc = nwGtpv2cHandleTriggeredRsp (thiz, msgType, udpData, udpDataLen, localPort, peerPort, peerIp, true); /**< We will check inside, if the received response is to be acked. */
+      rc = nwGtpv2cHandleTriggeredRsp (thiz, msgType, udpBuf, udpDataLen, localPort, peerPort, peerIp, true); /**< We will check inside, if the received response is to be acked. */
       break;
     case NW_GTP_CONTEXT_RSP:
-      rc = nwGtpv2cHandleTriggeredRsp (thiz, msgType, udpData, udpDataLen, localPort, peerPort, peerIp, false); /**< We will check inside, if the received response is to be acked. */
+      rc = nwGtpv2cHandleTriggeredRsp (thiz, msgType, udpBuf, udpDataLen, localPort, peerPort, peerIp, false); /**< We will check inside, if the received response is to be acked. */
     break;
     case NW_GTP_CONTEXT_ACK:
       /** Ignore the received Ctx ACK (no transaction). */
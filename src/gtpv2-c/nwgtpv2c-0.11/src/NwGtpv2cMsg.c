@@ -36,6 +36,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include "bstrlib.h"
 
@@ -58,8 +59,36 @@ extern                                  "C" {
                        P R I V A T E     F U N C T I O N S
   ----------------------------------------------------------------------------*/
 
+  /* The pool is shared by the stacks of TASK_S11 and TASK_S10 */
+  static pthread_mutex_t                    gGtpv2cMsgPoolMutex = PTHREAD_MUTEX_INITIALIZER;
   static nw_gtpv2c_msg_t                    *gpGtpv2cMsgPool = NULL;
 
+  static nw_gtpv2c_msg_t                    *nwGtpv2cMsgPoolGet (
+  NW_IN nw_gtpv2c_stack_t * pStack) {
+    nw_gtpv2c_msg_t                           *pMsg = NULL;
+
+    pthread_mutex_lock (&gGtpv2cMsgPoolMutex);
+    if (gpGtpv2cMsgPool) {
+      pMsg = gpGtpv2cMsgPool;
+      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
+    }
+    pthread_mutex_unlock (&gGtpv2cMsgPoolMutex);
+
+    if (pMsg == NULL) {
+      NW_GTPV2C_MALLOC (pStack, sizeof (nw_gtpv2c_msg_t), pMsg, nw_gtpv2c_msg_t *);
+      OAILOG_DEBUG (LOG_GTPV2C, "ALLOCATED NEW MESSAGE %p!\n", pMsg);
+    }
+    return pMsg;
+  }
+
+  static void                               nwGtpv2cMsgPoolPut (
+  NW_IN nw_gtpv2c_msg_t * pMsg) {
+    pthread_mutex_lock (&gGtpv2cMsgPoolMutex);
+    pMsg->next = gpGtpv2cMsgPool;
+    gpGtpv2cMsgPool = pMsg;
+    pthread_mutex_unlock (&gGtpv2cMsgPoolMutex);
+  }
+
 /*----------------------------------------------------------------------------*
                          P U B L I C   F U N C T I O N S
   ----------------------------------------------------------------------------*/
@@ -76,15 +105,17 @@ extern                                  "C" {
                                             NW_ASSERT (
   pStack);
 
-    if (gpGtpv2cMsgPool) {
-      pMsg = gpGtpv2cMsgPool;
-      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (pStack, sizeof (nw_gtpv2c_msg_t), pMsg, nw_gtpv2c_msg_t *);
-      OAILOG_DEBUG (LOG_GTPV2C, "ALLOCATED NEW MESSAGE %p!\n", pMsg);
-    }
+    pMsg = nwGtpv2cMsgPoolGet (pStack);
 
     if (pMsg) {
+      /*
+       * Encoded in the buffer handed over to TASK_UDP
+       */
+      if ((pMsg->buffer = udp_buffer_alloc ()) == NULL) {
+        nwGtpv2cMsgPoolPut (pMsg);
+        return NW_FAILURE;
+      }
+      pMsg->msgBuf = pMsg->buffer->data;
       pMsg->version = NW_GTP_VERSION;
       pMsg->teidPresent = teidPresent;
       pMsg->msgType = msgType;
@@ -103,24 +134,24 @@ extern                                  "C" {
 
   nw_rc_t                                   nwGtpv2cMsgFromBufferNew (
   NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
-  NW_IN uint8_t * pBuf,
+  NW_IN udp_buffer_t * udpBuf,
   NW_IN uint32_t bufLen,
   NW_OUT nw_gtpv2c_msg_handle_t * phMsg) {
     nw_gtpv2c_stack_t                         *pStack = (nw_gtpv2c_stack_t *) hGtpcStackHandle;
     nw_gtpv2c_msg_t                           *pMsg;
+    uint8_t                                *pBuf = udpBuf->data;
 
     NW_ASSERT (pStack);
 
-    if (gpGtpv2cMsgPool) {
-      pMsg = gpGtpv2cMsgPool;
-      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (pStack, sizeof (nw_gtpv2c_msg_t), pMsg, nw_gtpv2c_msg_t *);
-    }
+    pMsg = nwGtpv2cMsgPoolGet (pStack);
 
     if (pMsg) {
       *phMsg = (nw_gtpv2c_msg_handle_t) pMsg;
-      memcpy (pMsg->msgBuf, pBuf, bufLen);
+      /*
+       * Parsed in place, the message holds a reference on the datagram received by TASK_UDP
+       */
+      pMsg->buffer = udp_buffer_ref (udpBuf);
+      pMsg->msgBuf = pBuf;
       pMsg->msgLen = bufLen;
       pMsg->version = ((*pBuf) & 0xE0) >> 5;
       pMsg->teidPresent = ((*pBuf) & 0x08) >> 3;
@@ -149,10 +180,12 @@ extern                                  "C" {
     // warning: unused variable ‘pStack’ [-Wunused-variable]: NwGtpv2cStackT                         *pStack = (NwGtpv2cStackT *) hGtpcStackHandle;
 
     OAILOG_DEBUG (LOG_GTPV2C, "Purging message %" PRIxPTR "!\n", hMsg);
-    ((nw_gtpv2c_msg_t *) hMsg)->next = gpGtpv2cMsgPool;
-    gpGtpv2cMsgPool = (nw_gtpv2c_msg_t *) hMsg;
-    OAILOG_DEBUG (LOG_GTPV2C, "Message pool %" PRIxPTR "! Next element %" PRIxPTR "! \n",
-    		gpGtpv2cMsgPool, gpGtpv2cMsgPool->next);
+    /*
+     * TASK_UDP may still be sending the buffer, it holds its own reference
+     */
+    udp_buffer_unref (&((nw_gtpv2c_msg_t *) hMsg)->buffer);
+    ((nw_gtpv2c_msg_t *) hMsg)->msgBuf = NULL;
+    nwGtpv2cMsgPoolPut ((nw_gtpv2c_msg_t *) hMsg);
 
     return NW_OK;
   }
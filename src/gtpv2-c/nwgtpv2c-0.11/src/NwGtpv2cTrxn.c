@@ -68,7 +68,7 @@ extern                                  "C" {
     nw_rc_t                                   rc;
     NW_ASSERT (thiz);
     NW_ASSERT (thiz->pMsg);
-    rc = thiz->pStack->udp.udpDataReqCallback (thiz->pStack->udp.hUdp, thiz->pMsg->msgBuf, thiz->pMsg->msgLen, thiz->localPort, &thiz->peerIp, thiz->peerPort);
+    rc = thiz->pStack->udp.udpDataReqCallback (thiz->pStack->udp.hUdp, thiz->pMsg->buffer, thiz->pMsg->msgLen, thiz->localPort, &thiz->peerIp, thiz->peerPort);
     thiz->maxRetries--;
     return rc;
   }
@@ -317,7 +317,7 @@ extern                                  "C" {
          */
         if (pCollision->pMsg) {
           rc = pCollision->pStack->udp.udpDataReqCallback (pCollision->pStack->udp.hUdp,
-              pCollision->pMsg->msgBuf, pCollision->pMsg->msgLen,
+              pCollision->pMsg->buffer, pCollision->pMsg->msgLen,
               pCollision->localPort, &pCollision->peerIp, pCollision->peerPort);
         }
 
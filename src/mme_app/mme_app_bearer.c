@@ -4485,7 +4485,7 @@ mme_app_handle_mobile_reachability_timer_expiry (struct ue_context_s *ue_context
   ue_context->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
   OAILOG_INFO (LOG_MME_APP, "Expired- Mobile Reachability Timer for UE id  %d \n", ue_context->mme_ue_s1ap_id);
   // Start Implicit Detach timer
-  if (timer_setup (ue_context->implicit_detach_timer.sec, 0,
+  if (timer_setup_with_slack (ue_context->implicit_detach_timer.sec, 0, MME_APP_TIMER_SLACK_MS,
                 TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context->mme_ue_s1ap_id), &(ue_context->implicit_detach_timer.id)) < 0) {
     OAILOG_ERROR (LOG_MME_APP, "Failed to start Implicit Detach timer for UE id  %d \n", ue_context->mme_ue_s1ap_id);
     ue_context->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
@@ -52,6 +52,7 @@
 #include "enum_string.h"
 #include "timer.h"
 #include "esm_cause.h"
+#include "hashtable_epoch.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_bearer_context.h"
 #include "mme_app_defs.h"
@@ -847,7 +848,10 @@ void mme_remove_ue_context (
   // todo: unlock?
   //  unlock_ue_contexts(ue_context);
 
-  free_wrapper ((void**) &ue_context);
+  /*
+   * Lock-free lookups may still hold a pointer to the context.
+   */
+  hashtable_epoch_retire (ue_context, free_wrapper);
 
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
@@ -1687,7 +1691,7 @@ void mme_ue_context_update_ue_sig_connection_state (
 
     if (mme_config.nas_config.t3412_min > 0) {
       // Start Mobile reachability timer only if periodic TAU timer is not disabled
-      if (timer_setup (ue_context->mobile_reachability_timer.sec, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context->mme_ue_s1ap_id), &(ue_context->mobile_reachability_timer.id)) < 0) {
+      if (timer_setup_with_slack (ue_context->mobile_reachability_timer.sec, 0, MME_APP_TIMER_SLACK_MS, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context->mme_ue_s1ap_id), &(ue_context->mobile_reachability_timer.id)) < 0) {
         OAILOG_ERROR (LOG_MME_APP, "Failed to start Mobile Reachability timer for UE id  %d \n", ue_context->mme_ue_s1ap_id);
         ue_context->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
       } else {
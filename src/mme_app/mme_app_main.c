@@ -43,6 +43,7 @@
 #include "mme_config.h"
 #include "timer.h"
 #include "mme_app_extern.h"
+#include "hashtable_epoch.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
@@ -57,11 +58,57 @@ mme_app_desc_t                          mme_app_desc = {.rw_lock = PTHREAD_RWLOC
 void     *mme_app_thread (void *args);
 
 //------------------------------------------------------------------------------
-void *mme_app_thread (void *args)
+static void mme_app_handle_timer_has_expired (const timer_has_expired_t * const timer_has_expired)
 {
   struct ue_context_s                    *ue_context_p = NULL;
   mme_app_s10_proc_mme_handover_t        *s10_handover_proc  = NULL;
 
+  /*
+   * Check statistic timer
+   */
+  if (timer_has_expired->timer_id == mme_app_desc.statistic_timer_id) {
+    mme_app_statistics_display ();
+    /** Display the ITTI buffer. */
+    itti_print_DEBUG ();
+  } else if (timer_has_expired->arg != NULL) {
+    mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(timer_has_expired->arg));
+    ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
+    if (ue_context_p == NULL) {
+      OAILOG_WARNING (LOG_MME_APP, "Timer expired but no associated UE context for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
+      return;
+    }
+    s10_handover_proc = mme_app_get_s10_procedure_mme_handover(ue_context_p);
+
+    OAILOG_WARNING (LOG_MME_APP, "TIMER_HAS_EXPIRED with ID %u and FOR UE id %d \n", timer_has_expired->timer_id, mme_ue_s1ap_id);
+
+    if (timer_has_expired->timer_id == ue_context_p->mobile_reachability_timer.id) {
+      // Mobile Reachability Timer expiry handler
+      mme_app_handle_mobile_reachability_timer_expiry (ue_context_p);
+    } else if (timer_has_expired->timer_id == ue_context_p->implicit_detach_timer.id) {
+      // Implicit Detach Timer expiry handler
+      mme_app_handle_implicit_detach_timer_expiry (ue_context_p);
+    } else if (timer_has_expired->timer_id == ue_context_p->initial_context_setup_rsp_timer.id) {
+      // Initial Context Setup Rsp Timer expiry handler
+      mme_app_handle_initial_context_setup_rsp_timer_expiry (ue_context_p);
+    }
+    /** Check for S10 procedures. */
+    else if(s10_handover_proc && timer_has_expired->timer_id == s10_handover_proc->proc.timer.id){
+      // MME Mobility Completion Timer expiry handler (we need this in addition to the one in the S1AP for CLR handling after TAU at source MME. */
+      s10_handover_proc->proc.proc.time_out(s10_handover_proc);
+    }
+    else {
+      OAILOG_WARNING (LOG_MME_APP, "Timer expired but no associated timer_id for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void *mme_app_thread (void *args)
+{
+  MessageDef                             *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received_messages = 0;
+  int                                     next_message = 0;
+
   itti_mark_task_ready (TASK_MME_APP);
   MSC_START_USE ();
 
@@ -72,9 +119,18 @@ void *mme_app_thread (void *args)
      * Trying to fetch a message from the message queue.
      * If the queue is empty, this function will block till a
      * message is sent to the task.
+     * Messages are retrieved by batch, one wakeup per batch.
      */
-    itti_receive_msg (TASK_MME_APP, &received_message_p);
+    while (next_message == nb_received_messages) {
+      nb_received_messages = itti_receive_msg_batch (TASK_MME_APP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+      next_message = 0;
+    }
+    received_message_p = received_messages[next_message++];
     DevAssert (received_message_p );
+    /*
+     * UE contexts found in mme_app_desc.mme_ue_contexts stay valid until the message is handled
+     */
+    hashtable_epoch_enter ();
 
     switch (ITTI_MSG_ID (received_message_p)) {
 
@@ -441,42 +497,16 @@ void *mme_app_thread (void *args)
       break;
 
     case TIMER_HAS_EXPIRED:{
+        mme_app_handle_timer_has_expired (&received_message_p->ittiMsg.timer_has_expired);
+      }
+      break;
+
+    case TIMER_HAS_EXPIRED_BATCH:{
         /*
-         * Check statistic timer
+         * Supervision timers started with a slack, coalesced by the timer task
          */
-        if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.statistic_timer_id) {
-          mme_app_statistics_display ();
-          /** Display the ITTI buffer. */
-          itti_print_DEBUG ();
-        } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
-          mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
-          ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
-          if (ue_context_p == NULL) {
-            OAILOG_WARNING (LOG_MME_APP, "Timer expired but no associated UE context for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
-            break;
-          }
-          s10_handover_proc = mme_app_get_s10_procedure_mme_handover(ue_context_p);
-
-          OAILOG_WARNING (LOG_MME_APP, "TIMER_HAS_EXPIRED with ID %u and FOR UE id %d \n", received_message_p->ittiMsg.timer_has_expired.timer_id, mme_ue_s1ap_id);
-
-          if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->mobile_reachability_timer.id) {
-            // Mobile Reachability Timer expiry handler
-            mme_app_handle_mobile_reachability_timer_expiry (ue_context_p);
-          } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->implicit_detach_timer.id) {
-            // Implicit Detach Timer expiry handler
-            mme_app_handle_implicit_detach_timer_expiry (ue_context_p);
-          } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->initial_context_setup_rsp_timer.id) {
-            // Initial Context Setup Rsp Timer expiry handler
-            mme_app_handle_initial_context_setup_rsp_timer_expiry (ue_context_p);
-          }
-          /** Check for S10 procedures. */
-          else if(s10_handover_proc && received_message_p->ittiMsg.timer_has_expired.timer_id == s10_handover_proc->proc.timer.id){
-            // MME Mobility Completion Timer expiry handler (we need this in addition to the one in the S1AP for CLR handling after TAU at source MME. */
-            s10_handover_proc->proc.proc.time_out(s10_handover_proc);
-          }
-          else {
-            OAILOG_WARNING (LOG_MME_APP, "Timer expired but no associated timer_id for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
-          }
+        for (int i = 0; i < received_message_p->ittiMsg.timer_has_expired_batch.nb_timers; i++) {
+          mme_app_handle_timer_has_expired (&received_message_p->ittiMsg.timer_has_expired_batch.timers[i]);
         }
       }
       break;
@@ -492,6 +522,7 @@ void *mme_app_thread (void *args)
     itti_free_msg_content(received_message_p);
     itti_free(ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
     received_message_p = NULL;
+    hashtable_epoch_exit ();
   }
   return NULL;
 }
@@ -545,7 +576,7 @@ int mme_app_init (const mme_config_t * mme_config_p)
   /*
    * Request for periodic timer
    */
-  if (timer_setup (mme_config_p->mme_statistic_timer, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_desc.statistic_timer_id) < 0) {
+  if (timer_setup_with_slack (mme_config_p->mme_statistic_timer, 0, MME_APP_TIMER_SLACK_MS, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_desc.statistic_timer_id) < 0) {
     OAILOG_ERROR (LOG_MME_APP, "Failed to request new timer for statistics with %ds " "of periocidity\n", mme_config_p->mme_statistic_timer);
     mme_app_desc.statistic_timer_id = 0;
   }
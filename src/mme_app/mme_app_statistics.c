@@ -56,6 +56,9 @@ int mme_app_statistics_display (
                                           mme_app_desc.nb_s1u_bearers_established_since_last_stat,mme_app_desc.nb_s1u_bearers_released_since_last_stat);
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
 
+  // ITTI queues latency/throughput and handler time per message
+  itti_print_statistics ();
+
   mme_stats_write_lock (&mme_app_desc);
 
   // resetting stats for next display
@@ -93,6 +93,11 @@ void mme_app_convert_imsi_to_imsi_mme (mme_app_imsi_t * imsi_dst, const imsi_t *
  * failed to be started)
  */
 #define MME_APP_TIMER_INACTIVE_ID   (-1)
+/*
+ * Tolerated expiry delay of the supervision timers (mobile reachability,
+ * implicit detach, statistics): their expiries are coalesced by the timer task
+ */
+#define MME_APP_TIMER_SLACK_MS      (1000)
 #define MME_APP_DELTA_T3412_REACHABILITY_TIMER 4 // in minutes
 #define MME_APP_DELTA_REACHABILITY_IMPLICIT_DETACH_TIMER 0 // in minutes
 #define MME_APP_INITIAL_CONTEXT_SETUP_RSP_TIMER_VALUE 2 // In seconds
@@ -477,6 +482,12 @@ typedef struct ue_context_s {
 } ue_context_t;
 
 
+/*
+ * The lookups in these collections take no lock (see hashtable_epoch.h).
+ * A removed ue_context_t is retired, not freed: it stays readable until every
+ * thread inside an epoch section has left it, TASK_MME_APP handles each
+ * message inside one.
+ */
 typedef struct mme_ue_context_s {
   uint32_t               nb_ue_managed;
   uint32_t               nb_ue_idle;
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
@@ -47,6 +48,8 @@
 #include "log.h"
 #include "conversions.h"
 #include "intertask_interface.h"
+#include "intertask_interface_config.h"
+#include "intertask_interface_trace.h"
 #include "common_defs.h"
 #include "mme_config.h"
 #include "spgw_config.h"
@@ -212,8 +215,15 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
+  config_pP->itti_config.sizing.nb_task_queues = 0;
+  config_pP->itti_config.sizing.nb_memory_pools = 0;
+  config_pP->itti_config.sizing.trace_file_name[0] = '\0';
+  config_pP->itti_config.sizing.trace_size = ITTI_TRACE_DEFAULT_SIZE;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
+  config_pP->sctp_config.nb_receiver_threads = SCTP_RECEIVER_THREADS;
+  config_pP->sctp_config.data_ind_buffer_size = SCTP_DATA_IND_BUFFER_SIZE;
+  config_pP->udp_config.nb_receiver_threads = UDP_RECEIVER_THREADS;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
   config_pP->mme_statistic_timer = MME_STATISTIC_TIMER_S;
 
@@ -531,6 +541,8 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE, &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+
+      itti_config_parse (setting, &config_pP->itti_config.sizing);
     }
     // S6A SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S6A_CONFIG);
@@ -580,6 +592,26 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_SCTP_OUTSTREAMS, &aint))) {
         config_pP->sctp_config.out_streams = (uint16_t) aint;
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_SCTP_RECEIVER_THREADS, &aint))) {
+        AssertFatal ((aint > 0) && (aint <= 64), "Bad number of SCTP receiver threads %d, must be in [1..64]\n", aint);
+        config_pP->sctp_config.nb_receiver_threads = (uint16_t) aint;
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_SCTP_DATA_IND_BUFFER_SIZE, &aint))) {
+        AssertFatal ((aint >= SCTP_DATA_IND_BUFFER_SIZE_MIN) && (aint <= SCTP_DATA_IND_BUFFER_SIZE_MAX), "Bad SCTP_DATA_IND buffer size %d, must be in [%d..%d]\n",
+                     aint, SCTP_DATA_IND_BUFFER_SIZE_MIN, SCTP_DATA_IND_BUFFER_SIZE_MAX);
+        config_pP->sctp_config.data_ind_buffer_size = (uint16_t) aint;
+      }
+    }
+    // UDP SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_UDP_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_UDP_RECEIVER_THREADS, &aint))) {
+        AssertFatal ((aint > 0) && (aint <= 64), "Bad number of UDP receiver threads %d, must be in [1..64]\n", aint);
+        config_pP->udp_config.nb_receiver_threads = (uint16_t) aint;
+      }
     }
     // S1AP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S1AP_CONFIG);
@@ -1056,9 +1088,22 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- ITTI:\n");
   OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (bytes)\n", config_pP->itti_config.queue_size);
   OAILOG_INFO (LOG_CONFIG, "    log file .........: %s\n", bdata(config_pP->itti_config.log_file));
+  for (j = 0; j < config_pP->itti_config.sizing.nb_task_queues; j++) {
+    OAILOG_INFO (LOG_CONFIG, "    task queue .......: %s %u messages\n", config_pP->itti_config.sizing.task_queues[j].task_name, config_pP->itti_config.sizing.task_queues[j].queue_size);
+  }
+  for (j = 0; j < config_pP->itti_config.sizing.nb_memory_pools; j++) {
+    OAILOG_INFO (LOG_CONFIG, "    memory pool ......: %u items of %u bytes\n", config_pP->itti_config.sizing.memory_pools[j].items, config_pP->itti_config.sizing.memory_pools[j].item_size);
+  }
+  if (config_pP->itti_config.sizing.trace_file_name[0]) {
+    OAILOG_INFO (LOG_CONFIG, "    trace file .......: %s %" PRIu64 " bytes\n", config_pP->itti_config.sizing.trace_file_name, config_pP->itti_config.sizing.trace_size);
+  }
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
+  OAILOG_INFO (LOG_CONFIG, "    receiver threads .: %u\n", config_pP->sctp_config.nb_receiver_threads);
+  OAILOG_INFO (LOG_CONFIG, "    DATA_IND buffer ..: %u bytes\n", config_pP->sctp_config.data_ind_buffer_size);
+  OAILOG_INFO (LOG_CONFIG, "- UDP:\n");
+  OAILOG_INFO (LOG_CONFIG, "    receiver threads .: %u\n", config_pP->udp_config.nb_receiver_threads);
   OAILOG_INFO (LOG_CONFIG, "- GUMMEIs (PLMN|MMEGI|MMEC):\n");
   for (j = 0; j < config_pP->gummei.nb; j++) {
     OAILOG_INFO (LOG_CONFIG, "            " PLMN_FMT "|%u|%u \n",
@@ -37,6 +37,7 @@
 #include "common_types.h"
 #include "bstrlib.h"
 #include "log.h"
+#include "intertask_interface_conf.h"
 
 #define MAX_GUMMEI                2
 
@@ -77,6 +78,11 @@
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
 #define MME_CONFIG_STRING_SCTP_OUTSTREAMS                "SCTP_OUTSTREAMS"
+#define MME_CONFIG_STRING_SCTP_RECEIVER_THREADS          "SCTP_RECEIVER_THREADS"
+#define MME_CONFIG_STRING_SCTP_DATA_IND_BUFFER_SIZE      "SCTP_DATA_IND_BUFFER_SIZE"
+
+#define MME_CONFIG_STRING_UDP_CONFIG                     "UDP"
+#define MME_CONFIG_STRING_UDP_RECEIVER_THREADS           "UDP_RECEIVER_THREADS"
 
 
 #define MME_CONFIG_STRING_S1AP_CONFIG                    "S1AP"
@@ -200,8 +206,14 @@ typedef struct mme_config_s {
   struct {
     uint16_t in_streams;
     uint16_t out_streams;
+    uint16_t nb_receiver_threads;
+    uint16_t data_ind_buffer_size;
   } sctp_config;
 
+  struct {
+    uint16_t nb_receiver_threads;
+  } udp_config;
+
   struct {
     uint16_t port_number;
     uint8_t  outcome_drop_timer_sec;
@@ -234,8 +246,9 @@ typedef struct mme_config_s {
   } s6a_config;
 
   struct {
-    uint32_t  queue_size;
-    bstring   log_file;
+    uint32_t      queue_size;
+    bstring       log_file;
+    itti_config_t sizing;
   } itti_config;
 
   struct {
@@ -63,6 +63,7 @@
 #include "mme_config.h"
 
 #include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
 
 #include "sctp_primitives_server.h"
 #include "udp_primitives_server.h"
@@ -157,12 +158,12 @@ main (
 #else
           NULL,
 #endif
-          NULL));
+          NULL, &mme_config.itti_config.sizing, itti_free_msg_content));
   MSC_INIT (MSC_MME, THREAD_MAX + TASK_MAX);
   CHECK_INIT_RETURN (nas_emm_init (&mme_config));
   CHECK_INIT_RETURN (nas_esm_init ());
   CHECK_INIT_RETURN (sctp_init (&mme_config));
-  CHECK_INIT_RETURN (udp_init ());
+  CHECK_INIT_RETURN (udp_init (&mme_config));
   CHECK_INIT_RETURN (s10_mme_init (&mme_config));
   CHECK_INIT_RETURN (s11_mme_init (&mme_config));
   CHECK_INIT_RETURN (s1ap_mme_init());
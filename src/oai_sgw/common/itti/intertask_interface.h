@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "intertask_interface_conf.h"
 #include "intertask_interface_types.h"
@@ -46,9 +47,8 @@
 #define ITTI_MSG_ORIGIN_NAME(mSGpTR)        itti_get_task_name(ITTI_MSG_ORIGIN_ID(mSGpTR))
 #define ITTI_MSG_DESTINATION_NAME(mSGpTR)   itti_get_task_name(ITTI_MSG_DESTINATION_ID(mSGpTR))
 
-/* Make the message number platform specific */
-typedef unsigned long message_number_t;
-#define MESSAGE_NUMBER_SIZE (sizeof(unsigned long))
+/* Returned by itti_try_send_msg_to_task when the destination queue is full */
+#define ITTI_QUEUE_FULL                     (-2)
 
 typedef enum message_priorities_e {
   MESSAGE_PRIORITY_MAX       = 100,
@@ -77,6 +77,30 @@ typedef enum task_priorities_e {
   TASK_PRIORITY_MIN       = 10,
 } task_priorities_t;
 
+/* Called when the queue depth of a task crosses its watermarks, see itti_set_queue_watermarks */
+typedef void (*itti_queue_watermark_cb_t)(task_id_t task_id, bool overloaded, uint32_t queue_depth);
+
+/* Enqueue to dequeue latency histogram: bucket 0 counts latencies below 1 us,
+ * bucket n latencies in [2^(n-1), 2^n[ us, the last bucket everything above. */
+#define ITTI_LATENCY_HISTOGRAM_BUCKETS      (20)
+
+typedef struct itti_task_statistics_s {
+  uint64_t messages_in;                                        ///< Messages enqueued for the task
+  uint64_t messages_out;                                       ///< Messages dequeued by the task
+  uint32_t queue_depth;                                        ///< Current queue depth
+  uint32_t max_queue_depth;                                    ///< Highest queue depth seen
+  uint64_t queue_full_count;                                   ///< Messages refused because the queue was full
+  uint64_t latency_total_us;                                   ///< Sum of the enqueue to dequeue latencies
+  uint64_t latency_max_us;                                     ///< Highest enqueue to dequeue latency
+  uint64_t latency_histogram[ITTI_LATENCY_HISTOGRAM_BUCKETS];
+} itti_task_statistics_t;
+
+typedef struct itti_message_statistics_s {
+  uint64_t handled;                                            ///< Messages freed by the task that received them
+  uint64_t handler_time_total_us;                              ///< Sum of the times from dequeue (or previous message handled) to free
+  uint64_t handler_time_max_us;
+} itti_message_statistics_t;
+
 typedef struct task_info_s {
   thread_id_t thread;
   task_id_t   parent_task;
@@ -86,13 +110,6 @@ typedef struct task_info_s {
   const char * const name;
 } task_info_t;
 
-/** \brief Update the itti LTE time reference for messages
- \param current seconds
- \param current micro seconds
- @returns < 0 on failure, 0 otherwise
- **/
-void itti_update_lte_time (__time_t    seconds,__suseconds_t useconds);
-
 /** \brief Send a broadcast message to every task
  \param message_p Pointer to the message to send
  @returns < 0 on failure, 0 otherwise
@@ -107,6 +124,67 @@ int itti_send_broadcast_message(MessageDef *message_p);
  **/
 int itti_send_msg_to_task(task_id_t task_id, instance_t instance, MessageDef *message);
 
+/** \brief Send a message to a task, unless the task queue is full.
+ \param task_id Task ID
+ \param instance Instance of the task used for virtualization
+ \param message Pointer to the message to send
+ @returns ITTI_QUEUE_FULL if the queue is full (the message is not freed and
+ still belongs to the caller), -1 on other failures, 0 otherwise
+ **/
+int itti_try_send_msg_to_task(task_id_t task_id, instance_t instance, MessageDef *message);
+
+/** \brief Set the queue watermarks of a task.
+ The callback is called once when the number of queued messages reaches
+ high_watermark (overloaded = true, from the sender thread) then once when it
+ falls back to low_watermark (overloaded = false, from the receiver thread).
+ It must not block.
+ \param task_id Task ID
+ \param high_watermark Number of queued messages starting the overload, 0 to disable
+ \param low_watermark Number of queued messages ending the overload
+ \param callback Function called on each transition
+ **/
+void itti_set_queue_watermarks(task_id_t task_id, uint32_t high_watermark, uint32_t low_watermark, itti_queue_watermark_cb_t callback);
+
+/** \brief Return the size of the message queue of a task.
+ **/
+uint32_t itti_get_queue_size(task_id_t task_id);
+
+/** \brief Return the number of messages currently queued for a task.
+ **/
+uint32_t itti_get_queue_depth(task_id_t task_id);
+
+/** \brief Return true if the queue of a task is above its high watermark.
+ **/
+bool itti_is_task_overloaded(task_id_t task_id);
+
+/** \brief Return the number of messages refused because the queue of a task was full.
+ **/
+uint64_t itti_get_queue_full_count(task_id_t task_id);
+
+/** \brief Return the event fd signalling counters of the thread of a task.
+ \param task_id Task ID
+ \param wakeups_signalled Number of writes performed on the task event fd
+ \param wakeups_avoided Number of writes skipped because the task was already awake
+ **/
+void itti_get_wakeup_statistics(task_id_t task_id, uint64_t *wakeups_signalled, uint64_t *wakeups_avoided);
+
+/** \brief Return a snapshot of the counters of a task, the counters are
+ * updated without locks and may be slightly inconsistent with each other.
+ \param task_id Task ID
+ \param statistics Filled with the counters of the task
+ **/
+void itti_get_task_statistics(task_id_t task_id, itti_task_statistics_t *statistics);
+
+/** \brief Return a snapshot of the handler time counters of a message id.
+ \param message_id Message ID
+ \param statistics Filled with the counters of the message id
+ **/
+void itti_get_message_statistics(MessagesIds message_id, itti_message_statistics_t *statistics);
+
+/** \brief Log the counters of all tasks and message ids that carried traffic.
+ **/
+void itti_print_statistics(void);
+
 /** \brief Add a new fd to monitor.
  * NOTE: it is up to the user to read data associated with the fd
  *  \param task_id Task ID of the receiving task
@@ -134,6 +212,16 @@ int itti_get_events(task_id_t task_id, struct epoll_event **events);
  **/
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg);
 
+/** \brief Retrieves up to max_msgs messages in the queue associated to task_id.
+ * If the queue is empty, the thread is blocked till a new message arrives.
+ * All messages signalled by one wakeup are drained without extra syscalls.
+ \param task_id Task ID of the receiving task
+ \param received_msgs Array of at least max_msgs message pointers
+ \param max_msgs Maximum number of messages to retrieve
+ @returns the number of messages stored in received_msgs
+ **/
+int itti_receive_msg_batch(task_id_t task_id, MessageDef **received_msgs, int max_msgs);
+
 /** \brief Try to retrieves a message in the queue associated to task_id.
  \param task_id Task ID of the receiving task
  \param received_msg Pointer to the allocated message
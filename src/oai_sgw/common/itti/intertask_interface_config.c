@@ -0,0 +1,114 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/** @brief Intertask Interface runtime configuration, see intertask_interface_config.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "assertions.h"
+#include "intertask_interface_config.h"
+#include "intertask_interface_trace.h"
+
+#ifdef LIBCONFIG_LONG
+#  define libconfig_int long
+#else
+#  define libconfig_int int
+#endif
+
+//------------------------------------------------------------------------------
+void
+itti_config_parse (
+  const config_setting_t * const setting,
+  itti_config_t * const itti_config)
+{
+  config_setting_t                       *subsetting = NULL;
+  config_setting_t                       *sub2setting = NULL;
+  const char                             *astring = NULL;
+  libconfig_int                           aint = 0;
+  int                                     num = 0;
+  int                                     i = 0;
+
+  // Flight recorder of the last messages
+  if (config_setting_lookup_string (setting, ITTI_CONFIG_STRING_TRACE_FILE, &astring)) {
+    AssertFatal (strlen (astring) < ITTI_CONFIG_TRACE_FILE_NAME_SIZE, "ITTI trace file name too long: %s\n", astring);
+    strcpy (itti_config->trace_file_name, astring);
+  }
+  if (config_setting_lookup_int (setting, ITTI_CONFIG_STRING_TRACE_SIZE, &aint)) {
+    AssertFatal ((aint >= ITTI_TRACE_MIN_SIZE) && ((aint & (aint - 1)) == 0),
+                 "ITTI trace size (%d) must be a power of 2 not less than %d bytes\n", (int)aint, ITTI_TRACE_MIN_SIZE);
+    itti_config->trace_size = (uint64_t) aint;
+  }
+
+  // Per task queue sizes, other tasks keep the size of tasks_def.h
+  subsetting = config_setting_get_member (setting, ITTI_CONFIG_STRING_TASK_QUEUES);
+  itti_config->nb_task_queues = 0;
+
+  if (subsetting != NULL) {
+    num = config_setting_length (subsetting);
+    AssertFatal (num <= ITTI_CONFIG_MAX_TASK_QUEUES, "Too many ITTI task queues configured (%d/%d)", num, ITTI_CONFIG_MAX_TASK_QUEUES);
+
+    for (i = 0; i < num; i++) {
+      sub2setting = config_setting_get_elem (subsetting, i);
+
+      if (sub2setting != NULL) {
+        itti_task_queue_config_t *task_queue = &itti_config->task_queues[itti_config->nb_task_queues];
+
+        AssertFatal (config_setting_lookup_string (sub2setting, ITTI_CONFIG_STRING_TASK, &astring)
+                     && (strlen (astring) < ITTI_CONFIG_TASK_NAME_SIZE), "Bad or missing ITTI task name in task queue %d", i);
+        AssertFatal (config_setting_lookup_int (sub2setting, ITTI_CONFIG_STRING_SIZE, &aint)
+                     && (aint >= ITTI_CONFIG_QUEUE_SIZE_MIN) && (aint <= ITTI_CONFIG_QUEUE_SIZE_MAX) && ((aint & (aint - 1)) == 0),
+                     "Bad or missing ITTI queue size for task %s, must be a power of 2 in [%d, %d]", astring, ITTI_CONFIG_QUEUE_SIZE_MIN, ITTI_CONFIG_QUEUE_SIZE_MAX);
+        strncpy (task_queue->task_name, astring, ITTI_CONFIG_TASK_NAME_SIZE - 1);
+        task_queue->queue_size = (uint32_t) aint;
+        itti_config->nb_task_queues += 1;
+      }
+    }
+  }
+
+  // Memory pools, replace the built-in pools if present
+  subsetting = config_setting_get_member (setting, ITTI_CONFIG_STRING_MEMORY_POOLS);
+  itti_config->nb_memory_pools = 0;
+
+  if (subsetting != NULL) {
+    num = config_setting_length (subsetting);
+    AssertFatal (num <= ITTI_CONFIG_MAX_MEMORY_POOLS, "Too many ITTI memory pools configured (%d/%d)", num, ITTI_CONFIG_MAX_MEMORY_POOLS);
+
+    for (i = 0; i < num; i++) {
+      sub2setting = config_setting_get_elem (subsetting, i);
+
+      if (sub2setting != NULL) {
+        itti_memory_pool_config_t *memory_pool = &itti_config->memory_pools[itti_config->nb_memory_pools];
+
+        AssertFatal (config_setting_lookup_int (sub2setting, ITTI_CONFIG_STRING_ITEM_SIZE, &aint) && (aint > 0),
+                     "Bad or missing ITTI memory pool item size in memory pool %d", i);
+        memory_pool->item_size = (uint32_t) aint;
+        AssertFatal (config_setting_lookup_int (sub2setting, ITTI_CONFIG_STRING_ITEMS, &aint) && (aint > 0),
+                     "Bad or missing ITTI memory pool items number in memory pool %d", i);
+        memory_pool->items = (uint32_t) aint;
+        AssertFatal ((itti_config->nb_memory_pools == 0) || (memory_pool->item_size > (memory_pool - 1)->item_size),
+                     "ITTI memory pools must be sorted by increasing item size (memory pool %d)", i);
+        itti_config->nb_memory_pools += 1;
+      }
+    }
+  }
+}
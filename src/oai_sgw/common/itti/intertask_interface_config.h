@@ -0,0 +1,51 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/** @brief Intertask Interface runtime configuration
+   Parsing of the INTERTASK_INTERFACE section shared by mme.conf and
+   spgw.conf: flight recorder, per task queue sizes and memory pools.
+*/
+
+#ifndef INTERTASK_INTERFACE_CONFIG_H_
+#define INTERTASK_INTERFACE_CONFIG_H_
+
+#include <libconfig.h>
+
+#include "intertask_interface_conf.h"
+
+#define ITTI_CONFIG_STRING_TASK_QUEUES          "TASK_QUEUES"
+#define ITTI_CONFIG_STRING_TASK                 "TASK"
+#define ITTI_CONFIG_STRING_SIZE                 "SIZE"
+#define ITTI_CONFIG_STRING_MEMORY_POOLS         "MEMORY_POOLS"
+#define ITTI_CONFIG_STRING_ITEM_SIZE            "ITEM_SIZE"
+#define ITTI_CONFIG_STRING_ITEMS                "ITEMS"
+#define ITTI_CONFIG_STRING_TRACE_FILE           "TRACE_FILE"
+#define ITTI_CONFIG_STRING_TRACE_SIZE           "TRACE_SIZE"
+
+/** \brief Read the ITTI sizing from the INTERTASK_INTERFACE setting
+ *  Settings not present keep their value in itti_config, the task queues
+ *  and memory pools are replaced. Bad values are fatal.
+ *  \param setting     INTERTASK_INTERFACE setting of the configuration file
+ *  \param itti_config ITTI sizing to fill
+ **/
+void itti_config_parse (const config_setting_t * const setting, itti_config_t * const itti_config);
+
+#endif /* INTERTASK_INTERFACE_CONFIG_H_ */
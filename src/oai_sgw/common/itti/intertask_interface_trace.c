@@ -0,0 +1,194 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/** @brief Intertask Interface flight recorder, see intertask_interface_trace.h
+   Senders reserve their record with an atomic add on the head of the ring
+   and copy the message straight into the mapped file, no lock is taken and
+   nothing is written to the file descriptor: the kernel writes the pages
+   back, also after a crash of the process.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "assertions.h"
+#include "intertask_interface.h"
+#include "intertask_interface_trace.h"
+#include "log.h"
+
+volatile int                            itti_trace_enabled = 0;
+
+static int                              itti_trace_fd = -1;
+static void                            *itti_trace_map = NULL;
+static size_t                           itti_trace_map_size = 0;
+static itti_trace_file_header_t        *itti_trace_header = NULL;
+static uint8_t                         *itti_trace_ring = NULL;
+static uint64_t                         itti_trace_ring_mask = 0;
+
+//------------------------------------------------------------------------------
+int
+itti_trace_init (
+  const char * const file_name,
+  const uint64_t ring_size,
+  const char * const messages_definition_xml)
+{
+  uint32_t                                xml_length = (messages_definition_xml) ? strlen (messages_definition_xml) + 1 : 0;
+  uint32_t                                header_size = 0;
+  struct timespec                         ts;
+  struct timeval                          tv;
+  int                                     rc = 0;
+
+  AssertFatal (file_name != NULL, "No ITTI trace file name!\n");
+  AssertFatal ((ring_size >= ITTI_TRACE_MIN_SIZE) && ((ring_size & (ring_size - 1)) == 0),
+               "ITTI trace size (%" PRIu64 ") must be a power of 2 not less than %u\n", ring_size, ITTI_TRACE_MIN_SIZE);
+  header_size = (sizeof (itti_trace_file_header_t) + xml_length + ITTI_TRACE_FILE_HEADER_ALIGN - 1) & ~(ITTI_TRACE_FILE_HEADER_ALIGN - 1);
+  itti_trace_map_size = header_size + ring_size;
+
+  itti_trace_fd = open (file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (itti_trace_fd < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Cannot open ITTI trace file %s: %s, trace disabled\n", file_name, strerror (errno));
+    return -1;
+  }
+
+  /*
+   * Allocate the blocks now: a page of a sparse file that cannot be written back would raise SIGBUS in a sender
+   */
+  if ((rc = posix_fallocate (itti_trace_fd, 0, itti_trace_map_size)) != 0) {
+    OAILOG_ERROR (LOG_ITTI, "Cannot allocate %zu bytes for ITTI trace file %s: %s, trace disabled\n", itti_trace_map_size, file_name, strerror (rc));
+    close (itti_trace_fd);
+    itti_trace_fd = -1;
+    return -1;
+  }
+
+  itti_trace_map = mmap (NULL, itti_trace_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, itti_trace_fd, 0);
+  if (MAP_FAILED == itti_trace_map) {
+    OAILOG_ERROR (LOG_ITTI, "Cannot map ITTI trace file %s: %s, trace disabled\n", file_name, strerror (errno));
+    itti_trace_map = NULL;
+    close (itti_trace_fd);
+    itti_trace_fd = -1;
+    return -1;
+  }
+
+  itti_trace_header = (itti_trace_file_header_t *) itti_trace_map;
+  itti_trace_ring = (uint8_t *) itti_trace_map + header_size;
+  itti_trace_ring_mask = ring_size - 1;
+
+  memcpy (itti_trace_header->magic, ITTI_TRACE_FILE_MAGIC, sizeof (itti_trace_header->magic));
+  itti_trace_header->version = ITTI_TRACE_FILE_VERSION;
+  itti_trace_header->header_size = header_size;
+  itti_trace_header->ring_size = ring_size;
+  itti_trace_header->head = 0;
+  gettimeofday (&tv, NULL);
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  itti_trace_header->start_realtime_us = ((uint64_t) tv.tv_sec * 1000000) + tv.tv_usec;
+  itti_trace_header->start_monotonic_us = ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+  itti_trace_header->skipped = 0;
+  if (xml_length) {
+    itti_trace_header->xml_offset = sizeof (itti_trace_file_header_t);
+    itti_trace_header->xml_length = xml_length;
+    memcpy ((uint8_t *) itti_trace_map + itti_trace_header->xml_offset, messages_definition_xml, xml_length);
+  }
+
+  __atomic_store_n (&itti_trace_enabled, 1, __ATOMIC_RELEASE);
+  OAILOG_INFO (LOG_ITTI, "ITTI trace of the last %" PRIu64 " bytes of messages in %s\n", ring_size, file_name);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void
+itti_trace_message (
+  const struct MessageDef_s * const message,
+  const uint64_t message_number)
+{
+  uint32_t                                payload_size = sizeof (MessageHeader) + message->ittiMsgHeader.ittiMsgSize;
+  uint32_t                                size = (sizeof (itti_trace_record_t) + payload_size + ITTI_TRACE_RECORD_ALIGN - 1) & ~(ITTI_TRACE_RECORD_ALIGN - 1);
+  uint64_t                                position = 0;
+  uint64_t                                offset = 0;
+  itti_trace_record_t                    *record = NULL;
+
+  if (size > (itti_trace_header->ring_size >> 3)) {
+    __sync_fetch_and_add (&itti_trace_header->skipped, 1);
+    return;
+  }
+
+  for (;;) {
+    position = __atomic_fetch_add (&itti_trace_header->head, size, __ATOMIC_RELAXED);
+    offset = position & itti_trace_ring_mask;
+    record = (itti_trace_record_t *) &itti_trace_ring[offset];
+    if ((offset + size) <= itti_trace_header->ring_size) {
+      break;
+    }
+    /*
+     * Records do not wrap: pad up to the end of the ring (sizes are multiple of 16, at least 16 bytes are left) and retry
+     */
+    __atomic_store_n (&record->commit, 0, __ATOMIC_RELAXED);
+    record->position = position;
+    __atomic_store_n (&record->commit, ITTI_TRACE_COMMIT (ITTI_TRACE_PADDING_MAGIC, itti_trace_header->ring_size - offset), __ATOMIC_RELEASE);
+  }
+
+  /*
+   * Invalidate the old record first, a sender that dies in the middle of the copy leaves an invalid record
+   */
+  __atomic_store_n (&record->commit, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+  record->position = position;
+  record->time_us = ((uint64_t) message->ittiMsgHeader.lte_time.time.tv_sec * 1000000) + message->ittiMsgHeader.lte_time.time.tv_usec;
+  record->message_number = message_number;
+  record->message_id = message->ittiMsgHeader.messageId;
+  record->origin_task_id = message->ittiMsgHeader.originTaskId;
+  record->destination_task_id = message->ittiMsgHeader.destinationTaskId;
+  record->payload_size = payload_size;
+  record->reserved = 0;
+  /*
+   * The payload is not contiguous to the header in this ITTI copy, record them back to back like the MME does
+   */
+  memcpy (&record[1], &message->ittiMsgHeader, sizeof (MessageHeader));
+  if (message->ittiMsgHeader.ittiMsgSize) {
+    memcpy ((uint8_t *) &record[1] + sizeof (MessageHeader), message->itti_msg, message->ittiMsgHeader.ittiMsgSize);
+  }
+  __atomic_store_n (&record->commit, ITTI_TRACE_COMMIT (ITTI_TRACE_RECORD_MAGIC, size), __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+void
+itti_trace_exit (
+  void)
+{
+  if (!itti_trace_enabled) {
+    return;
+  }
+  /*
+   * Senders still running keep writing in the mapping until the process exits
+   */
+  __atomic_store_n (&itti_trace_enabled, 0, __ATOMIC_RELEASE);
+  msync (itti_trace_map, itti_trace_map_size, MS_SYNC);
+  close (itti_trace_fd);
+  itti_trace_fd = -1;
+}
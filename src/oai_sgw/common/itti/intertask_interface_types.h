@@ -101,6 +101,10 @@ typedef enum {
 
 typedef uint16_t MessageHeaderSize;
 
+/* Make the message number platform specific */
+typedef unsigned long message_number_t;
+#define MESSAGE_NUMBER_SIZE (sizeof(unsigned long))
+
 typedef struct itti_lte_time_s {
   struct timeval time;
 } itti_lte_time_t;
@@ -117,7 +121,10 @@ typedef struct MessageHeader_s {
 
   MessageHeaderSize ittiMsgSize;         /**< Message size (not including header size) */
 
-  itti_lte_time_t lte_time;       /**< Reference LTE time */
+  message_number_t messageNumber; /**< Unique message number, set when the message is enqueued */
+  uint32_t   messagePriority;     /**< Message priority, set when the message is enqueued */
+
+  itti_lte_time_t lte_time;       /**< Monotonic time at which the message was enqueued (latency statistics) */
 } MessageHeader;
 
 /** @struct MessageDef
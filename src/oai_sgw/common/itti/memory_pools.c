@@ -19,6 +19,10 @@
  *      contact@openairinterface.org
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
 #include "assertions.h"
 #include "memory_pools.h"
 #include "dynamic_memory_check.h"
@@ -42,22 +46,35 @@ uint64_t                                vcd_mp_free;
 
 #define MEMORY_POOL_ITEM_INFO_NUMBER    2
 
+/* Free items cached per thread and per pool, half of a magazine is moved
+ * from/to the shared pool when it runs empty/full. Pools with few items get
+ * smaller magazines (or none) so that threads can not starve each other. */
+#define MEMORY_POOL_MAGAZINE_SIZE       32
+#define MEMORY_POOL_MAGAZINE_RATIO      64
+
 /*------------------------------------------------------------------------------*/
 typedef int32_t                         items_group_position_t;
 typedef int32_t                         items_group_index_t;
 
-typedef union items_group_positions_u {
+/*
+ * Free items are kept in a lock-free LIFO: head is the first free item and
+ * indexes[i] the free item following item i. The tag is incremented on every
+ * update of head so that a compare and swap can not succeed on a stale head
+ * (ABA) when an item is taken and given back concurrently.
+ */
+typedef union items_group_head_u {
   uint64_t                                all;
   struct {
-    items_group_position_t                  put;
-    items_group_position_t                  get;
+    items_group_index_t                     index;
+    uint32_t                                tag;
   } ind;
-} items_group_positions_t;
+} items_group_head_t;
 
 typedef struct items_group_s {
   items_group_position_t                  number_plus_one;
   volatile uint32_t                       minimum;
-  volatile items_group_positions_t        positions;
+  volatile uint32_t                       free_items;
+  volatile items_group_head_t             head;
   volatile items_group_index_t           *indexes;
 } items_group_t;
 
@@ -102,23 +119,53 @@ typedef struct memory_pool_s {
   pool_id_t                               pool_id;
   uint32_t                                item_data_number;
   uint32_t                                pool_item_size;
+  uint32_t                                magazine_size;
   items_group_t                           items_group_free;
   memory_pool_item_t                     *items;
 } memory_pool_t;
 
 
+typedef struct memory_pool_magazine_s {
+  uint32_t                                count;
+  items_group_index_t                     items[MEMORY_POOL_MAGAZINE_SIZE];
+} memory_pool_magazine_t;
+
+struct memory_pools_s;
+
+typedef struct memory_pools_thread_cache_s {
+  struct memory_pools_s                  *memory_pools;
+  struct memory_pools_thread_cache_s     *next;
+  memory_pool_magazine_t                  magazines[0];  /* One per pool */
+} memory_pools_thread_cache_t;
+
 typedef struct memory_pools_s {
   pools_start_mark_t                      start_mark;
 
   uint32_t                                pools_number;
   uint32_t                                pools_defined;
   memory_pool_t                          *pools;
+
+  /*
+   * Index of the first pool large enough for a size, indexed by size in
+   * * * memory_pool_data_t units.
+   */
+  pool_id_t                              *size_to_pool;
+
+  /*
+   * Caches of the threads that used the pools, released on thread exit
+   */
+  pthread_key_t                           thread_cache_key;
+  pthread_mutex_t                         thread_caches_mutex;
+  memory_pools_thread_cache_t            *thread_caches;
 } memory_pools_t;
 
 //------------------------------------------------------------------------------
 static const uint32_t                   MAX_POOLS_NUMBER = 20;
-static const uint32_t                   MAX_POOL_ITEMS_NUMBER = 200 * 1000;
+static const uint32_t                   MAX_POOL_ITEMS_NUMBER = 4 * 1000 * 1000;
 static const uint32_t                   MAX_POOL_ITEM_SIZE = 100 * 1000;
+#define MAX_POOL_ITEM_DATA_NUMBER       ((100 * 1000) / sizeof (memory_pool_data_t))
+
+static const pool_id_t                  POOL_ID_INVALID = 0xFF;
 
 static const pool_item_start_mark_t     POOL_ITEM_START_MARK = CHARS_TO_UINT32 ('P', 'I', 's', 't');
 static const pool_item_end_mark_t       POOL_ITEM_END_MARK = CHARS_TO_UINT32 ('p', 'i', 'E', 'N');
@@ -143,13 +190,7 @@ static inline                           uint32_t
 items_group_free_items (
   items_group_t * items_group)
 {
-  items_group_positions_t                 positions;
-  uint32_t                                free_items;
-
-  positions.all = items_group->positions.all;
-  free_items = items_group->number_plus_one + positions.ind.put - positions.ind.get;
-  free_items %= items_group->number_plus_one;
-  return free_items;
+  return items_group->free_items;
 }
 
 //------------------------------------------------------------------------------
@@ -157,63 +198,38 @@ static inline                           items_group_index_t
 items_group_get_free_item (
   items_group_t * items_group)
 {
-  items_group_position_t                  get_raw;
-  items_group_position_t                  put;
-  items_group_position_t                  get;
-  items_group_position_t                  free_items;
-  items_group_index_t                     index = ITEMS_GROUP_INDEX_INVALID;
-
-  /*
-   * Get current put position
-   */
-  put = items_group->positions.ind.put % items_group->number_plus_one;
-  /*
-   * Get current get position and increase it
-   */
-  get_raw = __sync_fetch_and_add (&items_group->positions.ind.get, 1);
-  get = get_raw % items_group->number_plus_one;
+  items_group_head_t                      head;
+  items_group_head_t                      new_head;
+  uint32_t                                free_items;
 
-  if (put == get) {
-    /*
-     * No more item free, restore previous position
-     */
-    __sync_fetch_and_sub (&items_group->positions.ind.get, 1);
-  } else {
-    /*
-     * Get index at current get position
-     */
-    index = items_group->indexes[get];
+  do {
+    head.all = items_group->head.all;
 
-    if (index <= ITEMS_GROUP_INDEX_INVALID) {
+    if (head.ind.index <= ITEMS_GROUP_INDEX_INVALID) {
       /*
-       * Index has not yet been completely freed, restore previous get position
+       * No more item free
        */
-      __sync_fetch_and_sub (&items_group->positions.ind.get, 1);
-    } else {
-      if (get_raw == items_group->number_plus_one) {
-        /*
-         * Wrap get position
-         */
-        __sync_fetch_and_sub (&items_group->positions.ind.get, items_group->number_plus_one);
-      }
+      return (ITEMS_GROUP_INDEX_INVALID);
+    }
 
-      free_items = items_group_free_items (items_group);
+    /*
+     * indexes[] of an item taken meanwhile may be stale, the tag makes the
+     * * * swap fail in that case.
+     */
+    new_head.ind.index = items_group->indexes[head.ind.index];
+    new_head.ind.tag = head.ind.tag + 1;
+  } while (!__sync_bool_compare_and_swap (&items_group->head.all, head.all, new_head.all));
 
-      /*
-       * Updates minimum free items if needed
-       */
-      while (items_group->minimum > free_items) {
-        items_group->minimum = free_items;
-      }
+  free_items = __sync_sub_and_fetch (&items_group->free_items, 1);
 
-      /*
-       * Clear index at current get position to indicate that item is free
-       */
-      items_group->indexes[get] = ITEMS_GROUP_INDEX_INVALID;
-    }
+  /*
+   * Updates minimum free items if needed
+   */
+  while (items_group->minimum > free_items) {
+    items_group->minimum = free_items;
   }
 
-  return (index);
+  return (head.ind.index);
 }
 
 //------------------------------------------------------------------------------
@@ -222,27 +238,20 @@ items_group_put_free_item (
   items_group_t * items_group,
   items_group_index_t index)
 {
-  items_group_position_t                  put_raw;
-  items_group_position_t                  put;
+  items_group_head_t                      head;
+  items_group_head_t                      new_head;
 
-  /*
-   * Get current put position and increase it
-   */
-  put_raw = __sync_fetch_and_add (&items_group->positions.ind.put, 1);
-  put = put_raw % items_group->number_plus_one;
+  AssertError ((index > ITEMS_GROUP_INDEX_INVALID) && (index < items_group->number_plus_one - 1), return (EXIT_FAILURE),
+               "Freed item index (%d) is out of range (%d)!\n", index, items_group->number_plus_one - 1);
+  new_head.ind.index = index;
 
-  if (put_raw == items_group->number_plus_one) {
-    /*
-     * Wrap position
-     */
-    __sync_fetch_and_sub (&items_group->positions.ind.put, items_group->number_plus_one);
-  }
+  do {
+    head.all = items_group->head.all;
+    items_group->indexes[index] = head.ind.index;
+    new_head.ind.tag = head.ind.tag + 1;
+  } while (!__sync_bool_compare_and_swap (&items_group->head.all, head.all, new_head.all));
 
-  AssertError (items_group->indexes[put] <= ITEMS_GROUP_INDEX_INVALID, return (EXIT_FAILURE), "Index at current put position (%d) is not marked as free (%d)!\n", put, items_group->number_plus_one);
-  /*
-   * Save freed item index at current put position
-   */
-  items_group->indexes[put] = index;
+  __sync_fetch_and_add (&items_group->free_items, 1);
   return (EXIT_SUCCESS);
 }
 
@@ -298,6 +307,158 @@ memory_pool_item_from_index (
   return (address);
 }
 
+/*------------------------------------------------------------------------------*/
+static __thread memory_pools_thread_cache_t *memory_pools_thread_cache = NULL;
+
+//------------------------------------------------------------------------------
+static void
+memory_pools_thread_cache_release (
+  void *arg)
+{
+  memory_pools_thread_cache_t            *thread_cache = (memory_pools_thread_cache_t *) arg;
+  memory_pools_t                         *memory_pools = thread_cache->memory_pools;
+  memory_pools_thread_cache_t           **previous;
+  pool_id_t                               pool;
+
+  /*
+   * Give the cached items back to the pools
+   */
+  for (pool = 0; pool < memory_pools->pools_number; pool++) {
+    while (thread_cache->magazines[pool].count > 0) {
+      thread_cache->magazines[pool].count--;
+      items_group_put_free_item (&memory_pools->pools[pool].items_group_free, thread_cache->magazines[pool].items[thread_cache->magazines[pool].count]);
+    }
+  }
+
+  pthread_mutex_lock (&memory_pools->thread_caches_mutex);
+
+  for (previous = &memory_pools->thread_caches; *previous != NULL; previous = &(*previous)->next) {
+    if (*previous == thread_cache) {
+      *previous = thread_cache->next;
+      break;
+    }
+  }
+
+  pthread_mutex_unlock (&memory_pools->thread_caches_mutex);
+  free (thread_cache);
+}
+
+//------------------------------------------------------------------------------
+static inline memory_pools_thread_cache_t *
+memory_pools_get_thread_cache (
+  memory_pools_t * memory_pools)
+{
+  memory_pools_thread_cache_t            *thread_cache = memory_pools_thread_cache;
+
+  if (thread_cache == NULL) {
+    thread_cache = calloc (1, sizeof (memory_pools_thread_cache_t) + (memory_pools->pools_number * sizeof (memory_pool_magazine_t)));
+    AssertFatal (thread_cache != NULL, "Memory pools thread cache allocation failed!\n");
+    thread_cache->memory_pools = memory_pools;
+    pthread_mutex_lock (&memory_pools->thread_caches_mutex);
+    thread_cache->next = memory_pools->thread_caches;
+    memory_pools->thread_caches = thread_cache;
+    pthread_mutex_unlock (&memory_pools->thread_caches_mutex);
+    pthread_setspecific (memory_pools->thread_cache_key, thread_cache);
+    memory_pools_thread_cache = thread_cache;
+  }
+
+  if (thread_cache->memory_pools != memory_pools) {
+    /*
+     * Only the first memory pools used by a thread are cached
+     */
+    return (NULL);
+  }
+
+  return (thread_cache);
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t
+memory_pools_cached_items (
+  memory_pools_t * memory_pools,
+  pool_id_t pool)
+{
+  memory_pools_thread_cache_t            *thread_cache;
+  uint32_t                                cached_items = 0;
+
+  pthread_mutex_lock (&memory_pools->thread_caches_mutex);
+
+  for (thread_cache = memory_pools->thread_caches; thread_cache != NULL; thread_cache = thread_cache->next) {
+    cached_items += thread_cache->magazines[pool].count;
+  }
+
+  pthread_mutex_unlock (&memory_pools->thread_caches_mutex);
+  return (cached_items);
+}
+
+//------------------------------------------------------------------------------
+static inline                           items_group_index_t
+memory_pools_get_free_item (
+  memory_pools_t * memory_pools,
+  memory_pools_thread_cache_t * thread_cache,
+  pool_id_t pool)
+{
+  memory_pool_magazine_t                 *magazine;
+  items_group_index_t                     item_index;
+
+  if ((thread_cache == NULL) || (memory_pools->pools[pool].magazine_size == 0)) {
+    return items_group_get_free_item (&memory_pools->pools[pool].items_group_free);
+  }
+
+  magazine = &thread_cache->magazines[pool];
+
+  if (magazine->count == 0) {
+    /*
+     * Refill half of the magazine from the shared pool
+     */
+    while (magazine->count < (memory_pools->pools[pool].magazine_size / 2)) {
+      item_index = items_group_get_free_item (&memory_pools->pools[pool].items_group_free);
+
+      if (item_index <= ITEMS_GROUP_INDEX_INVALID) {
+        break;
+      }
+
+      magazine->items[magazine->count++] = item_index;
+    }
+
+    if (magazine->count == 0) {
+      return (ITEMS_GROUP_INDEX_INVALID);
+    }
+  }
+
+  return (magazine->items[--magazine->count]);
+}
+
+//------------------------------------------------------------------------------
+static inline int
+memory_pools_put_free_item (
+  memory_pools_t * memory_pools,
+  memory_pools_thread_cache_t * thread_cache,
+  pool_id_t pool,
+  items_group_index_t item_index)
+{
+  memory_pool_magazine_t                 *magazine;
+  int                                     result = EXIT_SUCCESS;
+
+  if ((thread_cache == NULL) || (memory_pools->pools[pool].magazine_size == 0)) {
+    return items_group_put_free_item (&memory_pools->pools[pool].items_group_free, item_index);
+  }
+
+  magazine = &thread_cache->magazines[pool];
+
+  if (magazine->count == memory_pools->pools[pool].magazine_size) {
+    /*
+     * Give half of the magazine back to the shared pool
+     */
+    while ((magazine->count > (memory_pools->pools[pool].magazine_size / 2)) && (result == EXIT_SUCCESS)) {
+      result = items_group_put_free_item (&memory_pools->pools[pool].items_group_free, magazine->items[--magazine->count]);
+    }
+  }
+
+  magazine->items[magazine->count++] = item_index;
+  return (result);
+}
+
 //------------------------------------------------------------------------------
 memory_pools_handle_t memory_pools_create (uint32_t pools_number)
 {
@@ -317,6 +478,15 @@ memory_pools_handle_t memory_pools_create (uint32_t pools_number)
     memory_pools->start_mark = POOLS_START_MARK;
     memory_pools->pools_number = pools_number;
     memory_pools->pools_defined = 0;
+    memory_pools->thread_caches = NULL;
+    pthread_mutex_init (&memory_pools->thread_caches_mutex, NULL);
+    AssertFatal (pthread_key_create (&memory_pools->thread_cache_key, memory_pools_thread_cache_release) == 0, "Memory pools thread cache key creation failed!\n");
+    /*
+     * Allocate the size to pool lookup table, no pool defined yet
+     */
+    memory_pools->size_to_pool = malloc ((MAX_POOL_ITEM_DATA_NUMBER + 1) * sizeof (pool_id_t));
+    AssertFatal (memory_pools->size_to_pool != NULL, "Memory pools lookup table allocation failed!\n");
+    memset (memory_pools->size_to_pool, POOL_ID_INVALID, (MAX_POOL_ITEM_DATA_NUMBER + 1) * sizeof (pool_id_t));
     /*
      * Allocate pools
      */
@@ -353,23 +523,48 @@ memory_pools_statistics (
   memory_pools = memory_pools_from_handler (memory_pools_handle);
   AssertFatal (memory_pools != NULL, "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
   statistics = malloc (memory_pools->pools_defined * 200);
-  printed_chars = sprintf (&statistics[0], "Pool:   size, number, minimum,   free, address space and memory used in Kbytes\n");
+  printed_chars = sprintf (&statistics[0], "Pool:   size, number, minimum,   free, cached, address space and memory used in Kbytes\n");
 
   for (pool = 0; pool < memory_pools->pools_defined; pool++) {
     items_group = &memory_pools->pools[pool].items_group_free;
     allocated_pool_memory = items_group_number_items (items_group) * memory_pools->pools[pool].pool_item_size;
     allocated_pools_memory += allocated_pool_memory;
     pool_items_size = memory_pools->pools[pool].item_data_number * sizeof (memory_pool_data_t);
-    printed_chars += sprintf (&statistics[printed_chars], "  %2u: %6u, %6u,  %6u, %6u, [%p-%p] %6u\n",
+    printed_chars += sprintf (&statistics[printed_chars], "  %2u: %6u, %6u,  %6u, %6u, %6u, [%p-%p] %6u\n",
                               pool, pool_items_size,
                               items_group_number_items (items_group),
-                              items_group->minimum, items_group_free_items (items_group), memory_pools->pools[pool].items, ((void *)memory_pools->pools[pool].items) + allocated_pool_memory, allocated_pool_memory / (1024));
+                              items_group->minimum, items_group_free_items (items_group), memory_pools_cached_items (memory_pools, pool), memory_pools->pools[pool].items, ((void *)memory_pools->pools[pool].items) + allocated_pool_memory, allocated_pool_memory / (1024));
   }
 
   printed_chars = sprintf (&statistics[printed_chars], "Pools memory %u Kbytes\n", allocated_pools_memory / (1024));
   return (statistics);
 }
 
+//------------------------------------------------------------------------------
+uint64_t
+memory_pools_reserved_size (
+  memory_pools_handle_t memory_pools_handle)
+{
+  memory_pools_t                         *memory_pools;
+  pool_id_t                               pool;
+  uint64_t                                reserved_size = 0;
+
+  /*
+   * Recover memory_pools
+   */
+  memory_pools = memory_pools_from_handler (memory_pools_handle);
+  AssertFatal (memory_pools != NULL, "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
+
+  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+    uint64_t                                items_number = memory_pools->pools[pool].items_group_free.number_plus_one - 1;
+
+    reserved_size += items_number * memory_pools->pools[pool].pool_item_size;
+    reserved_size += memory_pools->pools[pool].items_group_free.number_plus_one * sizeof (items_group_index_t);
+  }
+
+  return (reserved_size);
+}
+
 //------------------------------------------------------------------------------
 int
 memory_pools_add_pool (
@@ -399,6 +594,11 @@ memory_pools_add_pool (
    */
   pool = memory_pools->pools_defined;
   memory_pool = &memory_pools->pools[pool];
+  /*
+   * Allocations use the first large enough pool: pools must be sorted by item size
+   */
+  AssertFatal ((pool == 0) || (memory_pools->pools[pool - 1].item_data_number * sizeof (memory_pool_data_t) < pool_item_size),
+               "Memory pool item size %u is not greater than the one of the previous pool!\n", pool_item_size);
   /*
    * Initialize pool
    */
@@ -410,9 +610,17 @@ memory_pools_add_pool (
     memory_pool->item_data_number = (pool_item_size + sizeof (memory_pool_data_t) - 1) / sizeof (memory_pool_data_t);
     memory_pool->pool_item_size = (memory_pool->item_data_number * sizeof (memory_pool_data_t)) + sizeof (memory_pool_item_t);
     memory_pool->items_group_free.number_plus_one = pool_items_number + 1;
+    memory_pool->magazine_size = pool_items_number / MEMORY_POOL_MAGAZINE_RATIO;
+
+    if (memory_pool->magazine_size > MEMORY_POOL_MAGAZINE_SIZE) {
+      memory_pool->magazine_size = MEMORY_POOL_MAGAZINE_SIZE;
+    } else if (memory_pool->magazine_size < 2) {
+      memory_pool->magazine_size = 0;
+    }
     memory_pool->items_group_free.minimum = pool_items_number;
-    memory_pool->items_group_free.positions.ind.put = pool_items_number;
-    memory_pool->items_group_free.positions.ind.get = 0;
+    memory_pool->items_group_free.free_items = pool_items_number;
+    memory_pool->items_group_free.head.ind.index = (pool_items_number > 0) ? 0 : ITEMS_GROUP_INDEX_INVALID;
+    memory_pool->items_group_free.head.ind.tag = 0;
     /*
      * Allocate free indexes
      */
@@ -423,13 +631,16 @@ memory_pools_add_pool (
      * Initialize free indexes
      */
     for (item_index = 0; item_index < pool_items_number; item_index++) {
-      memory_pool->items_group_free.indexes[item_index] = item_index;
+      memory_pool->items_group_free.indexes[item_index] = item_index + 1;
     }
 
     /*
-     * Last index is not allocated
+     * Last item has no successor, last index is not used
      */
-    memory_pool->items_group_free.indexes[item_index] = ITEMS_GROUP_INDEX_INVALID;
+    if (pool_items_number > 0) {
+      memory_pool->items_group_free.indexes[pool_items_number - 1] = ITEMS_GROUP_INDEX_INVALID;
+    }
+    memory_pool->items_group_free.indexes[pool_items_number] = ITEMS_GROUP_INDEX_INVALID;
     /*
      * Allocate items
      */
@@ -446,6 +657,14 @@ memory_pools_add_pool (
       memory_pool_item->start.item_status = ITEM_STATUS_FREE;
       memory_pool_item->data[memory_pool->item_data_number] = POOL_ITEM_END_MARK;
     }
+
+    /*
+     * Sizes above the previous pool item size and up to this one map to this pool
+     */
+    for (item_index = (pool == 0) ? 0 : memory_pools->pools[pool - 1].item_data_number + 1;
+         item_index <= memory_pool->item_data_number; item_index++) {
+      memory_pools->size_to_pool[item_index] = pool;
+    }
   }
   memory_pools->pools_defined++;
   return (0);
@@ -462,6 +681,7 @@ memory_pools_allocate (
   memory_pools_t                         *memory_pools;
   memory_pool_item_t                     *memory_pool_item;
   memory_pool_item_handle_t               memory_pool_item_handle = NULL;
+  memory_pools_thread_cache_t            *thread_cache;
   pool_id_t                               pool;
   items_group_index_t                     item_index = ITEMS_GROUP_INDEX_INVALID;
 
@@ -474,15 +694,23 @@ memory_pools_allocate (
                }
                , "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
 
-  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
-    if ((memory_pools->pools[pool].item_data_number * sizeof (memory_pool_data_t)) < item_size) {
-      /*
-       * This memory pool has too small items, skip it
-       */
-      continue;
-    }
+  /*
+   * First pool with large enough items, the following ones are used if it is exhausted
+   */
+  pool = POOL_ID_INVALID;
+
+  if (item_size <= MAX_POOL_ITEM_SIZE) {
+    pool = memory_pools->size_to_pool[(item_size + sizeof (memory_pool_data_t) - 1) / sizeof (memory_pool_data_t)];
+  }
+
+  if (pool == POOL_ID_INVALID) {
+    pool = memory_pools->pools_defined;
+  }
+
+  thread_cache = memory_pools_get_thread_cache (memory_pools);
 
-    item_index = items_group_get_free_item (&memory_pools->pools[pool].items_group_free);
+  for (; pool < memory_pools->pools_defined; pool++) {
+    item_index = memory_pools_get_free_item (memory_pools, thread_cache, pool);
 
     if (item_index <= ITEMS_GROUP_INDEX_INVALID) {
       /*
@@ -574,7 +802,7 @@ memory_pools_free (
    */
   AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_ALLOCATED, "Trying to free a non allocated (%x) memory pool item (pool %u, item %d)!\n", memory_pool_item->start.item_status, pool, item_index);
   memory_pool_item->start.item_status = ITEM_STATUS_FREE;
-  result = items_group_put_free_item (&memory_pools->pools[pool].items_group_free, item_index);
+  result = memory_pools_put_free_item (memory_pools, memory_pools_get_thread_cache (memory_pools), pool, item_index);
   AssertError (result == EXIT_SUCCESS, {
                }
                , "Failed to free memory pool item (pool %u, item %d)!\n", pool, item_index);
@@ -31,6 +31,8 @@ memory_pools_handle_t memory_pools_create (uint32_t pools_number);
 
 char *memory_pools_statistics(memory_pools_handle_t memory_pools_handle);
 
+uint64_t memory_pools_reserved_size(memory_pools_handle_t memory_pools_handle);
+
 int memory_pools_add_pool (memory_pools_handle_t memory_pools_handle, uint32_t pool_items_number, uint32_t pool_item_size);
 
 memory_pool_item_handle_t memory_pools_allocate (memory_pools_handle_t memory_pools_handle, uint32_t item_size, uint16_t info_0, uint16_t info_1);
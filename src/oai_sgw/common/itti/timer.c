@@ -19,6 +19,19 @@
  *      contact@openairinterface.org
  */
 
+
+/*
+ * Timers are kept in a hierarchical timing wheel advanced by the TASK_TIMER
+ * thread on a single timerfd: starting and removing a timer is O(1) and does
+ * not create any kernel object.
+ * The wheel has TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots, a slot
+ * of level n covering TIMER_WHEEL_SLOTS^n ticks. Timers of upper levels are
+ * cascaded to lower levels when the wheel reaches their slot.
+ * Timers started with a slack have their expiry rounded up to a multiple of
+ * the largest power of 2 ticks within the slack, so that they expire together,
+ * and are notified with one TIMER_HAS_EXPIRED_BATCH message per task.
+ */
+
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,9 +39,10 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <signal.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
 
 #include "bstrlib.h"
 
@@ -40,90 +54,457 @@
 #include "dynamic_memory_check.h"
 #include "assertions.h"
 
+#define TIMER_WHEEL_TICK_US     (10 * 1000)
+#define TIMER_WHEEL_SLOT_BITS   (6)
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK   (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS      (5)
+/* Timers further in the future are parked in the last level and cascaded again */
+#define TIMER_WHEEL_MAX_TICKS   ((1ULL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1)
 
-int                                     timer_handle_signal (
-  siginfo_t * info);
+/* Timers are allocated by chunks, never released, and found by index */
+#define TIMER_CHUNK_SIZE        (4096)
+#define TIMER_MAX_CHUNKS        (1024)
+#define TIMER_GENERATION_MASK   (0x7FFFFFFF)
+
+/* Number of expiries sent per lock of the timer list */
+#define TIMER_EXPIRY_BATCH      (256)
 
 struct timer_elm_s {
   task_id_t                               task_id;      ///< Task ID which has requested the timer
   int32_t                                 instance;     ///< Instance of the task which has requested the timer
-  timer_t                                 timer;        ///< Unique timer id
+  uint32_t                                index;        ///< Index of the element in the timer chunks
+  uint32_t                                generation;   ///< Incremented each time the element is allocated, part of the timer id
+  bool                                    in_use;       ///< Element allocated to a running timer
   timer_type_t                            type; ///< Timer type
   void                                   *timer_arg;    ///< Optional argument that will be passed when timer expires
-                                          STAILQ_ENTRY (
-  timer_elm_s)                            entries;      ///< Pointer to next element
+  uint64_t                                interval_ticks;       ///< Timer interval, used to restart periodic timers
+  uint64_t                                expiry_tick;  ///< Tick at which the timer expires, slack applied
+  uint64_t                                nominal_expiry_tick;  ///< Tick at which the timer expires without slack
+  uint64_t                                slack_ticks;  ///< Expiry rounding (power of 2), 0 if the expiry is not coalesced
+  LIST_ENTRY (timer_elm_s)                entries;      ///< Wheel slot or free list links
 };
 
+LIST_HEAD (timer_list_head, timer_elm_s);
+
+typedef struct timer_expiry_s {
+  task_id_t                               task_id;
+  int32_t                                 instance;
+  long                                    timer_id;
+  void                                   *timer_arg;
+  bool                                    coalesce;
+} timer_expiry_t;
+
 typedef struct timer_desc_s {
-  STAILQ_HEAD (
-  timer_list_head,
-  timer_elm_s) timer_queue;
+  struct timer_list_head                  wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  struct timer_list_head                  free_list;
+  struct timer_elm_s                     *chunks[TIMER_MAX_CHUNKS];
+  uint32_t                                nb_chunks;
+  uint32_t                                nb_timers;
+  uint64_t                                current_tick;
+  struct timespec                         origin;
+  int                                     timer_fd;
+  bool                                    timer_fd_armed;
   pthread_mutex_t                         timer_list_mutex;
-  struct timespec                         timeout;
 } timer_desc_t;
 
 static timer_desc_t                     timer_desc;
 
-#define TIMER_SEARCH(vAR, tIMERfIELD, tIMERvALUE, tIMERqUEUE)   \
-  do {                                                            \
-    STAILQ_FOREACH(vAR, tIMERqUEUE, entries) {                  \
-      if (((vAR)->tIMERfIELD == tIMERvALUE))                  \
-        break;                                              \
-    }                                                           \
-  } while(0)
+static inline long
+timer_elm_id (
+  const struct timer_elm_s * const timer_p)
+{
+  return (long)(((uint64_t) timer_p->generation << 32) | timer_p->index);
+}
 
-int
-timer_handle_signal (
-  siginfo_t * info)
+static uint64_t
+timer_get_current_tick (
+  void)
 {
-  struct timer_elm_s                     *timer_p;
-  MessageDef                             *message_p;
-  timer_has_expired_t                    *timer_expired_p;
-  task_id_t                               task_id;
-  int32_t                                 instance;
+  struct timespec                         now;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return ((uint64_t) (now.tv_sec - timer_desc.origin.tv_sec) * 1000000 + (now.tv_nsec - timer_desc.origin.tv_nsec) / 1000) / TIMER_WHEEL_TICK_US;
+}
+
+static void
+timer_arm_timer_fd (
+  bool arm)
+{
+  struct itimerspec                       its;
+
+  memset (&its, 0, sizeof (its));
+
+  if (arm) {
+    its.it_value.tv_nsec = TIMER_WHEEL_TICK_US * 1000;
+    its.it_interval.tv_nsec = TIMER_WHEEL_TICK_US * 1000;
+  }
+
+  AssertFatal (timerfd_settime (timer_desc.timer_fd, 0, &its, NULL) == 0, "Failed to %s timer fd: %s!\n", arm ? "arm" : "disarm", strerror (errno));
+  timer_desc.timer_fd_armed = arm;
+}
+
+static inline uint64_t
+timer_apply_slack (
+  uint64_t tick,
+  uint64_t slack_ticks)
+{
+  if (slack_ticks > 1) {
+    return (tick + slack_ticks - 1) & ~(slack_ticks - 1);
+  }
+
+  return tick;
+}
+
+/*
+ * Must be called with the timer list locked
+ */
+static void
+timer_wheel_insert (
+  struct timer_elm_s *timer_p)
+{
+  uint64_t                                delta = 0;
+  uint64_t                                slot_tick = timer_p->expiry_tick;
+  int                                     level = 0;
+
+  if (timer_p->expiry_tick > timer_desc.current_tick) {
+    delta = timer_p->expiry_tick - timer_desc.current_tick;
+  }
+
+  if (delta > TIMER_WHEEL_MAX_TICKS) {
+    delta = TIMER_WHEEL_MAX_TICKS;
+    slot_tick = timer_desc.current_tick + TIMER_WHEEL_MAX_TICKS;
+  } else if (delta == 0) {
+    /*
+     * Expired while being cascaded, fires in the current tick
+     */
+    slot_tick = timer_desc.current_tick;
+  }
+
+  while ((level < TIMER_WHEEL_LEVELS - 1) && (delta >> (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+
+  LIST_INSERT_HEAD (&timer_desc.wheel[level][(slot_tick >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK], timer_p, entries);
+}
+
+
+/*
+ * Must be called with the timer list locked
+ */
+static struct timer_elm_s *
+timer_alloc_elm (
+  void)
+{
+  struct timer_elm_s                     *timer_p = LIST_FIRST (&timer_desc.free_list);
+  struct timer_elm_s                     *chunk_p = NULL;
+  uint32_t                                i;
+
+  if (timer_p == NULL) {
+    if (timer_desc.nb_chunks == TIMER_MAX_CHUNKS) {
+      return NULL;
+    }
+
+    chunk_p = calloc (TIMER_CHUNK_SIZE, sizeof (struct timer_elm_s));
+
+    if (chunk_p == NULL) {
+      return NULL;
+    }
+
+    for (i = TIMER_CHUNK_SIZE; i > 0; i--) {
+      chunk_p[i - 1].index = (timer_desc.nb_chunks * TIMER_CHUNK_SIZE) + (i - 1);
+      LIST_INSERT_HEAD (&timer_desc.free_list, &chunk_p[i - 1], entries);
+    }
+
+    timer_desc.chunks[timer_desc.nb_chunks++] = chunk_p;
+    timer_p = LIST_FIRST (&timer_desc.free_list);
+  }
 
+  LIST_REMOVE (timer_p, entries);
   /*
-   * Get back pointer to timer list element
+   * A new generation gives a new timer id: the id of a removed or expired
+   * * * timer can not match the element when it is reused.
    */
-  timer_p = (struct timer_elm_s *)info->si_ptr;
-  // LG: To many traces for msc timer:
-  // TMR_DEBUG("Timer with id 0x%lx has expired", (long)timer_p->timer);
-  task_id = timer_p->task_id;
-  instance = timer_p->instance;
-  message_p = itti_alloc_new_message_sized (TASK_TIMER, TIMER_HAS_EXPIRED, sizeof(timer_has_expired_t));
-  timer_expired_p = TIMER_HAS_EXPIRED(message_p);
-  timer_expired_p->timer_id = (long)timer_p->timer;
-  timer_expired_p->arg = timer_p->timer_arg;
+  timer_p->generation = (timer_p->generation + 1) & TIMER_GENERATION_MASK;
+
+  if (timer_p->generation == 0) {
+    timer_p->generation = 1;
+  }
+
+  timer_p->in_use = true;
+  timer_desc.nb_timers++;
+  return timer_p;
+}
+
+/*
+ * Must be called with the timer list locked, the element out of the wheel
+ */
+static void
+timer_free_elm (
+  struct timer_elm_s *timer_p)
+{
+  timer_p->in_use = false;
+  timer_p->timer_arg = NULL;
+  LIST_INSERT_HEAD (&timer_desc.free_list, timer_p, entries);
+  timer_desc.nb_timers--;
+}
+
+/*
+ * Must be called with the timer list locked
+ */
+static struct timer_elm_s *
+timer_find_elm (
+  long timer_id)
+{
+  uint32_t                                index = (uint32_t) ((uint64_t) timer_id & 0xFFFFFFFF);
+  uint32_t                                generation = (uint32_t) ((uint64_t) timer_id >> 32);
+  struct timer_elm_s                     *timer_p = NULL;
+
+  if ((index / TIMER_CHUNK_SIZE) >= timer_desc.nb_chunks) {
+    return NULL;
+  }
+
+  timer_p = &timer_desc.chunks[index / TIMER_CHUNK_SIZE][index % TIMER_CHUNK_SIZE];
+
+  if ((!timer_p->in_use) || (timer_p->generation != generation)) {
+    return NULL;
+  }
+
+  return timer_p;
+}
+
+/*
+ * Must be called with the timer list locked
+ */
+static void
+timer_wheel_cascade (
+  int level)
+{
+  struct timer_list_head                  slot;
+  struct timer_elm_s                     *timer_p = NULL;
+  struct timer_list_head                 *slot_head = &timer_desc.wheel[level][(timer_desc.current_tick >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK];
 
   /*
-   * Timer is a one shot timer, remove it
+   * Detach the slot first, a timer may be inserted back in the same slot
    */
-  if (timer_p->type == TIMER_ONE_SHOT) {
-    //         if (timer_delete(timer_p->timer) < 0) {
-    //             TMR_DEBUG("Failed to delete timer 0x%lx", (long)timer_p->timer);
-    //         }
-    //         TMR_DEBUG("Removed timer 0x%lx", (long)timer_p->timer);
-    //         pthread_mutex_lock(&timer_desc.timer_list_mutex);
-    //         STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-    //         pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-    //         free_wrapper(timer_p);
-    //         timer_p = NULL;
-    // timer_arg saved in TIMER_HAS_EXPIRED msg
-    if (timer_remove ((long)timer_p->timer, NULL) != 0) {
-      OAILOG_DEBUG (LOG_ITTI, "Failed to delete timer 0x%lx\n", (long)timer_p->timer);
-    }
+  LIST_INIT (&slot);
+
+  while ((timer_p = LIST_FIRST (slot_head))) {
+    LIST_REMOVE (timer_p, entries);
+    LIST_INSERT_HEAD (&slot, timer_p, entries);
+  }
+
+  while ((timer_p = LIST_FIRST (&slot))) {
+    LIST_REMOVE (timer_p, entries);
+    timer_wheel_insert (timer_p);
   }
+}
 
+static void
+timer_send_message (
+  task_id_t task_id,
+  int32_t instance,
+  MessageDef * message_p)
+{
   /*
    * Notify task of timer expiry
    */
   if (itti_send_msg_to_task (task_id, instance, message_p) < 0) {
-    OAILOG_DEBUG (LOG_ITTI, "Failed to send msg TIMER_HAS_EXPIRED to task %u\n", task_id);
-    itti_free (TASK_TIMER, message_p);
-    return -1;
+    OAILOG_DEBUG (LOG_ITTI, "Failed to send msg %s to task %u\n", ITTI_MSG_NAME (message_p), task_id);
   }
+}
 
-  return 0;
+static void
+timer_send_expiries (
+  timer_expiry_t * expiries,
+  int nb_expiries)
+{
+  MessageDef                             *message_p;
+  timer_has_expired_t                    *timer_expired_p;
+  timer_has_expired_batch_t              *timer_expired_batch_p = NULL;
+  int                                     i;
+  int                                     j;
+
+  for (i = 0; i < nb_expiries; i++) {
+    if (expiries[i].coalesce) {
+      continue;
+    }
+
+    message_p = itti_alloc_new_message_sized (TASK_TIMER, TIMER_HAS_EXPIRED, sizeof(timer_has_expired_t));
+    timer_expired_p = TIMER_HAS_EXPIRED(message_p);
+    timer_expired_p->timer_id = expiries[i].timer_id;
+    timer_expired_p->arg = expiries[i].timer_arg;
+    timer_send_message (expiries[i].task_id, expiries[i].instance, message_p);
+  }
+
+  /*
+   * Gather the coalesced expiries of a task instance in batch messages, the
+   * * * expiries gathered are marked as not coalesced.
+   */
+  for (i = 0; i < nb_expiries; i++) {
+    if (!expiries[i].coalesce) {
+      continue;
+    }
+
+    message_p = NULL;
+
+    for (j = i; j < nb_expiries; j++) {
+      if ((!expiries[j].coalesce) || (expiries[j].task_id != expiries[i].task_id) || (expiries[j].instance != expiries[i].instance)) {
+        continue;
+      }
+
+      if (message_p == NULL) {
+        message_p = itti_alloc_new_message_sized (TASK_TIMER, TIMER_HAS_EXPIRED_BATCH, sizeof(timer_has_expired_batch_t));
+        timer_expired_batch_p = TIMER_HAS_EXPIRED_BATCH(message_p);
+        timer_expired_batch_p->nb_timers = 0;
+      }
+
+      timer_expired_batch_p->timers[timer_expired_batch_p->nb_timers].timer_id = expiries[j].timer_id;
+      timer_expired_batch_p->timers[timer_expired_batch_p->nb_timers].arg = expiries[j].timer_arg;
+      timer_expired_batch_p->nb_timers++;
+      expiries[j].coalesce = false;
+
+      if (timer_expired_batch_p->nb_timers == TIMER_HAS_EXPIRED_BATCH_MAX_TIMERS) {
+        timer_send_message (expiries[i].task_id, expiries[i].instance, message_p);
+        message_p = NULL;
+      }
+    }
+
+    if (message_p != NULL) {
+      timer_send_message (expiries[i].task_id, expiries[i].instance, message_p);
+    }
+  }
+}
+
+/*
+ * Advance the wheel up to the current time and notify the tasks of the
+ * * * expired timers. Called by the TASK_TIMER thread only.
+ */
+static void
+timer_handle_expiries (
+  void)
+{
+  timer_expiry_t                          expiries[TIMER_EXPIRY_BATCH];
+  int                                     nb_expiries = 0;
+  struct timer_list_head                 *slot_head = NULL;
+  struct timer_elm_s                     *timer_p = NULL;
+  uint64_t                                now_tick = timer_get_current_tick ();
+  uint64_t                                fd_expirations = 0;
+  int                                     level;
+
+  /*
+   * Reset the timer fd counter, missed ticks are caught up with the clock
+   */
+  if (read (timer_desc.timer_fd, &fd_expirations, sizeof (fd_expirations)) < 0) {
+    AssertFatal (errno == EAGAIN, "Read from timer fd failed: %s!\n", strerror (errno));
+  }
+
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
+
+  while (timer_desc.current_tick < now_tick) {
+    if (timer_desc.nb_timers == 0) {
+      timer_desc.current_tick = now_tick;
+      break;
+    }
+
+    timer_desc.current_tick++;
+
+    /*
+     * Cascade the upper levels whose slot starts at this tick, highest first
+     */
+    for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+      if (timer_desc.current_tick & ((1ULL << (TIMER_WHEEL_SLOT_BITS * level)) - 1)) {
+        break;
+      }
+    }
+
+    while (--level > 0) {
+      timer_wheel_cascade (level);
+    }
+
+    slot_head = &timer_desc.wheel[0][timer_desc.current_tick & TIMER_WHEEL_SLOT_MASK];
+
+    while ((timer_p = LIST_FIRST (slot_head))) {
+      LIST_REMOVE (timer_p, entries);
+      expiries[nb_expiries].task_id = timer_p->task_id;
+      expiries[nb_expiries].instance = timer_p->instance;
+      expiries[nb_expiries].timer_id = timer_elm_id (timer_p);
+      expiries[nb_expiries].timer_arg = timer_p->timer_arg;
+      expiries[nb_expiries].coalesce = (timer_p->slack_ticks > 0);
+      nb_expiries++;
+
+      if (timer_p->type == TIMER_PERIODIC) {
+        timer_p->nominal_expiry_tick += timer_p->interval_ticks;
+        timer_p->expiry_tick = timer_apply_slack (timer_p->nominal_expiry_tick, timer_p->slack_ticks);
+        timer_wheel_insert (timer_p);
+      } else {
+        /*
+         * Timer is a one shot timer, remove it. The timer_arg is given to
+         * * * the task in the TIMER_HAS_EXPIRED message.
+         */
+        timer_free_elm (timer_p);
+      }
+
+      if (nb_expiries == TIMER_EXPIRY_BATCH) {
+        pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+        timer_send_expiries (expiries, nb_expiries);
+        nb_expiries = 0;
+        pthread_mutex_lock (&timer_desc.timer_list_mutex);
+      }
+    }
+  }
+
+  if ((timer_desc.nb_timers == 0) && (timer_desc.timer_fd_armed)) {
+    timer_arm_timer_fd (false);
+  }
+
+  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+  timer_send_expiries (expiries, nb_expiries);
+}
+
+static void *
+timer_thread (
+  __attribute__ ((unused)) void *args)
+{
+  MessageDef                             *received_message_p = NULL;
+  struct epoll_event                     *events = NULL;
+  int                                     nb_events = 0;
+  int                                     i;
+
+  itti_subscribe_event_fd (TASK_TIMER, timer_desc.timer_fd);
+  itti_mark_task_ready (TASK_TIMER);
+
+  while (1) {
+    itti_receive_msg (TASK_TIMER, &received_message_p);
+
+    if (received_message_p != NULL) {
+      switch (ITTI_MSG_ID (received_message_p)) {
+      case TERMINATE_MESSAGE:{
+          itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+          itti_exit_task ();
+        }
+        break;
+
+      default:{
+          OAILOG_DEBUG (LOG_ITTI, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+        }
+        break;
+      }
+
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+      received_message_p = NULL;
+    }
+
+    nb_events = itti_get_events (TASK_TIMER, &events);
+
+    for (i = 0; (i < nb_events) && (events != NULL); i++) {
+      if ((events[i].data.fd == timer_desc.timer_fd) && (events[i].events & EPOLLIN)) {
+        timer_handle_expiries ();
+      }
+    }
+  }
+
+  return NULL;
 }
 
 int
@@ -136,10 +517,24 @@ timer_setup (
   void *timer_arg,
   long *timer_id)
 {
-  struct sigevent                         se;
-  struct itimerspec                       its;
+  return timer_setup_with_slack (interval_sec, interval_us, 0, task_id, instance, type, timer_arg, timer_id);
+}
+
+int
+timer_setup_with_slack (
+  uint32_t interval_sec,
+  uint32_t interval_us,
+  uint32_t slack_ms,
+  task_id_t task_id,
+  int32_t instance,
+  timer_type_t type,
+  void *timer_arg,
+  long *timer_id)
+{
   struct timer_elm_s                     *timer_p;
-  timer_t                                 timer;
+  uint64_t                                interval_ticks;
+  uint64_t                                slack_ticks = 0;
+  uint64_t                                now_tick;
 
   if (timer_id == NULL) {
     return -1;
@@ -147,86 +542,77 @@ timer_setup (
 
   AssertFatal (type < TIMER_TYPE_MAX, "Invalid timer type (%d/%d)!\n", type, TIMER_TYPE_MAX);
   /*
-   * Allocate new timer list element
+   * Round up to the wheel tick, a timer never expires early
    */
-  timer_p = malloc (sizeof (struct timer_elm_s));
+  interval_ticks = (((uint64_t) interval_sec * 1000000) + interval_us + TIMER_WHEEL_TICK_US - 1) / TIMER_WHEEL_TICK_US;
 
-  if (timer_p == NULL) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to create new timer element\n");
-    return -1;
+  if (interval_ticks == 0) {
+    interval_ticks = 1;
   }
 
-  memset (&timer, 0, sizeof (timer_t));
-  memset (&se, 0, sizeof (struct sigevent));
-  timer_p->task_id = task_id;
-  timer_p->instance = instance;
-  timer_p->type = type;
-  timer_p->timer_arg = timer_arg;
-  /*
-   * Setting up alarm
-   */
-  /*
-   * Set and enable alarm
-   */
-  se.sigev_notify = SIGEV_SIGNAL;
-  se.sigev_signo = SIGTIMER;
-  se.sigev_value.sival_ptr = timer_p;
+  if (slack_ms > 0) {
+    /*
+     * Largest power of 2 ticks within the slack, not above the interval
+     * * * for the next expiries of a periodic timer to stay in the future.
+     */
+    slack_ticks = 1;
 
-  /*
-   * At the timer creation, the timer structure will be filled in with timer_id,
-   * * * which is unique for this process. This id is allocated by kernel and the
-   * * * value might be used to distinguish timers.
-   */
-  if (timer_create (CLOCK_REALTIME, &se, &timer) < 0) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to create timer: (%s:%d)\n", strerror (errno), errno);
-    free_wrapper ((void**)&timer_p);
-    return -1;
+    while (((slack_ticks << 1) * TIMER_WHEEL_TICK_US <= (uint64_t) slack_ms * 1000) && ((slack_ticks << 1) <= interval_ticks)) {
+      slack_ticks <<= 1;
+    }
   }
 
+  now_tick = timer_get_current_tick ();
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
   /*
-   * Fill in the first expiration value.
+   * Allocate new timer list element
    */
-  its.it_value.tv_sec = interval_sec;
-  its.it_value.tv_nsec = interval_us * 1000;
+  timer_p = timer_alloc_elm ();
 
-  if (type == TIMER_PERIODIC) {
-    /*
-     * Asked for periodic timer. We set the interval time
-     */
-    its.it_interval.tv_sec = interval_sec;
-    its.it_interval.tv_nsec = interval_us * 1000;
-  } else {
+  if (timer_p == NULL) {
+    pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+    OAILOG_ERROR (LOG_ITTI, "Failed to create new timer element\n");
+    return -1;
+  }
+
+  if (timer_desc.nb_timers == 1) {
     /*
-     * Asked for one-shot timer. Do not set the interval field
+     * The wheel was empty, it did not follow the clock
      */
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
+    if (timer_desc.current_tick < now_tick) {
+      timer_desc.current_tick = now_tick;
+    }
+
+    if (!timer_desc.timer_fd_armed) {
+      timer_arm_timer_fd (true);
+    }
   }
 
-  timer_settime (timer, 0, &its, NULL);
+  timer_p->task_id = task_id;
+  timer_p->instance = instance;
+  timer_p->type = type;
+  timer_p->timer_arg = timer_arg;
+  timer_p->interval_ticks = interval_ticks;
+  timer_p->slack_ticks = slack_ticks;
+  timer_p->nominal_expiry_tick = now_tick + interval_ticks;
+  timer_p->expiry_tick = timer_apply_slack (timer_p->nominal_expiry_tick, slack_ticks);
+  timer_wheel_insert (timer_p);
   /*
    * Simply set the timer_id argument. so it can be used by caller
    */
-  *timer_id = (long)timer;
-  OAILOG_DEBUG (LOG_ITTI, "Requesting new %s timer with id 0x%lx that expires within " "%d sec and %d usec\n", type == TIMER_PERIODIC ? "periodic" : "single shot", *timer_id, interval_sec, interval_us);
-  timer_p->timer = timer;
-  /*
-   * Lock the queue and insert the timer at the tail
-   */
-  pthread_mutex_lock (&timer_desc.timer_list_mutex);
-  STAILQ_INSERT_TAIL (&timer_desc.timer_queue, timer_p, entries);
+  *timer_id = timer_elm_id (timer_p);
   pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+  OAILOG_DEBUG (LOG_ITTI, "Requesting new %s timer with id 0x%lx that expires within " "%d sec and %d usec (slack %u msec)\n", type == TIMER_PERIODIC ? "periodic" : "single shot", *timer_id, interval_sec, interval_us, slack_ms);
   return 0;
 }
 
 int timer_remove (long timer_id, void ** arg)
 {
-  int                                     rc = 0;
   struct timer_elm_s                     *timer_p;
 
   OAILOG_DEBUG (LOG_ITTI, "Removing timer 0x%lx\n", timer_id);
   pthread_mutex_lock (&timer_desc.timer_list_mutex);
-  TIMER_SEARCH (timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
+  timer_p = timer_find_elm (timer_id);
 
   /*
    * We didn't find the timer in list
@@ -238,29 +624,47 @@ int timer_remove (long timer_id, void ** arg)
     return -1;
   }
 
-  STAILQ_REMOVE (&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
-
   // let user of API get back arg that can be an allocated memory (memory leak).
 
   if (arg) *arg = timer_p->timer_arg;
-  if (timer_delete (timer_p->timer) < 0) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to delete timer 0x%lx\n", (long)timer_p->timer);
-    rc = -1;
-  }
-
-  free_wrapper ((void**)&timer_p);
-  return rc;
+  LIST_REMOVE (timer_p, entries);
+  timer_free_elm (timer_p);
+  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+  return 0;
 }
 
+
 int
 timer_init (
   void)
 {
+  int                                     level;
+  int                                     slot;
+
   OAILOG_DEBUG (LOG_ITTI, "Initializing TIMER task interface\n");
   memset (&timer_desc, 0, sizeof (timer_desc_t));
-  STAILQ_INIT (&timer_desc.timer_queue);
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+      LIST_INIT (&timer_desc.wheel[level][slot]);
+    }
+  }
+
+  LIST_INIT (&timer_desc.free_list);
   pthread_mutex_init (&timer_desc.timer_list_mutex, NULL);
+  clock_gettime (CLOCK_MONOTONIC, &timer_desc.origin);
+  timer_desc.timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+  if (timer_desc.timer_fd < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create timer fd: (%s:%d)\n", strerror (errno), errno);
+    return -1;
+  }
+
+  if (itti_create_task (TASK_TIMER, &timer_thread, NULL) < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create TIMER task: (%s:%d)\n", strerror (errno), errno);
+    return -1;
+  }
+
   OAILOG_DEBUG (LOG_ITTI, "Initializing TIMER task interface: DONE\n");
   return 0;
 }
@@ -20,3 +20,4 @@
  */
 
 MESSAGE_DEF(TIMER_HAS_EXPIRED, MESSAGE_PRIORITY_MED_PLUS)
+MESSAGE_DEF(TIMER_HAS_EXPIRED_BATCH, MESSAGE_PRIORITY_MED_PLUS)
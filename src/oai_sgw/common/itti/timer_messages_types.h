@@ -25,6 +25,7 @@
 //-------------------------------------------------------------------------------------------//
 // Defines to access message fields.
 #define TIMER_HAS_EXPIRED(mSGpTR)   ((timer_has_expired_t*)(mSGpTR)->itti_msg)
+#define TIMER_HAS_EXPIRED_BATCH(mSGpTR)   ((timer_has_expired_batch_t*)(mSGpTR)->itti_msg)
 
 //-------------------------------------------------------------------------------------------//
 typedef struct timer_has_expired_s {
@@ -32,4 +33,12 @@ typedef struct timer_has_expired_s {
   long  timer_id;
 } timer_has_expired_t;
 
+#define TIMER_HAS_EXPIRED_BATCH_MAX_TIMERS   (64)
+
+/* Expiries of timers started with a slack, coalesced per task and tick */
+typedef struct timer_has_expired_batch_s {
+  int                 nb_timers;
+  timer_has_expired_t timers[TIMER_HAS_EXPIRED_BATCH_MAX_TIMERS];
+} timer_has_expired_batch_t;
+
 #endif /* TIMER_MESSAGES_TYPES_H_ */
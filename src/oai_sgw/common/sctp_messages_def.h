@@ -32,5 +32,5 @@ MESSAGE_DEF(SCTP_INIT_MSG,          MESSAGE_PRIORITY_MED)
 MESSAGE_DEF(SCTP_DATA_REQ,          MESSAGE_PRIORITY_MED)
 MESSAGE_DEF(SCTP_DATA_IND,          MESSAGE_PRIORITY_MED)
 MESSAGE_DEF(SCTP_DATA_CNF,          MESSAGE_PRIORITY_MED)
-MESSAGE_DEF(SCTP_NEW_ASSOCIATION,   MESSAGE_PRIORITY_MAX)
-MESSAGE_DEF(SCTP_CLOSE_ASSOCIATION, MESSAGE_PRIORITY_MAX)
+MESSAGE_DEF(SCTP_NEW_ASSOCIATION,   MESSAGE_PRIORITY_MED)
+MESSAGE_DEF(SCTP_CLOSE_ASSOCIATION, MESSAGE_PRIORITY_MED)
@@ -62,6 +62,7 @@
 #include "common_types.h"
 #include "common_defs.h"
 #include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
 #include "udp_primitives_server.h"
 #include "sgw_config.h"
 #include "pgw_config.h"
@@ -95,12 +96,13 @@ main (
     exit (-EDEADLK);
   }
 
-  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL));
-  CHECK_INIT_RETURN (async_system_init());
   /*
    * Parse the command line for options and set the mme_config accordingly.
    */
   CHECK_INIT_RETURN (spgw_config_parse_opt_line (argc, argv, &spgw_config));
+  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL, &spgw_config.sgw_config.itti_config.sizing, itti_free_msg_content));
+  CHECK_INIT_RETURN (async_system_init());
+  CHECK_INIT_RETURN (spgw_config_process (&spgw_config));
   /*
    * Calling each layer init function
    */
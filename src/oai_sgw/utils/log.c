@@ -109,7 +109,6 @@ typedef struct oai_log_s {
   char                                    log_level2str[MAX_LOG_LEVEL][LOG_LEVEL_NAME_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   char                                    log_level2ansi[MAX_LOG_LEVEL][ANSI_CODE_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   int                                     log_start_time_second;                                       /*!< \brief Logging utility reference time              */
-  log_level_t                             log_level[MAX_LOG_PROTOS];                                   /*!< \brief Loglevel id of each client (protocol/layer) */
 
   log_message_number_t                    log_message_number;                                          /*!< \brief Counter of log message        */
 
@@ -117,6 +116,7 @@ typedef struct oai_log_s {
 } oai_log_t;
 
 static oai_log_t g_oai_log={0};    /*!< \brief  logging utility internal variables global var definition*/
+log_level_t     g_oai_log_level[MAX_LOG_PROTOS] = {0};    /*!< \brief Loglevel id of each client (protocol/layer) */
 
 //------------------------------------------------------------------------------
 void* log_task (__attribute__ ((unused)) void *args_p)
@@ -238,26 +238,26 @@ void log_connect_to_server(void)
 void log_set_config(const log_config_t * const config)
 {
   if (config) {
-    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log.log_level[LOG_UDP] = config->udp_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log.log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log.log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
-    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log.log_level[LOG_SCTP]     = config->sctp_log_level;
-    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log.log_level[LOG_S1AP]     = config->s1ap_log_level;
-    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log.log_level[LOG_MME_APP]  = config->mme_app_log_level;
+    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log_level[LOG_UDP] = config->udp_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
+    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log_level[LOG_SCTP]     = config->sctp_log_level;
+    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log_level[LOG_S1AP]     = config->s1ap_log_level;
+    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log_level[LOG_MME_APP]  = config->mme_app_log_level;
     if ((MAX_LOG_LEVEL > config->nas_log_level) && (MIN_LOG_LEVEL <= config->nas_log_level)) {
-      g_oai_log.log_level[LOG_NAS]      = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_EMM]  = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_ESM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS]      = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_EMM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_ESM]  = config->nas_log_level;
     }
-    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log.log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
-    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log.log_level[LOG_S11]      = config->s11_log_level;
-    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log.log_level[LOG_S6A]      = config->s6a_log_level;
-    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log.log_level[LOG_SECU]     = config->secu_log_level;
-    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log.log_level[LOG_UTIL]     = config->util_log_level;
-    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log.log_level[LOG_MSC]      = config->msc_log_level;
-    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log.log_level[LOG_ITTI]     = config->itti_log_level;
+    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
+    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log_level[LOG_S11]      = config->s11_log_level;
+    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log_level[LOG_S6A]      = config->s6a_log_level;
+    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log_level[LOG_SECU]     = config->secu_log_level;
+    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log_level[LOG_UTIL]     = config->util_log_level;
+    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log_level[LOG_MSC]      = config->msc_log_level;
+    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log_level[LOG_ITTI]     = config->itti_log_level;
     if ((MAX_LOG_LEVEL > config->async_system_log_level) && (MIN_LOG_LEVEL <= config->async_system_log_level))
-      g_oai_log.log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
+      g_oai_log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
 
     g_oai_log.is_output_fd_buffered = config->is_output_thread_safe;
     g_oai_log.is_ansi_codes = config->color;
@@ -405,7 +405,7 @@ log_init (
   snprintf (&g_oai_log.log_level2ansi[OAILOG_LEVEL_EMERGENCY][0], ANSI_CODE_MAX_LENGTH, ANSI_COLOR_FG_REV_RED);
 
   for (i=MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
-    g_oai_log.log_level[i] = default_log_levelP;
+    g_oai_log_level[i] = default_log_levelP;
   }
   // did not check return value of snprintf...
   for (i=MIN_LOG_LEVEL; i < MAX_LOG_LEVEL; i++) {
@@ -669,7 +669,7 @@ void log_message_start (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > __atomic_load_n (&g_oai_log_level[protoP], __ATOMIC_RELAXED)) {
     return;
   }
 
@@ -816,7 +816,7 @@ log_message (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > __atomic_load_n (&g_oai_log_level[protoP], __ATOMIC_RELAXED)) {
     return;
   }
   if (NULL == thread_ctxt){
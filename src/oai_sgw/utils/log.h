@@ -197,8 +197,26 @@ typedef struct log_config_s {
   bool          color;              /*!< \brief use of ANSI styling codes or no */
 } log_config_t;
 
+/*
+ * Least severe level compiled in, as a log_level_t value (0 EMERGENCY .. 6 INFO, 7 DEBUG, 8 TRACE).
+ * The OAILOG_DEBUG, OAILOG_TRACE and OAILOG_FUNC_* call sites of a less severe level are removed by the
+ * preprocessor.
+ */
+#if !defined(LOG_OAI_COMPILED_LEVEL)
+#  if TRACE_IS_ON
+#    define LOG_OAI_COMPILED_LEVEL                                      8
+#  elif DEBUG_IS_ON
+#    define LOG_OAI_COMPILED_LEVEL                                      7
+#  else
+#    define LOG_OAI_COMPILED_LEVEL                                      6
+#  endif
+#endif
+
 # if LOG_OAI
 
+/* Current level of each protocol, read without lock by OAILOG_IS_ENABLED() */
+extern log_level_t g_oai_log_level[MAX_LOG_PROTOS];
+
 void log_connect_to_server(void);
 void log_set_config(const log_config_t * const config);
 const char * log_level_int2str(const log_level_t log_level);
@@ -284,6 +302,8 @@ int log_get_start_time_sec (void);
 #    define OAILOG_INIT                                                 log_init
 #    define OAILOG_ITTI_CONNECT                                         log_itti_connect
 #    define OAILOG_EXIT()                                               log_exit()
+/*! \brief true if a message of this level and protocol would be logged, to be tested before building costly arguments or dumps */
+#    define OAILOG_IS_ENABLED(lOgLeVeL, pRoTo)                          (((lOgLeVeL) <= LOG_OAI_COMPILED_LEVEL) && ((lOgLeVeL) <= __atomic_load_n (&g_oai_log_level[pRoTo], __ATOMIC_RELAXED)))
 #    define OAILOG_SPEC(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief 3GPP trace on specifications */
 #    define OAILOG_EMERGENCY(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_EMERGENCY,pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief system is unusable */
 #    define OAILOG_ALERT(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ALERT,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief action must be taken immediately */
@@ -300,9 +320,9 @@ int log_get_start_time_sec (void);
                                                                    log_stream_hex(lOgLeVeL, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE);\
                                                                    OAI_GCC_DIAG_ON(pointer-sign); \
                                                                  } while(0); /*!< \brief trace buffer content */
-#    if DEBUG_IS_ON
+#    if LOG_OAI_COMPILED_LEVEL >= 7
 #      define OAILOG_DEBUG(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_DEBUG,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief debug informations */
-#      if TRACE_IS_ON
+#      if LOG_OAI_COMPILED_LEVEL >= 8
 #        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   do { log_message(NULL, lOgLeVeL       ,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
 #        define OAILOG_TRACE(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_TRACE,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief most detailled informations, struct dumps */
 #        define OAILOG_FUNC_IN(pRoTo)                                   do { log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
@@ -315,6 +335,7 @@ int log_get_start_time_sec (void);
 #  else
 #    define OAILOG_SPEC(...)
 #    define OAILOG_SET_CONFIG(a)
+#    define OAILOG_IS_ENABLED(...)                                      (0)
 #    define OAILOG_LEVEL_STR2INT(a)                                     OAILOG_LEVEL_EMERGENCY
 #    define OAILOG_LEVEL_INT2STR(a)                                     "EMERGENCY"
 #    define OAILOG_INIT(a,b,c)                                          0
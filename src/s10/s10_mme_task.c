@@ -168,7 +168,7 @@ s10_mme_ulp_process_stack_req_cb (
 static nw_rc_t
 s10_mme_send_udp_msg (
   nw_gtpv2c_udp_handle_t udpHandle,
-  uint8_t * buffer,
+  udp_buffer_t * buffer,
   uint32_t buffer_len,
   uint16_t localPort,
   struct in_addr *peerIpAddr,
@@ -184,9 +184,13 @@ s10_mme_send_udp_msg (
   udp_data_req_p->local_port = localPort;
   udp_data_req_p->peer_address.s_addr = peerIpAddr->s_addr;
   udp_data_req_p->peer_port = peerPort;
-  udp_data_req_p->buffer = buffer;
+  udp_data_req_p->buffer = udp_buffer_ref (buffer);
   udp_data_req_p->buffer_length = buffer_len;
+  udp_data_req_p->buffer_offset = 0;
 
+  /*
+   * On failure ITTI frees the message with its content, releasing the reference taken above
+   */
   ret = itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
   return ((ret == 0) ? NW_OK : NW_FAILURE);
 }
@@ -318,7 +322,7 @@ s10_mme_thread (
       udp_data_ind_t                         *udp_data_ind;
 
       udp_data_ind = &received_message_p->ittiMsg.udp_data_ind;
-      rc = nwGtpv2cProcessUdpReq (s10_mme_stack_handle, udp_data_ind->msgBuf, udp_data_ind->buffer_length, udp_data_ind->local_port, udp_data_ind->peer_port, &udp_data_ind->peer_address);
+      rc = nwGtpv2cProcessUdpReq (s10_mme_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->local_port, udp_data_ind->peer_port, &udp_data_ind->peer_address);
       DevAssert (rc == NW_OK);
       }
       break;
@@ -156,7 +156,7 @@ s11_mme_ulp_process_stack_req_cb (
 static nw_rc_t
 s11_mme_send_udp_msg (
   nw_gtpv2c_udp_handle_t udpHandle,
-  uint8_t * buffer,
+  udp_buffer_t * buffer,
   uint32_t buffer_len,
   uint16_t localPort,
   struct in_addr *peerIpAddr,
@@ -172,9 +172,16 @@ s11_mme_send_udp_msg (
   udp_data_req_p->local_port = localPort;
   udp_data_req_p->peer_address.s_addr = peerIpAddr->s_addr;
   udp_data_req_p->peer_port = peerPort;
-  udp_data_req_p->buffer = buffer;
+  /*
+   * The message stays in the stack (retransmission) while TASK_UDP sends it, no copy: both hold a reference
+   */
+  udp_data_req_p->buffer = udp_buffer_ref (buffer);
   udp_data_req_p->buffer_length = buffer_len;
+  udp_data_req_p->buffer_offset = 0;
 
+  /*
+   * On failure ITTI frees the message with its content, releasing the reference taken above
+   */
   ret = itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
   return ((ret == 0) ? NW_OK : NW_FAILURE);
 }
@@ -220,12 +227,20 @@ static void                            *
 s11_mme_thread (
   void *args)
 {
+  MessageDef                             *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received_messages = 0;
+  int                                     next_message = 0;
+
   itti_mark_task_ready (TASK_S11);
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_S11, &received_message_p);
+    while (next_message == nb_received_messages) {
+      nb_received_messages = itti_receive_msg_batch (TASK_S11, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+      next_message = 0;
+    }
+    received_message_p = received_messages[next_message++];
     assert (received_message_p );
 
     switch (ITTI_MSG_ID (received_message_p)) {
@@ -305,7 +320,7 @@ s11_mme_thread (
         udp_data_ind_t                         *udp_data_ind;
 
         udp_data_ind = &received_message_p->ittiMsg.udp_data_ind;
-        rc = nwGtpv2cProcessUdpReq (s11_mme_stack_handle, udp_data_ind->msgBuf, udp_data_ind->buffer_length, udp_data_ind->local_port, udp_data_ind->peer_port, &udp_data_ind->peer_address);
+        rc = nwGtpv2cProcessUdpReq (s11_mme_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->local_port, udp_data_ind->peer_port, &udp_data_ind->peer_address);
         DevAssert (rc == NW_OK);
       }
       break;
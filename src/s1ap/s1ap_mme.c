@@ -68,9 +68,13 @@
 #  define UE_LIST_OUT(x, args...)
 #endif
 
+/* Elements copied per hashtable_ts_cursor_next() call when walking the eNB and UE collections */
+#define S1AP_COLL_WALK_BATCH                   64
+
 
 bool                                    hss_associated = false;
 uint32_t                                nb_enb_associated = 0;
+bool                                    s1ap_mme_overloaded = false;
 
 hash_table_ts_t g_s1ap_enb_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
 hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains sctp association id, key is mme_ue_s1ap_id;
@@ -103,6 +107,42 @@ static int s1ap_send_init_sctp (void)
   return RETURNerror;
 }
 
+//------------------------------------------------------------------------------
+static void
+s1ap_mme_queue_watermark_cb (
+  task_id_t task_id,
+  bool overloaded,
+  uint32_t queue_depth)
+{
+  MessageDef                             *message_p = NULL;
+
+  /*
+   * Called from the thread of the sender or of the receiver of the queue,
+   * * * the eNBs are notified by the S1AP task.
+   * * * The indication only wakes S1AP up: if its queue is full the indication
+   * * * is not queued, S1AP catches up with the state of the queues after its
+   * * * next batch of messages (see s1ap_mme_update_overload).
+   */
+  message_p = itti_alloc_new_message (TASK_S1AP, S1AP_MME_OVERLOAD_IND);
+  S1AP_MME_OVERLOAD_IND (message_p).task_id = task_id;
+  S1AP_MME_OVERLOAD_IND (message_p).overloaded = overloaded;
+  S1AP_MME_OVERLOAD_IND (message_p).queue_depth = queue_depth;
+  if (itti_try_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p) == ITTI_QUEUE_FULL) {
+    itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void
+s1ap_mme_set_queue_watermarks (
+  task_id_t task_id)
+{
+  uint32_t                                queue_size = itti_get_queue_size (task_id);
+
+  itti_set_queue_watermarks (task_id, (queue_size * S1AP_OVERLOAD_HIGH_WATERMARK_PERCENT) / 100,
+      (queue_size * S1AP_OVERLOAD_LOW_WATERMARK_PERCENT) / 100, s1ap_mme_queue_watermark_cb);
+}
+
 //------------------------------------------------------------------------------
 static void
 s1ap_remove_enb (
@@ -119,11 +159,49 @@ s1ap_remove_enb (
   return;
 }
 
+//------------------------------------------------------------------------------
+static void
+s1ap_mme_handle_timer_has_expired (
+  const timer_has_expired_t * const timer_has_expired)
+{
+  ue_description_t                       *ue_ref_p = NULL;
+  if (timer_has_expired->arg != NULL) {
+    enb_s1ap_id_key_t enb_s1ap_id_key = (enb_s1ap_id_key_t)(timer_has_expired->arg);
+    enb_ue_s1ap_id_t enb_ue_s1ap_id = MME_APP_ENB_S1AP_ID_KEY2ENB_S1AP_ID(enb_s1ap_id_key);
+    uint32_t enb_id = ((enb_s1ap_id_key >> 24) & 0xFFFFFFFFFF);
+
+    /** Check if the UE still exists. */
+    ue_ref_p = s1ap_is_enb_ue_s1ap_id_in_list_per_enb(enb_ue_s1ap_id, enb_id);
+    if (!ue_ref_p) {
+      OAILOG_WARNING (LOG_S1AP, "Timer with id 0x%lx expired but no associated UE context!\n", timer_has_expired->timer_id);
+      return;
+    }
+    OAILOG_WARNING (LOG_S1AP, "Processing expired timer with id 0x%lx for ueId "MME_UE_S1AP_ID_FMT " with s1ap_ue_context_rel_timer_id 0x%lx !\n",
+  		  timer_has_expired->timer_id,
+        ue_ref_p->mme_ue_s1ap_id, ue_ref_p->s1ap_ue_context_rel_timer.id);
+    if (timer_has_expired->timer_id == ue_ref_p->s1ap_ue_context_rel_timer.id) {
+      // UE context release complete timer expiry handler
+      s1ap_mme_handle_ue_context_rel_comp_timer_expiry (ue_ref_p);
+    } else if (timer_has_expired->timer_id == ue_ref_p->s1ap_handover_completion_timer.id) {
+      s1ap_mme_handle_mme_mobility_completion_timer_expiry(ue_ref_p);
+    }
+  }
+  /* TODO - Commenting out below function as it is not used as of now.
+   * Need to handle it when we support other timers in S1AP
+   */
+
+  //s1ap_handle_timer_expiry (timer_has_expired);
+}
+
 //------------------------------------------------------------------------------
 void                                   *
 s1ap_mme_thread (
   __attribute__((unused)) void *args)
 {
+  MessageDef                             *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received_messages = 0;
+  int                                     next_message = 0;
+
   itti_mark_task_ready (TASK_S1AP);
 //  OAILOG_START_USE ();
 //  MSC_START_USE ();
@@ -135,8 +213,17 @@ s1ap_mme_thread (
      * Trying to fetch a message from the message queue.
      * * * * If the queue is empty, this function will block till a
      * * * * message is sent to the task.
+     * * * * Messages are retrieved by batch, one wakeup per batch.
      */
-    itti_receive_msg (TASK_S1AP, &received_message_p);
+    while (next_message == nb_received_messages) {
+      /*
+       * Catch up with an overload transition whose indication was not queued
+       */
+      s1ap_mme_update_overload ();
+      nb_received_messages = itti_receive_msg_batch (TASK_S1AP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+      next_message = 0;
+    }
+    received_message_p = received_messages[next_message++];
     DevAssert (received_message_p != NULL);
 
     switch (ITTI_MSG_ID (received_message_p)) {
@@ -275,6 +362,11 @@ s1ap_mme_thread (
       }
       break;
 
+      case S1AP_MME_OVERLOAD_IND: {
+        s1ap_handle_mme_overload_ind(&S1AP_MME_OVERLOAD_IND (received_message_p));
+      }
+      break;
+
       case MME_APP_S1AP_MME_UE_ID_NOTIFICATION:{
         s1ap_handle_mme_ue_id_notification (&MME_APP_S1AP_MME_UE_ID_NOTIFICATION (received_message_p));
       }
@@ -286,33 +378,14 @@ s1ap_mme_thread (
       break;
 
       case TIMER_HAS_EXPIRED:{
-        ue_description_t                       *ue_ref_p = NULL;
-        if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
-          enb_s1ap_id_key_t enb_s1ap_id_key = (enb_s1ap_id_key_t)(received_message_p->ittiMsg.timer_has_expired.arg);
-          enb_ue_s1ap_id_t enb_ue_s1ap_id = MME_APP_ENB_S1AP_ID_KEY2ENB_S1AP_ID(enb_s1ap_id_key);
-          uint32_t enb_id = ((enb_s1ap_id_key >> 24) & 0xFFFFFFFFFF);
-
-          /** Check if the UE still exists. */
-          ue_ref_p = s1ap_is_enb_ue_s1ap_id_in_list_per_enb(enb_ue_s1ap_id, enb_id);
-          if (!ue_ref_p) {
-            OAILOG_WARNING (LOG_S1AP, "Timer with id 0x%lx expired but no associated UE context!\n", received_message_p->ittiMsg.timer_has_expired.timer_id);
-            break;
-          }
-          OAILOG_WARNING (LOG_S1AP, "Processing expired timer with id 0x%lx for ueId "MME_UE_S1AP_ID_FMT " with s1ap_ue_context_rel_timer_id 0x%lx !\n",
-        		  received_message_p->ittiMsg.timer_has_expired.timer_id,
-              ue_ref_p->mme_ue_s1ap_id, ue_ref_p->s1ap_ue_context_rel_timer.id);
-          if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_ref_p->s1ap_ue_context_rel_timer.id) {
-            // UE context release complete timer expiry handler
-            s1ap_mme_handle_ue_context_rel_comp_timer_expiry (ue_ref_p);
-          } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_ref_p->s1ap_handover_completion_timer.id) {
-            s1ap_mme_handle_mme_mobility_completion_timer_expiry(ue_ref_p);
-          }
-        }
-        /* TODO - Commenting out below function as it is not used as of now.
-         * Need to handle it when we support other timers in S1AP
-         */
+        s1ap_mme_handle_timer_has_expired (&received_message_p->ittiMsg.timer_has_expired);
+      }
+      break;
 
-        //s1ap_handle_timer_expiry (&received_message_p->ittiMsg.timer_has_expired);
+      case TIMER_HAS_EXPIRED_BATCH:{
+        for (int i = 0; i < received_message_p->ittiMsg.timer_has_expired_batch.nb_timers; i++) {
+          s1ap_mme_handle_timer_has_expired (&received_message_p->ittiMsg.timer_has_expired_batch.timers[i]);
+        }
       }
       break;
 
@@ -380,6 +453,14 @@ s1ap_mme_init(void)
     return RETURNerror;
   }
 
+  /*
+   * Backpressure: the eNBs are asked to reduce the signalling load when the
+   * * * tasks processing it are falling behind.
+   */
+  s1ap_mme_set_queue_watermarks (TASK_MME_APP);
+  s1ap_mme_set_queue_watermarks (TASK_NAS_EMM);
+  s1ap_mme_set_queue_watermarks (TASK_NAS_ESM);
+
   OAILOG_DEBUG (LOG_S1AP, "Initializing S1AP interface: DONE, but not reachable yet (wait for MME<->HSS CER procedure)\n");
   return RETURNok;
 }
@@ -492,20 +573,6 @@ bool s1ap_enb_compare_by_enb_id_cb (__attribute__((unused)) const hash_key_t key
   return false;
 }
 
-//------------------------------------------------------------------------------
-bool s1ap_enb_compare_by_tac_cb (__attribute__((unused)) const hash_key_t keyP,
-                                    void * const elementP,
-                                    void * parameterP, void **resultP)
-{
-  const tac_t                  * const tac_p = (const tac_t*const)parameterP;
-  enb_description_t                      *enb_ref  = (enb_description_t*)elementP;
-  if ( *tac_p == enb_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_consecutive_tacs.tac) {
-    *resultP = elementP;
-    return true;
-  }
-  return false;
-}
-
 //------------------------------------------------------------------------------
 enb_description_t                      *
 s1ap_is_enb_id_in_list (
@@ -523,20 +590,25 @@ void s1ap_is_tac_in_list (
   int *num_enbs,
   enb_description_t ** enbs)
 {
-  enb_description_t                      *enb_ref = NULL;
-  tac_t                                  *tac_p   = (tac_t*)&tac;
-
-  /** Collect all eNBs for the given TAC. */
-  hashtable_element_array_t              ea;
-//  enb_description_t *			         enb_p_elements[mme_config.max_enbs];
-  memset(&ea, 0, sizeof(hashtable_element_array_t));
-//  memset(&enb_p_elements, 0, (sizeof(enb_description_t*) * mme_config.max_enbs));
-  ea.elements = enbs;
-
-  hashtable_ts_apply_list_callback_on_elements((hash_table_ts_t * const)&g_s1ap_enb_coll, s1ap_enb_compare_by_tac_cb, (void *)tac_p, &ea);
-  OAILOG_DEBUG(LOG_S1AP, "Found %d matching enb references based on the received tac " TAC_FMT ". \n", ea.num_elements, tac);
-  *num_enbs = ea.num_elements;
-//  *enbs = enb_p_elements;
+  enb_description_t                      *enb_refs[S1AP_COLL_WALK_BATCH];
+  hashtable_ts_cursor_t                   cursor;
+  int                                     n = 0;
+  int                                     i = 0;
+
+  /** Collect all eNBs for the given TAC, enbs holds mme_config.max_enbs references. */
+  *num_enbs = 0;
+  if (hashtable_ts_cursor_open (&g_s1ap_enb_coll, &cursor) != HASH_TABLE_OK) {
+    return;
+  }
+  while ((n = hashtable_ts_cursor_next (&g_s1ap_enb_coll, &cursor, NULL, (void **)enb_refs, S1AP_COLL_WALK_BATCH)) > 0) {
+    for (i = 0; (i < n) && (*num_enbs < mme_config.max_enbs); i++) {
+      if (tac == enb_refs[i]->tai_list.partial_tai_list[0].u.tai_one_plmn_consecutive_tacs.tac) {
+        enbs[(*num_enbs)++] = enb_refs[i];
+      }
+    }
+  }
+  hashtable_ts_cursor_close (&g_s1ap_enb_coll, &cursor);
+  OAILOG_DEBUG(LOG_S1AP, "Found %d matching enb references based on the received tac " TAC_FMT ". \n", *num_enbs, tac);
 }
 
 //------------------------------------------------------------------------------
@@ -590,32 +662,35 @@ s1ap_is_enb_ue_s1ap_id_in_list_per_enb (
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_mme_ue_id_cb (__attribute__((unused)) const hash_key_t keyP,
-                                      void * const elementP, void * parameterP, void **resultP)
-{
-  mme_ue_s1ap_id_t                      * mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t*)parameterP;
-  ue_description_t                       *ue_ref           = (ue_description_t*)elementP;
-  if ( *mme_ue_s1ap_id_p == ue_ref->mme_ue_s1ap_id ) {
-    *resultP = elementP;
-    OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", ue_ref, ue_ref->mme_ue_s1ap_id);
-    return true;
-  }
-  return false;
-}
-
-//------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_mme_ue_id_cb (__attribute__((unused))const hash_key_t keyP,
-                                       void * const elementP, void * parameterP, void **resultP)
+/*
+   Walk the UEs of an eNB in batches, the walk stops at the first match.
+*/
+static ue_description_t *s1ap_enb_find_ue_by_mme_ue_id (
+  enb_description_t * const enb_ref,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
-  enb_description_t                      *enb_ref = (enb_description_t*)elementP;
+  ue_description_t                       *ue_refs[S1AP_COLL_WALK_BATCH];
+  ue_description_t                       *ue_ref = NULL;
+  hashtable_ts_cursor_t                   cursor;
+  int                                     n = 0;
+  int                                     i = 0;
 
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&enb_ref->ue_coll, s1ap_ue_compare_by_mme_ue_id_cb, parameterP, resultP);
-  if (*resultP) {
-    OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", *resultP, ((ue_description_t*)(*resultP))->mme_ue_s1ap_id);
-    return true;
+  if (hashtable_ts_cursor_open (&enb_ref->ue_coll, &cursor) != HASH_TABLE_OK) {
+    return NULL;
   }
-  return false;
+  while ((!ue_ref) && ((n = hashtable_ts_cursor_next (&enb_ref->ue_coll, &cursor, NULL, (void **)ue_refs, S1AP_COLL_WALK_BATCH)) > 0)) {
+    for (i = 0; i < n; i++) {
+      if (mme_ue_s1ap_id == ue_refs[i]->mme_ue_s1ap_id) {
+        ue_ref = ue_refs[i];
+        OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", ue_ref, ue_ref->mme_ue_s1ap_id);
+        break;
+      }
+    }
+  }
+  hashtable_ts_cursor_close (&enb_ref->ue_coll, &cursor);
+  return ue_ref;
 }
+
 //------------------------------------------------------------------------------
 bool s1ap_ue_compare_by_s11_sgw_teid_cb (__attribute__((unused))const hash_key_t keyP,
                                          void * const elementP,
@@ -649,9 +724,31 @@ s1ap_is_ue_mme_id_in_list (
   const mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
   ue_description_t                       *ue_ref = NULL;
-  mme_ue_s1ap_id_t                       *mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t*)&mme_ue_s1ap_id;
+  enb_description_t                      *enb_ref = NULL;
+  enb_description_t                      *enb_refs[S1AP_COLL_WALK_BATCH];
+  hashtable_ts_cursor_t                   cursor;
+  void                                   *id = NULL;
+  int                                     n = 0;
+  int                                     i = 0;
+
+  /*
+   * Try the eNB the UE was last associated with first
+   */
+  if ((hashtable_ts_get (&g_s1ap_mme_id2assoc_id_coll, (const hash_key_t)mme_ue_s1ap_id, &id) == HASH_TABLE_OK)
+      && (enb_ref = s1ap_is_enb_assoc_id_in_list ((sctp_assoc_id_t)(uintptr_t)id))
+      && (ue_ref = s1ap_enb_find_ue_by_mme_ue_id (enb_ref, mme_ue_s1ap_id))) {
+    return ue_ref;
+  }
 
-  hashtable_ts_apply_callback_on_elements(&g_s1ap_enb_coll, s1ap_enb_find_ue_by_mme_ue_id_cb, (void*)mme_ue_s1ap_id_p, (void**)&ue_ref);
+  if (hashtable_ts_cursor_open (&g_s1ap_enb_coll, &cursor) != HASH_TABLE_OK) {
+    return NULL;
+  }
+  while ((!ue_ref) && ((n = hashtable_ts_cursor_next (&g_s1ap_enb_coll, &cursor, NULL, (void **)enb_refs, S1AP_COLL_WALK_BATCH)) > 0)) {
+    for (i = 0; (i < n) && (!ue_ref); i++) {
+      ue_ref = s1ap_enb_find_ue_by_mme_ue_id (enb_refs[i], mme_ue_s1ap_id);
+    }
+  }
+  hashtable_ts_cursor_close (&g_s1ap_enb_coll, &cursor);
 //  OAILOG_TRACE(LOG_S1AP, "Return ue_ref %p \n", ue_ref);
   return ue_ref;
 }
@@ -683,6 +780,7 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
     ue_description_t   *ue_ref = s1ap_is_ue_enb_id_in_list (enb_ref,enb_ue_s1ap_id);
     if (ue_ref) {
       ue_ref->mme_ue_s1ap_id = mme_ue_s1ap_id;
+      ue_ref->sctp_stream_send = s1ap_mme_ue_sctp_stream (enb_ref, mme_ue_s1ap_id);
       hashtable_rc_t  h_rc = hashtable_ts_insert (&g_s1ap_mme_id2assoc_id_coll, (const hash_key_t) mme_ue_s1ap_id, (void *)(uintptr_t)sctp_assoc_id);
       OAILOG_DEBUG(LOG_S1AP, "Associated  sctp_assoc_id %d, enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT ", mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ":%s \n",
           sctp_assoc_id, enb_ue_s1ap_id, mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
@@ -698,6 +796,18 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
   OAILOG_DEBUG(LOG_S1AP, "Could not find  eNB with sctp_assoc_id %d \n", sctp_assoc_id);
 }
 
+//------------------------------------------------------------------------------
+sctp_stream_id_t
+s1ap_mme_ue_sctp_stream (
+  const enb_description_t * const enb_ref,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  if ((enb_ref->outstreams <= 1) || (INVALID_MME_UE_S1AP_ID == mme_ue_s1ap_id)) {
+    return 0;
+  }
+  return (sctp_stream_id_t) (1 + (mme_ue_s1ap_id % (enb_ref->outstreams - 1)));
+}
+
 //------------------------------------------------------------------------------
 enb_description_t *s1ap_new_enb (void)
 {
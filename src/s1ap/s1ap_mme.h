@@ -40,9 +40,17 @@
 struct enb_description_s;
 
 #define S1AP_TIMER_INACTIVE_ID   (-1)
+/* Tolerated expiry delay of the UE context release complete timer */
+#define S1AP_TIMER_SLACK_MS      (100)
 #define S1AP_UE_CONTEXT_REL_COMP_TIMER 1 // in seconds
 #define S1AP_HANDOVER_COMPLETION_TIMER 2 // in seconds
 
+/* Overload Start is sent to the eNBs when the queue of MME_APP, NAS_EMM or NAS_ESM
+ * reaches this percentage of its size, Overload Stop once all of them are back
+ * to the low watermark. */
+#define S1AP_OVERLOAD_HIGH_WATERMARK_PERCENT 75
+#define S1AP_OVERLOAD_LOW_WATERMARK_PERCENT  50
+
 /* Timer structure */
 struct s1ap_timer_t {
   long id;           /* The timer identifier                 */
@@ -81,6 +89,7 @@ typedef struct ue_description_s {
    *  During an UE S1 connection, a pair of streams is
    *  allocated and is used during all the connection.
    *  Stream 0 is reserved for non UE signalling.
+   *  The send stream is set by s1ap_mme_ue_sctp_stream() once the MME UE S1AP ID is known.
    *  @name sctp stream identifier
    **/
   /*@{*/
@@ -123,7 +132,6 @@ typedef struct enb_description_s {
   /** SCTP stuff **/
   /*@{*/
   sctp_assoc_id_t  sctp_assoc_id;    ///< SCTP association id on this machine
-  sctp_stream_id_t next_sctp_stream; ///< Next SCTP stream
   sctp_stream_id_t instreams;        ///< Number of streams avalaible on eNB -> MME
   sctp_stream_id_t outstreams;       ///< Number of streams avalaible on MME -> eNB
   /*@}*/
@@ -131,6 +139,7 @@ typedef struct enb_description_s {
 
 extern bool             hss_associated;
 extern uint32_t         nb_enb_associated;
+extern bool             s1ap_mme_overloaded;
 extern struct mme_config_s    *global_mme_config_p;
 
 /** \brief S1AP layer top init
@@ -150,6 +159,7 @@ enb_description_t* s1ap_is_enb_id_in_list(const uint32_t enb_id);
 
 /** \brief Look for given TAC in the list.
  * \param tac TAC is not uniqueue and used for the search in the list.
+ * \param enbs Filled with up to mme_config.max_enbs matching eNBs, their number is returned in num_enbs.
  * @returns All matched eNBs in the enb_list.
  **/
 void s1ap_is_tac_in_list (
@@ -195,6 +205,16 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
  **/
 enb_description_t* s1ap_new_enb(void);
 
+/** \brief SCTP stream of the UE associated signalling sent to an eNB.
+ * The UEs are spread by MME UE S1AP ID over the streams 1 to outstreams - 1,
+ * stream 0 is left to the non UE associated signalling (and used when the eNB
+ * negotiated a single stream or the MME UE S1AP ID is not yet allocated).
+ * \param enb_ref eNB the message is sent to
+ * \param mme_ue_s1ap_id MME UE S1AP ID of the UE
+ * @returns the SCTP stream
+ **/
+sctp_stream_id_t s1ap_mme_ue_sctp_stream(const enb_description_t * const enb_ref, const mme_ue_s1ap_id_t mme_ue_s1ap_id);
+
 /** \brief Allocate and add to the right eNB list a new UE descriptor
  * \param sctp_assoc_id association ID over SCTP
  * \param enb_ue_s1ap_id ue ID over S1AP
@@ -241,9 +261,6 @@ void s1ap_dump_ue(const ue_description_t * const ue_ref);
 bool s1ap_enb_compare_by_enb_id_cb (const hash_key_t keyP,
                                     void * const elementP, void * parameterP, void __attribute__((unused)) **unused_resultP);
 
-bool s1ap_enb_compare_by_tac_cb (const hash_key_t keyP,
-                                    void * const elementP, void * parameterP, void __attribute__((unused)) **unused_resultP);
-
 void
 s1ap_set_tai (enb_description_t * enb_ref, S1ap_SupportedTAs_t * ta_list);
 
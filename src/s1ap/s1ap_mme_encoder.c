@@ -81,6 +81,16 @@ static inline int                       s1ap_mme_encode_paging(
   uint8_t ** buffer,
   uint32_t * length);
 
+static inline int                       s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+
+static inline int                       s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+
 static inline int                       s1ap_mme_encode_initiating (
   s1ap_message * message_p,
   MessagesIds *message_id,
@@ -216,6 +226,10 @@ int s1ap_free_mme_encode_pdu(
     return free_s1ap_mmestatustransfer(&message->msg.s1ap_MMEStatusTransferIEs);
   case S1AP_PAGING_LOG:
     return free_s1ap_paging(&message->msg.s1ap_PagingIEs);
+  case S1AP_OVERLOAD_START_LOG:
+    return free_s1ap_overloadstart(&message->msg.s1ap_OverloadStartIEs);
+  case S1AP_OVERLOAD_STOP_LOG:
+    return free_s1ap_overloadstop(&message->msg.s1ap_OverloadStopIEs);
   case S1AP_PATH_SWITCH_ACK_LOG:
     return free_s1ap_pathswitchrequestacknowledge(&message->msg.s1ap_PathSwitchRequestAcknowledgeIEs);
   case S1AP_HANDOVER_COMMAND_LOG:
@@ -281,6 +295,14 @@ s1ap_mme_encode_initiating (
     *message_id = S1AP_PAGING_LOG;
     return s1ap_mme_encode_paging(message_p, buffer, length);
 
+  case S1ap_ProcedureCode_id_OverloadStart:
+    *message_id = S1AP_OVERLOAD_START_LOG;
+    return s1ap_mme_encode_overload_start (message_p, buffer, length);
+
+  case S1ap_ProcedureCode_id_OverloadStop:
+    *message_id = S1AP_OVERLOAD_STOP_LOG;
+    return s1ap_mme_encode_overload_stop (message_p, buffer, length);
+
   default:
     OAILOG_NOTICE (LOG_S1AP, "Unknown procedure ID (%d) for initiating message_p\n", (int)message_p->procedureCode);
     break;
@@ -678,3 +700,47 @@ s1ap_mme_encode_paging(
 
   return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_Paging, message_p->criticality, &asn_DEF_S1ap_E_RABSetupRequest, paging_p);
 }
+
+//------------------------------------------------------------------------------
+static inline int
+s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStart_t                    overloadStart;
+  S1ap_OverloadStart_t                   *overloadStart_p = &overloadStart;
+
+  memset (overloadStart_p, 0, sizeof (S1ap_OverloadStart_t));
+
+  /*
+   * Convert IE structure into asn1 message_p
+   */
+  if (s1ap_encode_s1ap_overloadstarties (overloadStart_p, &message_p->msg.s1ap_OverloadStartIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStart, S1ap_Criticality_ignore, &asn_DEF_S1ap_OverloadStart, overloadStart_p);
+}
+
+//------------------------------------------------------------------------------
+static inline int
+s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStop_t                     overloadStop;
+  S1ap_OverloadStop_t                    *overloadStop_p = &overloadStop;
+
+  memset (overloadStop_p, 0, sizeof (S1ap_OverloadStop_t));
+
+  /*
+   * Convert IE structure into asn1 message_p
+   */
+  if (s1ap_encode_s1ap_overloadstopies (overloadStop_p, &message_p->msg.s1ap_OverloadStopIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStop, S1ap_Criticality_ignore, &asn_DEF_S1ap_OverloadStop, overloadStop_p);
+}
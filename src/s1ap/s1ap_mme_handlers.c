@@ -71,6 +71,9 @@ static int                              s1ap_send_path_switch_request_failure (
     const mme_ue_s1ap_id_t mme_ue_s1ap_id,
     const enb_ue_s1ap_id_t enb_ue_s1ap_id);
 
+static int                              s1ap_mme_generate_overload (
+    enb_description_t * enb_ref, bool overload_start);
+
 //Forward declaration
 struct s1ap_message_s;
 
@@ -531,6 +534,13 @@ s1ap_generate_s1_setup_response (
   free(buffer);
   s1ap_free_mme_encode_pdu(&message, message_id);
   rc = s1ap_mme_itti_send_sctp_request (&b, enb_association->sctp_assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+
+  if ((rc == RETURNok) && (enc_rval >= 0) && (s1ap_mme_overloaded)) {
+    /*
+     * The MME is already overloaded, tell the new eNB too
+     */
+    s1ap_mme_generate_overload (enb_association, true);
+  }
   OAILOG_FUNC_RETURN (LOG_S1AP, rc);
 }
 
@@ -892,7 +902,7 @@ s1ap_mme_generate_ue_context_release_command (
   free(buffer);
   s1ap_free_mme_encode_pdu(&message, message_id);
 
-  rc = s1ap_mme_itti_send_sctp_request (&b, enb_ref_p->sctp_assoc_id, (ue_ref_p) ? ue_ref_p->sctp_stream_send : enb_ref_p->next_sctp_stream, mme_ue_s1ap_id);
+  rc = s1ap_mme_itti_send_sctp_request (&b, enb_ref_p->sctp_assoc_id, (ue_ref_p) ? ue_ref_p->sctp_stream_send : s1ap_mme_ue_sctp_stream (enb_ref_p, mme_ue_s1ap_id), mme_ue_s1ap_id);
   if(ue_ref_p){
     ue_ref_p->s1_release_cause = cause;
 
@@ -908,7 +918,7 @@ s1ap_mme_generate_ue_context_release_command (
       // Start timer to track UE context release complete from eNB
       enb_s1ap_id_key_t enb_ue_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
       MME_APP_ENB_S1AP_ID_KEY(enb_ue_s1ap_id_key, enb_ref_p->enb_id, ue_ref_p->enb_ue_s1ap_id);
-      if (timer_setup (ue_ref_p->s1ap_ue_context_rel_timer.sec, 0,
+      if (timer_setup_with_slack (ue_ref_p->s1ap_ue_context_rel_timer.sec, 0, S1AP_TIMER_SLACK_MS,
           TASK_S1AP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void*)enb_ue_s1ap_id_key, &(ue_ref_p->s1ap_ue_context_rel_timer.id)) < 0) {
         OAILOG_ERROR (LOG_S1AP, "Failed to start UE context release complete timer for UE id %d \n", ue_ref_p->mme_ue_s1ap_id);
         ue_ref_p->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
@@ -1141,6 +1151,7 @@ s1ap_mme_handle_path_switch_request (
   S1ap_PathSwitchRequestIEs_t            *pathSwitchRequest_p = NULL;
   S1ap_E_RABToBeSwitchedDLItemIEs_t      *eRABToBeSwitchedDlItemIEs_p = NULL;
 
+  enb_description_t                      *enb_ref_p = NULL;
   ue_description_t                       *ue_ref_p = NULL;
   enb_ue_s1ap_id_t                        enb_ue_s1ap_id = 0;
   mme_ue_s1ap_id_t                        mme_ue_s1ap_id = 0;
@@ -1171,6 +1182,14 @@ s1ap_mme_handle_path_switch_request (
   mme_ue_s1ap_id = pathSwitchRequest_p->sourceMME_UE_S1AP_ID;
   OAILOG_DEBUG (LOG_S1AP, "Path Switch Request message received from eNB UE S1AP ID: " ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
 
+  /*
+   * The request comes from the target eNB, the UE context still refers to the source eNB
+   */
+  if ((enb_ref_p = s1ap_is_enb_assoc_id_in_list (assoc_id)) == NULL) {
+    OAILOG_ERROR (LOG_S1AP, "Ignoring Path Switch Request from unknown assoc %u\n", assoc_id);
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  }
+
   if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id)) == NULL) {
     /*
      * The MME UE S1AP ID provided by eNB doesn't point to any valid UE.
@@ -1209,7 +1228,7 @@ s1ap_mme_handle_path_switch_request (
 
     // On which stream we received the message
     ue_ref_p->sctp_stream_recv = stream;
-    ue_ref_p->sctp_stream_send = ue_ref_p->enb->next_sctp_stream;
+    ue_ref_p->sctp_stream_send = s1ap_mme_ue_sctp_stream (enb_ref_p, mme_ue_s1ap_id);
     // CGI mandatory IE
     DevAssert (pathSwitchRequest_p->eutran_cgi.pLMNidentity.size == 3);
     TBCD_TO_PLMN_T(&pathSwitchRequest_p->eutran_cgi.pLMNidentity, &ecgi.plmn);
@@ -1217,24 +1236,8 @@ s1ap_mme_handle_path_switch_request (
     /** Set the ENB Id. */
     ecgi.cell_identity.enb_id = ue_ref_p->enb->enb_id;
 
-    /*
-     * Increment the sctp stream for the eNB association.
-     * If the next sctp stream is >= instream negociated between eNB and MME, wrap to first stream.
-     * TODO: search for the first available stream instead.
-     */
-
-    /*
-     * TODO task#15456359.
-     * Below logic seems to be incorrect , revisit it.
-     */
-    ue_ref_p->enb->next_sctp_stream += 1;
-    if (ue_ref_p->enb->next_sctp_stream >= ue_ref_p->enb->instreams) {
-      ue_ref_p->enb->next_sctp_stream = 1;
-    }
-
-    /** Set the new association and the new stream. */
+    /** Set the new association. */
     ue_ref_p->enb->sctp_assoc_id = assoc_id;
-    ue_ref_p->enb->next_sctp_stream = stream;
 
     // set the new enb ue id
     ue_ref_p->enb_ue_s1ap_id = enb_ue_s1ap_id;
@@ -1768,27 +1771,8 @@ s1ap_mme_handle_handover_resource_allocation_response(const sctp_assoc_id_t asso
 
   // On which stream we received the message
   ue_ref_p->sctp_stream_recv = stream;
-  /**
-   * todo: Lionel: this (if no run condition occurs= should be the same stream where we sent the HANDOVER_REQUEST... might not be if run-condition occurs!
-   */
-  ue_ref_p->sctp_stream_send = ue_ref_p->enb->next_sctp_stream;
-
-  /*
-   * Increment the sctp stream for the eNB association.
-   * If the next sctp stream is >= instream negociated between eNB and MME, wrap to first stream.
-   * TODO: search for the first available stream instead.
-   */
-
-  /*
-   * TODO task#15456359.
-   * Below logic seems to be incorrect , revisit it.
-   *
-   * todo: always setting to 0 might work?!
-   */
-  ue_ref_p->enb->next_sctp_stream += 1;
-  if (ue_ref_p->enb->next_sctp_stream >= ue_ref_p->enb->instreams) {
-    ue_ref_p->enb->next_sctp_stream = 1;
-  }
+  // Same stream as the HANDOVER_REQUEST sent to this eNB
+  ue_ref_p->sctp_stream_send = s1ap_mme_ue_sctp_stream (ue_ref_p->enb, mme_ue_s1ap_id);
   s1ap_dump_enb (ue_ref_p->enb);
   /** UE Reference will be in IDLE state. */
 
@@ -2193,11 +2177,6 @@ s1ap_handle_new_association (
    */
   enb_association->instreams = sctp_new_peer_p->instreams;
   enb_association->outstreams = sctp_new_peer_p->outstreams;
-  /*
-   * initialize the next sctp stream to 1 as 0 is reserved for non
-   * * * * ue associated signalling.
-   */
-  enb_association->next_sctp_stream = 1;
   enb_association->s1_state = S1AP_INIT;
   MSC_LOG_EVENT (MSC_S1AP_MME, "0 Event SCTP_NEW_ASSOCIATION assoc_id: %d", enb_association->sctp_assoc_id);
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
@@ -2801,3 +2780,103 @@ s1ap_handle_enb_initiated_reset_ack (
   s1ap_free_mme_encode_pdu(&message, message_id);
   OAILOG_FUNC_RETURN (LOG_S1AP, rc);
 }
+
+//------------------------------------------------------------------------------
+static int
+s1ap_mme_generate_overload (
+  enb_description_t * enb_ref,
+  bool overload_start)
+{
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  s1ap_message                            message = {0};
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  int                                     rc = RETURNok;
+
+  OAILOG_FUNC_IN (LOG_S1AP);
+  DevAssert (enb_ref != NULL);
+
+  if (overload_start) {
+    /*
+     * Reject new non-emergency mobile originated data transfers, keep the
+     * * * mobile terminated services and the UEs already connected.
+     */
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStart;
+    message.msg.s1ap_OverloadStartIEs.overloadResponse.present = S1ap_OverloadResponse_PR_overloadAction;
+    message.msg.s1ap_OverloadStartIEs.overloadResponse.choice.overloadAction = S1ap_OverloadAction_reject_non_emergency_mo_dt;
+  } else {
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStop;
+    message.msg.s1ap_OverloadStopIEs.presenceMask = 0;
+  }
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+
+  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer, &length) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Overload %s encoding failed for eNB %u\n", overload_start ? "Start" : "Stop", enb_ref->enb_id);
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  }
+
+  OAILOG_NOTICE (LOG_S1AP, "Send S1AP Overload %s to eNB %u (assoc_id %u)\n", overload_start ? "Start" : "Stop", enb_ref->enb_id, enb_ref->sctp_assoc_id);
+  MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_S1AP_ENB, NULL, 0, "0 Overload%s assoc_id %u", overload_start ? "Start" : "Stop", enb_ref->sctp_assoc_id);
+  /*
+   * Non-UE signalling -> stream 0
+   */
+  bstring b = blk2bstr(buffer, length);
+  free(buffer);
+  s1ap_free_mme_encode_pdu(&message, message_id);
+  rc = s1ap_mme_itti_send_sctp_request (&b, enb_ref->sctp_assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+  OAILOG_FUNC_RETURN (LOG_S1AP, rc);
+}
+
+//------------------------------------------------------------------------------
+static bool s1ap_send_overload_cb (
+    __attribute__((unused)) const hash_key_t keyP,
+    void * const dataP,
+    void *argP,
+    __attribute__((unused)) void ** resultP)
+{
+  enb_description_t                      *enb_ref = (enb_description_t*)dataP;
+  bool                                   *overload_start = (bool*)argP;
+
+  if ((enb_ref) && (enb_ref->s1_state == S1AP_READY)) {
+    s1ap_mme_generate_overload (enb_ref, *overload_start);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+int
+s1ap_handle_mme_overload_ind (
+  const itti_s1ap_mme_overload_ind_t * const overload_ind_p)
+{
+  OAILOG_FUNC_IN (LOG_S1AP);
+  DevAssert (overload_ind_p != NULL);
+  OAILOG_WARNING (LOG_S1AP, "Queue of task %s %s (%u messages)\n", itti_get_task_name (overload_ind_p->task_id),
+      overload_ind_p->overloaded ? "reached its high watermark" : "is back to its low watermark", overload_ind_p->queue_depth);
+  /*
+   * Indications may be received out of order, rely on the current state of
+   * * * the queues rather than on the indication itself.
+   */
+  OAILOG_FUNC_RETURN (LOG_S1AP, s1ap_mme_update_overload ());
+}
+
+//------------------------------------------------------------------------------
+int
+s1ap_mme_update_overload (
+  void)
+{
+  bool                                    overloaded = false;
+
+  /*
+   * Polled once per batch of messages, no function trace here.
+   */
+  overloaded = itti_is_task_overloaded (TASK_MME_APP) || itti_is_task_overloaded (TASK_NAS_EMM) || itti_is_task_overloaded (TASK_NAS_ESM);
+
+  if (overloaded == s1ap_mme_overloaded) {
+    return RETURNok;
+  }
+
+  s1ap_mme_overloaded = overloaded;
+  OAILOG_WARNING (LOG_S1AP, "MME overload %s, notifying %u eNBs\n", overloaded ? "started" : "stopped", nb_enb_associated);
+  hashtable_ts_apply_callback_on_elements (&g_s1ap_enb_coll, s1ap_send_overload_cb, (void *)&overloaded, NULL);
+  return RETURNok;
+}
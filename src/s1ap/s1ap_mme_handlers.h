@@ -112,6 +112,22 @@ int s1ap_mme_handle_erab_release_indication (
 
 int s1ap_handle_enb_initiated_reset_ack (const itti_s1ap_enb_initiated_reset_ack_t * const enb_reset_ack_p);
 
+/** \brief Handle a watermark crossing of the queue of a task serving S1AP.
+ * S1AP Overload Start is sent to all the eNBs when one of the queues is
+ * overloaded, Overload Stop when none of them is overloaded anymore.
+ * \param overload_ind_p Indication sent by the ITTI watermark callback
+ * @returns int
+ **/
+int s1ap_handle_mme_overload_ind (const itti_s1ap_mme_overload_ind_t * const overload_ind_p);
+
+/** \brief Compare the state of the queues of the tasks serving S1AP with the
+ * state last notified to the eNBs, send S1AP Overload Start/Stop if it changed.
+ * Called on every S1AP_MME_OVERLOAD_IND and after every batch of messages, so
+ * a transition is never lost when its indication could not be queued.
+ * @returns int
+ **/
+int s1ap_mme_update_overload (void);
+
 int s1ap_mme_handle_error_ind_message (const sctp_assoc_id_t assoc_id,
                                        const sctp_stream_id_t stream, struct s1ap_message_s *message);
 
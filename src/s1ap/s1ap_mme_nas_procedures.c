@@ -132,17 +132,8 @@ s1ap_mme_handle_initial_ue_message (
 
     // On which stream we received the message
     ue_ref->sctp_stream_recv = stream;
-    ue_ref->sctp_stream_send = ue_ref->enb->next_sctp_stream;
-
-    /*
-     * Increment the sctp stream for the eNB association.
-     * If the next sctp stream is >= instream negociated between eNB and MME, wrap to first stream.
-     * TODO: search for the first available stream instead.
-     */
-    ue_ref->enb->next_sctp_stream += 1;
-    if (ue_ref->enb->next_sctp_stream >= ue_ref->enb->instreams) {
-      ue_ref->enb->next_sctp_stream = 1;
-    }
+    // Stream 0 until NAS allocates the MME_UE_S1AP_ID, see s1ap_notified_new_ue_mme_s1ap_id_association
+    ue_ref->sctp_stream_send = s1ap_mme_ue_sctp_stream (ue_ref->enb, ue_ref->mme_ue_s1ap_id);
 
     /** MME_UE_S1AP_ID will be set in MME_APP layer. */
 
@@ -1305,8 +1296,8 @@ s1ap_handle_handover_cancel_acknowledge (
   bstring b = blk2bstr(buffer_p, length);
   free(buffer_p);
   s1ap_free_mme_encode_pdu(&message, message_id);
-  // todo: the next_sctp_stream is the one without incrementation?
-  s1ap_mme_itti_send_sctp_request (&b, source_enb_ref->sctp_assoc_id, source_enb_ref->next_sctp_stream, handover_cancel_acknowledge_pP->mme_ue_s1ap_id);
+  s1ap_mme_itti_send_sctp_request (&b, source_enb_ref->sctp_assoc_id, s1ap_mme_ue_sctp_stream (source_enb_ref, handover_cancel_acknowledge_pP->mme_ue_s1ap_id),
+      handover_cancel_acknowledge_pP->mme_ue_s1ap_id);
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 
@@ -1537,8 +1528,7 @@ s1ap_handle_handover_request (
                       (mme_ue_s1ap_id_t)handoverRequest_p->mme_ue_s1ap_id);
   bstring b = blk2bstr(buffer_p, length);
   free(buffer_p);
-  // todo: the next_sctp_stream is the one without incrementation?
-  s1ap_mme_itti_send_sctp_request (&b, target_enb_ref->sctp_assoc_id, target_enb_ref->next_sctp_stream, handover_request_pP->ue_id);
+  s1ap_mme_itti_send_sctp_request (&b, target_enb_ref->sctp_assoc_id, s1ap_mme_ue_sctp_stream (target_enb_ref, handover_request_pP->ue_id), handover_request_pP->ue_id);
   s1ap_free_mme_encode_pdu(&message, message_id);
 
   /*
@@ -1897,7 +1887,8 @@ s1ap_handle_paging( const itti_s1ap_paging_t * const s1ap_paging_pP){
 		  bstring b = blk2bstr(buffer_p, length);
 		  free(buffer_p);
 		  s1ap_free_mme_encode_pdu(&message, message_id);
-		  s1ap_mme_itti_send_sctp_request (&b, eNB_ref->sctp_assoc_id, eNB_ref->next_sctp_stream, s1ap_paging_pP->mme_ue_s1ap_id);
+		  // Paging is non UE associated signalling
+		  s1ap_mme_itti_send_sctp_request (&b, eNB_ref->sctp_assoc_id, 0, s1ap_paging_pP->mme_ue_s1ap_id);
 	  }
   }
 
@@ -252,3 +252,55 @@ int sctp_get_localaddresses (
 
   return 0;
 }
+
+//------------------------------------------------------------------------------
+int sctp_recvmsg_nonblocking (
+  int sd,
+  void *msg,
+  size_t len,
+  struct sockaddr *from,
+  socklen_t * fromlen,
+  struct sctp_sndrcvinfo *sinfo,
+  int *msg_flags)
+{
+  struct iovec                            iov = {0};
+  struct msghdr                           inmsg = {0};
+  struct cmsghdr                         *cmsg = NULL;
+  char                                    incmsg[CMSG_SPACE (sizeof (struct sctp_sndrcvinfo))];
+  int                                     n = 0;
+
+  /*
+   * Same as libsctp sctp_recvmsg(), which does not take recvmsg() flags
+   */
+  iov.iov_base = msg;
+  iov.iov_len = len;
+  inmsg.msg_name = from;
+  inmsg.msg_namelen = (fromlen) ? *fromlen : 0;
+  inmsg.msg_iov = &iov;
+  inmsg.msg_iovlen = 1;
+  inmsg.msg_control = incmsg;
+  inmsg.msg_controllen = sizeof (incmsg);
+
+  if ((n = recvmsg (sd, &inmsg, (msg_flags) ? *msg_flags | MSG_DONTWAIT : MSG_DONTWAIT)) < 0) {
+    return n;
+  }
+
+  if (fromlen) {
+    *fromlen = inmsg.msg_namelen;
+  }
+
+  if (msg_flags) {
+    *msg_flags = inmsg.msg_flags;
+  }
+
+  if (sinfo) {
+    for (cmsg = CMSG_FIRSTHDR (&inmsg); cmsg != NULL; cmsg = CMSG_NXTHDR (&inmsg, cmsg)) {
+      if ((IPPROTO_SCTP == cmsg->cmsg_level) && (SCTP_SNDRCV == cmsg->cmsg_type)) {
+        memcpy (sinfo, CMSG_DATA (cmsg), sizeof (struct sctp_sndrcvinfo));
+        break;
+      }
+    }
+  }
+
+  return n;
+}
@@ -45,4 +45,8 @@ int sctp_get_peeraddresses(int sock, struct sockaddr **remote_addr,
 int sctp_get_localaddresses(int sock, struct sockaddr **local_addr,
                             int *nb_local_addresses);
 
+/* sctp_recvmsg() that does not block on a blocking socket (MSG_DONTWAIT), errno is EAGAIN if there is nothing to read */
+int sctp_recvmsg_nonblocking(int sd, void *msg, size_t len, struct sockaddr *from, socklen_t *fromlen,
+                             struct sctp_sndrcvinfo *sinfo, int *msg_flags);
+
 #endif /* FILE_SCTP_COMMON_SEEN */
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sctp_eNB_defs.h
+ *  \brief Association descriptor of the SCTP client side (eNB simulators and tests)
+ *  @ingroup _sctp
+ */
+
+#ifndef FILE_SCTP_ENB_DEFS_SEEN
+#define FILE_SCTP_ENB_DEFS_SEEN
+
+#include <stdint.h>
+#include <sys/queue.h>
+#include <sys/socket.h>
+
+#include "common_types.h"
+
+/* A message received by sctp_run(), queued until the user reads it */
+typedef struct sctp_queue_item_s {
+  sctp_assoc_id_t                         assoc_id;
+  sctp_stream_id_t                        local_stream;
+  uint16_t                                remote_port;
+  uint32_t                                remote_addr;
+  uint32_t                                ppid;
+
+  uint32_t                                length;
+  uint8_t                                *buffer;   ///< Owned by the item
+
+  TAILQ_ENTRY (sctp_queue_item_s)         entry;
+} sctp_queue_item_t;
+
+typedef struct sctp_data_s {
+  int                                     sd;
+  sctp_assoc_id_t                         assoc_id;
+  sctp_stream_id_t                        instreams;
+  sctp_stream_id_t                        outstreams;
+  uint16_t                                remote_port;
+
+  struct sockaddr                        *remote_ip_addresses;
+  int                                     nb_remote_addresses;
+
+  TAILQ_HEAD (sctp_queue_s, sctp_queue_item_s) sctp_queue;
+  uint32_t                                queue_length;     ///< Number of messages in sctp_queue
+  uint32_t                                queue_size;       ///< Bytes in sctp_queue
+} sctp_data_t;
+
+#endif /* FILE_SCTP_ENB_DEFS_SEEN */
@@ -94,6 +94,47 @@ int sctp_itti_send_new_message_ind(
   return RETURNerror;
 }
 
+//------------------------------------------------------------------------------
+MessageDef *sctp_itti_alloc_new_message_ind_in_place(
+    const uint32_t         buffer_size,
+    uint8_t ** const       buffer)
+{
+  MessageDef                             *message_p = NULL;
+  void                                   *message_buffer = NULL;
+
+  /*
+   * The header of the payload bstring comes first in the buffer
+   */
+  message_p = itti_alloc_new_message_with_buffer (TASK_SCTP, SCTP_DATA_IND, sizeof (struct tagbstring) + buffer_size, &message_buffer);
+  *buffer = (uint8_t *) message_buffer + sizeof (struct tagbstring);
+  return message_p;
+}
+
+//------------------------------------------------------------------------------
+int sctp_itti_send_new_message_ind_in_place(
+    STOLEN_REF MessageDef *message_p,
+    const uint32_t         length,
+    const sctp_assoc_id_t  assoc_id,
+    const sctp_stream_id_t stream,
+    const sctp_stream_id_t instreams,
+    const sctp_stream_id_t outstreams)
+{
+  struct tagbstring                      *payload = (struct tagbstring *)((uint8_t *) message_p + ITTI_MSG_BUFFER_OFFSET (sizeof (sctp_data_ind_t)));
+
+  /*
+   * Write protected: bdestroy() of the payload does not free it, itti_free() of the message does.
+   * The size of the message only covers the received bytes, for the ITTI dump and trace.
+   */
+  btfromblk (*payload, (uint8_t *) & payload[1], length);
+  message_p->ittiMsgHeader.ittiMsgSize = ITTI_MSG_BUFFER_OFFSET (sizeof (sctp_data_ind_t)) - sizeof (MessageHeader) + sizeof (struct tagbstring) + length;
+  SCTP_DATA_IND (message_p).payload    = payload;
+  SCTP_DATA_IND (message_p).stream     = stream;
+  SCTP_DATA_IND (message_p).assoc_id   = assoc_id;
+  SCTP_DATA_IND (message_p).instreams  = instreams;
+  SCTP_DATA_IND (message_p).outstreams = outstreams;
+  return itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
+}
+
 //------------------------------------------------------------------------------
 int
 sctp_itti_send_com_down_ind (
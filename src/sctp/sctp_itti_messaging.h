@@ -48,6 +48,20 @@ int sctp_itti_send_new_message_ind(
     const sctp_stream_id_t instreams,
     const sctp_stream_id_t outstreams);
 
+/* SCTP_DATA_IND followed by a buffer the PDU is received in, the payload
+   of the message points to it and is freed with the message */
+MessageDef *sctp_itti_alloc_new_message_ind_in_place(
+    const uint32_t         buffer_size,
+    uint8_t ** const       buffer);
+
+int sctp_itti_send_new_message_ind_in_place(
+    STOLEN_REF MessageDef *message_p,
+    const uint32_t         length,
+    const sctp_assoc_id_t  assoc_id,
+    const sctp_stream_id_t stream,
+    const sctp_stream_id_t instreams,
+    const sctp_stream_id_t outstreams);
+
 int sctp_itti_send_com_down_ind(const sctp_assoc_id_t assoc_id);
 
 #endif /* FILE_SCTP_ITTI_MESSAGING_SEEN */
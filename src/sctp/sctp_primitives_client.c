@@ -44,8 +44,8 @@
 int
 sctp_send_msg (
   sctp_data_t * sctp_data_p,
-  constuint16_t ppid,
-  constsctp_stream_id_t stream,
+  const uint16_t ppid,
+  const sctp_stream_id_t stream,
   const uint8_t * buffer,
   const size_t length)
 {
@@ -182,7 +182,7 @@ sctp_connect_to_remote_host (
   char *local_ip_addr[],
   int nb_local_addr,
   char *remote_ip_addr,
-  constuint16_t port,
+  const uint16_t port,
   int socket_type,
   sctp_data_t * sctp_data_p)
 {
@@ -28,14 +28,18 @@
     @ingroup _sctp
 */
 
+#define _GNU_SOURCE
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netinet/in.h>
 #include <netinet/sctp.h>
 #include <arpa/inet.h>
@@ -47,6 +51,7 @@
 #include "assertions.h"
 #include "log.h"
 #include "msc.h"
+#include "hashtable.h"
 #include "intertask_interface.h"
 #include "itti_free_defined_msg.h"
 #include "sctp_primitives_server.h"
@@ -58,6 +63,12 @@
 #define SCTP_RC_ERROR       -1
 #define SCTP_RC_NORMAL_READ  0
 #define SCTP_RC_DISCONNECT   1
+#define SCTP_RC_NO_DATA      2
+
+typedef struct sctp_send_pdu_s {
+  bstring                                 payload;
+  sctp_stream_id_t                        stream;
+} sctp_send_pdu_t;
 
 typedef struct sctp_association_s {
   struct sctp_association_s              *next_assoc;   ///< Next association in the list
@@ -67,33 +78,74 @@ typedef struct sctp_association_s {
   uint16_t                                instreams;    ///< Number of input streams negociated for this connection
   uint16_t                                outstreams;   ///< Number of output strams negotiated for this connection
   sctp_assoc_id_t                         assoc_id;     ///< SCTP association id for the connection
-  uint32_t                                messages_recv;        ///< Number of messages received on this connection
-  uint32_t                                messages_sent;        ///< Number of messages sent on this connection
+  // The received counters are written by the receiver thread of the association, the sent ones with send_lock held
+  uint64_t                                messages_recv;        ///< Number of messages received on this connection
+  uint64_t                                messages_sent;        ///< Number of messages sent on this connection
+  uint64_t                                bytes_recv;   ///< Payload bytes received on this connection
+  uint64_t                                bytes_sent;   ///< Payload bytes sent on this connection
+  time_t                                  last_activity;        ///< Time of the last message received or sent
+  uint64_t                               *stream_messages_recv; ///< Messages received on each of the instreams
+  uint64_t                               *stream_messages_sent; ///< Messages sent on each of the outstreams
+  bstring                                 partial_payload;      ///< Beginning of a PDU bigger than the SCTP_DATA_IND buffer, completed by the next reads
+
+  // Send queue, a ring of PDUs flushed by TASK_SCTP and, when the socket was full, by the receiver thread on EPOLLOUT
+  pthread_mutex_t                         send_lock;
+  sctp_send_pdu_t                        *send_queue;
+  uint32_t                                send_queue_size;      ///< Capacity of the ring, power of 2, grows up to SCTP_SEND_QUEUE_MAX_SIZE
+  uint32_t                                send_queue_head;      ///< Free running index of the next PDU to send
+  uint32_t                                send_queue_tail;      ///< Free running index of the next PDU queued
+  uint32_t                                send_queue_max_depth;
+  uint64_t                                send_queue_drops;     ///< PDUs dropped, queue full or send error
+  uint64_t                                send_batches; ///< sendmmsg() calls
+  bool                                    epollout;     ///< EPOLLOUT is armed, the socket was full
+  int                                     epoll_fd;     ///< epoll instance of the receiver thread of the association
 
   struct sockaddr                        *peer_addresses;       ///< A list of peer addresses
   int                                     nb_peer_addresses;
 } sctp_association_t;
 
+struct sctp_listener_s;
+
+/* A receiver thread waits with its own epoll instance (edge triggered) on a share of the
+   associations of a listener, the first receiver of a listener also accepts the connections. */
+typedef struct sctp_receiver_s {
+  pthread_t                               thread;
+  int                                     epoll_fd;
+  struct sctp_listener_s                 *listener;
+  volatile uint32_t                       nb_sockets;   ///< Number of associations served by this thread
+  // Next SCTP_DATA_IND, the socket is read in its buffer. Kept when the read returns no PDU.
+  MessageDef                             *data_ind;
+  uint8_t                                *data_ind_buffer;
+} sctp_receiver_t;
+
+typedef struct sctp_listener_s {
+  struct sctp_listener_s                 *next_listener;
+  int                                     sd;   ///< Listening socket descriptor
+  uint32_t                                ppid; ///< Payload protocol Identifier
+  uint16_t                                nb_receivers;
+  sctp_receiver_t                         receivers[];
+} sctp_listener_t;
+
 typedef struct sctp_descriptor_s {
   // List of connected peers
   struct sctp_association_s              *available_connections_head;
   struct sctp_association_s              *available_connections_tail;
+  // Same associations indexed by assoc_id and by socket descriptor
+  hash_table_t                           *associations;
+  hash_table_t                           *sd_associations;
+  // Written by the receiver threads when associations come and go, read by all the others
+  pthread_rwlock_t                        lock;
 
   uint32_t                                number_of_connections;
   uint16_t                                nb_instreams;
   uint16_t                                nb_outstreams;
+  uint16_t                                nb_receiver_threads;
+  uint16_t                                data_ind_buffer_size;
+  struct sctp_listener_s                 *listeners;
 } sctp_descriptor_t;
 
-typedef struct sctp_arg_s {
-  int                                     sd;
-  uint32_t                                ppid;
-} sctp_arg_t;
-
 static struct sctp_descriptor_s         sctp_desc;
 
-// Thread used to handle sctp messages
-static pthread_t                        assoc_thread;
-
 // LOCAL FUNCTIONS prototypes
 void                                   *sctp_receiver_thread (void *args_p);
 static int sctp_send_msg (
@@ -103,13 +155,13 @@ static int sctp_send_msg (
 
 // Association list related local functions prototypes
 static struct sctp_association_s       *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id);
-static struct sctp_association_s       *sctp_add_new_peer (void);
+static struct sctp_association_s       *sctp_add_new_peer (sctp_assoc_id_t assoc_id, int sd);
 static int                              sctp_handle_com_down (sctp_assoc_id_t assoc_id);
 static void                             sctp_dump_list (void);
 static void sctp_exit (void);
 
 //------------------------------------------------------------------------------
-static struct sctp_association_s *sctp_add_new_peer (void)
+static struct sctp_association_s *sctp_add_new_peer (sctp_assoc_id_t assoc_id, int sd)
 {
   struct sctp_association_s              *new_sctp_descriptor = calloc (1, sizeof (struct sctp_association_s));
 
@@ -120,6 +172,22 @@ static struct sctp_association_s *sctp_add_new_peer (void)
 
   new_sctp_descriptor->next_assoc = NULL;
   new_sctp_descriptor->previous_assoc = NULL;
+  new_sctp_descriptor->assoc_id = assoc_id;
+  new_sctp_descriptor->sd = sd;
+  new_sctp_descriptor->last_activity = time (NULL);
+  pthread_mutex_init (&new_sctp_descriptor->send_lock, NULL);
+
+  if (hashtable_insert (sctp_desc.associations, (hash_key_t) assoc_id, new_sctp_descriptor) != HASH_TABLE_OK) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to index new peer assoc id %u\n", assoc_id);
+    free_wrapper ((void**)&new_sctp_descriptor);
+    return NULL;
+  }
+  if (hashtable_insert (sctp_desc.sd_associations, (hash_key_t) sd, new_sctp_descriptor) != HASH_TABLE_OK) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to index new peer sd %d\n", sd);
+    hashtable_remove (sctp_desc.associations, (hash_key_t) assoc_id, (void **)&new_sctp_descriptor);
+    free_wrapper ((void**)&new_sctp_descriptor);
+    return NULL;
+  }
 
   if (sctp_desc.available_connections_tail == NULL) {
     sctp_desc.available_connections_head = new_sctp_descriptor;
@@ -131,39 +199,44 @@ static struct sctp_association_s *sctp_add_new_peer (void)
   }
 
   sctp_desc.number_of_connections++;
-  sctp_dump_list ();
   return new_sctp_descriptor;
 }
 
 //------------------------------------------------------------------------------
-static struct sctp_association_s *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id)
+static void sctp_free_send_queue (struct sctp_association_s *assoc_desc)
 {
-  struct sctp_association_s              *assoc_desc = NULL;
-
-  if (assoc_id < 0) {
-    return NULL;
+  while (assoc_desc->send_queue_head != assoc_desc->send_queue_tail) {
+    bdestroy_wrapper (&assoc_desc->send_queue[assoc_desc->send_queue_head++ & (assoc_desc->send_queue_size - 1)].payload);
   }
+  free_wrapper ((void**)&assoc_desc->send_queue);
+  free_wrapper ((void**)&assoc_desc->stream_messages_recv);
+  free_wrapper ((void**)&assoc_desc->stream_messages_sent);
+  bdestroy_wrapper (&assoc_desc->partial_payload);
+  pthread_mutex_destroy (&assoc_desc->send_lock);
+}
 
-  for (assoc_desc = sctp_desc.available_connections_head; assoc_desc; assoc_desc = assoc_desc->next_assoc) {
-    if (assoc_desc->assoc_id == assoc_id) {
-      break;
-    }
-  }
+//------------------------------------------------------------------------------
+static struct sctp_association_s *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id)
+{
+  void                                   *assoc_desc = NULL;
 
-  return assoc_desc;
+  hashtable_get (sctp_desc.associations, (hash_key_t) assoc_id, &assoc_desc);
+  return (struct sctp_association_s *)assoc_desc;
 }
 
 //------------------------------------------------------------------------------
 static int sctp_remove_assoc_from_list (sctp_assoc_id_t assoc_id)
 {
   struct sctp_association_s              *assoc_desc = NULL;
+  void                                   *sd_assoc_desc = NULL;
 
   /*
    * Association not in the list
    */
-  if ((assoc_desc = sctp_is_assoc_in_list (assoc_id)) == NULL) {
+  if (hashtable_remove (sctp_desc.associations, (hash_key_t) assoc_id, (void **)&assoc_desc) != HASH_TABLE_OK) {
     return -1;
   }
+  hashtable_remove (sctp_desc.sd_associations, (hash_key_t) assoc_desc->sd, &sd_assoc_desc);
 
   if (assoc_desc->next_assoc == NULL) {
     if (assoc_desc->previous_assoc == NULL) {
@@ -198,6 +271,7 @@ static int sctp_remove_assoc_from_list (sctp_assoc_id_t assoc_id)
     int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
     if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
   }
+  sctp_free_send_queue (assoc_desc);
   free_wrapper ((void**)&assoc_desc);
   sctp_desc.number_of_connections--;
   return 0;
@@ -251,6 +325,133 @@ static void sctp_dump_list (void)
 #endif
 }
 
+//------------------------------------------------------------------------------
+static int sctp_enqueue_pdu (struct sctp_association_s *assoc_desc, uint16_t stream, STOLEN_REF bstring *payload)
+{
+  sctp_send_pdu_t                        *queue = NULL;
+  uint32_t                                depth = assoc_desc->send_queue_tail - assoc_desc->send_queue_head;
+  uint32_t                                size = 0;
+  uint32_t                                i = 0;
+
+  if (depth == assoc_desc->send_queue_size) {
+    /*
+     * Full ring, doubled while under the limit, the PDUs are moved in order to the start of the new ring
+     */
+    size = (assoc_desc->send_queue_size) ? 2 * assoc_desc->send_queue_size : SCTP_SEND_QUEUE_INITIAL_SIZE;
+
+    if ((size > SCTP_SEND_QUEUE_MAX_SIZE) || ((queue = malloc (size * sizeof (sctp_send_pdu_t))) == NULL)) {
+      assoc_desc->send_queue_drops++;
+      return -1;
+    }
+
+    for (i = 0; i < depth; i++) {
+      queue[i] = assoc_desc->send_queue[(assoc_desc->send_queue_head + i) & (assoc_desc->send_queue_size - 1)];
+    }
+    free_wrapper ((void**)&assoc_desc->send_queue);
+    assoc_desc->send_queue = queue;
+    assoc_desc->send_queue_size = size;
+    assoc_desc->send_queue_head = 0;
+    assoc_desc->send_queue_tail = depth;
+  }
+
+  assoc_desc->send_queue[assoc_desc->send_queue_tail & (assoc_desc->send_queue_size - 1)].payload = *payload;
+  assoc_desc->send_queue[assoc_desc->send_queue_tail & (assoc_desc->send_queue_size - 1)].stream = stream;
+  *payload = NULL;
+  assoc_desc->send_queue_tail++;
+
+  if (++depth > assoc_desc->send_queue_max_depth) {
+    assoc_desc->send_queue_max_depth = depth;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void sctp_flush_send_queue (struct sctp_association_s *assoc_desc)
+{
+  struct mmsghdr                          msgs[SCTP_SEND_BATCH_SIZE];
+  struct iovec                            iovs[SCTP_SEND_BATCH_SIZE];
+  union {
+    struct cmsghdr                          header;
+    char                                    buffer[CMSG_SPACE (sizeof (struct sctp_sndrcvinfo))];
+  }                                       cmsgs[SCTP_SEND_BATCH_SIZE];
+  struct sctp_send_pdu_s                 *pdu = NULL;
+  struct sctp_sndrcvinfo                 *sinfo = NULL;
+  struct epoll_event                      event = {0};
+  bool                                    epollout = false;
+  int                                     nb_pdus = 0;
+  int                                     sent = 0;
+  int                                     i = 0;
+
+  /*
+   * Called with send_lock held, up to SCTP_SEND_BATCH_SIZE PDUs per system call
+   */
+  while (assoc_desc->send_queue_head != assoc_desc->send_queue_tail) {
+    nb_pdus = assoc_desc->send_queue_tail - assoc_desc->send_queue_head;
+    nb_pdus = (nb_pdus > SCTP_SEND_BATCH_SIZE) ? SCTP_SEND_BATCH_SIZE : nb_pdus;
+    memset (msgs, 0, nb_pdus * sizeof (struct mmsghdr));
+    memset (cmsgs, 0, nb_pdus * sizeof (cmsgs[0]));
+
+    for (i = 0; i < nb_pdus; i++) {
+      pdu = &assoc_desc->send_queue[(assoc_desc->send_queue_head + i) & (assoc_desc->send_queue_size - 1)];
+      iovs[i].iov_base = bdata (pdu->payload);
+      iovs[i].iov_len = blength (pdu->payload);
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_control = cmsgs[i].buffer;
+      msgs[i].msg_hdr.msg_controllen = sizeof (cmsgs[i].buffer);
+      cmsgs[i].header.cmsg_level = IPPROTO_SCTP;
+      cmsgs[i].header.cmsg_type = SCTP_SNDRCV;
+      cmsgs[i].header.cmsg_len = CMSG_LEN (sizeof (struct sctp_sndrcvinfo));
+      sinfo = (struct sctp_sndrcvinfo *)CMSG_DATA (&cmsgs[i].header);
+      sinfo->sinfo_stream = pdu->stream;
+      sinfo->sinfo_ppid = htonl (assoc_desc->ppid);
+    }
+
+    if ((sent = sendmmsg (assoc_desc->sd, msgs, nb_pdus, MSG_DONTWAIT | MSG_NOSIGNAL)) < 0) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      /*
+       * The first PDU cannot be sent, it is dropped, the association is probably going down
+       */
+      OAILOG_ERROR (LOG_SCTP, "[%d][%d] sendmmsg: %s:%d\n", assoc_desc->sd, assoc_desc->assoc_id, strerror (errno), errno);
+      bdestroy_wrapper (&assoc_desc->send_queue[assoc_desc->send_queue_head++ & (assoc_desc->send_queue_size - 1)].payload);
+      assoc_desc->send_queue_drops++;
+      continue;
+    }
+
+    assoc_desc->send_batches++;
+    for (i = 0; i < sent; i++) {
+      pdu = &assoc_desc->send_queue[assoc_desc->send_queue_head++ & (assoc_desc->send_queue_size - 1)];
+      assoc_desc->messages_sent++;
+      assoc_desc->bytes_sent += blength (pdu->payload);
+      if (pdu->stream < assoc_desc->outstreams) {
+        assoc_desc->stream_messages_sent[pdu->stream]++;
+      }
+      bdestroy_wrapper (&pdu->payload);
+    }
+    assoc_desc->last_activity = time (NULL);
+  }
+
+  /*
+   * EPOLLOUT is armed while PDUs are left, the receiver thread of the association then sends them
+   */
+  epollout = (assoc_desc->send_queue_head != assoc_desc->send_queue_tail);
+  if (epollout != assoc_desc->epollout) {
+    event.events = EPOLLIN | EPOLLET | ((epollout) ? EPOLLOUT : 0);
+    event.data.fd = assoc_desc->sd;
+
+    if (epoll_ctl (assoc_desc->epoll_fd, EPOLL_CTL_MOD, assoc_desc->sd, &event) < 0) {
+      OAILOG_ERROR (LOG_SCTP, "[%d] epoll_ctl: %s:%d\n", assoc_desc->sd, strerror (errno), errno);
+    } else {
+      assoc_desc->epollout = epollout;
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 static int sctp_send_msg (
     sctp_assoc_id_t sctp_assoc_id,
@@ -258,15 +459,22 @@ static int sctp_send_msg (
     STOLEN_REF bstring *payload)
 {
   struct sctp_association_s              *assoc_desc = NULL;
+  int                                     rc = 0;
 
   DevAssert (*payload);
 
+  /*
+   * The PDU is only queued, sctp_flush_associations() sends it
+   */
+  pthread_rwlock_rdlock (&sctp_desc.lock);
   if ((assoc_desc = sctp_is_assoc_in_list (sctp_assoc_id)) == NULL) {
+    pthread_rwlock_unlock (&sctp_desc.lock);
     OAILOG_DEBUG (LOG_SCTP, "This assoc id has not been fount in list (%d)\n", sctp_assoc_id);
     return -1;
   }
 
   if (assoc_desc->sd == -1) {
+    pthread_rwlock_unlock (&sctp_desc.lock);
     /*
      * The socket is invalid may be closed.
      */
@@ -274,34 +482,69 @@ static int sctp_send_msg (
     return -1;
   }
 
-  OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Sending buffer %p of %d bytes on stream %d with ppid %d\n",
+  OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Queuing buffer %p of %d bytes on stream %d with ppid %d\n",
       assoc_desc->sd, sctp_assoc_id, bdata(*payload), blength(*payload), stream, assoc_desc->ppid);
 
-  /*
-   * Send message_p on specified stream of the sd association
-   */
-  if (sctp_sendmsg (assoc_desc->sd, (const void *)bdata(*payload), blength(*payload), NULL, 0, htonl(assoc_desc->ppid), 0, stream, 0, 0) < 0) {
-    bdestroy_wrapper(payload);
-    OAILOG_ERROR (LOG_SCTP, "send: %s:%d", strerror (errno), errno);
-    return -1;
+  pthread_mutex_lock (&assoc_desc->send_lock);
+  rc = sctp_enqueue_pdu (assoc_desc, stream, payload);
+  pthread_mutex_unlock (&assoc_desc->send_lock);
+  pthread_rwlock_unlock (&sctp_desc.lock);
+
+  if (rc < 0) {
+    OAILOG_ERROR (LOG_SCTP, "Send queue of assoc id %u full, PDU dropped\n", sctp_assoc_id);
   }
-  OAILOG_DEBUG (LOG_SCTP, "Successfully sent %d bytes on stream %d\n", blength(*payload), stream);
-  bdestroy_wrapper(payload);
+  return rc;
+}
 
-  assoc_desc->messages_sent++;
-  return 0;
+//------------------------------------------------------------------------------
+static void sctp_flush_associations (const sctp_assoc_id_t * const assoc_ids, const int nb_assoc_ids)
+{
+  struct sctp_association_s              *assoc_desc = NULL;
+  int                                     i = 0;
+
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  for (i = 0; i < nb_assoc_ids; i++) {
+    if ((assoc_desc = sctp_is_assoc_in_list (assoc_ids[i])) == NULL) {
+      continue;
+    }
+    pthread_mutex_lock (&assoc_desc->send_lock);
+    /*
+     * A full socket is flushed by its receiver thread on EPOLLOUT
+     */
+    if (!assoc_desc->epollout) {
+      sctp_flush_send_queue (assoc_desc);
+    }
+    pthread_mutex_unlock (&assoc_desc->send_lock);
+  }
+  pthread_rwlock_unlock (&sctp_desc.lock);
+}
+
+//------------------------------------------------------------------------------
+static void sctp_flush_socket (int sd)
+{
+  void                                   *assoc_desc = NULL;
+
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  if (hashtable_get (sctp_desc.sd_associations, (hash_key_t) sd, &assoc_desc) == HASH_TABLE_OK) {
+    pthread_mutex_lock (&((struct sctp_association_s *)assoc_desc)->send_lock);
+    sctp_flush_send_queue ((struct sctp_association_s *)assoc_desc);
+    pthread_mutex_unlock (&((struct sctp_association_s *)assoc_desc)->send_lock);
+  }
+  pthread_rwlock_unlock (&sctp_desc.lock);
 }
 
 //------------------------------------------------------------------------------
 static int sctp_create_new_listener (SctpInit * init_p)
 {
   struct sctp_event_subscribe             event = {0};
+  struct epoll_event                      listen_event = {0};
 //  struct sockaddr                        *addr = NULL;
-  struct sctp_arg_s                      *sctp_arg_p = NULL;
+  struct sctp_listener_s                 *listener = NULL;
   uint16_t                                i = 0,
                                           j = 0;
-  int                                     sd = 0;
+  int                                     sd = -1;
   int                                     used_addresses = 0;
+  int                                     rc = 0;
 
   DevAssert (init_p != NULL);
 
@@ -360,7 +603,7 @@ static int sctp_create_new_listener (SctpInit * init_p)
 
   if (setsockopt (sd, IPPROTO_SCTP, SCTP_EVENTS, &event, sizeof (struct sctp_event_subscribe)) < 0) {
     OAILOG_ERROR (LOG_SCTP, "setsockopt: %s:%d\n", strerror (errno), errno);
-    return -1;
+    goto err;
   }
 
   /*
@@ -372,29 +615,83 @@ static int sctp_create_new_listener (SctpInit * init_p)
 
   if (sctp_bindx (sd, addr, used_addresses, SCTP_BINDX_ADD_ADDR) != 0) {
     OAILOG_ERROR (LOG_SCTP, "sctp_bindx: %s:%d\n", strerror (errno), errno);
-    return -1;
+    goto err;
   }
 
-  if (listen (sd, 5) < 0) {
+  if (listen (sd, SCTP_LISTEN_BACKLOG) < 0) {
     OAILOG_ERROR (LOG_SCTP, "listen: %s:%d\n", strerror (errno), errno);
-    return -1;
+    goto err;
   }
 
-  if ((sctp_arg_p = malloc (sizeof (struct sctp_arg_s))) == NULL) {
-    return -1;
+  /*
+   * Connections are accepted until EAGAIN
+   */
+  if (fcntl (sd, F_SETFL, fcntl (sd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+    OAILOG_ERROR (LOG_SCTP, "fcntl O_NONBLOCK: %s:%d\n", strerror (errno), errno);
+    goto err;
   }
 
-  sctp_arg_p->sd = sd;
-  sctp_arg_p->ppid = init_p->ppid;
+  if ((listener = calloc (1, sizeof (struct sctp_listener_s) + sctp_desc.nb_receiver_threads * sizeof (struct sctp_receiver_s))) == NULL) {
+    goto err;
+  }
 
-  if (pthread_create (&assoc_thread, NULL, &sctp_receiver_thread, (void *)sctp_arg_p) < 0) {
-    OAILOG_ERROR (LOG_SCTP, "pthread_create: %s:%d\n", strerror (errno), errno);
-    return -1;
+  listener->sd = sd;
+  listener->ppid = init_p->ppid;
+
+  for (i = 0; i < sctp_desc.nb_receiver_threads; i++) {
+    listener->receivers[i].listener = listener;
+    listener->receivers[i].epoll_fd = -1;
   }
 
+  for (i = 0; i < sctp_desc.nb_receiver_threads; i++) {
+    if ((listener->receivers[i].epoll_fd = epoll_create1 (EPOLL_CLOEXEC)) < 0) {
+      OAILOG_ERROR (LOG_SCTP, "epoll_create1: %s:%d\n", strerror (errno), errno);
+      goto err;
+    }
+  }
+
+  listen_event.events = EPOLLIN | EPOLLET;
+  listen_event.data.fd = sd;
+
+  if (epoll_ctl (listener->receivers[0].epoll_fd, EPOLL_CTL_ADD, sd, &listen_event) < 0) {
+    OAILOG_ERROR (LOG_SCTP, "epoll_ctl: %s:%d\n", strerror (errno), errno);
+    goto err;
+  }
+
+  /*
+   * Once the first receiver runs the listener is in use: if a next thread cannot be created, the associations
+   * * * are shared by the receivers already running.
+   */
+  for (i = 0; i < sctp_desc.nb_receiver_threads; i++) {
+    if ((rc = pthread_create (&listener->receivers[i].thread, NULL, &sctp_receiver_thread, (void *)&listener->receivers[i])) != 0) {
+      OAILOG_ERROR (LOG_SCTP, "pthread_create: %s:%d\n", strerror (rc), rc);
+      if (0 == i) {
+        goto err;
+      }
+      break;
+    }
+    listener->nb_receivers++;
+  }
+  for (i = listener->nb_receivers; i < sctp_desc.nb_receiver_threads; i++) {
+    close (listener->receivers[i].epoll_fd);
+    listener->receivers[i].epoll_fd = -1;
+  }
+
+  listener->next_listener = sctp_desc.listeners;
+  sctp_desc.listeners = listener;
+  OAILOG_DEBUG (LOG_SCTP, "Listening on sd %d with %u receiver threads\n", sd, listener->nb_receivers);
   return sd;
 err:
 
+  if (listener) {
+    for (i = 0; i < sctp_desc.nb_receiver_threads; i++) {
+      if (listener->receivers[i].epoll_fd >= 0) {
+        close (listener->receivers[i].epoll_fd);
+      }
+    }
+    free_wrapper ((void**)&listener);
+  }
+
   if (sd != -1) {
     close (sd);
     sd = -1;
@@ -404,27 +701,66 @@ err:
 }
 
 //------------------------------------------------------------------------------
-static inline int sctp_read_from_socket (int sd, int ppid)
+static bool sctp_get_assoc_id_from_sd (int sd, sctp_assoc_id_t * assoc_id)
+{
+  void                                   *assoc_desc = NULL;
+
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  if (hashtable_get (sctp_desc.sd_associations, (hash_key_t) sd, &assoc_desc) == HASH_TABLE_OK) {
+    *assoc_id = ((struct sctp_association_s *)assoc_desc)->assoc_id;
+  }
+  pthread_rwlock_unlock (&sctp_desc.lock);
+  return (assoc_desc != NULL);
+}
+
+//------------------------------------------------------------------------------
+static inline int sctp_read_from_socket (struct sctp_receiver_s *receiver, int sd)
 {
   int                                     flags = 0,
     n;
   socklen_t                               from_len = 0;
   struct sctp_sndrcvinfo                  sinfo = {0};
   struct sockaddr_in6                     addr = {0};
-  uint8_t                                 buffer[SCTP_RECV_BUFFER_SIZE];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                ppid = receiver->listener->ppid;
 
   if (sd < 0) {
     return -1;
   }
 
+  /*
+   * The PDU is read in the buffer of the next SCTP_DATA_IND message, no copy and no allocation of a payload
+   */
+  if (receiver->data_ind == NULL) {
+    receiver->data_ind = sctp_itti_alloc_new_message_ind_in_place (sctp_desc.data_ind_buffer_size, &receiver->data_ind_buffer);
+  }
+  buffer = receiver->data_ind_buffer;
+
   memset ((void *)&addr, 0, sizeof (struct sockaddr_in6));
   from_len = (socklen_t) sizeof (struct sockaddr_in6);
   memset ((void *)&sinfo, 0, sizeof (struct sctp_sndrcvinfo));
-  n = sctp_recvmsg (sd, (void *)buffer, SCTP_RECV_BUFFER_SIZE, (struct sockaddr *)&addr, &from_len, &sinfo, &flags);
+  n = sctp_recvmsg_nonblocking (sd, (void *)buffer, sctp_desc.data_ind_buffer_size, (struct sockaddr *)&addr, &from_len, &sinfo, &flags);
 
   if (n < 0) {
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+      return SCTP_RC_NO_DATA;
+    }
+    if (errno == EINTR) {
+      return SCTP_RC_NORMAL_READ;
+    }
     OAILOG_DEBUG (LOG_SCTP, "An error occured during read\n");
     OAILOG_ERROR (LOG_SCTP, "sctp_recvmsg: %s:%d\n", strerror (errno), errno);
+  }
+
+  if (n <= 0) {
+    sctp_assoc_id_t                         assoc_id = 0;
+
+    /*
+     * The association is gone without notification
+     */
+    if (sctp_get_assoc_id_from_sd (sd, &assoc_id)) {
+      sctp_handle_com_down (assoc_id);
+    }
     return SCTP_RC_ERROR;
   }
 
@@ -453,35 +789,49 @@ static inline int sctp_read_from_socket (int sd, int ppid)
       switch (sctp_assoc_changed->sac_state) {
       case SCTP_COMM_UP:{
           struct sctp_association_s              *new_association = NULL;
+          struct sockaddr                        *peer_addresses = NULL;
+          int                                     nb_peer_addresses = 0;
 
           sctp_get_sockinfo (sd, NULL, NULL, NULL);
           OAILOG_DEBUG (LOG_SCTP, "New connection\n");
+          sctp_get_localaddresses (sd, NULL, NULL);
+          sctp_get_peeraddresses (sd, &peer_addresses, &nb_peer_addresses);
 
-          if ((new_association = sctp_add_new_peer ()) == NULL) {
+          pthread_rwlock_wrlock (&sctp_desc.lock);
+          if ((new_association = sctp_add_new_peer (sctp_assoc_changed->sac_assoc_id, sd)) == NULL) {
+            pthread_rwlock_unlock (&sctp_desc.lock);
+            if (peer_addresses) sctp_freepaddrs (peer_addresses);
             // TODO: handle this case
             DevMessage ("Unexpected error...\n");
             return SCTP_RC_ERROR;
           } else {
-            new_association->sd = sd;
             new_association->ppid = ppid;
+            new_association->epoll_fd = receiver->epoll_fd;
             new_association->instreams = sctp_assoc_changed->sac_inbound_streams;
             new_association->outstreams = sctp_assoc_changed->sac_outbound_streams;
-            new_association->assoc_id = sctp_assoc_changed->sac_assoc_id;
-            sctp_get_localaddresses (sd, NULL, NULL);
-            sctp_get_peeraddresses (sd, &new_association->peer_addresses, &new_association->nb_peer_addresses);
-
-            if (sctp_itti_send_new_association (new_association->assoc_id, new_association->instreams, new_association->outstreams) < 0) {
+            new_association->stream_messages_recv = calloc (new_association->instreams, sizeof (uint64_t));
+            new_association->stream_messages_sent = calloc (new_association->outstreams, sizeof (uint64_t));
+            DevAssert ((new_association->stream_messages_recv != NULL) && (new_association->stream_messages_sent != NULL));
+            new_association->peer_addresses = peer_addresses;
+            new_association->nb_peer_addresses = nb_peer_addresses;
+            pthread_rwlock_unlock (&sctp_desc.lock);
+
+            if (sctp_itti_send_new_association (sctp_assoc_changed->sac_assoc_id, sctp_assoc_changed->sac_inbound_streams, sctp_assoc_changed->sac_outbound_streams) < 0) {
               OAILOG_ERROR (LOG_SCTP, "Failed to send message to S1AP\n");
-              return SCTP_RC_ERROR;
             }
           }
         }
         break;
 
+      case SCTP_COMM_LOST:{
+        OAILOG_DEBUG (LOG_SCTP, "SCTP_COMM_LOST received\n");
+        return sctp_handle_com_down (sctp_assoc_changed->sac_assoc_id);
+      }
+      break;
+
       case SCTP_RESTART:{
         OAILOG_DEBUG (LOG_SCTP, "Received SCTP restart for the new connection.\n");
         /** No separate SCTP INIT will be expected.. */
-        return SCTP_RC_ERROR;
       }
       break;
 
@@ -494,29 +844,67 @@ static inline int sctp_read_from_socket (int sd, int ppid)
      * Data payload received
      */
     struct sctp_association_s              *association;
+    sctp_stream_id_t                        instreams = 0;
+    sctp_stream_id_t                        outstreams = 0;
+    uint32_t                                association_ppid = 0;
+    bstring                                 payload = NULL;
 
+    pthread_rwlock_rdlock (&sctp_desc.lock);
     if ((association = sctp_is_assoc_in_list (sinfo.sinfo_assoc_id)) == NULL) {
+      pthread_rwlock_unlock (&sctp_desc.lock);
       // TODO: handle this case
-      return SCTP_RC_ERROR;
+      OAILOG_ERROR (LOG_SCTP, "Received data for unknown assoc id %d\n", sinfo.sinfo_assoc_id);
+      return SCTP_RC_NORMAL_READ;
     }
 
-    association->messages_recv++;
+    // Only the receiver thread of the association writes these counters and its partial PDU
+    if (association->partial_payload == NULL) {
+      association->messages_recv++;
+      if (sinfo.sinfo_stream < association->instreams) {
+        association->stream_messages_recv[sinfo.sinfo_stream]++;
+      }
+    }
+    association->bytes_recv += n;
+    association->last_activity = time (NULL);
+    instreams = association->instreams;
+    outstreams = association->outstreams;
+    association_ppid = association->ppid;
+
+    if ((ntohl (sinfo.sinfo_ppid) == association_ppid) && ((association->partial_payload) || !(flags & MSG_EOR))) {
+      /*
+       * PDU bigger than the buffer, its pieces are gathered in a bstring as they are read, the message is kept
+       * * * for the next read. The rest of the PDU is read on the next EPOLLIN if it is not queued yet.
+       */
+      if (association->partial_payload == NULL) {
+        association->partial_payload = blk2bstr (buffer, n);
+      } else if (bcatblk (association->partial_payload, buffer, n) != BSTR_OK) {
+        bdestroy_wrapper (&association->partial_payload);
+      }
+      if (flags & MSG_EOR) {
+        payload = association->partial_payload;
+        association->partial_payload = NULL;
+      }
+    }
+    pthread_rwlock_unlock (&sctp_desc.lock);
 
-    if (ntohl (sinfo.sinfo_ppid) != association->ppid) {
+    if (ntohl (sinfo.sinfo_ppid) != association_ppid) {
       /*
        * Mismatch in Payload Protocol Identifier,
        * * * * may be we received unsollicited traffic from stack other than S1AP.
        */
-      OAILOG_ERROR (LOG_SCTP, "Received data from peer with unsollicited PPID %d, expecting %d\n", ntohl (sinfo.sinfo_ppid), association->ppid);
-      return SCTP_RC_ERROR;
+      OAILOG_ERROR (LOG_SCTP, "Received data from peer with unsollicited PPID %d, expecting %d\n", ntohl (sinfo.sinfo_ppid), association_ppid);
+      return SCTP_RC_NORMAL_READ;
     }
 
     OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Msg of length %d received from port %u, on stream %d, PPID %d\n", sinfo.sinfo_assoc_id, sd, n, ntohs (addr.sin6_port), sinfo.sinfo_stream, ntohl (sinfo.sinfo_ppid));
-    bstring payload = blk2bstr(buffer, n);
-    sctp_itti_send_new_message_ind (&payload, sinfo.sinfo_assoc_id, sinfo.sinfo_stream, association->instreams, association->outstreams);
-  }
 
-  OAILOG_DEBUG (LOG_SCTP, "SCTP RETURNING!!\n");
+    if (payload) {
+      sctp_itti_send_new_message_ind (&payload, sinfo.sinfo_assoc_id, sinfo.sinfo_stream, instreams, outstreams);
+    } else if (flags & MSG_EOR) {
+      sctp_itti_send_new_message_ind_in_place (receiver->data_ind, n, sinfo.sinfo_assoc_id, sinfo.sinfo_stream, instreams, outstreams);
+      receiver->data_ind = NULL;
+    }
+  }
 
   return SCTP_RC_NORMAL_READ;
 }
@@ -524,189 +912,230 @@ static inline int sctp_read_from_socket (int sd, int ppid)
 //------------------------------------------------------------------------------
 static int sctp_handle_com_down (sctp_assoc_id_t assoc_id)
 {
+  int                                     rc = 0;
+
   OAILOG_DEBUG (LOG_SCTP, "Sending close connection for assoc_id %u\n", assoc_id);
 
-  if (sctp_itti_send_com_down_ind (assoc_id) < 0) {
-    OAILOG_ERROR (LOG_SCTP, "Failed to send message to TASK_S1AP\n");
-  }
+  pthread_rwlock_wrlock (&sctp_desc.lock);
+  rc = sctp_remove_assoc_from_list (assoc_id);
+  pthread_rwlock_unlock (&sctp_desc.lock);
 
-  if (sctp_remove_assoc_from_list (assoc_id) < 0) {
+  if (rc < 0) {
     OAILOG_ERROR (LOG_SCTP, "Failed to find client in list\n");
+  } else if (sctp_itti_send_com_down_ind (assoc_id) < 0) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to send message to TASK_S1AP\n");
   }
 
   return SCTP_RC_DISCONNECT;
 }
 
 //------------------------------------------------------------------------------
-void *sctp_receiver_thread (void *args_p)
+static void sctp_accept_associations (struct sctp_listener_s *listener)
 {
-  struct sctp_arg_s                      *sctp_arg_p = NULL;
+  struct sctp_receiver_s                 *receiver = NULL;
+  struct epoll_event                      event = {0};
+  int                                     clientsock = -1;
+  int                                     i = 0;
 
   /*
-   * maximum file descriptor number
+   * Edge triggered: accept until there is no pending connection
    */
-  int                                     fdmax,
-                                          clientsock,
-                                          i;
+  while (1) {
+    if ((clientsock = accept (listener->sd, NULL, NULL)) < 0) {
+      if ((errno == EINTR) || (errno == ECONNABORTED)) {
+        continue;
+      }
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+        OAILOG_ERROR (LOG_SCTP, "[%d] accept: %s:%d\n", listener->sd, strerror (errno), errno);
+      }
+      return;
+    }
 
-  /*
-   * master file descriptor list
-   */
-  fd_set                                  master;
+    /*
+     * PDUs are sent by sctp_flush_send_queue() without blocking
+     */
+    if (fcntl (clientsock, F_SETFL, fcntl (clientsock, F_GETFL, 0) | O_NONBLOCK) < 0) {
+      OAILOG_ERROR (LOG_SCTP, "[%d] fcntl O_NONBLOCK: %s:%d\n", clientsock, strerror (errno), errno);
+      close (clientsock);
+      continue;
+    }
 
-  /*
-   * temp file descriptor list for select()
-   */
-  fd_set                                  read_fds;
+    /*
+     * The new association goes to the receiver thread serving the fewest ones
+     */
+    receiver = &listener->receivers[0];
+    for (i = 1; i < listener->nb_receivers; i++) {
+      if (listener->receivers[i].nb_sockets < receiver->nb_sockets) {
+        receiver = &listener->receivers[i];
+      }
+    }
 
-  if ((sctp_arg_p = (struct sctp_arg_s *)args_p) == NULL) {
-    pthread_exit (NULL);
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = clientsock;
+    __sync_fetch_and_add (&receiver->nb_sockets, 1);
+
+    if (epoll_ctl (receiver->epoll_fd, EPOLL_CTL_ADD, clientsock, &event) < 0) {
+      OAILOG_ERROR (LOG_SCTP, "[%d] epoll_ctl: %s:%d\n", clientsock, strerror (errno), errno);
+      __sync_fetch_and_sub (&receiver->nb_sockets, 1);
+      close (clientsock);
+    }
   }
+}
 
-  /*
-   * clear the master and temp sets
-   */
-  FD_ZERO (&master);
-  FD_ZERO (&read_fds);
-  FD_SET (sctp_arg_p->sd, &master);
-  fdmax = sctp_arg_p->sd;       /* so far, it's this one */
+//------------------------------------------------------------------------------
+void *sctp_receiver_thread (void *args_p)
+{
+  struct sctp_receiver_s                 *receiver = NULL;
+  struct epoll_event                      events[SCTP_MAX_EPOLL_EVENTS];
+  int                                     nb_events = 0,
+                                          sd = -1,
+                                          ret = 0,
+                                          i = 0;
+
+  if ((receiver = (struct sctp_receiver_s *)args_p) == NULL) {
+    pthread_exit (NULL);
+  }
 
   while (1) {
-    memcpy (&read_fds, &master, sizeof (master));
-
-    if (select (fdmax + 1, &read_fds, NULL, NULL, NULL) == -1) {
-      OAILOG_ERROR (LOG_SCTP, "[%d] Select() error: %s", sctp_arg_p->sd, strerror (errno));
-      free_wrapper ((void**)&args_p);
+    if ((nb_events = epoll_wait (receiver->epoll_fd, events, SCTP_MAX_EPOLL_EVENTS, -1)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_SCTP, "[%d] epoll_wait() error: %s", receiver->listener->sd, strerror (errno));
       pthread_exit (NULL);
     }
 
-    for (i = 0; i <= fdmax; i++) {
-      if (FD_ISSET (i, &read_fds)) {
-        if (i == sctp_arg_p->sd) {
-          /*
-           * There is data to read on listener socket. This means we have to accept
-           * * * * the connection.
-           */
-          if ((clientsock = accept (sctp_arg_p->sd, NULL, NULL)) < 0) {
-            OAILOG_ERROR (LOG_SCTP, "[%d] accept: %s:%d\n", sctp_arg_p->sd, strerror (errno), errno);
-            free_wrapper ((void**)&args_p);
-            pthread_exit (NULL);
-          } else {
-            FD_SET (clientsock, &master);       /* add to master set */
+    for (i = 0; i < nb_events; i++) {
+      sd = events[i].data.fd;
 
-            if (clientsock > fdmax) {
-              /*
-               * keep track of the maximum
-               */
-              fdmax = clientsock;
-            }
-          }
-        } else {
-          int                                     ret;
+      if (sd == receiver->listener->sd) {
+        sctp_accept_associations (receiver->listener);
+        continue;
+      }
 
-          /*
-           * Read from socket
-           */
-          ret = sctp_read_from_socket (i, sctp_arg_p->ppid);
+      if (events[i].events & EPOLLOUT) {
+        sctp_flush_socket (sd);
+      }
 
-          /*
-           * When the socket is disconnected we have to update
-           * * * * the fd_set.
-           */
-          if (ret == SCTP_RC_DISCONNECT) {
-            /*
-             * Remove the socket from the FD set and update the max sd
-             */
-            FD_CLR (i, &master);
+      if (!(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+        continue;
+      }
 
-            if (i == fdmax) {
-              while (FD_ISSET (fdmax, &master) == false)
-                fdmax -= 1;
-            }
-          }
-        }
+      /*
+       * Edge triggered: read until the socket is empty
+       */
+      do {
+        ret = sctp_read_from_socket (receiver, sd);
+      } while (ret == SCTP_RC_NORMAL_READ);
+
+      if ((ret == SCTP_RC_DISCONNECT) || (ret == SCTP_RC_ERROR)) {
+        /*
+         * The association has been removed, no sender can use this socket anymore
+         */
+        epoll_ctl (receiver->epoll_fd, EPOLL_CTL_DEL, sd, NULL);
+        close (sd);
+        __sync_fetch_and_sub (&receiver->nb_sockets, 1);
       }
     }
   }
 
-  free_wrapper ((void**)&args_p);
   return NULL;
 }
 
 //------------------------------------------------------------------------------
 static void * sctp_intertask_interface (void *args_p)
 {
+  MessageDef                             *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+  sctp_assoc_id_t                         assoc_ids[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received_messages = 0;
+  int                                     nb_assoc_ids = 0;
+  int                                     i = 0,
+                                          j = 0;
+
   itti_mark_task_ready (TASK_SCTP);
 
   while (1) {
-    MessageDef                             *received_message_p = NULL;
-
-    itti_receive_msg (TASK_SCTP, &received_message_p);
+    /*
+     * The PDUs of a batch of messages are queued, then each association they go to is flushed once
+     */
+    nb_received_messages = itti_receive_msg_batch (TASK_SCTP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+    nb_assoc_ids = 0;
 
-    switch (ITTI_MSG_ID (received_message_p)) {
-    case SCTP_CLOSE_ASSOCIATION:{
-      }
-      break;
+    for (i = 0; i < nb_received_messages; i++) {
+      MessageDef                             *received_message_p = received_messages[i];
 
-    case SCTP_DATA_REQ:{
-        if (sctp_send_msg (SCTP_DATA_REQ (received_message_p).assoc_id,
-            SCTP_DATA_REQ (received_message_p).stream,
-            &SCTP_DATA_REQ (received_message_p).payload) < 0) {
+      switch (ITTI_MSG_ID (received_message_p)) {
+      case SCTP_CLOSE_ASSOCIATION:{
+        }
+        break;
 
-          sctp_itti_send_lower_layer_conf(received_message_p->ittiMsgHeader.originTaskId,
-              SCTP_DATA_REQ (received_message_p).assoc_id,
+      case SCTP_DATA_REQ:{
+          if (sctp_send_msg (SCTP_DATA_REQ (received_message_p).assoc_id,
               SCTP_DATA_REQ (received_message_p).stream,
-              SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id,
-              false);
-        } /* NO NEED FOR CONFIRM success yet else {
-          if (INVALID_MME_UE_S1AP_ID != SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id) {
+              &SCTP_DATA_REQ (received_message_p).payload) < 0) {
+
             sctp_itti_send_lower_layer_conf(received_message_p->ittiMsgHeader.originTaskId,
                 SCTP_DATA_REQ (received_message_p).assoc_id,
                 SCTP_DATA_REQ (received_message_p).stream,
                 SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id,
-                true);
+                false);
+          } else {
+            /* NO NEED FOR CONFIRM success yet
+            if (INVALID_MME_UE_S1AP_ID != SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id) {
+              sctp_itti_send_lower_layer_conf(received_message_p->ittiMsgHeader.originTaskId,
+                  SCTP_DATA_REQ (received_message_p).assoc_id,
+                  SCTP_DATA_REQ (received_message_p).stream,
+                  SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id,
+                  true);
+            }*/
+            for (j = 0; (j < nb_assoc_ids) && (assoc_ids[j] != SCTP_DATA_REQ (received_message_p).assoc_id); j++);
+            if (j == nb_assoc_ids) {
+              assoc_ids[nb_assoc_ids++] = SCTP_DATA_REQ (received_message_p).assoc_id;
+            }
           }
-        }*/
-      }
-      break;
+        }
+        break;
 
-    case SCTP_INIT_MSG:{
-        OAILOG_DEBUG (LOG_SCTP, "Received SCTP_INIT_MSG\n");
+      case SCTP_INIT_MSG:{
+          OAILOG_DEBUG (LOG_SCTP, "Received SCTP_INIT_MSG\n");
 
-        /*
-         * We received a new connection request
-         */
-        if (sctp_create_new_listener (&received_message_p->ittiMsg.sctpInit) < 0) {
           /*
-           * SCTP socket creation or bind failed...
+           * We received a new connection request
            */
-          OAILOG_ERROR (LOG_SCTP, "Failed to create new SCTP listener\n");
+          if (sctp_create_new_listener (&received_message_p->ittiMsg.sctpInit) < 0) {
+            /*
+             * SCTP socket creation or bind failed...
+             */
+            OAILOG_ERROR (LOG_SCTP, "Failed to create new SCTP listener\n");
+          }
         }
-      }
-      break;
+        break;
 
-    case MESSAGE_TEST:{
-        OAI_FPRINTF_INFO("TASK_SCTP received MESSAGE_TEST\n");
-      }
-      break;
+      case MESSAGE_TEST:{
+          OAI_FPRINTF_INFO("TASK_SCTP received MESSAGE_TEST\n");
+        }
+        break;
 
-    case TERMINATE_MESSAGE:{
-        sctp_exit();
-        itti_free_msg_content(received_message_p);
-        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-        itti_exit_task ();
-      }
-      break;
+      case TERMINATE_MESSAGE:{
+          sctp_exit();
+          itti_free_msg_content(received_message_p);
+          itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+          itti_exit_task ();
+        }
+        break;
 
-    default:{
-        OAILOG_DEBUG (LOG_SCTP, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+      default:{
+          OAILOG_DEBUG (LOG_SCTP, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+        }
+        break;
       }
-      break;
+
+      itti_free_msg_content(received_message_p);
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+      received_message_p = NULL;
     }
 
-    itti_free_msg_content(received_message_p);
-    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-    received_message_p = NULL;
+    sctp_flush_associations (assoc_ids, nb_assoc_ids);
   }
 
   return NULL;
@@ -722,6 +1151,20 @@ int sctp_init (const mme_config_t * mme_config_p)
    */
   sctp_desc.nb_instreams = mme_config_p->sctp_config.in_streams;
   sctp_desc.nb_outstreams = mme_config_p->sctp_config.out_streams;
+  sctp_desc.nb_receiver_threads = (mme_config_p->sctp_config.nb_receiver_threads) ? mme_config_p->sctp_config.nb_receiver_threads : SCTP_RECEIVER_THREADS;
+  sctp_desc.data_ind_buffer_size = (mme_config_p->sctp_config.data_ind_buffer_size) ? mme_config_p->sctp_config.data_ind_buffer_size : SCTP_DATA_IND_BUFFER_SIZE;
+  pthread_rwlock_init (&sctp_desc.lock, NULL);
+  /*
+   * The list owns the associations, the tables only index them
+   */
+  sctp_desc.associations = hashtable_create (SCTP_ASSOC_HASHTABLE_SIZE, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, NULL);
+  sctp_desc.sd_associations = hashtable_create (SCTP_ASSOC_HASHTABLE_SIZE, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, NULL);
+  if ((sctp_desc.associations == NULL) || (sctp_desc.sd_associations == NULL)) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to create the association tables\n");
+    return -1;
+  }
+  sctp_desc.associations->log_enabled = false;
+  sctp_desc.sd_associations->log_enabled = false;
 
   if (itti_create_task (TASK_SCTP, &sctp_intertask_interface, NULL) < 0) {
     OAILOG_ERROR (LOG_SCTP, "create task failed");
@@ -733,12 +1176,123 @@ int sctp_init (const mme_config_t * mme_config_p)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+static void sctp_copy_assoc_stats (struct sctp_association_s * const assoc_desc, sctp_assoc_stats_t * const stats)
+{
+  pthread_mutex_lock (&assoc_desc->send_lock);
+  stats->assoc_id = assoc_desc->assoc_id;
+  stats->instreams = assoc_desc->instreams;
+  stats->outstreams = assoc_desc->outstreams;
+  stats->messages_recv = assoc_desc->messages_recv;
+  stats->messages_sent = assoc_desc->messages_sent;
+  stats->bytes_recv = assoc_desc->bytes_recv;
+  stats->bytes_sent = assoc_desc->bytes_sent;
+  stats->last_activity = assoc_desc->last_activity;
+  stats->send_queue_depth = assoc_desc->send_queue_tail - assoc_desc->send_queue_head;
+  stats->send_queue_max_depth = assoc_desc->send_queue_max_depth;
+  stats->send_queue_drops = assoc_desc->send_queue_drops;
+  stats->send_batches = assoc_desc->send_batches;
+  pthread_mutex_unlock (&assoc_desc->send_lock);
+}
+
+//------------------------------------------------------------------------------
+int sctp_get_assoc_stats (const sctp_assoc_id_t assoc_id, sctp_assoc_stats_t * const stats)
+{
+  struct sctp_association_s              *assoc_desc = NULL;
+
+  DevAssert (stats != NULL);
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  if ((assoc_desc = sctp_is_assoc_in_list (assoc_id)) == NULL) {
+    pthread_rwlock_unlock (&sctp_desc.lock);
+    return -1;
+  }
+  sctp_copy_assoc_stats (assoc_desc, stats);
+  pthread_rwlock_unlock (&sctp_desc.lock);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int sctp_get_all_assoc_stats (sctp_assoc_stats_t * const stats, const int max_stats)
+{
+  struct sctp_association_s              *assoc_desc = NULL;
+  int                                     nb_stats = 0;
+
+  DevAssert ((stats != NULL) || (max_stats == 0));
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  for (assoc_desc = sctp_desc.available_connections_head; (assoc_desc) && (nb_stats < max_stats); assoc_desc = assoc_desc->next_assoc) {
+    sctp_copy_assoc_stats (assoc_desc, &stats[nb_stats++]);
+  }
+  pthread_rwlock_unlock (&sctp_desc.lock);
+  return nb_stats;
+}
+
+//------------------------------------------------------------------------------
+int sctp_get_assoc_stream_stats (const sctp_assoc_id_t assoc_id, uint64_t * const messages_recv, uint64_t * const messages_sent, const int max_streams)
+{
+  struct sctp_association_s              *assoc_desc = NULL;
+  int                                     i = 0;
+
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  if ((assoc_desc = sctp_is_assoc_in_list (assoc_id)) == NULL) {
+    pthread_rwlock_unlock (&sctp_desc.lock);
+    return -1;
+  }
+  pthread_mutex_lock (&assoc_desc->send_lock);
+  for (i = 0; i < max_streams; i++) {
+    if (messages_recv) {
+      messages_recv[i] = (i < assoc_desc->instreams) ? assoc_desc->stream_messages_recv[i] : 0;
+    }
+    if (messages_sent) {
+      messages_sent[i] = (i < assoc_desc->outstreams) ? assoc_desc->stream_messages_sent[i] : 0;
+    }
+  }
+  pthread_mutex_unlock (&assoc_desc->send_lock);
+  pthread_rwlock_unlock (&sctp_desc.lock);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t sctp_get_nb_associations (void)
+{
+  uint32_t                                nb_associations = 0;
+
+  pthread_rwlock_rdlock (&sctp_desc.lock);
+  nb_associations = sctp_desc.number_of_connections;
+  pthread_rwlock_unlock (&sctp_desc.lock);
+  return nb_associations;
+}
+
 //------------------------------------------------------------------------------
 static void sctp_exit (void)
 {
+  int                                     rv = 0;
+  int                                     i = 0;
+
+  while (sctp_desc.listeners) {
+    struct sctp_listener_s                 *listener = sctp_desc.listeners;
+
+    for (i = 0; i < listener->nb_receivers; i++) {
+      rv = pthread_cancel (listener->receivers[i].thread);
+      if (rv) {
+        OAILOG_DEBUG (LOG_SCTP, "pthread_cancel(%08lX) failed: %d:%s\n", listener->receivers[i].thread, rv, strerror(rv));
+      } else {
+        pthread_join (listener->receivers[i].thread, NULL);
+      }
+      close (listener->receivers[i].epoll_fd);
+      if (listener->receivers[i].data_ind) {
+        itti_free (TASK_SCTP, listener->receivers[i].data_ind);
+      }
+    }
+    close (listener->sd);
+    sctp_desc.listeners = listener->next_listener;
+    free_wrapper ((void**)&listener);
+  }
 
-  int rv = pthread_cancel(assoc_thread);
-  if (rv) OAILOG_DEBUG (LOG_SCTP, "pthread_cancel(%08lX) failed: %d:%s\n", assoc_thread, rv, strerror(rv));
+  sctp_dump_list ();
+  hashtable_destroy (sctp_desc.associations);
+  hashtable_destroy (sctp_desc.sd_associations);
+  sctp_desc.associations = NULL;
+  sctp_desc.sd_associations = NULL;
 
   struct sctp_association_s              *sctp_assoc_p = sctp_desc.available_connections_head;
   struct sctp_association_s              *next_sctp_assoc_p = sctp_desc.available_connections_head;
@@ -749,6 +1303,7 @@ static void sctp_exit (void)
       rv = sctp_freepaddrs(sctp_assoc_p->peer_addresses);
       if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", sctp_assoc_p->peer_addresses);
     }
+    sctp_free_send_queue (sctp_assoc_p);
     free_wrapper ((void**)&sctp_assoc_p);
     sctp_desc.number_of_connections--;
     sctp_assoc_p = next_sctp_assoc_p;
@@ -41,13 +41,29 @@
 # include "config.h"
 #endif
 
+#include <stdint.h>
+#include <time.h>
+
+#include "common_types.h"
 #include "mme_config.h"
 
-/** \brief SCTP data received callback
- \param buffer pointer to buffer received
- \param length pointer to the length of buffer
+/** \brief Counters of an SCTP association
+ Messages and bytes count the S1AP payloads, notifications excluded.
  **/
-typedef void (*sctp_recv_callback)(uint8_t *buffer, uint32_t length);
+typedef struct sctp_assoc_stats_s {
+  sctp_assoc_id_t assoc_id;
+  uint16_t        instreams;
+  uint16_t        outstreams;
+  uint64_t        messages_recv;
+  uint64_t        messages_sent;
+  uint64_t        bytes_recv;
+  uint64_t        bytes_sent;
+  time_t          last_activity;  ///< Time of the last message received or sent
+  uint32_t        send_queue_depth;      ///< PDUs waiting in the send queue
+  uint32_t        send_queue_max_depth;
+  uint64_t        send_queue_drops;      ///< PDUs dropped, queue full or send error
+  uint64_t        send_batches;          ///< sendmmsg() calls, messages_sent / send_batches PDUs per call
+} sctp_assoc_stats_t;
 
 /** \brief SCTP Init function. Initialize SCTP layer
  \param mme_config The global MME configuration structure
@@ -56,6 +72,34 @@ typedef void (*sctp_recv_callback)(uint8_t *buffer, uint32_t length);
 struct mme_config_s;
 int sctp_init(const struct mme_config_s *mme_config_p);
 
+/** \brief Counters of one association, safe to call from any thread
+ \param assoc_id SCTP association id
+ \param stats    Filled with the counters of the association
+ @returns -1 if the association is unknown, 0 otherwise.
+ **/
+int sctp_get_assoc_stats(const sctp_assoc_id_t assoc_id, sctp_assoc_stats_t * const stats);
+
+/** \brief Counters of all the associations, safe to call from any thread
+ \param stats     Array filled with the counters of the associations
+ \param max_stats Number of elements of stats, see sctp_get_nb_associations()
+ @returns the number of elements filled.
+ **/
+int sctp_get_all_assoc_stats(sctp_assoc_stats_t * const stats, const int max_stats);
+
+/** \brief Messages per stream of one association, safe to call from any thread
+ Streams not negotiated (see instreams and outstreams in sctp_assoc_stats_t) are reported as 0.
+ \param assoc_id      SCTP association id
+ \param messages_recv Filled with the messages received on each stream, may be NULL
+ \param messages_sent Filled with the messages sent on each stream, may be NULL
+ \param max_streams   Number of elements of the arrays
+ @returns -1 if the association is unknown, 0 otherwise.
+ **/
+int sctp_get_assoc_stream_stats(const sctp_assoc_id_t assoc_id, uint64_t * const messages_recv, uint64_t * const messages_sent, const int max_streams);
+
+/** \brief Number of associations currently up
+ **/
+uint32_t sctp_get_nb_associations(void);
+
 #endif /* FILE_SCTP_PRIMITIVES_SERVER_SEEN */
 
 /* @} */
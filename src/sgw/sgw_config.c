@@ -37,6 +37,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <netdb.h>
 
@@ -47,6 +48,8 @@
 #include "dynamic_memory_check.h"
 #include "log.h"
 #include "intertask_interface.h"
+#include "intertask_interface_config.h"
+#include "intertask_interface_trace.h"
 #include "common_defs.h"
 #include "sgw_config.h"
 
@@ -95,6 +98,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
   libconfig_int                           sgw_udp_port_S11 = 2123;
   config_setting_t                       *subsetting = NULL;
   const char                             *astring = NULL;
+  libconfig_int                           aint = 0;
   bstring                                 address = NULL;
   bstring                                 cidr = NULL;
   bstring                                 mask = NULL;
@@ -199,6 +203,18 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
     }
     OAILOG_SET_CONFIG(&config_pP->log_config);
 
+    // ITTI SETTING
+    subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG);
+
+    if (subsetting) {
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE, &aint)) {
+        config_pP->itti_config.queue_size = (uint32_t) aint;
+      }
+
+      config_pP->itti_config.sizing.trace_size = ITTI_TRACE_DEFAULT_SIZE;
+      itti_config_parse (subsetting, &config_pP->itti_config.sizing);
+    }
+
     subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_NETWORK_INTERFACES_CONFIG);
 
     if (subsetting) {
@@ -274,6 +290,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
 //------------------------------------------------------------------------------
 void sgw_config_display (sgw_config_t * config_p)
 {
+  int                                     i = 0;
 
   OAILOG_INFO (LOG_SPGW_APP, "==== EURECOM %s v%s ====\n", PACKAGE_NAME, PACKAGE_VERSION);
   OAILOG_INFO (LOG_SPGW_APP, "Configuration:\n");
@@ -293,6 +310,15 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "- ITTI:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    queue size .......: %u (bytes)\n", config_p->itti_config.queue_size);
   OAILOG_INFO (LOG_SPGW_APP, "    log file .........: %s\n", bdata(config_p->itti_config.log_file));
+  for (i = 0; i < config_p->itti_config.sizing.nb_task_queues; i++) {
+    OAILOG_INFO (LOG_SPGW_APP, "    task queue .......: %s %u messages\n", config_p->itti_config.sizing.task_queues[i].task_name, config_p->itti_config.sizing.task_queues[i].queue_size);
+  }
+  for (i = 0; i < config_p->itti_config.sizing.nb_memory_pools; i++) {
+    OAILOG_INFO (LOG_SPGW_APP, "    memory pool ......: %u items of %u bytes\n", config_p->itti_config.sizing.memory_pools[i].items, config_p->itti_config.sizing.memory_pools[i].item_size);
+  }
+  if (config_p->itti_config.sizing.trace_file_name[0]) {
+    OAILOG_INFO (LOG_SPGW_APP, "    trace file .......: %s %" PRIu64 " bytes\n", config_p->itti_config.sizing.trace_file_name, config_p->itti_config.sizing.trace_size);
+  }
 
   OAILOG_INFO (LOG_SPGW_APP, "- Logging:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    Output ..............: %s\n", bdata(config_p->log_config.output));
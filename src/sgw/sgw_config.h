@@ -33,6 +33,7 @@
 #include "log.h"
 #include "bstrlib.h"
 #include "common_types.h"
+#include "intertask_interface_conf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +50,9 @@ extern "C" {
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11              "SGW_IPV4_ADDRESS_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_UDP_PORT_FOR_S11                  "SGW_UDP_PORT_FOR_S11"
 
+#define SGW_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG            "INTERTASK_INTERFACE"
+#define SGW_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE        "ITTI_QUEUE_SIZE"
+
 #define SPGW_ABORT_ON_ERROR true
 #define SPGW_WARN_ON_ERROR false
 
@@ -58,8 +62,9 @@ typedef struct sgw_config_s {
   pthread_rwlock_t rw_lock;
 
   struct {
-    uint32_t  queue_size;
-    bstring   log_file;
+    uint32_t      queue_size;
+    bstring       log_file;
+    itti_config_t sizing;
   } itti_config;
 
   struct {
@@ -85,6 +85,10 @@ sgw_display_s11teid2mme_mappings (
   void)
 //-----------------------------------------------------------------------------
 {
+  if (!OAILOG_IS_ENABLED (OAILOG_LEVEL_DEBUG, LOG_SPGW_APP)) {
+    // do not walk the whole collection for nothing
+    return;
+  }
   OAILOG_DEBUG (LOG_SPGW_APP, "+--------------------------------------+\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "| MME <--- S11 TE ID MAPPINGS ---> SGW |\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "+--------------------------------------+\n");
@@ -146,6 +150,10 @@ sgw_display_s11_bearer_context_information_mapping (
   void)
 //-----------------------------------------------------------------------------
 {
+  if (!OAILOG_IS_ENABLED (OAILOG_LEVEL_DEBUG, LOG_SPGW_APP)) {
+    // do not walk the whole collection for nothing
+    return;
+  }
   OAILOG_DEBUG (LOG_SPGW_APP, "+-----------------------------------------+\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "| S11 BEARER CONTEXT INFORMATION MAPPINGS |\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "+-----------------------------------------+\n");
@@ -77,12 +77,20 @@ static void sgw_exit(void);
 //------------------------------------------------------------------------------
 static void *sgw_intertask_interface (void *args_p)
 {
+  MessageDef                             *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received_messages = 0;
+  int                                     next_message = 0;
+
   itti_mark_task_ready (TASK_SPGW_APP);
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_SPGW_APP, &received_message_p);
+    while (next_message == nb_received_messages) {
+      nb_received_messages = itti_receive_msg_batch (TASK_SPGW_APP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+      next_message = 0;
+    }
+    received_message_p = received_messages[next_message++];
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case GTPV1U_CREATE_TUNNEL_RESP:{
@@ -73,7 +73,7 @@ static void spgw_config_init (spgw_config_t * config_pP)
 }
 
 //------------------------------------------------------------------------------
-static int spgw_config_process (spgw_config_t * config_pP)
+int spgw_config_process (spgw_config_t * config_pP)
 {
 #if ENABLE_LIBGTPNL
   async_system_command (TASK_ASYNC_SYSTEM, SPGW_WARN_ON_ERROR, "sysctl -w net.ipv4.ip_forward=1");
@@ -93,6 +93,11 @@ static int spgw_config_process (spgw_config_t * config_pP)
   if (RETURNok != pgw_config_process (&config_pP->pgw_config)) {
     return RETURNerror;
   }
+
+  /*
+   * Display the configuration
+   */
+  spgw_config_display (config_pP);
   return RETURNok;
 }
 
@@ -129,10 +134,6 @@ static int spgw_config_parse_file (spgw_config_t * config_pP)
     return RETURNerror;
   }
 
-  if (spgw_config_process (config_pP) != 0) {
-    return RETURNerror;
-  }
-
   config_destroy (&cfg);
   return RETURNok;
 }
@@ -223,11 +224,6 @@ int spgw_config_parse_opt_line (
   if (spgw_config_parse_file (spgw_config_p) != 0) {
     return RETURNerror;
   }
-
-  /*
-   * Display the configuration
-   */
-  spgw_config_display (spgw_config_p);
   return RETURNok;
 }
 
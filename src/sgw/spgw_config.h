@@ -50,6 +50,10 @@ int spgw_config_parse_opt_line (
   char *argv[],
   spgw_config_t * spgw_config_p);
 
+/* Needs ITTI: spgw_config_parse_opt_line() only parses the file so that ITTI
+ * can be sized from it, the configuration is processed once ITTI is running. */
+int spgw_config_process (spgw_config_t * config_pP);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,286 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oaisim_mme_hashtable_benchmark.c
+  \brief Hashtable micro-benchmark: insert, lookup (hit and miss) and remove
+         latency and heap bytes per entry of the open addressing hash_table_t
+         and of the chained hash_table_ts_t, at 1M entries by default, for
+         sequential keys (mme_ue_s1ap_id), IMSI64 keys and TEIDs allocated
+         with a stride of 16. For hash_table_ts_t, the time per element of a
+         full walk with hashtable_ts_apply_callback_on_elements() and with a
+         cursor is also given.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "hashtable.h"
+
+#define HT_BENCHMARK_DEFAULT_ENTRIES      (1000 * 1000)
+#define HT_BENCHMARK_CURSOR_BATCH         (64)
+
+typedef enum ht_benchmark_keys_e {
+  HT_BENCHMARK_KEYS_SEQUENTIAL = 0,
+  HT_BENCHMARK_KEYS_IMSI64,
+  HT_BENCHMARK_KEYS_STRIDED,
+  HT_BENCHMARK_KEYS_MAX
+} ht_benchmark_keys_t;
+
+static const char * const               keys_names[HT_BENCHMARK_KEYS_MAX] = { "sequential", "imsi64", "strided" };
+
+typedef struct ht_benchmark_result_s {
+  double                                  insert_ns;
+  double                                  lookup_ns;
+  double                                  miss_ns;
+  double                                  remove_ns;
+  double                                  walk_callback_ns;
+  double                                  walk_cursor_ns;
+  double                                  bytes_per_entry;
+} ht_benchmark_result_t;
+
+//------------------------------------------------------------------------------
+static double ht_benchmark_ns_per_op (struct timespec *start, struct timespec *end, uint64_t operations)
+{
+  return ((double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec)) / (double)operations;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t ht_benchmark_random (uint64_t * const state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+//------------------------------------------------------------------------------
+static void ht_benchmark_generate_keys (ht_benchmark_keys_t type, hash_key_t *keys, hash_key_t *miss_keys, uint64_t nb_entries)
+{
+  uint64_t                                state = 0x9E3779B97F4A7C15ULL;
+  uint64_t                                i = 0;
+  uint64_t                                j = 0;
+  hash_key_t                              key = 0;
+
+  for (i = 0; i < nb_entries; i++) {
+    switch (type) {
+    case HT_BENCHMARK_KEYS_SEQUENTIAL:
+      keys[i] = i + 1;
+      miss_keys[i] = nb_entries + i + 1;
+      break;
+
+    case HT_BENCHMARK_KEYS_IMSI64:
+      /*
+       * MCC 208 MNC 93, MSINs allocated in blocks by the HSS, odd MSINs only
+       */
+      keys[i] = 208930000000000ULL + 2 * i + 1;
+      miss_keys[i] = 208930000000000ULL + 2 * i;
+      break;
+
+    case HT_BENCHMARK_KEYS_STRIDED:
+      keys[i] = (i + 1) << 4;
+      miss_keys[i] = ((i + 1) << 4) + 1;
+      break;
+
+    default:
+      AssertFatal (0, "Bad key type %d\n", type);
+    }
+  }
+
+  /*
+   * Access the keys in random order
+   */
+  for (i = nb_entries - 1; i > 0; i--) {
+    j = ht_benchmark_random (&state) % (i + 1);
+    key = keys[i];
+    keys[i] = keys[j];
+    keys[j] = key;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void ht_benchmark_open_addressing (const hash_key_t *keys, const hash_key_t *miss_keys, uint64_t nb_entries, ht_benchmark_result_t *result)
+{
+  hash_table_t                           *htbl = hashtable_create (nb_entries, NULL, hash_free_int_func, NULL);
+  struct timespec                         start;
+  struct timespec                         end;
+  uint64_t                                i = 0;
+  void                                   *data = NULL;
+
+  AssertFatal (htbl != NULL, "Hashtable creation failed!\n");
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    AssertFatal (hashtable_insert (htbl, keys[i], (void *)(uintptr_t)(i + 1)) == HASH_TABLE_OK, "Insert failed!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->insert_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+  result->bytes_per_entry = (double)(htbl->size * (sizeof (hash_slot_t) + sizeof (uint8_t))) / (double)nb_entries;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    hashtable_get (htbl, keys[nb_entries - 1 - i], &data);
+    AssertFatal (data == (void *)(uintptr_t)(nb_entries - i), "Lookup failed!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->lookup_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    AssertFatal (hashtable_get (htbl, miss_keys[i], &data) == HASH_TABLE_KEY_NOT_EXISTS, "Unexpected hit!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->miss_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    AssertFatal (hashtable_remove (htbl, keys[i], &data) == HASH_TABLE_OK, "Remove failed!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->remove_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+  AssertFatal (htbl->num_elements == 0, "%zu elements left!\n", htbl->num_elements);
+  hashtable_destroy (htbl);
+}
+
+//------------------------------------------------------------------------------
+static bool ht_benchmark_count_cb (const hash_key_t keyP, void * const dataP, void *parameterP, void **resultP)
+{
+  (*(uint64_t *)parameterP)++;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static void ht_benchmark_chained (const hash_key_t *keys, const hash_key_t *miss_keys, uint64_t nb_entries, ht_benchmark_result_t *result)
+{
+  hash_table_ts_t                        *htbl = hashtable_ts_create (nb_entries, NULL, hash_free_int_func, NULL);
+  struct timespec                         start;
+  struct timespec                         end;
+  uint64_t                                i = 0;
+  uint64_t                                count = 0;
+  void                                   *data = NULL;
+  hashtable_ts_cursor_t                   cursor;
+  hash_key_t                              batch_keys[HT_BENCHMARK_CURSOR_BATCH];
+  void                                   *batch_elements[HT_BENCHMARK_CURSOR_BATCH];
+  int                                     n = 0;
+
+  AssertFatal (htbl != NULL, "Hashtable creation failed!\n");
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    AssertFatal (hashtable_ts_insert (htbl, keys[i], (void *)(uintptr_t)(i + 1)) == HASH_TABLE_OK, "Insert failed!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->insert_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+  /*
+   * Allocator overhead of the nodes not included
+   */
+  result->bytes_per_entry = (double)(htbl->size * (sizeof (hash_node_t *) + sizeof (pthread_mutex_t)) + nb_entries * sizeof (hash_node_t)) / (double)nb_entries;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    hashtable_ts_get (htbl, keys[nb_entries - 1 - i], &data);
+    AssertFatal (data == (void *)(uintptr_t)(nb_entries - i), "Lookup failed!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->lookup_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    AssertFatal (hashtable_ts_get (htbl, miss_keys[i], &data) == HASH_TABLE_KEY_NOT_EXISTS, "Unexpected hit!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->miss_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  hashtable_ts_apply_callback_on_elements (htbl, ht_benchmark_count_cb, &count, NULL);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  AssertFatal (count == nb_entries, "Callback walk returned %"PRIu64" elements!\n", count);
+  result->walk_callback_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+
+  count = 0;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  AssertFatal (hashtable_ts_cursor_open (htbl, &cursor) == HASH_TABLE_OK, "Cursor open failed!\n");
+  while ((n = hashtable_ts_cursor_next (htbl, &cursor, batch_keys, batch_elements, HT_BENCHMARK_CURSOR_BATCH)) > 0) {
+    count += n;
+  }
+  hashtable_ts_cursor_close (htbl, &cursor);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  AssertFatal (count == nb_entries, "Cursor walk returned %"PRIu64" elements!\n", count);
+  result->walk_cursor_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < nb_entries; i++) {
+    AssertFatal (hashtable_ts_remove (htbl, keys[i], &data) == HASH_TABLE_OK, "Remove failed!\n");
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  result->remove_ns = ht_benchmark_ns_per_op (&start, &end, nb_entries);
+  hashtable_ts_destroy (htbl);
+}
+
+//------------------------------------------------------------------------------
+static void ht_benchmark_print (const char *table, ht_benchmark_keys_t type, const ht_benchmark_result_t *result)
+{
+  fprintf (stdout, "Hashtable benchmark: %-16s %-10s insert %6.1f ns lookup %6.1f ns miss %6.1f ns remove %6.1f ns, %5.1f bytes/entry\n",
+           table, keys_names[type], result->insert_ns, result->lookup_ns, result->miss_ns, result->remove_ns, result->bytes_per_entry);
+  if (result->walk_cursor_ns > 0) {
+    fprintf (stdout, "Hashtable benchmark: %-16s %-10s walk callback %6.1f ns/element cursor %6.1f ns/element\n",
+             table, keys_names[type], result->walk_callback_ns, result->walk_cursor_ns);
+  }
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_entries = HT_BENCHMARK_DEFAULT_ENTRIES;
+  hash_key_t                             *keys = NULL;
+  hash_key_t                             *miss_keys = NULL;
+  ht_benchmark_result_t                   result;
+  int                                     type = 0;
+
+  if (argc > 1) {
+    nb_entries = strtoull (argv[1], NULL, 0);
+  }
+  AssertFatal (nb_entries > 1, "At least 2 entries needed\n");
+
+  keys = calloc (nb_entries, sizeof (hash_key_t));
+  miss_keys = calloc (nb_entries, sizeof (hash_key_t));
+  AssertFatal ((keys != NULL) && (miss_keys != NULL), "Allocation of the keys failed!\n");
+
+  for (type = 0; type < HT_BENCHMARK_KEYS_MAX; type++) {
+    ht_benchmark_generate_keys (type, keys, miss_keys, nb_entries);
+    memset (&result, 0, sizeof (result));
+    ht_benchmark_open_addressing (keys, miss_keys, nb_entries, &result);
+    ht_benchmark_print ("open addressing", type, &result);
+    memset (&result, 0, sizeof (result));
+    ht_benchmark_chained (keys, miss_keys, nb_entries, &result);
+    ht_benchmark_print ("chained (ts)", type, &result);
+  }
+
+  free (keys);
+  free (miss_keys);
+  return 0;
+}
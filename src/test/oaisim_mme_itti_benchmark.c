@@ -0,0 +1,154 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oaisim_mme_itti_benchmark.c
+  \brief ITTI micro-benchmark: messages/sec between two tasks and memory pools
+         allocations per message in flight.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "bstrlib.h"
+
+#include "log.h"
+#include "assertions.h"
+#include "intertask_interface_init.h"
+
+#define ITTI_BENCHMARK_DEFAULT_MESSAGES   (1000 * 1000)
+#define ITTI_BENCHMARK_BURST_MESSAGES     (128)
+/* Stay below the TASK_MME_APP queue size, full queues are not handled here */
+#define ITTI_BENCHMARK_MAX_IN_FLIGHT      (192)
+
+static volatile uint64_t                received_messages = 0;
+static volatile int                     consumer_started = 0;
+
+//------------------------------------------------------------------------------
+static void *itti_benchmark_consumer (__attribute__((unused)) void *args)
+{
+  MessageDef                             *messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_messages = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_MME_APP);
+
+  while (!consumer_started) {
+    usleep (1000);
+  }
+
+  while (1) {
+    nb_messages = itti_receive_msg_batch (TASK_MME_APP, messages, ITTI_RECEIVE_BATCH_SIZE);
+
+    for (i = 0; i < nb_messages; i++) {
+      itti_free (ITTI_MSG_ORIGIN_ID (messages[i]), messages[i]);
+    }
+    __sync_fetch_and_add (&received_messages, nb_messages);
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static double itti_benchmark_elapsed (struct timespec *start, struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static void itti_benchmark_send (uint64_t nb_messages)
+{
+  uint64_t                                sent_messages = 0;
+  MessageDef                             *message_p = NULL;
+
+  for (sent_messages = 0; sent_messages < nb_messages; sent_messages++) {
+    message_p = itti_alloc_new_message (TASK_S1AP, MESSAGE_TEST);
+    itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_messages = ITTI_BENCHMARK_DEFAULT_MESSAGES;
+  uint64_t                                sent_messages = 0;
+  uint32_t                                allocated_items_before = 0;
+  uint32_t                                allocated_items_in_flight = 0;
+  uint64_t                                wakeups_signalled = 0;
+  uint64_t                                wakeups_avoided = 0;
+  itti_task_statistics_t                  task_statistics;
+  struct timespec                         start;
+  struct timespec                         end;
+  double                                  elapsed = 0;
+
+  if (argc > 1) {
+    nb_messages = strtoull (argv[1], NULL, 0);
+  }
+
+  CHECK_INIT_RETURN (OAILOG_INIT (LOG_SPGW_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS));
+  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL, NULL, NULL));
+  CHECK_INIT_RETURN (itti_create_task (TASK_MME_APP, &itti_benchmark_consumer, NULL));
+
+  /*
+   * Allocations per message: send a burst while the consumer is not reading
+   */
+  allocated_items_before = itti_get_allocated_items ();
+  itti_benchmark_send (ITTI_BENCHMARK_BURST_MESSAGES);
+  allocated_items_in_flight = itti_get_allocated_items () - allocated_items_before;
+  consumer_started = 1;
+
+  while (received_messages < ITTI_BENCHMARK_BURST_MESSAGES) {
+    usleep (1000);
+  }
+
+  /*
+   * Throughput: keep the consumer queue busy without overflowing it
+   */
+  received_messages = 0;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  while (sent_messages < nb_messages) {
+    if ((sent_messages - received_messages) < ITTI_BENCHMARK_MAX_IN_FLIGHT) {
+      itti_benchmark_send (1);
+      sent_messages++;
+    }
+  }
+
+  while (received_messages < nb_messages) {
+    ;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  elapsed = itti_benchmark_elapsed (&start, &end);
+  itti_get_wakeup_statistics (TASK_MME_APP, &wakeups_signalled, &wakeups_avoided);
+  itti_get_task_statistics (TASK_MME_APP, &task_statistics);
+
+  fprintf (stdout, "ITTI benchmark: %"PRIu64" messages in %.3f s, %.0f messages/s\n", nb_messages, elapsed, (double)nb_messages / elapsed);
+  fprintf (stdout, "ITTI benchmark: %.2f memory pools allocations/message\n", (double)allocated_items_in_flight / ITTI_BENCHMARK_BURST_MESSAGES);
+  fprintf (stdout, "ITTI benchmark: event fd wakeups signalled %"PRIu64" avoided %"PRIu64"\n", wakeups_signalled, wakeups_avoided);
+  fprintf (stdout, "ITTI benchmark: queue latency avg %"PRIu64" us max %"PRIu64" us, max queue depth %u\n",
+           task_statistics.latency_total_us / task_statistics.messages_out, task_statistics.latency_max_us, task_statistics.max_queue_depth);
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oaisim_mme_memory_pools_benchmark.c
+  \brief Memory pools micro-benchmark: multi-producer alloc/free throughput at
+         2, 4, 8 and 16 threads, items freed by the allocating thread (local)
+         or by the next thread as ITTI messages are (handoff).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <sched.h>
+
+#include "assertions.h"
+#include "memory_pools.h"
+
+#define MP_BENCHMARK_DEFAULT_OPERATIONS   (1000 * 1000)
+#define MP_BENCHMARK_BURST                (16)
+#define MP_BENCHMARK_MAX_THREADS          (16)
+
+typedef struct mp_benchmark_thread_s {
+  pthread_t                               thread;
+  int                                     index;
+  int                                     nb_threads;
+  bool                                    handoff;
+  uint64_t                                operations;
+  /*
+   * Burst handed over by the previous thread, freed by this one
+   */
+  volatile int                            mailbox_full;
+  memory_pool_item_handle_t               mailbox[MP_BENCHMARK_BURST];
+} mp_benchmark_thread_t;
+
+static memory_pools_handle_t            memory_pools_handle;
+static mp_benchmark_thread_t            threads[MP_BENCHMARK_MAX_THREADS];
+static volatile int                     started = 0;
+static volatile int                     finished = 0;
+
+/* Message sizes as seen by ITTI: mostly small messages, some large ones */
+static const uint32_t                   item_sizes[MP_BENCHMARK_BURST] = {
+  40, 48, 80, 96, 40, 48, 80, 96, 40, 48, 80, 96, 500, 900, 40, 10000
+};
+
+//------------------------------------------------------------------------------
+static void mp_benchmark_free_burst (memory_pool_item_handle_t *burst)
+{
+  int                                     i;
+
+  for (i = 0; i < MP_BENCHMARK_BURST; i++) {
+    AssertFatal (memory_pools_free (memory_pools_handle, burst[i], 0) == EXIT_SUCCESS, "Free failed!\n");
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mp_benchmark_receive_burst (mp_benchmark_thread_t *self)
+{
+  memory_pool_item_handle_t               burst[MP_BENCHMARK_BURST];
+
+  if (self->mailbox_full) {
+    __sync_synchronize ();
+    memcpy (burst, self->mailbox, sizeof (burst));
+    __sync_synchronize ();
+    self->mailbox_full = 0;
+    mp_benchmark_free_burst (burst);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *mp_benchmark_thread (void *args)
+{
+  mp_benchmark_thread_t                  *self = (mp_benchmark_thread_t *) args;
+  mp_benchmark_thread_t                  *next = &threads[(self->index + 1) % self->nb_threads];
+  memory_pool_item_handle_t               burst[MP_BENCHMARK_BURST];
+  uint64_t                                done = 0;
+  int                                     i;
+
+  while (!started) {
+    sched_yield ();
+  }
+
+  for (done = 0; done < self->operations; done += MP_BENCHMARK_BURST) {
+    for (i = 0; i < MP_BENCHMARK_BURST; i++) {
+      burst[i] = memory_pools_allocate (memory_pools_handle, item_sizes[i], self->index, 0);
+      AssertFatal (burst[i] != NULL, "Allocation of %u bytes failed!\n", item_sizes[i]);
+    }
+
+    if (!self->handoff) {
+      mp_benchmark_free_burst (burst);
+      continue;
+    }
+
+    /*
+     * Hand the burst over to the next thread, free the ones handed to us
+     * * * while waiting for its mailbox.
+     */
+    while (next->mailbox_full) {
+      mp_benchmark_receive_burst (self);
+      sched_yield ();
+    }
+
+    memcpy (next->mailbox, burst, sizeof (burst));
+    __sync_synchronize ();
+    next->mailbox_full = 1;
+    mp_benchmark_receive_burst (self);
+  }
+
+  /*
+   * The previous thread may still be waiting for our mailbox
+   */
+  __sync_fetch_and_add (&finished, 1);
+
+  while (finished < self->nb_threads) {
+    mp_benchmark_receive_burst (self);
+    sched_yield ();
+  }
+
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static double mp_benchmark_run (int nb_threads, bool handoff, uint64_t operations)
+{
+  struct timespec                         start;
+  struct timespec                         end;
+  int                                     i;
+
+  memset (threads, 0, sizeof (threads));
+  started = 0;
+  finished = 0;
+
+  for (i = 0; i < nb_threads; i++) {
+    threads[i].index = i;
+    threads[i].nb_threads = nb_threads;
+    threads[i].handoff = handoff;
+    threads[i].operations = operations / nb_threads;
+    AssertFatal (pthread_create (&threads[i].thread, NULL, mp_benchmark_thread, &threads[i]) == 0, "Thread creation failed!\n");
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  started = 1;
+
+  for (i = 0; i < nb_threads; i++) {
+    pthread_join (threads[i].thread, NULL);
+  }
+
+  /*
+   * Bursts still in the mailboxes
+   */
+  for (i = 0; i < nb_threads; i++) {
+    mp_benchmark_receive_burst (&threads[i]);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  static const int                        nb_threads[] = { 2, 4, 8, 16 };
+  uint64_t                                operations = MP_BENCHMARK_DEFAULT_OPERATIONS;
+  double                                  elapsed = 0;
+  unsigned int                            i;
+
+  if (argc > 1) {
+    operations = strtoull (argv[1], NULL, 0);
+  }
+
+  /*
+   * Same pools as the ITTI defaults
+   */
+  memory_pools_handle = memory_pools_create (5);
+  memory_pools_add_pool (memory_pools_handle, 1000 + (64 * 1024), 50);
+  memory_pools_add_pool (memory_pools_handle, 1000 + (2 * 64 * 1024), 100);
+  memory_pools_add_pool (memory_pools_handle, 10000, 1000);
+  memory_pools_add_pool (memory_pools_handle, 400, 20050);
+  memory_pools_add_pool (memory_pools_handle, 100, 30050);
+
+  for (i = 0; i < sizeof (nb_threads) / sizeof (nb_threads[0]); i++) {
+    elapsed = mp_benchmark_run (nb_threads[i], false, operations);
+    fprintf (stdout, "Memory pools benchmark: %2d threads, local   alloc/free: %.0f operations/s\n", nb_threads[i], (double)operations / elapsed);
+    elapsed = mp_benchmark_run (nb_threads[i], true, operations);
+    fprintf (stdout, "Memory pools benchmark: %2d threads, handoff alloc/free: %.0f operations/s\n", nb_threads[i], (double)operations / elapsed);
+  }
+
+  return 0;
+}
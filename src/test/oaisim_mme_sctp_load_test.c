@@ -0,0 +1,312 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oaisim_mme_sctp_load_test.c
+  \brief SCTP server load test: many local associations opened with
+         sctp_primitives_client.c on TASK_SCTP, association setup rate and
+         messages/s delivered to a fake TASK_S1AP.
+         Usage: oaisim_mme_sctp_load_test [associations [messages per association [receiver threads]]]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/sctp.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "log.h"
+#include "assertions.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+#include "mme_config.h"
+#include "sctp_primitives_server.h"
+#include "sctp_primitives_client.h"
+
+#define SCTP_LOAD_TEST_DEFAULT_ASSOCIATIONS   (1000)
+#define SCTP_LOAD_TEST_DEFAULT_MESSAGES       (100)
+#define SCTP_LOAD_TEST_DEFAULT_THREADS        (4)
+/* Not the S1AP port, a MME may run on the host */
+#define SCTP_LOAD_TEST_PORT                   (36999)
+#define SCTP_LOAD_TEST_MESSAGE_SIZE           (128)
+#define SCTP_LOAD_TEST_SENDERS                (4)
+#define SCTP_LOAD_TEST_S1AP_QUEUE_SIZE        (64 * 1024)
+#define SCTP_LOAD_TEST_TIMEOUT_S              (60)
+
+typedef struct sctp_load_test_sender_s {
+  pthread_t                               thread;
+  int                                     index;
+} sctp_load_test_sender_t;
+
+static sctp_data_t                     *associations = NULL;
+static uint32_t                         nb_associations = SCTP_LOAD_TEST_DEFAULT_ASSOCIATIONS;
+static uint32_t                         nb_messages = SCTP_LOAD_TEST_DEFAULT_MESSAGES;
+
+static volatile uint64_t                new_associations = 0;
+static volatile uint64_t                data_indications = 0;
+static volatile uint64_t                closed_associations = 0;
+
+//------------------------------------------------------------------------------
+static void *sctp_load_test_s1ap (__attribute__((unused)) void *args)
+{
+  MessageDef                             *messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_S1AP);
+
+  while (1) {
+    nb_received = itti_receive_msg_batch (TASK_S1AP, messages, ITTI_RECEIVE_BATCH_SIZE);
+
+    for (i = 0; i < nb_received; i++) {
+      switch (ITTI_MSG_ID (messages[i])) {
+      case SCTP_NEW_ASSOCIATION:
+        __sync_fetch_and_add (&new_associations, 1);
+        break;
+
+      case SCTP_DATA_IND:
+        __sync_fetch_and_add (&data_indications, 1);
+        break;
+
+      case SCTP_CLOSE_ASSOCIATION:
+        __sync_fetch_and_add (&closed_associations, 1);
+        break;
+
+      default:
+        break;
+      }
+      itti_free_msg_content (messages[i]);
+      itti_free (ITTI_MSG_ORIGIN_ID (messages[i]), messages[i]);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void *sctp_load_test_sender (void *args)
+{
+  sctp_load_test_sender_t                *sender = (sctp_load_test_sender_t *) args;
+  uint8_t                                 buffer[SCTP_LOAD_TEST_MESSAGE_SIZE];
+  uint32_t                                message = 0;
+  uint32_t                                i = 0;
+  uint16_t                                stream = 0;
+
+  memset (buffer, 0xA5, sizeof (buffer));
+
+  /*
+   * One message on each association in turn, spread over the UE signalling streams as the MME does
+   */
+  for (message = 0; message < nb_messages; message++) {
+    for (i = sender->index; i < nb_associations; i += SCTP_LOAD_TEST_SENDERS) {
+      stream = (associations[i].outstreams > 1) ? 1 + (message % (associations[i].outstreams - 1)) : 0;
+      sctp_send_msg (&associations[i], S1AP_SCTP_PPID, stream, buffer, sizeof (buffer));
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static double sctp_load_test_elapsed (struct timespec *start, struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static bool sctp_load_test_wait (volatile uint64_t *counter, uint64_t expected, bool count_drops)
+{
+  struct timespec                         start;
+  struct timespec                         now;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  /*
+   * Messages dropped on a full TASK_S1AP queue are counted as delivered
+   */
+  while ((*counter + ((count_drops) ? itti_get_queue_full_count (TASK_S1AP) : 0)) < expected) {
+    usleep (1000);
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    if (sctp_load_test_elapsed (&start, &now) > SCTP_LOAD_TEST_TIMEOUT_S) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  char                                   *local_addresses[] = { "127.0.0.1" };
+  itti_config_t                           itti_config = {0};
+  mme_config_t                            config;
+  struct rlimit                           rlimit;
+  sctp_load_test_sender_t                 senders[SCTP_LOAD_TEST_SENDERS];
+  MessageDef                             *message_p = NULL;
+  struct timespec                         start;
+  struct timespec                         end;
+  double                                  elapsed = 0;
+  sctp_assoc_stats_t                     *stats = NULL;
+  int                                     nb_stats = 0;
+  uint64_t                                messages_recv = 0;
+  uint64_t                                bytes_recv = 0;
+  uint64_t                                stream_messages[SCTP_IN_STREAMS];
+  uint64_t                                stream_messages_recv[SCTP_IN_STREAMS];
+  uint32_t                                missing_streams = 0;
+  uint32_t                                i = 0;
+  int                                     stream = 0;
+
+  memset (&config, 0, sizeof (config));
+  config.sctp_config.in_streams = SCTP_IN_STREAMS;
+  config.sctp_config.out_streams = SCTP_OUT_STREAMS;
+  config.sctp_config.nb_receiver_threads = SCTP_LOAD_TEST_DEFAULT_THREADS;
+
+  if (argc > 1) {
+    nb_associations = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_messages = strtoul (argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    config.sctp_config.nb_receiver_threads = strtoul (argv[3], NULL, 0);
+  }
+
+  /*
+   * Both ends of the associations are in this process
+   */
+  getrlimit (RLIMIT_NOFILE, &rlimit);
+  rlimit.rlim_cur = rlimit.rlim_max;
+  setrlimit (RLIMIT_NOFILE, &rlimit);
+  AssertFatal ((2 * nb_associations + 64) <= rlimit.rlim_cur, "Too many associations for %lu file descriptors\n", (unsigned long)rlimit.rlim_cur);
+  associations = calloc (nb_associations, sizeof (sctp_data_t));
+
+  strcpy (itti_config.task_queues[0].task_name, "TASK_S1AP");
+  itti_config.task_queues[0].queue_size = SCTP_LOAD_TEST_S1AP_QUEUE_SIZE;
+  itti_config.nb_task_queues = 1;
+  CHECK_INIT_RETURN (OAILOG_INIT (LOG_SPGW_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS));
+  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL, &itti_config, itti_free_msg_content));
+  CHECK_INIT_RETURN (itti_create_task (TASK_S1AP, &sctp_load_test_s1ap, NULL));
+  CHECK_INIT_RETURN (sctp_init (&config));
+
+  message_p = itti_alloc_new_message (TASK_S1AP, SCTP_INIT_MSG);
+  SCTP_INIT_MSG (message_p).port = SCTP_LOAD_TEST_PORT;
+  SCTP_INIT_MSG (message_p).ppid = S1AP_SCTP_PPID;
+  SCTP_INIT_MSG (message_p).ipv4 = 1;
+  SCTP_INIT_MSG (message_p).nb_ipv4_addr = 1;
+  inet_pton (AF_INET, local_addresses[0], &SCTP_INIT_MSG (message_p).ipv4_address[0]);
+  itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
+  sleep (1);
+
+  /*
+   * Association setup
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (i = 0; i < nb_associations; i++) {
+    AssertFatal (sctp_connect_to_remote_host (local_addresses, 1, local_addresses[0], SCTP_LOAD_TEST_PORT, SOCK_STREAM, &associations[i]) >= 0,
+                 "Association %u failed\n", i);
+  }
+
+  AssertFatal (sctp_load_test_wait (&new_associations, nb_associations, false), "Only %"PRIu64" associations up\n", new_associations);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  elapsed = sctp_load_test_elapsed (&start, &end);
+  fprintf (stdout, "SCTP load test: %u associations (%u receiver threads) up in %.3f s, %.0f associations/s\n",
+           nb_associations, config.sctp_config.nb_receiver_threads, elapsed, (double)nb_associations / elapsed);
+
+  /*
+   * Data path
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (i = 0; i < SCTP_LOAD_TEST_SENDERS; i++) {
+    senders[i].index = i;
+    pthread_create (&senders[i].thread, NULL, sctp_load_test_sender, &senders[i]);
+  }
+
+  for (i = 0; i < SCTP_LOAD_TEST_SENDERS; i++) {
+    pthread_join (senders[i].thread, NULL);
+  }
+
+  if (!sctp_load_test_wait (&data_indications, (uint64_t) nb_associations * nb_messages, true)) {
+    fprintf (stdout, "SCTP load test: timeout, %"PRIu64" messages of %"PRIu64" received\n", data_indications, (uint64_t) nb_associations * nb_messages);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  elapsed = sctp_load_test_elapsed (&start, &end);
+  fprintf (stdout, "SCTP load test: %"PRIu64" messages of %u bytes in %.3f s, %.0f messages/s, %"PRIu64" dropped on a full TASK_S1AP queue\n",
+           data_indications, SCTP_LOAD_TEST_MESSAGE_SIZE, elapsed, (double)data_indications / elapsed, itti_get_queue_full_count (TASK_S1AP));
+
+  /*
+   * Server side counters
+   */
+  stats = calloc (nb_associations, sizeof (sctp_assoc_stats_t));
+  nb_stats = sctp_get_all_assoc_stats (stats, nb_associations);
+  memset (stream_messages_recv, 0, sizeof (stream_messages_recv));
+  for (i = 0; i < (uint32_t) nb_stats; i++) {
+    messages_recv += stats[i].messages_recv;
+    bytes_recv += stats[i].bytes_recv;
+    if (sctp_get_assoc_stream_stats (stats[i].assoc_id, stream_messages, NULL, SCTP_IN_STREAMS) == 0) {
+      for (stream = 0; stream < SCTP_IN_STREAMS; stream++) {
+        stream_messages_recv[stream] += stream_messages[stream];
+      }
+      /*
+       * Message m is sent on stream 1 + m % (streams - 1), every stream up to nb_messages is used
+       */
+      for (stream = 1; (stream < stats[i].instreams) && (stream < SCTP_IN_STREAMS) && ((uint32_t) stream <= nb_messages); stream++) {
+        if (stream_messages[stream] == 0) {
+          missing_streams++;
+        }
+      }
+    }
+  }
+  fprintf (stdout, "SCTP load test: %u associations in the server, %"PRIu64" messages, %"PRIu64" bytes received\n",
+           sctp_get_nb_associations (), messages_recv, bytes_recv);
+  for (stream = 0; stream < SCTP_IN_STREAMS; stream++) {
+    fprintf (stdout, "SCTP load test: stream %d, %"PRIu64" messages received\n", stream, stream_messages_recv[stream]);
+  }
+  free (stats);
+  AssertFatal (stream_messages_recv[0] == 0, "%"PRIu64" UE associated messages received on stream 0\n", stream_messages_recv[0]);
+  AssertFatal (missing_streams == 0, "%u UE signalling streams without any message\n", missing_streams);
+
+  /*
+   * Teardown, every association must be reported down
+   */
+  for (i = 0; i < nb_associations; i++) {
+    close (associations[i].sd);
+  }
+
+  if (!sctp_load_test_wait (&closed_associations, nb_associations, false)) {
+    fprintf (stdout, "SCTP load test: only %"PRIu64" associations of %u reported down\n", closed_associations, nb_associations);
+    return 1;
+  }
+
+  fprintf (stdout, "SCTP load test: %u associations down\n", nb_associations);
+  return 0;
+}
@@ -0,0 +1,450 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file oaisim_mme_udp_echo_bench.c
+  \brief UDP server loopback benchmark: local GTPv2-C peers send Echo Requests
+         (as nw-egtping does) to TASK_UDP, a fake TASK_S11 hands them to a
+         nwgtpv2c stack answering with Echo Responses. Each peer keeps a window
+         of requests in flight, the order of the requests of each peer is
+         checked in TASK_S11 and the order of the responses in the peer.
+         Usage: oaisim_mme_udp_echo_bench [peers [echoes per peer [receiver threads]]]
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "log.h"
+#include "assertions.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+#include "mme_config.h"
+#include "udp_primitives_server.h"
+#include "NwGtpv2c.h"
+
+#define UDP_ECHO_BENCH_DEFAULT_PEERS          (64)
+#define UDP_ECHO_BENCH_DEFAULT_ECHOES         (20000)
+#define UDP_ECHO_BENCH_DEFAULT_THREADS        (4)
+#define UDP_ECHO_BENCH_MAX_PEERS              (1024)
+/* Not the GTPv2-C port, a MME may run on the host */
+#define UDP_ECHO_BENCH_PORT                   (32123)
+#define UDP_ECHO_BENCH_WINDOW                 (4)     ///< Echo Requests in flight per peer
+#define UDP_ECHO_BENCH_GENERATORS             (4)     ///< Threads sending the requests of the peers
+#define UDP_ECHO_BENCH_S11_QUEUE_SIZE         (64 * 1024)
+#define UDP_ECHO_BENCH_TIMEOUT_MS             (1000)  ///< A peer without response for this time has lost datagrams
+
+/* GTPv2-C header without TEID then the Recovery IE, see nw-egtping */
+#define GTPV2C_ECHO_REQUEST                   (1)
+#define GTPV2C_ECHO_RESPONSE                  (2)
+#define GTPV2C_IE_RECOVERY                    (3)
+#define GTPV2C_ECHO_LENGTH                    (13)
+
+typedef struct udp_echo_bench_peer_s {
+  int                                     sd;
+  uint16_t                                port;
+  uint32_t                                next_request;          ///< sequence number of the next request to send
+  uint32_t                                next_response;         ///< sequence number of the next response expected
+  /* TASK_S11 side */
+  uint32_t                                next_request_in_s11;
+} udp_echo_bench_peer_t;
+
+typedef struct udp_echo_bench_generator_s {
+  pthread_t                               thread;
+  int                                     index;
+  struct timespec                         cpu_time;
+} udp_echo_bench_generator_t;
+
+static udp_echo_bench_peer_t            peers[UDP_ECHO_BENCH_MAX_PEERS];
+static int                              peer_of_port[65536];
+static uint32_t                         nb_peers = UDP_ECHO_BENCH_DEFAULT_PEERS;
+static uint32_t                         nb_echoes = UDP_ECHO_BENCH_DEFAULT_ECHOES;
+static struct in_addr                   loopback;
+static nw_gtpv2c_stack_handle_t         s11_stack_handle = 0;
+
+static volatile uint64_t                requests_received = 0;
+static volatile uint64_t                requests_out_of_order = 0;
+static volatile uint64_t                requests_lost = 0;
+static volatile uint64_t                responses_received = 0;
+static volatile uint64_t                responses_out_of_order = 0;
+static volatile uint64_t                responses_lost = 0;
+static volatile uint64_t                peers_stalled = 0;
+
+//------------------------------------------------------------------------------
+static void udp_echo_bench_encode (uint8_t *buffer, uint8_t message_type, uint32_t sequence_number)
+{
+  buffer[0] = 0x40;                                      /* version 2, no TEID */
+  buffer[1] = message_type;
+  buffer[2] = 0;
+  buffer[3] = GTPV2C_ECHO_LENGTH - 4;
+  buffer[4] = (sequence_number >> 16) & 0xFF;
+  buffer[5] = (sequence_number >> 8) & 0xFF;
+  buffer[6] = sequence_number & 0xFF;
+  buffer[7] = 0;
+  buffer[8] = GTPV2C_IE_RECOVERY;
+  buffer[9] = 0;
+  buffer[10] = 1;
+  buffer[11] = 0;                                        /* instance */
+  buffer[12] = 1;                                        /* restart counter */
+}
+
+//------------------------------------------------------------------------------
+static uint32_t udp_echo_bench_sequence_number (const uint8_t *buffer)
+{
+  return ((uint32_t) buffer[4] << 16) | ((uint32_t) buffer[5] << 8) | buffer[6];
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t udp_echo_bench_send_udp_msg (
+  nw_gtpv2c_udp_handle_t udpHandle,
+  udp_buffer_t * buffer,
+  uint32_t buffer_len,
+  uint16_t localPort,
+  struct in_addr *peerIpAddr,
+  uint16_t peerPort)
+{
+  MessageDef                             *message_p = NULL;
+
+  /*
+   * As s11_mme_send_udp_msg(), but from the bench port: the stack answers echoes from the GTPv2-C port
+   */
+  message_p = itti_alloc_new_message (TASK_S11, UDP_DATA_REQ);
+  message_p->ittiMsg.udp_data_req.local_port = UDP_ECHO_BENCH_PORT;
+  message_p->ittiMsg.udp_data_req.peer_address.s_addr = peerIpAddr->s_addr;
+  message_p->ittiMsg.udp_data_req.peer_port = peerPort;
+  message_p->ittiMsg.udp_data_req.buffer = udp_buffer_ref (buffer);
+  message_p->ittiMsg.udp_data_req.buffer_offset = 0;
+  message_p->ittiMsg.udp_data_req.buffer_length = buffer_len;
+  return (itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p) == 0) ? NW_OK : NW_FAILURE;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t udp_echo_bench_ulp_req (nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t * pUlpApi)
+{
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t udp_echo_bench_start_timer (
+  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
+  uint32_t timeoutSec,
+  uint32_t timeoutUsec,
+  uint32_t tmrType,
+  void *timeoutArg,
+  nw_gtpv2c_timer_handle_t * hTmr)
+{
+  /*
+   * Echo Responses are sent without transaction
+   */
+  *hTmr = 0;
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t udp_echo_bench_stop_timer (nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle, nw_gtpv2c_timer_handle_t tmrHandle)
+{
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t udp_echo_bench_log (nw_gtpv2c_log_mgr_handle_t hLogMgr, uint32_t logLevel, char *file, uint32_t line, char *logStr)
+{
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static void udp_echo_bench_s11_init (void)
+{
+  nw_gtpv2c_ulp_entity_t                  ulp;
+  nw_gtpv2c_udp_entity_t                  udp;
+  nw_gtpv2c_timer_mgr_entity_t            tmrMgr;
+  nw_gtpv2c_log_mgr_entity_t              logMgr;
+
+  DevAssert (NW_OK == nwGtpv2cInitialize (&s11_stack_handle));
+  ulp.hUlp = (nw_gtpv2c_ulp_handle_t) NULL;
+  ulp.ulpReqCallback = udp_echo_bench_ulp_req;
+  DevAssert (NW_OK == nwGtpv2cSetUlpEntity (s11_stack_handle, &ulp));
+  udp.hUdp = (nw_gtpv2c_udp_handle_t) NULL;
+  udp.gtpv2cStandardPort = UDP_ECHO_BENCH_PORT;
+  udp.udpDataReqCallback = udp_echo_bench_send_udp_msg;
+  DevAssert (NW_OK == nwGtpv2cSetUdpEntity (s11_stack_handle, &udp));
+  tmrMgr.tmrMgrHandle = (nw_gtpv2c_timer_mgr_handle_t) NULL;
+  tmrMgr.tmrStartCallback = udp_echo_bench_start_timer;
+  tmrMgr.tmrStopCallback = udp_echo_bench_stop_timer;
+  DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (s11_stack_handle, &tmrMgr));
+  logMgr.logMgrHandle = 0;
+  logMgr.logReqCallback = udp_echo_bench_log;
+  DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (s11_stack_handle, &logMgr));
+}
+
+//------------------------------------------------------------------------------
+static void udp_echo_bench_handle_request (udp_data_ind_t * const udp_data_ind)
+{
+  udp_echo_bench_peer_t                  *peer = NULL;
+  uint32_t                                sequence_number = 0;
+
+  if ((udp_data_ind->buffer_length != GTPV2C_ECHO_LENGTH) || (udp_data_ind->buffer->data[1] != GTPV2C_ECHO_REQUEST) ||
+      (peer_of_port[udp_data_ind->peer_port] < 0)) {
+    return;
+  }
+  peer = &peers[peer_of_port[udp_data_ind->peer_port]];
+  sequence_number = udp_echo_bench_sequence_number (udp_data_ind->buffer->data);
+  __sync_fetch_and_add (&requests_received, 1);
+  /*
+   * A gap is a datagram dropped on a full socket, going back is a reordering
+   */
+  if (sequence_number < peer->next_request_in_s11) {
+    __sync_fetch_and_add (&requests_out_of_order, 1);
+    return;
+  }
+  __sync_fetch_and_add (&requests_lost, sequence_number - peer->next_request_in_s11);
+  peer->next_request_in_s11 = sequence_number + 1;
+
+  /*
+   * The stack parses the datagram in place and sends the response it encodes, as in s11_mme_thread()
+   */
+  DevAssert (NW_OK == nwGtpv2cProcessUdpReq (s11_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length,
+                                             udp_data_ind->local_port, udp_data_ind->peer_port, &udp_data_ind->peer_address));
+}
+
+//------------------------------------------------------------------------------
+static void *udp_echo_bench_s11 (__attribute__((unused)) void *args)
+{
+  MessageDef                             *messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_S11);
+
+  while (1) {
+    nb_received = itti_receive_msg_batch (TASK_S11, messages, ITTI_RECEIVE_BATCH_SIZE);
+
+    for (i = 0; i < nb_received; i++) {
+      if (ITTI_MSG_ID (messages[i]) == UDP_DATA_IND) {
+        udp_echo_bench_handle_request (&messages[i]->ittiMsg.udp_data_ind);
+      }
+      itti_free_msg_content (messages[i]);
+      itti_free (ITTI_MSG_ORIGIN_ID (messages[i]), messages[i]);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void udp_echo_bench_send_request (udp_echo_bench_peer_t *peer, const struct sockaddr_in * const to)
+{
+  uint8_t                                 request[GTPV2C_ECHO_LENGTH];
+
+  udp_echo_bench_encode (request, GTPV2C_ECHO_REQUEST, peer->next_request++);
+  while ((sendto (peer->sd, request, sizeof (request), 0, (const struct sockaddr *)to, sizeof (*to)) < 0) && (errno == EINTR));
+}
+
+//------------------------------------------------------------------------------
+static void *udp_echo_bench_generator (void *args)
+{
+  udp_echo_bench_generator_t             *generator = (udp_echo_bench_generator_t *) args;
+  struct pollfd                           pfds[UDP_ECHO_BENCH_MAX_PEERS];
+  udp_echo_bench_peer_t                  *generator_peers[UDP_ECHO_BENCH_MAX_PEERS];
+  struct sockaddr_in                      to;
+  uint8_t                                 response[64];
+  uint32_t                                nb_generator_peers = 0;
+  uint32_t                                nb_done = 0;
+  uint32_t                                i = 0;
+  int                                     nb_events = 0;
+  ssize_t                                 length = 0;
+
+  memset (&to, 0, sizeof (to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons (UDP_ECHO_BENCH_PORT);
+  to.sin_addr = loopback;
+
+  for (i = generator->index; i < nb_peers; i += UDP_ECHO_BENCH_GENERATORS) {
+    generator_peers[nb_generator_peers] = &peers[i];
+    pfds[nb_generator_peers].fd = peers[i].sd;
+    pfds[nb_generator_peers].events = POLLIN;
+    nb_generator_peers++;
+  }
+
+  /*
+   * Fill the window of every peer, then one new request per response
+   */
+  for (i = 0; i < nb_generator_peers; i++) {
+    while ((generator_peers[i]->next_request < UDP_ECHO_BENCH_WINDOW) && (generator_peers[i]->next_request < nb_echoes)) {
+      udp_echo_bench_send_request (generator_peers[i], &to);
+    }
+  }
+
+  while (nb_done < nb_generator_peers) {
+    if ((nb_events = poll (pfds, nb_generator_peers, UDP_ECHO_BENCH_TIMEOUT_MS)) == 0) {
+      __sync_fetch_and_add (&peers_stalled, nb_generator_peers - nb_done);
+      break;
+    }
+    for (i = 0; (i < nb_generator_peers) && (nb_events > 0); i++) {
+      if (!(pfds[i].revents & POLLIN)) {
+        continue;
+      }
+      nb_events--;
+      while ((length = recv (pfds[i].fd, response, sizeof (response), MSG_DONTWAIT)) > 0) {
+        udp_echo_bench_peer_t                  *peer = generator_peers[i];
+
+        if ((length != GTPV2C_ECHO_LENGTH) || (response[1] != GTPV2C_ECHO_RESPONSE)) {
+          continue;
+        }
+        __sync_fetch_and_add (&responses_received, 1);
+        if (udp_echo_bench_sequence_number (response) < peer->next_response) {
+          __sync_fetch_and_add (&responses_out_of_order, 1);
+          continue;
+        }
+        __sync_fetch_and_add (&responses_lost, udp_echo_bench_sequence_number (response) - peer->next_response);
+        peer->next_response = udp_echo_bench_sequence_number (response) + 1;
+        if (peer->next_request < nb_echoes) {
+          udp_echo_bench_send_request (peer, &to);
+        }
+        if (peer->next_response == nb_echoes) {
+          pfds[i].fd = -1;
+          nb_done++;
+          break;
+        }
+      }
+    }
+  }
+  clock_gettime (CLOCK_THREAD_CPUTIME_ID, &generator->cpu_time);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static double udp_echo_bench_elapsed (struct timespec *start, struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  itti_config_t                           itti_config = {0};
+  mme_config_t                            config;
+  udp_echo_bench_generator_t              generators[UDP_ECHO_BENCH_GENERATORS];
+  MessageDef                             *message_p = NULL;
+  struct sockaddr_in                      addr;
+  socklen_t                               addr_len = sizeof (addr);
+  struct timespec                         start;
+  struct timespec                         end;
+  struct timespec                         cpu_start;
+  struct timespec                         cpu_end;
+  struct timespec                         zero = {0};
+  double                                  elapsed = 0;
+  double                                  mme_cpu = 0;
+  uint32_t                                i = 0;
+
+  memset (&config, 0, sizeof (config));
+  config.udp_config.nb_receiver_threads = UDP_ECHO_BENCH_DEFAULT_THREADS;
+
+  if (argc > 1) {
+    nb_peers = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_echoes = strtoul (argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    config.udp_config.nb_receiver_threads = strtoul (argv[3], NULL, 0);
+  }
+  AssertFatal ((nb_peers > 0) && (nb_peers <= UDP_ECHO_BENCH_MAX_PEERS), "Bad number of peers %u, must be in [1..%u]\n", nb_peers, UDP_ECHO_BENCH_MAX_PEERS);
+  AssertFatal (nb_echoes < (1 << 24), "Too many echoes %u, the sequence number has 24 bits\n", nb_echoes);
+  inet_pton (AF_INET, "127.0.0.1", &loopback);
+
+  /*
+   * The peers, each one on its own port: the kernel hashes them over the receiver sockets
+   */
+  memset (peer_of_port, 0xFF, sizeof (peer_of_port));
+  for (i = 0; i < nb_peers; i++) {
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr = loopback;
+    AssertFatal ((peers[i].sd = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP)) >= 0, "socket: %s\n", strerror (errno));
+    AssertFatal (bind (peers[i].sd, (struct sockaddr *)&addr, sizeof (addr)) == 0, "bind: %s\n", strerror (errno));
+    addr_len = sizeof (addr);
+    getsockname (peers[i].sd, (struct sockaddr *)&addr, &addr_len);
+    peers[i].port = ntohs (addr.sin_port);
+    peer_of_port[peers[i].port] = i;
+  }
+
+  strcpy (itti_config.task_queues[0].task_name, "TASK_S11");
+  itti_config.task_queues[0].queue_size = UDP_ECHO_BENCH_S11_QUEUE_SIZE;
+  itti_config.nb_task_queues = 1;
+  CHECK_INIT_RETURN (OAILOG_INIT (LOG_SPGW_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS));
+  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL, &itti_config, itti_free_msg_content));
+  udp_echo_bench_s11_init ();
+  CHECK_INIT_RETURN (itti_create_task (TASK_S11, &udp_echo_bench_s11, NULL));
+  CHECK_INIT_RETURN (udp_init (&config));
+
+  message_p = itti_alloc_new_message (TASK_S11, UDP_INIT);
+  message_p->ittiMsg.udp_init.port = UDP_ECHO_BENCH_PORT;
+  message_p->ittiMsg.udp_init.address = loopback;
+  itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
+  sleep (1);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+
+  for (i = 0; i < UDP_ECHO_BENCH_GENERATORS; i++) {
+    generators[i].index = i;
+    pthread_create (&generators[i].thread, NULL, udp_echo_bench_generator, &generators[i]);
+  }
+
+  for (i = 0; i < UDP_ECHO_BENCH_GENERATORS; i++) {
+    pthread_join (generators[i].thread, NULL);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+  elapsed = udp_echo_bench_elapsed (&start, &end);
+
+  /*
+   * CPU time of the MME side: TASK_UDP, its receiver threads and TASK_S11 with its stack, the peers excluded
+   */
+  mme_cpu = udp_echo_bench_elapsed (&cpu_start, &cpu_end);
+  for (i = 0; i < UDP_ECHO_BENCH_GENERATORS; i++) {
+    mme_cpu -= udp_echo_bench_elapsed (&zero, &generators[i].cpu_time);
+  }
+
+  fprintf (stdout, "UDP echo bench: %u peers, %u receiver threads, %"PRIu64" echoes in %.3f s, %.0f echoes/s\n",
+           nb_peers, config.udp_config.nb_receiver_threads, responses_received, elapsed, (double)responses_received / elapsed);
+  if (mme_cpu > 0) {
+    fprintf (stdout, "UDP echo bench: %.3f s CPU on the MME side, %.0f GTPv2-C messages/s per core\n",
+             mme_cpu, (double)(requests_received + responses_received) / mme_cpu);
+  }
+  fprintf (stdout, "UDP echo bench: requests %"PRIu64" received, %"PRIu64" out of order, %"PRIu64" lost; responses %"PRIu64" out of order, %"PRIu64" lost; %"PRIu64" peers stalled\n",
+           requests_received, requests_out_of_order, requests_lost, responses_out_of_order, responses_lost, peers_stalled);
+  return ((requests_out_of_order == 0) && (responses_out_of_order == 0)) ? 0 : 1;
+}
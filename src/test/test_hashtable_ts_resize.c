@@ -0,0 +1,346 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_hashtable_ts_resize.c
+  \brief Concurrent insert, lookup and remove on the thread safe hashtables
+         while they grow and shrink with their incremental resize: every
+         thread owns its keys and checks each result, all the threads also
+         look up a set of keys inserted beforehand that must never be missed.
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "hashtable.h"
+#include "obj_hashtable.h"
+#include "hashtable_epoch.h"
+
+#define TEST_HT_THREADS                   (4)
+#define TEST_HT_KEYS_PER_THREAD           (4096)
+#define TEST_HT_STABLE_KEYS               (64)
+#define TEST_HT_ROUNDS                    (4)
+#define TEST_HT_INITIAL_SIZE              (16)
+#define TEST_HT_STABLE_KEY_BASE           (UINT64_C(1) << 40)
+
+typedef enum test_ht_kind_e {
+  TEST_HT_TS = 0,
+  TEST_HT_UINT64_TS,
+  TEST_HT_OBJ_TS,
+  TEST_HT_OBJ_UINT64_TS,
+} test_ht_kind_t;
+
+typedef struct test_ht_s {
+  test_ht_kind_t                          kind;
+  hash_table_ts_t                        *ts;
+  hash_table_uint64_ts_t                 *uint64_ts;
+  obj_hash_table_t                       *obj_ts;
+  obj_hash_table_uint64_t                *obj_uint64_ts;
+  volatile hash_size_t                    max_size;
+} test_ht_t;
+
+typedef struct test_ht_worker_s {
+  test_ht_t                              *ht;
+  int                                     index;
+  int                                     errors;
+} test_ht_worker_t;
+
+//------------------------------------------------------------------------------
+static uint64_t test_ht_data (const uint64_t key)
+{
+  return (key * 2) + 1;
+}
+
+//------------------------------------------------------------------------------
+static volatile hash_size_t *test_ht_size (test_ht_t * const ht)
+{
+  switch (ht->kind) {
+  case TEST_HT_TS:             return &ht->ts->size;
+  case TEST_HT_UINT64_TS:      return &ht->uint64_ts->size;
+  case TEST_HT_OBJ_TS:         return &ht->obj_ts->size;
+  default:                     return &ht->obj_uint64_ts->size;
+  }
+}
+
+//------------------------------------------------------------------------------
+static hash_size_t test_ht_num_elements (test_ht_t * const ht)
+{
+  switch (ht->kind) {
+  case TEST_HT_TS:             return ht->ts->num_elements;
+  case TEST_HT_UINT64_TS:      return ht->uint64_ts->num_elements;
+  case TEST_HT_OBJ_TS:         return ht->obj_ts->num_elements;
+  default:                     return ht->obj_uint64_ts->num_elements;
+  }
+}
+
+//------------------------------------------------------------------------------
+static hashtable_rc_t test_ht_insert (test_ht_t * const ht, const uint64_t key)
+{
+  switch (ht->kind) {
+  case TEST_HT_TS:
+    return hashtable_ts_insert (ht->ts, key, (void *)(uintptr_t) test_ht_data (key));
+  case TEST_HT_UINT64_TS:
+    return hashtable_uint64_ts_insert (ht->uint64_ts, key, test_ht_data (key));
+  case TEST_HT_OBJ_TS:
+    /* The obj tables keep a copy of the key */
+    return obj_hashtable_ts_insert (ht->obj_ts, &key, sizeof (key), (void *)(uintptr_t) test_ht_data (key));
+  default:
+    return obj_hashtable_uint64_ts_insert (ht->obj_uint64_ts, &key, sizeof (key), test_ht_data (key));
+  }
+}
+
+//------------------------------------------------------------------------------
+static hashtable_rc_t test_ht_get (test_ht_t * const ht, const uint64_t key, uint64_t * const data)
+{
+  void                                   *element = NULL;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+
+  *data = 0;
+  switch (ht->kind) {
+  case TEST_HT_TS:
+    rc = hashtable_ts_get (ht->ts, key, &element);
+    *data = (uintptr_t) element;
+    return rc;
+  case TEST_HT_UINT64_TS:
+    return hashtable_uint64_ts_get (ht->uint64_ts, key, data);
+  case TEST_HT_OBJ_TS:
+    rc = obj_hashtable_ts_get (ht->obj_ts, &key, sizeof (key), &element);
+    *data = (uintptr_t) element;
+    return rc;
+  default:
+    return obj_hashtable_uint64_ts_get (ht->obj_uint64_ts, &key, sizeof (key), data);
+  }
+}
+
+//------------------------------------------------------------------------------
+static hashtable_rc_t test_ht_remove (test_ht_t * const ht, const uint64_t key, uint64_t * const data)
+{
+  void                                   *element = NULL;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+
+  /* The uint64 tables do not return the data on remove, it is read just before */
+  *data = test_ht_data (key);
+  switch (ht->kind) {
+  case TEST_HT_TS:
+    rc = hashtable_ts_remove (ht->ts, key, &element);
+    *data = (uintptr_t) element;
+    return rc;
+  case TEST_HT_UINT64_TS:
+    return hashtable_uint64_ts_remove (ht->uint64_ts, key);
+  case TEST_HT_OBJ_TS:
+    rc = obj_hashtable_ts_remove (ht->obj_ts, &key, sizeof (key), &element);
+    *data = (uintptr_t) element;
+    return rc;
+  default:
+    return obj_hashtable_uint64_ts_remove (ht->obj_uint64_ts, &key, sizeof (key));
+  }
+}
+
+//------------------------------------------------------------------------------
+static void test_ht_check_stable_keys (test_ht_worker_t * const worker)
+{
+  uint64_t                                data = 0;
+
+  for (uint64_t i = 0; i < TEST_HT_STABLE_KEYS; i++) {
+    const uint64_t                          key = TEST_HT_STABLE_KEY_BASE + i;
+
+    if ((test_ht_get (worker->ht, key, &data) != HASH_TABLE_OK) || (data != test_ht_data (key))) {
+      worker->errors++;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void test_ht_track_size (test_ht_t * const ht)
+{
+  hash_size_t                             size = *test_ht_size (ht);
+  hash_size_t                             max_size = ht->max_size;
+
+  while ((size > max_size) && !__sync_bool_compare_and_swap (&ht->max_size, max_size, size)) {
+    max_size = ht->max_size;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *test_ht_worker (void *arg)
+{
+  test_ht_worker_t                       *worker = (test_ht_worker_t *) arg;
+  test_ht_t                              *ht = worker->ht;
+  uint64_t                                data = 0;
+
+  for (int round = 0; round < TEST_HT_ROUNDS; round++) {
+    for (uint64_t i = 0; i < TEST_HT_KEYS_PER_THREAD; i++) {
+      const uint64_t                          key = worker->index + (TEST_HT_THREADS * i);
+
+      if (test_ht_insert (ht, key) != HASH_TABLE_OK) {
+        worker->errors++;
+      }
+      if ((test_ht_get (ht, key, &data) != HASH_TABLE_OK) || (data != test_ht_data (key))) {
+        worker->errors++;
+      }
+      if ((i % 256) == 0) {
+        test_ht_track_size (ht);
+        test_ht_check_stable_keys (worker);
+      }
+    }
+
+    for (uint64_t i = 0; i < TEST_HT_KEYS_PER_THREAD; i++) {
+      const uint64_t                          key = worker->index + (TEST_HT_THREADS * i);
+
+      if ((test_ht_get (ht, key, &data) != HASH_TABLE_OK) || (data != test_ht_data (key))) {
+        worker->errors++;
+      }
+      if ((test_ht_remove (ht, key, &data) != HASH_TABLE_OK) || (data != test_ht_data (key))) {
+        worker->errors++;
+      }
+      if (test_ht_get (ht, key, &data) != HASH_TABLE_KEY_NOT_EXISTS) {
+        worker->errors++;
+      }
+      if ((i % 256) == 0) {
+        test_ht_check_stable_keys (worker);
+      }
+    }
+  }
+  hashtable_epoch_reclaim ();
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void test_ht_run (test_ht_t * const ht)
+{
+  pthread_t                               threads[TEST_HT_THREADS];
+  test_ht_worker_t                        workers[TEST_HT_THREADS];
+  uint64_t                                data = 0;
+
+  ht->max_size = *test_ht_size (ht);
+  for (uint64_t i = 0; i < TEST_HT_STABLE_KEYS; i++) {
+    ck_assert_int_eq (test_ht_insert (ht, TEST_HT_STABLE_KEY_BASE + i), HASH_TABLE_OK);
+  }
+
+  for (int t = 0; t < TEST_HT_THREADS; t++) {
+    workers[t].ht = ht;
+    workers[t].index = t;
+    workers[t].errors = 0;
+    ck_assert_int_eq (pthread_create (&threads[t], NULL, test_ht_worker, &workers[t]), 0);
+  }
+  for (int t = 0; t < TEST_HT_THREADS; t++) {
+    ck_assert_int_eq (pthread_join (threads[t], NULL), 0);
+    ck_assert_int_eq (workers[t].errors, 0);
+  }
+
+  /* The tables grew above one element per bucket while the keys were inserted */
+  ck_assert_uint_gt (ht->max_size, TEST_HT_INITIAL_SIZE);
+  ck_assert_uint_eq (test_ht_num_elements (ht), TEST_HT_STABLE_KEYS);
+
+  for (uint64_t i = 0; i < TEST_HT_STABLE_KEYS; i++) {
+    const uint64_t                          key = TEST_HT_STABLE_KEY_BASE + i;
+
+    ck_assert_int_eq (test_ht_get (ht, key, &data), HASH_TABLE_OK);
+    ck_assert_uint_eq (data, test_ht_data (key));
+    ck_assert_int_eq (test_ht_remove (ht, key, &data), HASH_TABLE_OK);
+  }
+  ck_assert_uint_eq (test_ht_num_elements (ht), 0);
+  hashtable_epoch_reclaim ();
+}
+
+START_TEST(hashtable_ts_resize_test)
+{
+  test_ht_t ht = {.kind = TEST_HT_TS};
+
+  ht.ts = hashtable_ts_create (TEST_HT_INITIAL_SIZE, NULL, hash_free_int_func, bfromcstr ("test_hashtable_ts"));
+  ck_assert_ptr_ne (ht.ts, NULL);
+  test_ht_run (&ht);
+  ck_assert_int_eq (hashtable_ts_destroy (ht.ts), HASH_TABLE_OK);
+}
+END_TEST
+
+START_TEST(hashtable_uint64_ts_resize_test)
+{
+  test_ht_t ht = {.kind = TEST_HT_UINT64_TS};
+
+  ht.uint64_ts = hashtable_uint64_ts_create (TEST_HT_INITIAL_SIZE, NULL, bfromcstr ("test_hashtable_uint64_ts"));
+  ck_assert_ptr_ne (ht.uint64_ts, NULL);
+  test_ht_run (&ht);
+  ck_assert_int_eq (hashtable_uint64_ts_destroy (ht.uint64_ts), HASH_TABLE_OK);
+}
+END_TEST
+
+START_TEST(obj_hashtable_ts_resize_test)
+{
+  test_ht_t ht = {.kind = TEST_HT_OBJ_TS};
+
+  ht.obj_ts = obj_hashtable_ts_create (TEST_HT_INITIAL_SIZE, NULL, NULL, hash_free_int_func, bfromcstr ("test_obj_hashtable_ts"));
+  ck_assert_ptr_ne (ht.obj_ts, NULL);
+  test_ht_run (&ht);
+  ck_assert_int_eq (obj_hashtable_ts_destroy (ht.obj_ts), HASH_TABLE_OK);
+}
+END_TEST
+
+START_TEST(obj_hashtable_uint64_ts_resize_test)
+{
+  test_ht_t ht = {.kind = TEST_HT_OBJ_UINT64_TS};
+
+  ht.obj_uint64_ts = obj_hashtable_uint64_ts_create (TEST_HT_INITIAL_SIZE, NULL, NULL, bfromcstr ("test_obj_hashtable_uint64_ts"));
+  ck_assert_ptr_ne (ht.obj_uint64_ts, NULL);
+  test_ht_run (&ht);
+  ck_assert_int_eq (obj_hashtable_uint64_ts_destroy (ht.obj_uint64_ts), HASH_TABLE_OK);
+}
+END_TEST
+
+Suite * hashtable_ts_resize_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Hashtable ts resize");
+
+    /* Core test case */
+    tc_core = tcase_create("Concurrent resize test");
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, hashtable_ts_resize_test);
+    tcase_add_test(tc_core, hashtable_uint64_ts_resize_test);
+    tcase_add_test(tc_core, obj_hashtable_ts_resize_test);
+    tcase_add_test(tc_core, obj_hashtable_uint64_ts_resize_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = hashtable_ts_resize_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,236 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_itti_trace_sgw.c
+  \brief ITTI flight recorder of the SPGW copy (oai_sgw/common/itti), where
+         the payload of a message is allocated apart from its header: the
+         records read back from the trace file must hold the header followed
+         by the payload, as the MME copy and itti_trace_decoder expect.
+*/
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_trace.h"
+
+#define TEST_TRACE_RING_SIZE              (ITTI_TRACE_MIN_SIZE)
+#define TEST_TRACE_PAYLOAD_MAX            (1000)
+#define TEST_TRACE_MESSAGES               (4 * TEST_TRACE_RING_SIZE / TEST_TRACE_PAYLOAD_MAX)
+
+typedef struct test_trace_file_s {
+  char                                    name[64];
+  uint8_t                                *content;
+  itti_trace_file_header_t               *header;
+  uint8_t                                *ring;
+} test_trace_file_t;
+
+//------------------------------------------------------------------------------
+static void test_trace_start (test_trace_file_t * const file)
+{
+  int                                     fd = -1;
+
+  strcpy (file->name, "/tmp/test_itti_trace_sgw_XXXXXX");
+  fd = mkstemp (file->name);
+  ck_assert_int_ge (fd, 0);
+  close (fd);
+  ck_assert_int_eq (itti_trace_init (file->name, TEST_TRACE_RING_SIZE, NULL), 0);
+}
+
+//------------------------------------------------------------------------------
+static void test_trace_stop (test_trace_file_t * const file)
+{
+  FILE                                   *fp = NULL;
+  long                                    size = 0;
+
+  itti_trace_exit ();
+  fp = fopen (file->name, "r");
+  ck_assert_ptr_ne (fp, NULL);
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  rewind (fp);
+  file->content = malloc (size);
+  ck_assert_ptr_ne (file->content, NULL);
+  ck_assert_int_eq (fread (file->content, 1, size, fp), size);
+  fclose (fp);
+  unlink (file->name);
+  file->header = (itti_trace_file_header_t *) file->content;
+  ck_assert_int_eq (memcmp (file->header->magic, ITTI_TRACE_FILE_MAGIC, sizeof (file->header->magic)), 0);
+  ck_assert_uint_eq (file->header->ring_size, TEST_TRACE_RING_SIZE);
+  ck_assert_int_eq (size, file->header->header_size + TEST_TRACE_RING_SIZE);
+  file->ring = file->content + file->header->header_size;
+}
+
+//------------------------------------------------------------------------------
+static MessageDef *test_trace_new_message (const uint64_t message_number, const MessageHeaderSize size)
+{
+  MessageDef                             *message = calloc (1, sizeof (MessageDef));
+  uint8_t                                *payload = NULL;
+  int                                     i = 0;
+
+  ck_assert_ptr_ne (message, NULL);
+  message->ittiMsgHeader.messageId = message_number % 64;
+  message->ittiMsgHeader.ittiMsgSize = size;
+  message->ittiMsgHeader.messageNumber = message_number;
+  if (size) {
+    message->itti_msg = malloc (size);
+    ck_assert_ptr_ne (message->itti_msg, NULL);
+    payload = (uint8_t *) message->itti_msg;
+    for (i = 0; i < size; i++) {
+      payload[i] = (uint8_t) (message_number + i);
+    }
+  }
+  return message;
+}
+
+//------------------------------------------------------------------------------
+static void test_trace_free_message (MessageDef * const message)
+{
+  free (message->itti_msg);
+  free (message);
+}
+
+//------------------------------------------------------------------------------
+static void test_trace_check_record (const itti_trace_record_t * const record, const uint64_t message_number, const MessageHeaderSize size)
+{
+  const MessageHeader                    *header = (const MessageHeader *) &record[1];
+  const uint8_t                          *payload = (const uint8_t *) &record[1] + sizeof (MessageHeader);
+  int                                     i = 0;
+
+  ck_assert_uint_eq (ITTI_TRACE_COMMIT_MAGIC (record->commit), ITTI_TRACE_RECORD_MAGIC);
+  ck_assert_uint_eq (record->message_number, message_number);
+  ck_assert_uint_eq (record->payload_size, sizeof (MessageHeader) + size);
+  ck_assert_uint_eq (header->messageNumber, message_number);
+  ck_assert_uint_eq (header->ittiMsgSize, size);
+  for (i = 0; i < size; i++) {
+    ck_assert_uint_eq (payload[i], (uint8_t) (message_number + i));
+  }
+}
+
+START_TEST(itti_trace_sgw_payload_test)
+{
+  test_trace_file_t                       file = {.content = NULL};
+  MessageDef                             *messages[3] = {NULL};
+  const MessageHeaderSize                 sizes[3] = {0, 3, TEST_TRACE_PAYLOAD_MAX};
+  const itti_trace_record_t              *record = NULL;
+  uint64_t                                offset = 0;
+  int                                     i = 0;
+
+  test_trace_start (&file);
+  for (i = 0; i < 3; i++) {
+    messages[i] = test_trace_new_message (i + 1, sizes[i]);
+    itti_trace_message (messages[i], i + 1);
+  }
+  test_trace_stop (&file);
+
+  for (i = 0; i < 3; i++) {
+    record = (const itti_trace_record_t *) &file.ring[offset];
+    ck_assert_uint_eq (record->position, offset);
+    test_trace_check_record (record, i + 1, sizes[i]);
+    offset += ITTI_TRACE_COMMIT_SIZE (record->commit);
+    test_trace_free_message (messages[i]);
+  }
+  ck_assert_uint_eq (file.header->head, offset);
+  ck_assert_uint_eq (file.header->skipped, 0);
+  free (file.content);
+}
+END_TEST
+
+START_TEST(itti_trace_sgw_wrap_test)
+{
+  test_trace_file_t                       file = {.content = NULL};
+  MessageDef                             *message = NULL;
+  const itti_trace_record_t              *record = NULL;
+  uint64_t                                position = 0;
+  uint64_t                                expected_number = 0;
+  int                                     nb_records = 0;
+  int                                     i = 0;
+
+  test_trace_start (&file);
+  for (i = 1; i <= TEST_TRACE_MESSAGES; i++) {
+    message = test_trace_new_message (i, i % (TEST_TRACE_PAYLOAD_MAX + 1));
+    itti_trace_message (message, i);
+    test_trace_free_message (message);
+  }
+  test_trace_stop (&file);
+
+  /*
+   * Scan the last ring_size bytes like itti_trace_decoder: a record is valid only at its own position
+   */
+  position = file.header->head - TEST_TRACE_RING_SIZE;
+  while (position < file.header->head) {
+    record = (const itti_trace_record_t *) &file.ring[position & (TEST_TRACE_RING_SIZE - 1)];
+    if ((record->position != position) || (ITTI_TRACE_RECORD_MAGIC != ITTI_TRACE_COMMIT_MAGIC (record->commit))) {
+      position += ITTI_TRACE_RECORD_ALIGN;
+      continue;
+    }
+    if (expected_number) {
+      ck_assert_uint_eq (record->message_number, expected_number);
+    }
+    test_trace_check_record (record, record->message_number, record->message_number % (TEST_TRACE_PAYLOAD_MAX + 1));
+    expected_number = record->message_number + 1;
+    nb_records++;
+    position += ITTI_TRACE_COMMIT_SIZE (record->commit);
+  }
+  ck_assert_uint_eq (position, file.header->head);
+  ck_assert_uint_eq (expected_number, TEST_TRACE_MESSAGES + 1);
+  ck_assert_int_gt (nb_records, 0);
+  ck_assert_uint_eq (file.header->skipped, 0);
+  free (file.content);
+}
+END_TEST
+
+Suite * itti_trace_sgw_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("ITTI trace SPGW");
+
+    /* Core test case */
+    tc_core = tcase_create("Trace records test");
+    tcase_add_test(tc_core, itti_trace_sgw_payload_test);
+    tcase_add_test(tc_core, itti_trace_sgw_wrap_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = itti_trace_sgw_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
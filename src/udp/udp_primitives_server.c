@@ -26,6 +26,7 @@
   \email: lionel.gauthier@eurecom.fr
 */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -37,7 +38,9 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <poll.h>
 #include <stdbool.h>
+#include <sys/eventfd.h>
 
 #include "bstrlib.h"
 
@@ -52,17 +55,29 @@
 #include "itti_free_defined_msg.h"
 
 
+/* One of the SO_REUSEPORT sockets bound to a local port and the thread reading it.
+   The kernel hashes the address and port of the peer to select the socket, all the
+   datagrams of a peer are received by the same thread and keep their order. */
+typedef struct udp_receiver_s {
+  pthread_t                               thread;
+  int                                     sd;
+  struct udp_socket_desc_s               *socket_desc;
+  /* UDP_DATA_IND messages and their buffers the next datagrams are received in, see udp_data_inds */
+  MessageDef                             *data_inds[UDP_RECV_BATCH_SIZE];
+} udp_receiver_t;
+
 struct udp_socket_desc_s {
-  uint8_t                                 buffer[4096];
   int                                     sd;   /* Socket descriptor to use */
 
-  pthread_t                               listener_thread;      /* Thread affected to recv */
-
   struct in_addr                          local_address;        /* Local ipv4 address to use */
   uint16_t                                local_port;   /* Local port to use */
 
   task_id_t                               task_id;      /* Task who has requested the new endpoint */
 
+  /* 0 if sd is read by TASK_UDP, else the sockets of the port and their threads, receivers[0].sd is sd */
+  int                                     nb_receivers;
+  udp_receiver_t                         *receivers;
+
                                           STAILQ_ENTRY (
   udp_socket_desc_s)                      entries;
 };
@@ -73,9 +88,35 @@ STAILQ_HEAD (
   udp_socket_desc_s) udp_socket_list;
      static pthread_mutex_t                  udp_socket_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Sockets bound to each local port, from the configuration */
+static int                              udp_nb_receiver_threads = UDP_RECEIVER_THREADS;
+/* Polled by all the receiver threads with their socket, written once by udp_exit() to stop them */
+static int                              udp_receivers_exit_fd = -1;
+static volatile bool                    udp_receivers_exit = false;
+
+/* Datagrams of the UDP_DATA_REQ messages of a batch of ITTI messages, sent per socket with sendmmsg()
+   once the batch is handled. The references on their buffers are taken from the messages and released
+   once sent. Only the TASK_UDP thread uses them. */
+typedef struct udp_send_batch_s {
+  int                                     nb_datagrams;
+  int                                     sd[UDP_SEND_BATCH_SIZE];
+  udp_buffer_t                           *buffers[UDP_SEND_BATCH_SIZE];
+  struct mmsghdr                          msgs[UDP_SEND_BATCH_SIZE];
+  struct iovec                            iovs[UDP_SEND_BATCH_SIZE];
+  struct sockaddr_in                      peer_addrs[UDP_SEND_BATCH_SIZE];
+} udp_send_batch_t;
 
-static void                             udp_server_receive_and_process (
-  struct udp_socket_desc_s *udp_sock_pP);
+static udp_send_batch_t                 udp_send_batch;
+
+/* UDP_DATA_IND messages the next datagrams are received in by recvmmsg(), in their buffer. A message
+   sent to the task owning the socket is replaced before the next receive. */
+static MessageDef                      *udp_data_inds[UDP_RECV_BATCH_SIZE];
+
+
+static int                              udp_server_receive_and_process (
+  struct udp_socket_desc_s *udp_sock_pP,
+  int sd,
+  MessageDef **data_inds);
 
 
 /* @brief Retrieve the descriptor associated with the task_id
@@ -132,16 +173,18 @@ udp_server_get_socket_desc_by_sd (
   return udp_sock_p;
 }
 
+//------------------------------------------------------------------------------
 static
   int
-udp_server_create_socket (
+udp_server_open_socket (
   uint16_t port,
   struct in_addr *address,
-  task_id_t task_id)
+  bool reuse_port,
+  uint16_t *bound_port)
 {
   struct sockaddr_in                      addr;
   int                                     sd;
-  struct udp_socket_desc_s               *socket_desc_p = NULL;
+  int                                     on = 1;
 
 
   /*
@@ -155,6 +198,15 @@ udp_server_create_socket (
     return sd;
   }
 
+  /*
+   * Must be set on every socket of the port before it is bound
+   */
+  if (reuse_port && (setsockopt (sd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof (on)) < 0)) {
+    OAILOG_ERROR (LOG_UDP, "setsockopt SO_REUSEPORT failed: %s\n", strerror (errno));
+    close (sd);
+    return -1;
+  }
+
   memset (&addr, 0, sizeof (struct sockaddr_in));
   addr.sin_family = AF_INET;
   addr.sin_port = htons (port);
@@ -174,12 +226,13 @@ udp_server_create_socket (
   }
   struct sockaddr_in                      addr_check;
   socklen_t len = sizeof(addr_check);
-  if (getsockname(sd, (struct sockaddr *)&addr_check, &len) != -1)
-    OAILOG_DEBUG (LOG_UDP, "Listened on port %" PRIu16 "\n", ntohs(addr_check.sin_port));
+  if (getsockname(sd, (struct sockaddr *)&addr_check, &len) < 0) {
+    OAILOG_ERROR (LOG_UDP, "getsockname failed: %s\n", strerror (errno));
+    close (sd);
+    return -1;
+  }
+  OAILOG_DEBUG (LOG_UDP, "Listened on port %" PRIu16 "\n", ntohs(addr_check.sin_port));
 
-  /*
-   * Add the socket to list of fd monitored by ITTI
-   */
   /*
    * Mark the socket as non-blocking
    */
@@ -189,17 +242,140 @@ udp_server_create_socket (
     return -1;
   }
 
+  if (bound_port) {
+    *bound_port = ntohs(addr_check.sin_port);
+  }
+  return sd;
+}
+
+//------------------------------------------------------------------------------
+static void *
+udp_receiver_thread (
+  void *args_p)
+{
+  udp_receiver_t                         *receiver = (udp_receiver_t *) args_p;
+  struct pollfd                           pfds[2];
+
+  pfds[0].fd = receiver->sd;
+  pfds[0].events = POLLIN;
+  pfds[1].fd = udp_receivers_exit_fd;
+  pfds[1].events = POLLIN;
+
+  while (1) {
+    pfds[0].revents = 0;
+    pfds[1].revents = 0;
+    if (poll (pfds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_UDP, "poll failed on sd %d: %s\n", receiver->sd, strerror (errno));
+      break;
+    }
+    /*
+     * The thread only stops here, it never holds a lock or a message when udp_exit() joins it
+     */
+    if (pfds[1].revents) {
+      break;
+    }
+    /*
+     * Until the socket is drained, the receives that do not fill a batch end it
+     */
+    while ((!udp_receivers_exit) && (udp_server_receive_and_process (receiver->socket_desc, receiver->sd, receiver->data_inds) == UDP_RECV_BATCH_SIZE));
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static
+  int
+udp_server_create_socket (
+  uint16_t port,
+  struct in_addr *address,
+  task_id_t task_id)
+{
+  int                                     sd;
+  uint16_t                                local_port = 0;
+  struct udp_socket_desc_s               *socket_desc_p = NULL;
+  bool                                    reuse_port = (udp_nb_receiver_threads > 1);
+  int                                     i = 0;
+
+  if (reuse_port && port) {
+    /*
+     * Without SO_REUSEPORT binding an endpoint twice fails, with it the second endpoint would join the sockets of the first one
+     */
+    pthread_mutex_lock (&udp_socket_list_mutex);
+    STAILQ_FOREACH (socket_desc_p, &udp_socket_list, entries) {
+      if ((socket_desc_p->local_port == port) &&
+          ((socket_desc_p->local_address.s_addr == address->s_addr) ||
+           (socket_desc_p->local_address.s_addr == INADDR_ANY) || (address->s_addr == INADDR_ANY))) {
+        break;
+      }
+    }
+    pthread_mutex_unlock (&udp_socket_list_mutex);
+    if (socket_desc_p) {
+      OAILOG_ERROR (LOG_UDP, "Port %" PRIu16 " already bound by task %d, not bound by task %d\n", port, socket_desc_p->task_id, task_id);
+      return -1;
+    }
+  }
+
+  /*
+   * The first socket resolves an ephemeral port, the next ones are bound to the same port
+   */
+  if ((sd = udp_server_open_socket (port, address, reuse_port, &local_port)) < 0) {
+    return -1;
+  }
+
   socket_desc_p = calloc (1, sizeof (struct udp_socket_desc_s));
   DevAssert (socket_desc_p != NULL);
   socket_desc_p->sd = sd;
   socket_desc_p->local_address.s_addr = address->s_addr;
-  socket_desc_p->local_port = ntohs(addr_check.sin_port);
+  socket_desc_p->local_port = local_port;
   socket_desc_p->task_id = task_id;
-  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for task %d, sd %d\n", socket_desc_p->task_id, socket_desc_p->sd);
+
+  if (reuse_port) {
+    socket_desc_p->receivers = calloc (udp_nb_receiver_threads, sizeof (udp_receiver_t));
+    DevAssert (socket_desc_p->receivers != NULL);
+    socket_desc_p->receivers[0].sd = sd;
+    for (i = 1; i < udp_nb_receiver_threads; i++) {
+      if ((socket_desc_p->receivers[i].sd = udp_server_open_socket (local_port, address, true, NULL)) < 0) {
+        while (--i >= 0) {
+          close (socket_desc_p->receivers[i].sd);
+        }
+        free_wrapper ((void**)&socket_desc_p->receivers);
+        free_wrapper ((void**)&socket_desc_p);
+        return -1;
+      }
+    }
+    for (i = 0; i < udp_nb_receiver_threads; i++) {
+      socket_desc_p->receivers[i].socket_desc = socket_desc_p;
+      if (pthread_create (&socket_desc_p->receivers[i].thread, NULL, &udp_receiver_thread, (void *)&socket_desc_p->receivers[i]) != 0) {
+        OAILOG_ERROR (LOG_UDP, "pthread_create: %s:%d\n", strerror (errno), errno);
+        break;
+      }
+      socket_desc_p->nb_receivers++;
+    }
+    /*
+     * Sockets without thread are closed, the kernel hashes the peers over the remaining ones.
+     * Without any thread the first socket is read by TASK_UDP.
+     */
+    for (i = (socket_desc_p->nb_receivers) ? socket_desc_p->nb_receivers : 1; i < udp_nb_receiver_threads; i++) {
+      close (socket_desc_p->receivers[i].sd);
+    }
+    if (socket_desc_p->nb_receivers == 0) {
+      free_wrapper ((void**)&socket_desc_p->receivers);
+    }
+  }
+
+  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for task %d, sd %d, %d receiver threads\n", socket_desc_p->task_id, socket_desc_p->sd, socket_desc_p->nb_receivers);
   pthread_mutex_lock (&udp_socket_list_mutex);
   STAILQ_INSERT_TAIL (&udp_socket_list, socket_desc_p, entries);
   pthread_mutex_unlock (&udp_socket_list_mutex);
-  itti_subscribe_event_fd (TASK_UDP, sd);
+  if (socket_desc_p->nb_receivers == 0) {
+    /*
+     * Add the socket to list of fd monitored by ITTI
+     */
+    itti_subscribe_event_fd (TASK_UDP, sd);
+  }
   return sd;
 }
 
@@ -222,7 +398,7 @@ udp_server_flush_sockets (
       udp_sock_p = udp_server_get_socket_desc_by_sd (events[event].data.fd);
 
       if (udp_sock_p != NULL) {
-        udp_server_receive_and_process (udp_sock_p);
+        udp_server_receive_and_process (udp_sock_p, udp_sock_p->sd, udp_data_inds);
       } else {
         OAILOG_ERROR (LOG_UDP, "Failed to retrieve the udp socket descriptor %d", events[event].data.fd);
       }
@@ -232,65 +408,194 @@ udp_server_flush_sockets (
   }
 }
 
-static void
+/* @brief Receive a batch of datagrams of sd, one of the sockets of udp_sock_pP, and send them to the task owning it.
+   Called by TASK_UDP with udp_data_inds or by the receiver thread of sd with its own spare messages.
+   @returns the number of datagrams received, 0 if none
+*/
+static int
 udp_server_receive_and_process (
-  struct udp_socket_desc_s *udp_sock_pP)
+  struct udp_socket_desc_s *udp_sock_pP,
+  int sd,
+  MessageDef **data_inds)
 {
-  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for task %d, sd %d\n", udp_sock_pP->task_id, udp_sock_pP->sd);
-  {
-    int                                     bytes_received = 0;
-    socklen_t                               from_len;
-    struct sockaddr_in                      addr;
+  struct mmsghdr                          msgs[UDP_RECV_BATCH_SIZE];
+  struct iovec                            iovs[UDP_RECV_BATCH_SIZE];
+  struct sockaddr_in                      addrs[UDP_RECV_BATCH_SIZE];
+  MessageDef                             *message_p = NULL;
+  udp_data_ind_t                         *udp_data_ind_p = NULL;
+  int                                     nb_received = 0;
+  int                                     i = 0;
 
-    from_len = (socklen_t) sizeof (struct sockaddr_in);
+  OAILOG_DEBUG (LOG_UDP, "Receiving datagrams for task %d, sd %d\n", udp_sock_pP->task_id, sd);
 
-    if ((bytes_received = recvfrom (udp_sock_pP->sd, udp_sock_pP->buffer, sizeof (udp_sock_pP->buffer), 0, (struct sockaddr *)&addr, &from_len)) <= 0) {
-      OAILOG_ERROR (LOG_UDP, "Recvfrom failed %s\n", strerror (errno));
-      //break;
-    } else {
-      MessageDef                             *message_p = NULL;
-      udp_data_ind_t                         *udp_data_ind_p;
-      AssertFatal (sizeof (udp_sock_pP->buffer) >= bytes_received, "UDP BUFFER OVERFLOW");
-      message_p = itti_alloc_new_message (TASK_UDP, UDP_DATA_IND);
-      DevAssert (message_p != NULL);
-      udp_data_ind_p = &message_p->ittiMsg.udp_data_ind;
-      memcpy (udp_data_ind_p->msgBuf, udp_sock_pP->buffer, bytes_received);
-
-      udp_data_ind_p->buffer_length = bytes_received;
-      udp_data_ind_p->local_port = udp_sock_pP->local_port;
-      udp_data_ind_p->peer_port = htons (addr.sin_port);
-      udp_data_ind_p->peer_address = addr.sin_addr;
-      OAILOG_DEBUG (LOG_UDP, "Msg of length %d received from %s:%u\n", bytes_received, inet_ntoa (addr.sin_addr), ntohs (addr.sin_port));
-
-      if (itti_send_msg_to_task (udp_sock_pP->task_id, INSTANCE_DEFAULT, message_p) < 0) {
-        OAILOG_DEBUG (LOG_UDP, "Failed to send message %d to task %d\n", UDP_DATA_IND, udp_sock_pP->task_id);
-        //break;
+  /*
+   * Each datagram is received straight in the buffer of its UDP_DATA_IND message, the receiving task parses it in place
+   */
+  for (i = 0; i < UDP_RECV_BATCH_SIZE; i++) {
+    if (data_inds[i] == NULL) {
+      data_inds[i] = itti_alloc_new_message (TASK_UDP, UDP_DATA_IND);
+      DevAssert (data_inds[i] != NULL);
+      data_inds[i]->ittiMsg.udp_data_ind.buffer = udp_buffer_alloc ();
+      DevAssert (data_inds[i]->ittiMsg.udp_data_ind.buffer != NULL);
+    }
+    iovs[i].iov_base = data_inds[i]->ittiMsg.udp_data_ind.buffer->data;
+    iovs[i].iov_len = UDP_DATA_MAX_MSG_LEN;
+    memset (&msgs[i], 0, sizeof (msgs[i]));
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  /*
+   * The socket is level triggered in the ITTI epoll or polled again by its receiver thread, datagrams left are received on the next event
+   */
+  do {
+    nb_received = recvmmsg (sd, msgs, UDP_RECV_BATCH_SIZE, MSG_DONTWAIT, NULL);
+  } while ((nb_received < 0) && (errno == EINTR));
+
+  if (nb_received < 0) {
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+      OAILOG_ERROR (LOG_UDP, "Recvmmsg failed %s\n", strerror (errno));
+    }
+    return 0;
+  }
+
+  for (i = 0; i < nb_received; i++) {
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      /*
+       * The message is kept for the next receive
+       */
+      OAILOG_ERROR (LOG_UDP, "Datagram bigger than %d bytes received from %s:%u, dropped\n", UDP_DATA_MAX_MSG_LEN, inet_ntoa (addrs[i].sin_addr), ntohs (addrs[i].sin_port));
+      continue;
+    }
+
+    message_p = data_inds[i];
+    data_inds[i] = NULL;
+    udp_data_ind_p = &message_p->ittiMsg.udp_data_ind;
+    udp_data_ind_p->buffer_length = msgs[i].msg_len;
+    udp_data_ind_p->local_port = udp_sock_pP->local_port;
+    udp_data_ind_p->peer_port = htons (addrs[i].sin_port);
+    udp_data_ind_p->peer_address = addrs[i].sin_addr;
+    OAILOG_DEBUG (LOG_UDP, "Msg of length %d received from %s:%u\n", msgs[i].msg_len, inet_ntoa (addrs[i].sin_addr), ntohs (addrs[i].sin_port));
+
+    /*
+     * A message ITTI fails to queue is freed with its content, the buffer reference included
+     */
+    if (itti_send_msg_to_task (udp_sock_pP->task_id, INSTANCE_DEFAULT, message_p) < 0) {
+      OAILOG_DEBUG (LOG_UDP, "Failed to send message %d to task %d, datagram dropped\n", UDP_DATA_IND, udp_sock_pP->task_id);
+    }
+  }
+  return nb_received;
+}
+
+//------------------------------------------------------------------------------
+static void
+udp_server_flush_send_batch (
+  void)
+{
+  struct mmsghdr                          msgs[UDP_SEND_BATCH_SIZE];
+  int                                     nb_msgs = 0;
+  int                                     sent = 0;
+  int                                     rc = 0;
+  int                                     sd = -1;
+  int                                     i = 0,
+                                          j = 0;
+
+  /*
+   * One sendmmsg() per socket, the datagrams of a socket keep their order
+   */
+  for (i = 0; i < udp_send_batch.nb_datagrams; i++) {
+    if ((sd = udp_send_batch.sd[i]) < 0) {
+      continue;
+    }
+
+    nb_msgs = 0;
+    for (j = i; j < udp_send_batch.nb_datagrams; j++) {
+      if (udp_send_batch.sd[j] == sd) {
+        msgs[nb_msgs++] = udp_send_batch.msgs[j];
+        udp_send_batch.sd[j] = -1;
+      }
+    }
+
+    for (sent = 0; sent < nb_msgs;) {
+      if ((rc = sendmmsg (sd, &msgs[sent], nb_msgs - sent, 0)) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+          OAILOG_ERROR (LOG_UDP, "[%d] Socket full, %d datagrams dropped\n", sd, nb_msgs - sent);
+          break;
+        }
+        /*
+         * The first datagram cannot be sent, the next ones may go to other peers
+         */
+        OAILOG_ERROR (LOG_UDP, "There was an error while writing to socket " "(%d:%s)\n", errno, strerror (errno));
+        sent++;
+        continue;
       }
+      sent += rc;
     }
   }
-  //close(udp_sock_pP->sd);
-  //udp_sock_pP->sd = -1;
-  //pthread_mutex_lock(&udp_socket_list_mutex);
-  //STAILQ_REMOVE(&udp_socket_list, udp_sock_pP, udp_socket_desc_s, entries);
-  //pthread_mutex_unlock(&udp_socket_list_mutex);
-  //return NULL;
+
+  for (i = 0; i < udp_send_batch.nb_datagrams; i++) {
+    udp_buffer_unref (&udp_send_batch.buffers[i]);
+  }
+  udp_send_batch.nb_datagrams = 0;
+}
+
+//------------------------------------------------------------------------------
+static void
+udp_server_queue_datagram (
+  const int sd,
+  udp_data_req_t * const udp_data_req_p)
+{
+  int                                     i = udp_send_batch.nb_datagrams++;
+
+  memset (&udp_send_batch.peer_addrs[i], 0, sizeof (struct sockaddr_in));
+  udp_send_batch.peer_addrs[i].sin_family = AF_INET;
+  udp_send_batch.peer_addrs[i].sin_port = htons (udp_data_req_p->peer_port);
+  udp_send_batch.peer_addrs[i].sin_addr = udp_data_req_p->peer_address;
+  /*
+   * Take the reference of the message, the buffer stays valid until the batch is flushed
+   */
+  udp_send_batch.buffers[i] = udp_data_req_p->buffer;
+  udp_data_req_p->buffer = NULL;
+  udp_send_batch.iovs[i].iov_base = &udp_send_batch.buffers[i]->data[udp_data_req_p->buffer_offset];
+  udp_send_batch.iovs[i].iov_len = udp_data_req_p->buffer_length;
+  memset (&udp_send_batch.msgs[i], 0, sizeof (struct mmsghdr));
+  udp_send_batch.msgs[i].msg_hdr.msg_name = &udp_send_batch.peer_addrs[i];
+  udp_send_batch.msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+  udp_send_batch.msgs[i].msg_hdr.msg_iov = &udp_send_batch.iovs[i];
+  udp_send_batch.msgs[i].msg_hdr.msg_iovlen = 1;
+  udp_send_batch.sd[i] = sd;
+
+  if (udp_send_batch.nb_datagrams == UDP_SEND_BATCH_SIZE) {
+    udp_server_flush_send_batch ();
+  }
 }
 
 //------------------------------------------------------------------------------
 static void *udp_intertask_interface (void *args_p)
 {
+  MessageDef                             *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+  int                                     nb_received_messages = 0;
   int                                     rc = 0;
   int                                     nb_events = 0;
+  int                                     i = 0;
   struct epoll_event                     *events = NULL;
 
   itti_mark_task_ready (TASK_UDP);
 
   while (1) {
-    MessageDef                             *received_message_p = NULL;
+    /*
+     * The datagrams of a batch of messages are queued, then sent with one sendmmsg() per socket
+     */
+    nb_received_messages = itti_receive_msg_batch (TASK_UDP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
 
-    itti_receive_msg (TASK_UDP, &received_message_p);
+    for (i = 0; i < nb_received_messages; i++) {
+      MessageDef                             *received_message_p = received_messages[i];
 
-    if (received_message_p != NULL) {
       switch (ITTI_MSG_ID (received_message_p)) {
       case MESSAGE_TEST:{
           OAI_FPRINTF_INFO("TASK_UDP received MESSAGE_TEST\n");
@@ -315,40 +620,29 @@ static void *udp_intertask_interface (void *args_p)
 
       case UDP_DATA_REQ:{
           int                                     udp_sd = -1;
-          ssize_t                                 bytes_written;
           struct udp_socket_desc_s               *udp_sock_p = NULL;
           udp_data_req_t                         *udp_data_req_p;
-          struct sockaddr_in                      peer_addr;
 
           udp_data_req_p = &received_message_p->ittiMsg.udp_data_req;
           //UDP_DEBUG("-- UDP_DATA_REQ -----------------------------------------------------\n%s :\n",
           //        __FUNCTION__);
-          //udp_print_hex_octets(&udp_data_req_p->buffer[udp_data_req_p->buffer_offset],
+          //udp_print_hex_octets(&udp_data_req_p->buffer->data[udp_data_req_p->buffer_offset],
           //        udp_data_req_p->buffer_length);
-          memset (&peer_addr, 0, sizeof (struct sockaddr_in));
-          peer_addr.sin_family = AF_INET;
-          peer_addr.sin_port = htons (udp_data_req_p->peer_port);
-          peer_addr.sin_addr = udp_data_req_p->peer_address;
           pthread_mutex_lock (&udp_socket_list_mutex);
           udp_sock_p = udp_server_get_socket_desc (ITTI_MSG_ORIGIN_ID (received_message_p), udp_data_req_p->local_port, udp_data_req_p->peer_port);
 
           if (udp_sock_p == NULL) {
             OAILOG_ERROR (LOG_UDP, "Failed to retrieve the udp socket descriptor " "associated with task %d\n", ITTI_MSG_ORIGIN_ID (received_message_p));
             pthread_mutex_unlock (&udp_socket_list_mutex);
-            // no free udp_data_req_p->buffer, statically allocated
-            goto on_error;
+            // udp_data_req_p->buffer released with the message
+            break;
           }
 
           udp_sd = udp_sock_p->sd;
           pthread_mutex_unlock (&udp_socket_list_mutex);
-          OAILOG_DEBUG (LOG_UDP, "[%d] Sending message of size %u to " IN_ADDR_FMT " and port %u\n",
+          OAILOG_DEBUG (LOG_UDP, "[%d] Queuing message of size %u to " IN_ADDR_FMT " and port %u\n",
               udp_sd, udp_data_req_p->buffer_length, PRI_IN_ADDR (udp_data_req_p->peer_address), udp_data_req_p->peer_port);
-          bytes_written = sendto (udp_sd, &udp_data_req_p->buffer[udp_data_req_p->buffer_offset], udp_data_req_p->buffer_length, 0, (struct sockaddr *)&peer_addr, sizeof (struct sockaddr_in));
-          // no free udp_data_req_p->buffer, statically allocated
-
-          if (bytes_written != udp_data_req_p->buffer_length) {
-            OAILOG_ERROR (LOG_UDP, "There was an error while writing to socket " "(%d:%s)\n", errno, strerror (errno));
-          }
+          udp_server_queue_datagram (udp_sd, udp_data_req_p);
         }
         break;
 
@@ -358,11 +652,13 @@ static void *udp_intertask_interface (void *args_p)
         break;
       }
 
-    on_error:
       itti_free_msg_content(received_message_p);
       rc = itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
       AssertFatal (rc == EXIT_SUCCESS, "Failed to free memory (%d)!\n", rc);
-      received_message_p = NULL;
+    }
+
+    if (udp_send_batch.nb_datagrams) {
+      udp_server_flush_send_batch ();
     }
 
     nb_events = itti_get_events (TASK_UDP, &events);
@@ -379,10 +675,15 @@ static void *udp_intertask_interface (void *args_p)
 }
 
 //------------------------------------------------------------------------------
-int udp_init (void)
+int udp_init (const mme_config_t * mme_config_p)
 {
   OAILOG_DEBUG (LOG_UDP, "Initializing UDP task interface\n");
   STAILQ_INIT (&udp_socket_list);
+  udp_nb_receiver_threads = (mme_config_p->udp_config.nb_receiver_threads) ? mme_config_p->udp_config.nb_receiver_threads : UDP_RECEIVER_THREADS;
+  if ((udp_nb_receiver_threads > 1) && ((udp_receivers_exit_fd = eventfd (0, EFD_CLOEXEC)) < 0)) {
+    OAILOG_ERROR (LOG_UDP, "eventfd: %s, sockets read by TASK_UDP\n", strerror (errno));
+    udp_nb_receiver_threads = 1;
+  }
 
   if (itti_create_task (TASK_UDP, &udp_intertask_interface, NULL) < 0) {
     OAILOG_ERROR (LOG_UDP, "udp pthread_create (%s)\n", strerror (errno));
@@ -397,11 +698,51 @@ int udp_init (void)
 void udp_exit (void)
 {
   struct udp_socket_desc_s               *socket_desc_p = NULL;
+  int                                     i = 0,
+                                          j = 0;
+
+  if (udp_send_batch.nb_datagrams) {
+    udp_server_flush_send_batch ();
+  }
+  for (i = 0; i < UDP_RECV_BATCH_SIZE; i++) {
+    if (udp_data_inds[i]) {
+      itti_free_msg_content (udp_data_inds[i]);
+      itti_free (TASK_UDP, udp_data_inds[i]);
+      udp_data_inds[i] = NULL;
+    }
+  }
+  /*
+   * Never read, the event stays signaled for every receiver thread
+   */
+  udp_receivers_exit = true;
+  if ((udp_receivers_exit_fd >= 0) && (eventfd_write (udp_receivers_exit_fd, 1) < 0)) {
+    OAILOG_ERROR (LOG_UDP, "eventfd_write: %s\n", strerror (errno));
+  }
   while ((socket_desc_p = STAILQ_FIRST (&udp_socket_list))) {
-    itti_unsubscribe_event_fd(TASK_UDP, socket_desc_p->sd);
-    close(socket_desc_p->sd);
+    if (socket_desc_p->nb_receivers) {
+      for (i = 0; i < socket_desc_p->nb_receivers; i++) {
+        udp_receiver_t                         *receiver = &socket_desc_p->receivers[i];
+
+        pthread_join (receiver->thread, NULL);
+        close (receiver->sd);
+        for (j = 0; j < UDP_RECV_BATCH_SIZE; j++) {
+          if (receiver->data_inds[j]) {
+            itti_free_msg_content (receiver->data_inds[j]);
+            itti_free (TASK_UDP, receiver->data_inds[j]);
+          }
+        }
+      }
+      free_wrapper ((void**)&socket_desc_p->receivers);
+    } else {
+      itti_unsubscribe_event_fd(TASK_UDP, socket_desc_p->sd);
+      close(socket_desc_p->sd);
+    }
     pthread_mutex_destroy(&udp_socket_list_mutex);
     STAILQ_REMOVE_HEAD (&udp_socket_list, entries);
     free_wrapper ((void**)&socket_desc_p);
   }
+  if (udp_receivers_exit_fd >= 0) {
+    close (udp_receivers_exit_fd);
+    udp_receivers_exit_fd = -1;
+  }
 }
@@ -31,9 +31,12 @@
 #define UDP_PRIMITIVES_SERVER_H_
 
 /** \brief UDP task init function.
+ With udp_config.nb_receiver_threads > 1, each UDP_INIT binds that many
+ SO_REUSEPORT sockets to the port, each one read by its own thread.
+ @param mme_config_p configuration of the MME
  @returns -1 on error, 0 otherwise.
  **/
-int udp_init(void);
+int udp_init(const struct mme_config_s *mme_config_p);
 void udp_exit (void);
 
 
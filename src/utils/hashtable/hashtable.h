@@ -49,6 +49,85 @@ typedef enum hashtable_return_code_e {
 #define HASH_TABLE_DEFAULT_HASH_FUNC NULL
 #define HASH_TABLE_DEFAULT_free_wrapper_FUNC NULL
 
+/*
+ * The non thread safe tables (hash_table_t, hash_table_uint64_t) use open
+ * addressing: Robin Hood hashing with linear probing and backward shift
+ * deletion over a flat array of slots. A probe length of 0 marks an empty
+ * slot, otherwise it is the distance of the key from its home slot plus one.
+ * The tables grow when they are more than HASH_TABLE_MAX_LOAD_EIGHTHS / 8 full,
+ * or when a key would be more than HASH_TABLE_MAX_PROBE_LENGTH slots away from
+ * its home slot. If growing does not help (too few distinct hash values), the
+ * insert fails with HASH_TABLE_SYSTEM_ERROR and the table is left unchanged.
+ */
+#define HASH_TABLE_MAX_LOAD_EIGHTHS     (7)
+#define HASH_TABLE_MAX_PROBE_LENGTH     (255)
+
+/*
+ * The thread safe tables (hash_table_ts_t, hash_table_uint64_ts_t and the
+ * obj_hashtable_ts functions) resize incrementally: while a resize is in
+ * progress they own two bucket arrays, every access first migrates the old
+ * bucket of its key and every insert/remove migrates
+ * HASH_TABLE_REHASH_BUCKETS_PER_OP more old buckets. They grow (x2) above
+ * HASH_TABLE_TS_MAX_LOAD elements per bucket and shrink (/2) below
+ * 1/HASH_TABLE_TS_MIN_LOAD_INVERSE elements per bucket, never below the
+ * size they were created with.
+ */
+#define HASH_TABLE_TS_MAX_LOAD               (1)
+#define HASH_TABLE_TS_MIN_LOAD_INVERSE       (8)
+#define HASH_TABLE_REHASH_BUCKETS_PER_OP     (4)
+#define HASH_TABLE_RESIZE_LOCK_TRIES         (16)
+
+/*
+ * Their get and is_key_exists functions take no lock: they run inside an
+ * epoch section (see hashtable_epoch.h), unlinked nodes and bucket arrays are
+ * retired instead of being freed. A lookup that misses while a resize moves
+ * nodes is retried, after HASH_TABLE_LOCK_FREE_READ_TRIES tries it takes the
+ * locks like the writers do.
+ */
+#define HASH_TABLE_LOCK_FREE_READ_TRIES      (4)
+
+/*
+ * 64 bits mixer (splitmix64 finalizer): every bit of the key affects the low
+ * bits of the result, so that IMSI64 keys do not cluster in power of two tables.
+ */
+static inline hash_size_t hashtable_mix64 (uint64_t keyP)
+{
+  keyP ^= keyP >> 30;
+  keyP *= 0xbf58476d1ce4e5b9ULL;
+  keyP ^= keyP >> 27;
+  keyP *= 0x94d049bb133111ebULL;
+  keyP ^= keyP >> 31;
+  return (hash_size_t) keyP;
+}
+
+/*
+ * Number of slots or buckets of a table created or resized for sizeP
+ * elements: the upper power of two, at least 8.
+ */
+static inline hash_size_t hashtable_round_size (const hash_size_t sizeP)
+{
+  hash_size_t size = (sizeP < 8) ? 8 : sizeP;
+  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
+  //  By Sean Eron Anderson
+  // seander@cs.stanford.edu
+  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
+  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
+  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
+  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
+  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
+  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
+  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
+  size--;
+  size |= size >> 1;
+  size |= size >> 2;
+  size |= size >> 4;
+  size |= size >> 8;
+  size |= size >> 16;
+  size |= size >> 32;
+  size++;
+  return size;
+}
+
 
 typedef struct hash_node_s {
     hash_key_t          key;
@@ -62,10 +141,21 @@ typedef struct hash_node_uint64_s {
     struct hash_node_uint64_s *next;
 } hash_node_uint64_t;
 
+typedef struct hash_slot_s {
+    hash_key_t          key;
+    void               *data;
+} hash_slot_t;
+
+typedef struct hash_slot_uint64_s {
+    hash_key_t          key;
+    uint64_t            data;
+} hash_slot_uint64_t;
+
 typedef struct hash_table_s {
     hash_size_t         size;
     hash_size_t         num_elements;
-    struct hash_node_s **nodes;
+    hash_slot_t        *slots;
+    uint8_t            *probe_lengths;
     hash_size_t       (*hashfunc)(const hash_key_t);
     void              (*freefunc)(void**);
     bstring             name;
@@ -84,12 +174,30 @@ typedef struct hash_table_ts_s {
     bstring             name;
     bool                is_allocated_by_malloc;
     bool                log_enabled;
+    /* Incremental resize: bucket arrays are swapped with resize_lock held for writing */
+    pthread_rwlock_t    resize_lock;
+    hash_size_t         min_size;
+    hash_size_t         old_size;
+    struct hash_node_s **old_nodes;
+    pthread_mutex_t     *old_lock_nodes;
+    hash_size_t         rehash_index;
+    hash_size_t         rehashed_buckets;
+    /* Lock-free readers retry when a bucket array swap or a bucket migration ran meanwhile */
+    volatile uint64_t   rehash_seq_begin;
+    volatile uint64_t   rehash_seq_end;
+    /* Open cursors, no resize starts while there is one */
+    volatile int        cursors;
+    /* Buckets allocated for a resize that could not take resize_lock yet */
+    hash_size_t         next_size;
+    struct hash_node_s **next_nodes;
+    pthread_mutex_t     *next_lock_nodes;
 } hash_table_ts_t;
 
 typedef struct hash_table_uint64_s {
     hash_size_t         size;
     hash_size_t         num_elements;
-    struct hash_node_uint64_s **nodes;
+    hash_slot_uint64_t *slots;
+    uint8_t            *probe_lengths;
     hash_size_t       (*hashfunc)(const hash_key_t);
     bstring             name;
     bool                is_allocated_by_malloc;
@@ -106,8 +214,33 @@ typedef struct hash_table_uint64_ts_s {
     bstring             name;
     bool                is_allocated_by_malloc;
     bool                log_enabled;
+    /* Incremental resize: bucket arrays are swapped with resize_lock held for writing */
+    pthread_rwlock_t    resize_lock;
+    hash_size_t         min_size;
+    hash_size_t         old_size;
+    struct hash_node_uint64_s **old_nodes;
+    pthread_mutex_t     *old_lock_nodes;
+    hash_size_t         rehash_index;
+    hash_size_t         rehashed_buckets;
+    /* Lock-free readers retry when a bucket array swap or a bucket migration ran meanwhile */
+    volatile uint64_t   rehash_seq_begin;
+    volatile uint64_t   rehash_seq_end;
+    /* Open cursors, no resize starts while there is one */
+    volatile int        cursors;
+    /* Buckets allocated for a resize that could not take resize_lock yet */
+    hash_size_t         next_size;
+    struct hash_node_uint64_s **next_nodes;
+    pthread_mutex_t     *next_lock_nodes;
 } hash_table_uint64_ts_t;
 
+/*
+ * Position of a walk over a thread safe table, see hashtable_ts_cursor_next().
+ */
+typedef struct hashtable_ts_cursor_s {
+    hash_size_t         bucket;
+    hash_size_t         skip;      /* nodes of bucket already returned, when it did not fit in one batch */
+} hashtable_ts_cursor_t;
+
 typedef struct hashtable_key_array_s {
     int                 num_keys;
     hash_key_t         *keys;
@@ -141,6 +274,21 @@ hashtable_rc_t  hashtable_remove(hash_table_t * const hashtbl, const hash_key_t
 hashtable_rc_t  hashtable_get    (const hash_table_t * const hashtbl, const hash_key_t key, void **element) __attribute__ ((hot));
 hashtable_rc_t  hashtable_resize (hash_table_t * const hashtbl, const hash_size_t size);
 
+hash_table_uint64_t * hashtable_uint64_init (hash_table_uint64_t * const hashtbl, const hash_size_t size, hash_size_t (*hashfunc) (const hash_key_t), bstring display_name_p);
+__attribute__ ((malloc)) hash_table_uint64_t   *hashtable_uint64_create (const hash_size_t   size, hash_size_t (*hashfunc)(const hash_key_t ), bstring name_p);
+hashtable_rc_t  hashtable_uint64_destroy(hash_table_uint64_t * hashtbl);
+hashtable_rc_t  hashtable_uint64_is_key_exists (const hash_table_uint64_t * const hashtbl, const hash_key_t key) __attribute__ ((hot, warn_unused_result));
+hashtable_rc_t  hashtable_uint64_apply_callback_on_elements (hash_table_uint64_t * const hashtbl,
+                                                   bool func_cb(hash_key_t key, uint64_t element, void* parameter, void**result),
+                                                   void* parameter,
+                                                   void**result);
+hashtable_rc_t  hashtable_uint64_dump_content (const hash_table_uint64_t * const hashtbl, bstring str);
+hashtable_rc_t  hashtable_uint64_insert (hash_table_uint64_t * const hashtbl, const hash_key_t key, const uint64_t data);
+hashtable_rc_t  hashtable_uint64_free (hash_table_uint64_t * const hashtbl, const hash_key_t key);
+hashtable_rc_t  hashtable_uint64_remove(hash_table_uint64_t * const hashtbl, const hash_key_t key);
+hashtable_rc_t  hashtable_uint64_get    (const hash_table_uint64_t * const hashtbl, const hash_key_t key, uint64_t * const data) __attribute__ ((hot));
+hashtable_rc_t  hashtable_uint64_resize (hash_table_uint64_t * const hashtbl, const hash_size_t size);
+
 // Thread-safe functions
 hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtbl,const hash_size_t size,hash_size_t (*hashfunc) (const hash_key_t),void (*freefunc) (void **),bstring display_name_p);
 __attribute__ ((malloc)) hash_table_ts_t   *hashtable_ts_create (const hash_size_t   size, hash_size_t (*hashfunc)(const hash_key_t ), void (*freefunc)(void **), bstring name_p);
@@ -158,6 +306,9 @@ hashtable_ts_apply_list_callback_on_elements (hash_table_ts_t * const hashtblP,
 										 void *parameterP,
 										 hashtable_element_array_t              *ea);
 
+hashtable_rc_t  hashtable_ts_cursor_open (hash_table_ts_t * const hashtbl, hashtable_ts_cursor_t * const cursor);
+int             hashtable_ts_cursor_next (hash_table_ts_t * const hashtbl, hashtable_ts_cursor_t * const cursor, hash_key_t * const keys, void ** const elements, const int max_elements);
+void            hashtable_ts_cursor_close (hash_table_ts_t * const hashtbl, hashtable_ts_cursor_t * const cursor);
 hashtable_rc_t  hashtable_ts_dump_content (const hash_table_ts_t * const hashtbl, bstring str);
 hashtable_rc_t  hashtable_ts_insert (hash_table_ts_t * const hashtbl, const hash_key_t key, void *element);
 hashtable_rc_t  hashtable_ts_free (hash_table_ts_t * const hashtbl, const hash_key_t key);
@@ -175,6 +326,9 @@ hashtable_rc_t  hashtable_uint64_ts_apply_callback_on_elements (hash_table_uint6
                                                       bool func_cb(const hash_key_t key, const uint64_t element, void* parameter, void**result),
                                                       void* parameter,
                                                       void**result);
+hashtable_rc_t  hashtable_uint64_ts_cursor_open (hash_table_uint64_ts_t * const hashtbl, hashtable_ts_cursor_t * const cursor);
+int             hashtable_uint64_ts_cursor_next (hash_table_uint64_ts_t * const hashtbl, hashtable_ts_cursor_t * const cursor, hash_key_t * const keys, uint64_t * const elements, const int max_elements);
+void            hashtable_uint64_ts_cursor_close (hash_table_uint64_ts_t * const hashtbl, hashtable_ts_cursor_t * const cursor);
 hashtable_rc_t  hashtable_uint64_ts_dump_content (const hash_table_uint64_ts_t * const hashtbl, bstring str);
 hashtable_rc_t  hashtable_uint64_ts_insert (hash_table_uint64_ts_t * const hashtbl, const hash_key_t key, const uint64_t dataP);
 hashtable_rc_t  hashtable_uint64_ts_free (hash_table_uint64_ts_t * const hashtbl, const hash_key_t key);
@@ -0,0 +1,248 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+/*! \file hashtable_epoch.c
+  \brief Epoch based memory reclamation, see hashtable_epoch.h.
+         An item retired while the global epoch is E is released once the
+         global epoch reaches E + 2: the epoch only advances when every thread
+         inside a section has announced the current epoch, so no reader can
+         still hold a pointer to the item.
+         Each thread keeps the items it retired in a limbo list of its own,
+         released by itself without any shared lock: at the end of its
+         outermost section, where it holds no hashtable lock, or when it calls
+         hashtable_epoch_reclaim().
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "dynamic_memory_check.h"
+#include "hashtable_epoch.h"
+
+typedef struct hashtable_epoch_item_s {
+  void                                   *item;
+  void                                  (*freefunc) (void **);
+  uint64_t                                epoch;
+} hashtable_epoch_item_t;
+
+typedef struct hashtable_epoch_record_s {
+  /* (epoch << 1) | 1 while the thread is inside a section, 0 outside */
+  volatile uint64_t                       state;
+  int                                     nesting;
+  volatile int                            in_use;
+  struct hashtable_epoch_record_s        *next;
+  /* Items retired by the thread, in retire order hence by increasing epoch. Only used by the thread owning the record. */
+  hashtable_epoch_item_t                 *limbo;
+  size_t                                  limbo_count;
+  size_t                                  limbo_allocated;
+  size_t                                  next_reclaim;
+} hashtable_epoch_record_t;
+
+static volatile uint64_t                hashtable_epoch_global = 1;
+/* Records are never freed, the record of a thread that exited is reused by the next new thread, with the items
+   of its limbo list that could not be released yet */
+static hashtable_epoch_record_t * volatile hashtable_epoch_records = NULL;
+static __thread hashtable_epoch_record_t *hashtable_epoch_self = NULL;
+static pthread_key_t                    hashtable_epoch_key;
+static pthread_once_t                   hashtable_epoch_key_once = PTHREAD_ONCE_INIT;
+
+static void hashtable_epoch_reclaim_record (hashtable_epoch_record_t * const recordP);
+
+//------------------------------------------------------------------------------
+static void hashtable_epoch_thread_exit (void *recordP)
+{
+  hashtable_epoch_record_t               *record = (hashtable_epoch_record_t *) recordP;
+
+  record->nesting = 0;
+  record->state = 0;
+  __sync_synchronize ();
+  hashtable_epoch_reclaim_record (record);
+  record->in_use = 0;
+}
+
+//------------------------------------------------------------------------------
+static void hashtable_epoch_key_create (void)
+{
+  AssertFatal (pthread_key_create (&hashtable_epoch_key, hashtable_epoch_thread_exit) == 0, "Cannot create the hashtable epoch key!\n");
+}
+
+//------------------------------------------------------------------------------
+static hashtable_epoch_record_t *hashtable_epoch_register (void)
+{
+  hashtable_epoch_record_t               *record = NULL;
+
+  pthread_once (&hashtable_epoch_key_once, hashtable_epoch_key_create);
+
+  for (record = hashtable_epoch_records; record; record = record->next) {
+    if ((!record->in_use) && (__sync_bool_compare_and_swap (&record->in_use, 0, 1))) {
+      break;
+    }
+  }
+
+  if (!record) {
+    record = calloc (1, sizeof (hashtable_epoch_record_t));
+    AssertFatal (record != NULL, "Cannot allocate a hashtable epoch record!\n");
+    record->in_use = 1;
+    record->next_reclaim = HASHTABLE_EPOCH_RECLAIM_THRESHOLD;
+    do {
+      record->next = hashtable_epoch_records;
+    } while (!__sync_bool_compare_and_swap (&hashtable_epoch_records, record->next, record));
+  }
+
+  pthread_setspecific (hashtable_epoch_key, record);
+  hashtable_epoch_self = record;
+  return record;
+}
+
+//------------------------------------------------------------------------------
+void hashtable_epoch_enter (void)
+{
+  hashtable_epoch_record_t               *record = hashtable_epoch_self;
+
+  if (!record) {
+    record = hashtable_epoch_register ();
+  }
+
+  if (record->nesting++ == 0) {
+    record->state = (hashtable_epoch_global << 1) | 1;
+    /*
+     * The epoch must be announced before the first pointer of the section is read.
+     */
+    __sync_synchronize ();
+  }
+}
+
+//------------------------------------------------------------------------------
+void hashtable_epoch_exit (void)
+{
+  hashtable_epoch_record_t               *record = hashtable_epoch_self;
+
+  AssertFatal ((record) && (record->nesting > 0), "Not inside a hashtable epoch section!\n");
+  if (--record->nesting == 0) {
+    __atomic_store_n (&record->state, 0, __ATOMIC_RELEASE);
+    if (record->limbo_count >= record->next_reclaim) {
+      hashtable_epoch_reclaim_record (record);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Advance the global epoch if every thread inside a section has seen the current one.
+*/
+static void hashtable_epoch_try_advance (void)
+{
+  hashtable_epoch_record_t               *record = NULL;
+  uint64_t                                epoch = hashtable_epoch_global;
+  uint64_t                                state = 0;
+
+  __sync_synchronize ();
+  for (record = hashtable_epoch_records; record; record = record->next) {
+    state = record->state;
+    if ((state & 1) && ((state >> 1) != epoch)) {
+      return;
+    }
+  }
+  __sync_bool_compare_and_swap (&hashtable_epoch_global, epoch, epoch + 1);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Called by the thread owning the record.
+*/
+static void hashtable_epoch_reclaim_record (hashtable_epoch_record_t * const recordP)
+{
+  size_t                                  n = 0;
+
+  hashtable_epoch_try_advance ();
+
+  while ((n < recordP->limbo_count) && ((recordP->limbo[n].epoch + 2) <= hashtable_epoch_global)) {
+    recordP->limbo[n].freefunc (&recordP->limbo[n].item);
+    n++;
+  }
+
+  if (n) {
+    recordP->limbo_count -= n;
+    memmove (recordP->limbo, &recordP->limbo[n], recordP->limbo_count * sizeof (hashtable_epoch_item_t));
+  }
+  recordP->next_reclaim = recordP->limbo_count + HASHTABLE_EPOCH_RECLAIM_THRESHOLD;
+}
+
+//------------------------------------------------------------------------------
+/*
+   The item is released with freefunc once no reader can reference it any more.
+   The caller must have made it unreachable from the table first, it may still hold the lock of the table: the
+   item is only released later, at the end of the outermost section of the thread or by hashtable_epoch_reclaim().
+*/
+void hashtable_epoch_retire (void *item, void (*freefunc) (void **))
+{
+  hashtable_epoch_record_t               *record = hashtable_epoch_self;
+  hashtable_epoch_item_t                 *limbo = NULL;
+  size_t                                  allocated = 0;
+
+  if (!item) {
+    return;
+  }
+
+  if (!record) {
+    record = hashtable_epoch_register ();
+  }
+
+  if (record->limbo_count == record->limbo_allocated) {
+    /*
+     * A thread retiring items without ever reading the tables releases them here
+     */
+    if (record->limbo_count >= HASHTABLE_EPOCH_LIMBO_MAX_SIZE) {
+      hashtable_epoch_reclaim_record (record);
+    }
+  }
+  if (record->limbo_count == record->limbo_allocated) {
+    allocated = (record->limbo_allocated) ? (record->limbo_allocated << 1) : (HASHTABLE_EPOCH_RECLAIM_THRESHOLD << 1);
+    limbo = realloc (record->limbo, allocated * sizeof (hashtable_epoch_item_t));
+    AssertFatal (limbo != NULL, "Cannot grow the hashtable epoch limbo list to %zu items!\n", allocated);
+    record->limbo = limbo;
+    record->limbo_allocated = allocated;
+  }
+
+  record->limbo[record->limbo_count].item = item;
+  record->limbo[record->limbo_count].freefunc = freefunc;
+  __sync_synchronize ();
+  record->limbo[record->limbo_count].epoch = hashtable_epoch_global;
+  record->limbo_count++;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Release the items retired by the calling thread that are not referenced any more, without waiting for the
+   threshold. The caller must not hold the lock of a table whose items may be released.
+*/
+void hashtable_epoch_reclaim (void)
+{
+  hashtable_epoch_record_t               *record = hashtable_epoch_self;
+
+  if (record) {
+    hashtable_epoch_reclaim_record (record);
+  }
+}
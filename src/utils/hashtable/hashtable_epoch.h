@@ -0,0 +1,48 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file hashtable_epoch.h
+  \brief Epoch based memory reclamation for the lock-free reads of the thread
+         safe hashtables.
+         A reader brackets its accesses with hashtable_epoch_enter() and
+         hashtable_epoch_exit(), sections may be nested. Memory unlinked by a
+         writer is handed to hashtable_epoch_retire() and only released once
+         every thread that was inside a section at that time has left it.
+         Threads register themselves on their first section. Each thread
+         releases the items it retired itself, at the end of its outermost
+         section once HASHTABLE_EPOCH_RECLAIM_THRESHOLD items are pending.
+*/
+
+#ifndef FILE_HASHTABLE_EPOCH_SEEN
+#define FILE_HASHTABLE_EPOCH_SEEN
+
+/* Retired items kept before trying to advance the epoch and release them */
+#define HASHTABLE_EPOCH_RECLAIM_THRESHOLD    (64)
+/* Retired items of a thread above which hashtable_epoch_retire() releases them itself, for the threads that
+   retire items outside of any section */
+#define HASHTABLE_EPOCH_LIMBO_MAX_SIZE       (16 * HASHTABLE_EPOCH_RECLAIM_THRESHOLD)
+
+void            hashtable_epoch_enter (void);
+void            hashtable_epoch_exit (void);
+void            hashtable_epoch_retire (void *item, void (*freefunc) (void **));
+void            hashtable_epoch_reclaim (void);
+
+#endif /* FILE_HASHTABLE_EPOCH_SEEN */
@@ -30,11 +30,13 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <sched.h>
 
 #include "bstrlib.h"
 
 #include "dynamic_memory_check.h"
 #include "hashtable.h"
+#include "hashtable_epoch.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
@@ -58,10 +60,151 @@ static inline hash_size_t def_hashfunc (const uint64_t keyP)
   return (hash_size_t) keyP;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Open addressing helpers of the non thread safe hash_table_uint64_t.
+   The home slot of a key is given by the user hash function, mixed so that the low bits of the result are usable as an index.
+*/
+static inline hash_size_t hashtable_uint64_home_slot (const hash_table_uint64_t * const hashtblP, const hash_key_t keyP)
+{
+  return hashtable_mix64 (hashtblP->hashfunc (keyP)) & (hashtblP->size - 1);
+}
+
+static bool hashtable_uint64_find_slot (const hash_table_uint64_t * const hashtblP, const hash_key_t keyP, hash_size_t * const indexP)
+{
+  hash_size_t                             index = hashtable_uint64_home_slot (hashtblP, keyP);
+  unsigned int                            probe_length = 1;
+
+  /*
+   * Robin Hood invariant: the key cannot be further than a slot whose key is closer to its own home slot
+   */
+  while (hashtblP->probe_lengths[index] >= probe_length) {
+    if (hashtblP->slots[index].key == keyP) {
+      *indexP = index;
+      return true;
+    }
+    index = (index + 1) & (hashtblP->size - 1);
+    probe_length++;
+  }
+  return false;
+}
+
+/*
+   Dry run of hashtable_uint64_place(), that only moves keys past the slots it has read: false if a key would end up more than
+   HASH_TABLE_MAX_PROBE_LENGTH slots away from its home slot.
+*/
+static bool hashtable_uint64_can_place (const hash_table_uint64_t * const hashtblP, const hash_key_t keyP)
+{
+  hash_size_t                             index = hashtable_uint64_home_slot (hashtblP, keyP);
+  unsigned int                            probe_length = 1;
+
+  while (hashtblP->probe_lengths[index]) {
+    if (hashtblP->probe_lengths[index] < probe_length) {
+      probe_length = hashtblP->probe_lengths[index];
+    }
+    index = (index + 1) & (hashtblP->size - 1);
+    if (++probe_length > HASH_TABLE_MAX_PROBE_LENGTH) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+   Insert a key known to be absent, stealing the slot of keys closer to their home slot.
+   The caller checked with hashtable_uint64_can_place() that it fits.
+*/
+static void hashtable_uint64_place (hash_table_uint64_t * const hashtblP, const hash_key_t keyP, const uint64_t dataP)
+{
+  hash_slot_uint64_t                      slot = {.key = keyP, .data = dataP};
+  hash_slot_uint64_t                      swap_slot;
+  hash_size_t                             index = hashtable_uint64_home_slot (hashtblP, keyP);
+  unsigned int                            probe_length = 1;
+  unsigned int                            swap_probe_length = 0;
+
+  while (hashtblP->probe_lengths[index]) {
+    if (hashtblP->probe_lengths[index] < probe_length) {
+      swap_slot = hashtblP->slots[index];
+      swap_probe_length = hashtblP->probe_lengths[index];
+      hashtblP->slots[index] = slot;
+      hashtblP->probe_lengths[index] = probe_length;
+      slot = swap_slot;
+      probe_length = swap_probe_length;
+    }
+    index = (index + 1) & (hashtblP->size - 1);
+    probe_length++;
+  }
+  hashtblP->slots[index] = slot;
+  hashtblP->probe_lengths[index] = probe_length;
+}
+
+/*
+   Backward shift deletion: move the following keys one slot closer to their home slot, no tombstones.
+*/
+static void hashtable_uint64_delete_slot (hash_table_uint64_t * const hashtblP, hash_size_t indexP)
+{
+  hash_size_t                             next = (indexP + 1) & (hashtblP->size - 1);
+
+  while (hashtblP->probe_lengths[next] > 1) {
+    hashtblP->slots[indexP] = hashtblP->slots[next];
+    hashtblP->probe_lengths[indexP] = hashtblP->probe_lengths[next] - 1;
+    indexP = next;
+    next = (next + 1) & (hashtblP->size - 1);
+  }
+  hashtblP->probe_lengths[indexP] = 0;
+  hashtblP->num_elements -= 1;
+}
+
+static hashtable_rc_t hashtable_uint64_rehash (hash_table_uint64_t * const hashtblP, const hash_size_t sizeP)
+{
+  hash_slot_uint64_t                     *old_slots = hashtblP->slots;
+  uint8_t                                *old_probe_lengths = hashtblP->probe_lengths;
+  hash_size_t                             old_size = hashtblP->size;
+  hash_size_t                             size = hashtable_round_size (sizeP);
+  hash_size_t                             n = 0;
+
+  while ((hashtblP->num_elements * 8) > (size * HASH_TABLE_MAX_LOAD_EIGHTHS)) {
+    size <<= 1;
+  }
+
+  if (!(hashtblP->probe_lengths = calloc (size, sizeof (uint8_t)))) {
+    hashtblP->probe_lengths = old_probe_lengths;
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if (!(hashtblP->slots = malloc (size * sizeof (hash_slot_uint64_t)))) {
+    free_wrapper ((void**)&hashtblP->probe_lengths);
+    hashtblP->probe_lengths = old_probe_lengths;
+    hashtblP->slots = old_slots;
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  hashtblP->size = size;
+
+  for (n = 0; n < old_size; ++n) {
+    if (old_probe_lengths[n]) {
+      if (!hashtable_uint64_can_place (hashtblP, old_slots[n].key)) {
+        /*
+         * Too many colliding keys, the table is left as it was
+         */
+        free_wrapper ((void**)&hashtblP->slots);
+        free_wrapper ((void**)&hashtblP->probe_lengths);
+        hashtblP->slots = old_slots;
+        hashtblP->probe_lengths = old_probe_lengths;
+        hashtblP->size = old_size;
+        return HASH_TABLE_SYSTEM_ERROR;
+      }
+      hashtable_uint64_place (hashtblP, old_slots[n].key, old_slots[n].data);
+    }
+  }
+  free_wrapper ((void**)&old_slots);
+  free_wrapper ((void**)&old_probe_lengths);
+  PRINT_HASHTABLE (hashtblP, "%s(%s) resized from %zu to %zu slots\n", __FUNCTION__, bdata(hashtblP->name), old_size, size);
+  return HASH_TABLE_OK;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
-   hashtable_uint64_init() set up the initial structure of the hash table. The user specified size will be allocated and initialized to NULL.
+   hashtable_uint64_init() set up the initial structure of the hash table. The user specified size (rounded up to a power of two) is the initial number of slots.
    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
    If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_t pointer should be released with hashtable_uint64_destroy().
 */
@@ -70,33 +213,22 @@ hash_table_uint64_t * hashtable_uint64_init (hash_table_uint64_t * const hashtbl
     hash_size_t (*hashfuncP) (const hash_key_t),
     bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  if (!(hashtblP->nodes = calloc (size, sizeof (hash_node_uint64_t *)))) {
+  hash_size_t size = hashtable_round_size (sizeP);
+
+  if (!(hashtblP->probe_lengths = calloc (size, sizeof (uint8_t)))) {
+    free_wrapper ((void**)&hashtblP);
+    return NULL;
+  }
+  if (!(hashtblP->slots = malloc (size * sizeof (hash_slot_uint64_t)))) {
+    free_wrapper ((void**)&hashtblP->probe_lengths);
     free_wrapper ((void**)&hashtblP);
     return NULL;
   }
   hashtblP->log_enabled = true;
 
-  PRINT_HASHTABLE (hashtblP, "allocated nodes\n");
+  PRINT_HASHTABLE (hashtblP, "allocated slots\n");
   hashtblP->size = size;
+  hashtblP->num_elements = 0;
 
   if (hashfuncP)
     hashtblP->hashfunc = hashfuncP;
@@ -135,10 +267,309 @@ hashtable_uint64_create (
   return hashtbl;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Incremental resize helpers of the thread safe hash_table_uint64_ts_t.
+   Except hashtable_uint64_ts_start_rehash() and hashtable_uint64_ts_end_rehash(), they are called with resize_lock held for reading,
+   so the bucket arrays cannot be swapped under their feet.
+*/
+static hashtable_rc_t hashtable_uint64_ts_alloc_buckets (const hash_size_t sizeP, hash_node_uint64_t *** const nodesP, pthread_mutex_t ** const lock_nodesP)
+{
+  hash_size_t                             n = 0;
+
+  if (!(*nodesP = calloc (sizeP, sizeof (hash_node_uint64_t *)))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if (!(*lock_nodesP = calloc (sizeP, sizeof (pthread_mutex_t)))) {
+    free_wrapper ((void**)nodesP);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  for (n = 0; n < sizeP; n++) {
+    pthread_mutex_init (&(*lock_nodesP)[n], NULL);
+  }
+  return HASH_TABLE_OK;
+}
+
+static void hashtable_uint64_ts_free_buckets (const hash_size_t sizeP, hash_node_uint64_t *** const nodesP, pthread_mutex_t ** const lock_nodesP)
+{
+  hash_size_t                             n = 0;
+
+  for (n = 0; n < sizeP; n++) {
+    pthread_mutex_destroy (&(*lock_nodesP)[n]);
+  }
+  free_wrapper ((void**)nodesP);
+  free_wrapper ((void**)lock_nodesP);
+}
+
+/*
+   Never block on resize_lock: a walk callback may access the table it walks. Readers hold it only for one operation,
+   yield to them a few times before giving up, the next insert/remove will try again.
+*/
+static bool hashtable_uint64_ts_try_write_lock (hash_table_uint64_ts_t * const hashtblP)
+{
+  int                                     tries = 0;
+
+  while (pthread_rwlock_trywrlock (&hashtblP->resize_lock)) {
+    if (++tries >= HASH_TABLE_RESIZE_LOCK_TRIES) {
+      return false;
+    }
+    sched_yield ();
+  }
+  return true;
+}
+
+/*
+   Move the nodes of an old bucket to the current bucket array.
+   Old buckets are never inserted into, once migrated they stay empty.
+   A lock-free reader may be walking the moved nodes, rehash_seq_begin/rehash_seq_end tell it to retry a miss.
+*/
+static void hashtable_uint64_ts_migrate_bucket (hash_table_uint64_ts_t * const hashtblP, const hash_size_t old_hashP)
+{
+  hash_node_uint64_t                     *node = NULL;
+  hash_node_uint64_t                     *next = NULL;
+  hash_size_t                             hash = 0;
+
+  if (!__atomic_load_n (&hashtblP->old_nodes[old_hashP], __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  pthread_mutex_lock (&hashtblP->old_lock_nodes[old_hashP]);
+  __sync_fetch_and_add (&hashtblP->rehash_seq_begin, 1);
+  while ((node = hashtblP->old_nodes[old_hashP])) {
+    hash = hashtblP->hashfunc (node->key) % hashtblP->size;
+    pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
+    /*
+     * Unlink the node only once it is in its new bucket: the check of an empty old bucket above is done without its lock,
+     * the current bucket of a key must then already hold the node.
+     */
+    next = node->next;
+    node->next = hashtblP->nodes[hash];
+    __sync_synchronize ();
+    hashtblP->nodes[hash] = node;
+    __atomic_store_n (&hashtblP->old_nodes[old_hashP], next, __ATOMIC_RELEASE);
+    pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+  }
+  __sync_fetch_and_add (&hashtblP->rehash_seq_end, 1);
+  pthread_mutex_unlock (&hashtblP->old_lock_nodes[old_hashP]);
+}
+
+/*
+   Lock the bucket of a key in the current bucket array, once its old bucket has been migrated.
+*/
+static hash_size_t hashtable_uint64_ts_lock_bucket (hash_table_uint64_ts_t * const hashtblP, const hash_key_t keyP)
+{
+  hash_size_t                             hash = hashtblP->hashfunc (keyP);
+
+  if (hashtblP->old_nodes) {
+    hashtable_uint64_ts_migrate_bucket (hashtblP, hash % hashtblP->old_size);
+  }
+  hash = hash % hashtblP->size;
+  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
+  return hash;
+}
+
+/*
+   Migrate the next nb_bucketsP old buckets, each one is claimed by a single thread.
+*/
+static void hashtable_uint64_ts_rehash_buckets (hash_table_uint64_ts_t * const hashtblP, const hash_size_t nb_bucketsP)
+{
+  hash_size_t                             n = 0;
+  hash_size_t                             old_hash = 0;
+
+  for (n = 0; n < nb_bucketsP; n++) {
+    old_hash = __sync_fetch_and_add (&hashtblP->rehash_index, 1);
+    if (old_hash >= hashtblP->old_size) {
+      return;
+    }
+    hashtable_uint64_ts_migrate_bucket (hashtblP, old_hash);
+    __sync_fetch_and_add (&hashtblP->rehashed_buckets, 1);
+  }
+}
+
+/*
+   Swap in a bucket array of sizeP buckets, its allocation is kept for the next try if resize_lock is busy.
+*/
+static hashtable_rc_t hashtable_uint64_ts_start_rehash (hash_table_uint64_ts_t * const hashtblP, const hash_size_t sizeP)
+{
+  if (pthread_mutex_trylock (&hashtblP->mutex)) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if ((hashtblP->next_nodes) && (hashtblP->next_size != sizeP)) {
+    hashtable_uint64_ts_free_buckets (hashtblP->next_size, &hashtblP->next_nodes, &hashtblP->next_lock_nodes);
+  }
+  if (!hashtblP->next_nodes) {
+    if (hashtable_uint64_ts_alloc_buckets (sizeP, &hashtblP->next_nodes, &hashtblP->next_lock_nodes) != HASH_TABLE_OK) {
+      pthread_mutex_unlock (&hashtblP->mutex);
+      return HASH_TABLE_SYSTEM_ERROR;
+    }
+    hashtblP->next_size = sizeP;
+  }
+  if (!hashtable_uint64_ts_try_write_lock (hashtblP)) {
+    pthread_mutex_unlock (&hashtblP->mutex);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if ((hashtblP->old_nodes) || (hashtblP->cursors)) {
+    pthread_rwlock_unlock (&hashtblP->resize_lock);
+    pthread_mutex_unlock (&hashtblP->mutex);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  __sync_fetch_and_add (&hashtblP->rehash_seq_begin, 1);
+  hashtblP->old_size = hashtblP->size;
+  hashtblP->old_nodes = hashtblP->nodes;
+  hashtblP->old_lock_nodes = hashtblP->lock_nodes;
+  hashtblP->size = hashtblP->next_size;
+  hashtblP->nodes = hashtblP->next_nodes;
+  hashtblP->lock_nodes = hashtblP->next_lock_nodes;
+  __sync_fetch_and_add (&hashtblP->rehash_seq_end, 1);
+  hashtblP->rehash_index = 0;
+  hashtblP->rehashed_buckets = 0;
+  hashtblP->next_size = 0;
+  hashtblP->next_nodes = NULL;
+  hashtblP->next_lock_nodes = NULL;
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
+  pthread_mutex_unlock (&hashtblP->mutex);
+  PRINT_HASHTABLE (hashtblP, "%s(%s) resizing from %zu to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->old_size, sizeP);
+  return HASH_TABLE_OK;
+}
+
+/*
+   Release the old bucket array once all its buckets have been migrated, retried by the next insert/remove if resize_lock is busy.
+   Its buckets are empty but lock-free readers may still be looking at them, the array itself is retired.
+*/
+static void hashtable_uint64_ts_end_rehash (hash_table_uint64_ts_t * const hashtblP)
+{
+  hash_node_uint64_t                    **old_nodes = NULL;
+  pthread_mutex_t                        *old_lock_nodes = NULL;
+  hash_size_t                             old_size = 0;
+  hash_size_t                             n = 0;
+
+  if (!hashtable_uint64_ts_try_write_lock (hashtblP)) {
+    return;
+  }
+  if ((hashtblP->old_nodes) && (hashtblP->rehashed_buckets >= hashtblP->old_size)) {
+    old_size = hashtblP->old_size;
+    old_nodes = hashtblP->old_nodes;
+    old_lock_nodes = hashtblP->old_lock_nodes;
+    hashtblP->old_size = 0;
+    hashtblP->old_nodes = NULL;
+    hashtblP->old_lock_nodes = NULL;
+  }
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
+
+  if (old_nodes) {
+    for (n = 0; n < old_size; n++) {
+      pthread_mutex_destroy (&old_lock_nodes[n]);
+    }
+    free_wrapper ((void**)&old_lock_nodes);
+    hashtable_epoch_retire (old_nodes, free_wrapper);
+    PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->size);
+  }
+}
+
+/*
+   Called after an insert/remove or a walk with resize_lock held for reading, releases it.
+   Moves a resize forward, or starts one if the load factor is out of bounds.
+*/
+static void hashtable_uint64_ts_resize_step (hash_table_uint64_ts_t * const hashtblP, const hash_size_t nb_bucketsP)
+{
+  bool                                    rehash_done = false;
+  hash_size_t                             size = 0;
+
+  if (hashtblP->old_nodes) {
+    hashtable_uint64_ts_rehash_buckets (hashtblP, nb_bucketsP);
+    rehash_done = (hashtblP->rehashed_buckets >= hashtblP->old_size);
+  } else if (hashtblP->cursors) {
+    /*
+     * Deferred until the last cursor is closed
+     */
+  } else if (hashtblP->num_elements > (hashtblP->size * HASH_TABLE_TS_MAX_LOAD)) {
+    size = hashtblP->size << 1;
+  } else if ((hashtblP->size > hashtblP->min_size) && ((hashtblP->num_elements * HASH_TABLE_TS_MIN_LOAD_INVERSE) < hashtblP->size)) {
+    size = hashtblP->size >> 1;
+  }
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
+
+  if (rehash_done) {
+    hashtable_uint64_ts_end_rehash (hashtblP);
+  } else if (size) {
+    hashtable_uint64_ts_start_rehash (hashtblP, size);
+  }
+}
+
+/*
+   Walking the whole table: migrate the remaining old buckets first so that every element is seen once.
+   Returns with resize_lock held for reading, released by hashtable_uint64_ts_resize_step().
+*/
+static void hashtable_uint64_ts_walk_begin (hash_table_uint64_ts_t * const hashtblP)
+{
+  hash_size_t                             n = 0;
+
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  if (hashtblP->old_nodes) {
+    for (n = 0; n < hashtblP->old_size; n++) {
+      hashtable_uint64_ts_migrate_bucket (hashtblP, n);
+    }
+  }
+}
+
+/*
+   Lock-free lookup, called inside an epoch section. The old bucket of the key is searched before the current one since nodes
+   only move from old to current buckets. A hit is always right, a miss only if no bucket array swap or migration ran meanwhile.
+   Writers bump the sequence counters with full barriers, acquire ordering is enough here.
+   Returns false if resizes kept interfering, the caller then takes the locks.
+*/
+static bool hashtable_uint64_ts_lookup (const hash_table_uint64_ts_t * const hashtblP, const hash_key_t keyP, uint64_t * const dataP, hashtable_rc_t * const rcP)
+{
+  hash_node_uint64_t                    **nodes = NULL;
+  hash_node_uint64_t                    **old_nodes = NULL;
+  hash_node_uint64_t                     *node = NULL;
+  hash_size_t                             size = 0;
+  hash_size_t                             old_size = 0;
+  hash_size_t                             hash = hashtblP->hashfunc (keyP);
+  uint64_t                                seq = 0;
+  int                                     tries = 0;
+
+  for (tries = 0; tries < HASH_TABLE_LOCK_FREE_READ_TRIES; tries++) {
+    seq = __atomic_load_n (&hashtblP->rehash_seq_end, __ATOMIC_ACQUIRE);
+    size = hashtblP->size;
+    nodes = hashtblP->nodes;
+    old_size = hashtblP->old_size;
+    old_nodes = hashtblP->old_nodes;
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if (hashtblP->rehash_seq_begin != seq) {
+      continue;
+    }
+
+    if (old_nodes) {
+      for (node = old_nodes[hash % old_size]; node; node = node->next) {
+        if (node->key == keyP) {
+          *dataP = node->data;
+          *rcP = HASH_TABLE_OK;
+          return true;
+        }
+      }
+    }
+    for (node = nodes[hash % size]; node; node = node->next) {
+      if (node->key == keyP) {
+        *dataP = node->data;
+        *rcP = HASH_TABLE_OK;
+        return true;
+      }
+    }
+
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if (hashtblP->rehash_seq_begin == seq) {
+      *rcP = HASH_TABLE_KEY_NOT_EXISTS;
+      return true;
+    }
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
    hashtable_uint64_ts_init() sets up the initial structure of the thread safe hash table. The user specified size will be allocated and initialized to NULL.
+   The table grows and shrinks by itself with the number of elements, never below this initial size.
    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
    If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_t pointer should be released with hashtable_uint64_destroy().
 */
@@ -147,45 +578,20 @@ hash_table_uint64_ts_t * hashtable_uint64_ts_init (hash_table_uint64_ts_t * cons
     hash_size_t (*hashfuncP) (const hash_key_t),
     bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
+  hash_size_t size = hashtable_round_size (sizeP);
 
   memset(hashtblP, 0, sizeof(*hashtblP));
 
-  if (!(hashtblP->nodes = calloc (size, sizeof (hash_node_uint64_t *)))) {
-    free_wrapper ((void**)&hashtblP);
-    return NULL;
-  }
-
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&hashtblP->nodes);
-    free_wrapper ((void**)&hashtblP->name);
+  if (hashtable_uint64_ts_alloc_buckets (size, &hashtblP->nodes, &hashtblP->lock_nodes) != HASH_TABLE_OK) {
     free_wrapper ((void**)&hashtblP);
     return NULL;
   }
 
   pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
+  pthread_rwlock_init(&hashtblP->resize_lock, NULL);
 
   hashtblP->size = size;
+  hashtblP->min_size = size;
 
   if (hashfuncP)
     hashtblP->hashfunc = hashfuncP;
@@ -227,31 +633,18 @@ hashtable_uint64_ts_create (
 //------------------------------------------------------------------------------
 /*
    Cleanup
-   The hashtable_uint64_destroy() walks through the linked lists for each possible hash value, and releases the elements. It also releases the nodes array and the hash_table_uint64_t.
+   The hashtable_uint64_destroy() releases the slots arrays and the hash_table_uint64_t.
 */
 hashtable_rc_t
 hashtable_uint64_destroy (
   hash_table_uint64_t * hashtblP)
 {
-  hash_size_t                             n = 0;
-  hash_node_uint64_t                     *node = NULL,
-                                         *oldnode = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-      free_wrapper ((void**)&oldnode);
-    }
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
+  free_wrapper ((void**)&hashtblP->slots);
+  free_wrapper ((void**)&hashtblP->probe_lengths);
   bdestroy_wrapper(&hashtblP->name);
   if (hashtblP->is_allocated_by_malloc) {
     free_wrapper ((void**)&hashtblP);
@@ -276,6 +669,8 @@ hashtable_uint64_ts_destroy (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
+  hashtable_uint64_ts_walk_begin (hashtblP);
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
   for (n = 0; n < hashtblP->size; ++n) {
     pthread_mutex_lock (&hashtblP->lock_nodes[n]);
     node = hashtblP->nodes[n];
@@ -287,12 +682,17 @@ hashtable_uint64_ts_destroy (
     }
 
     pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
   }
 
-  free_wrapper ((void**)&hashtblP->nodes);
+  hashtable_uint64_ts_free_buckets (hashtblP->size, &hashtblP->nodes, &hashtblP->lock_nodes);
+  if (hashtblP->old_nodes) {
+    hashtable_uint64_ts_free_buckets (hashtblP->old_size, &hashtblP->old_nodes, &hashtblP->old_lock_nodes);
+  }
+  if (hashtblP->next_nodes) {
+    hashtable_uint64_ts_free_buckets (hashtblP->next_size, &hashtblP->next_nodes, &hashtblP->next_lock_nodes);
+  }
+  pthread_rwlock_destroy (&hashtblP->resize_lock);
   bdestroy_wrapper (&hashtblP->name);
-  free_wrapper((void**)&hashtblP->lock_nodes);
   if (hashtblP->is_allocated_by_malloc) {
     free_wrapper ((void**)&hashtblP);
   }
@@ -307,23 +707,15 @@ hashtable_uint64_is_key_exists (
   const hash_table_uint64_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  hash_size_t                             hash = 0;
+  hash_size_t                             index = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  if (hashtable_uint64_find_slot (hashtblP, keyP, &index)) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -337,20 +729,32 @@ hashtable_uint64_ts_is_key_exists (
   const hash_table_uint64_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
+  hash_table_uint64_ts_t                 *hashtbl = (hash_table_uint64_ts_t *)hashtblP;
   hash_node_uint64_t                     *node = NULL;
   hash_size_t                             hash = 0;
+  uint64_t                                data = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
+  hashtable_epoch_enter ();
+  if (hashtable_uint64_ts_lookup (hashtblP, keyP, &data, &rc)) {
+    hashtable_epoch_exit ();
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, hashtable_rc_code2string(rc));
+    return rc;
+  }
+  hashtable_epoch_exit ();
+
+  pthread_rwlock_rdlock (&hashtbl->resize_lock);
+  hash = hashtable_uint64_ts_lock_bucket (hashtbl, keyP);
   node = hashtblP->nodes[hash];
 
   while (node) {
     if (node->key == keyP) {
       pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+      pthread_rwlock_unlock (&hashtbl->resize_lock);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
       return HASH_TABLE_OK;
     }
@@ -358,6 +762,7 @@ hashtable_uint64_ts_is_key_exists (
     node = node->next;
   }
   pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtbl->resize_lock);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -378,24 +783,18 @@ hashtable_uint64_apply_callback_on_elements (
   void *parameterP,
   void **resultP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  unsigned int                            i = 0;
-  unsigned int                            num_elements = 0;
+  hash_size_t                             i = 0;
+  hash_size_t                             num_elements = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
   while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb (node->key, node->data, parameterP, resultP)) {
-          return HASH_TABLE_OK;
-        }
-        node = node->next;
+    if (hashtblP->probe_lengths[i]) {
+      num_elements++;
+      if (funct_cb (hashtblP->slots[i].key, hashtblP->slots[i].data, parameterP, resultP)) {
+        return HASH_TABLE_OK;
       }
     }
     i++;
@@ -415,6 +814,7 @@ hashtable_key_array_t * hashtable_uint64_ts_get_keys (hash_table_uint64_ts_t * c
   if ((!hashtblP) || !(hashtblP->num_elements)){
     return NULL;
   }
+  hashtable_uint64_ts_walk_begin (hashtblP);
   ka = calloc(1, sizeof(hashtable_key_array_t));
   ka->keys = calloc(hashtblP->num_elements, sizeof(hash_key_t*));
 
@@ -430,6 +830,7 @@ hashtable_key_array_t * hashtable_uint64_ts_get_keys (hash_table_uint64_ts_t * c
     pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
     i++;
   }
+  hashtable_uint64_ts_resize_step (hashtblP, hashtblP->old_size);
   return ka;
 }
 
@@ -445,6 +846,7 @@ hashtable_uint64_element_array_t * hashtable_uint64_ts_get_elements (hash_table_
     return NULL;
   }
 
+  hashtable_uint64_ts_walk_begin (hashtblP);
   ea = calloc(1, sizeof(hashtable_uint64_element_array_t));
   ea->elements = calloc(hashtblP->num_elements, sizeof(uint64_t*));
 
@@ -460,6 +862,7 @@ hashtable_uint64_element_array_t * hashtable_uint64_ts_get_elements (hash_table_
     pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
     i++;
   }
+  hashtable_uint64_ts_resize_step (hashtblP, hashtblP->old_size);
   return ea;
 }
 
@@ -468,6 +871,7 @@ hashtable_uint64_element_array_t * hashtable_uint64_ts_get_elements (hash_table_
 // may cost a lot CPU...
 // Also useful if we want to find an element in the collection based on compare criteria different than the single key
 // The compare criteria in implemented in the funct_cb function
+// funct_cb must not insert into or remove from the walked table.
 hashtable_rc_t
 hashtable_uint64_ts_apply_callback_on_elements (
   hash_table_uint64_ts_t * const hashtblP,
@@ -486,6 +890,7 @@ hashtable_uint64_ts_apply_callback_on_elements (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
+  hashtable_uint64_ts_walk_begin (hashtblP);
   while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
     pthread_mutex_lock(&hashtblP->lock_nodes[i]);
     if (hashtblP->nodes[i] != NULL) {
@@ -495,6 +900,7 @@ hashtable_uint64_ts_apply_callback_on_elements (
         num_elements++;
         if (funct_cb (node->key, node->data, parameterP, resultP)) {
           pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
+          hashtable_uint64_ts_resize_step (hashtblP, hashtblP->old_size);
           return HASH_TABLE_OK;
         }
         node = node->next;
@@ -504,6 +910,7 @@ hashtable_uint64_ts_apply_callback_on_elements (
     i++;
   }
 
+  hashtable_uint64_ts_resize_step (hashtblP, hashtblP->old_size);
   return HASH_TABLE_OK;
 }
 
@@ -514,8 +921,7 @@ hashtable_uint64_dump_content (
   const hash_table_uint64_t * const hashtblP,
   bstring str)
 {
-  hash_node_uint64_t                     *node = NULL;
-  unsigned int                            i = 0;
+  hash_size_t                             i = 0;
 
   if (!hashtblP) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
@@ -523,19 +929,13 @@ hashtable_uint64_dump_content (
   }
 
   while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat("Key 0x%"PRIx64" Element %"PRIx64" Node %p\n", node->key, node->data, node);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy_wrapper (&b0);
-        }
-        node = node->next;
-
+    if (hashtblP->probe_lengths[i]) {
+      bstring b0 = bformat("Key 0x%"PRIx64" Element %"PRIx64" Slot %zu Probe %u\n", hashtblP->slots[i].key, hashtblP->slots[i].data, i, hashtblP->probe_lengths[i]);
+      if (!b0) {
+        PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
+      } else {
+        bconcat(str, b0);
+        bdestroy_wrapper (&b0);
       }
     }
     i += 1;
@@ -543,12 +943,121 @@ hashtable_uint64_dump_content (
   return HASH_TABLE_OK;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Cursors
+   hashtable_uint64_ts_cursor_open() starts a walk over the elements of the table, hashtable_uint64_ts_cursor_next() copies the next elements into
+   the buffers of the caller and hashtable_uint64_ts_cursor_close() ends the walk, possibly before the last element.
+   Nothing is allocated and no bucket is locked: the buckets are read like hashtable_uint64_ts_get() does, and resizes are deferred
+   while a cursor is open, so every element present during the whole walk is returned once. Elements inserted or removed
+   meanwhile may or may not be returned.
+*/
+hashtable_rc_t
+hashtable_uint64_ts_cursor_open (
+  hash_table_uint64_ts_t * const hashtblP,
+  hashtable_ts_cursor_t * const cursorP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  cursorP->bucket = 0;
+  cursorP->skip = 0;
+  __sync_fetch_and_add (&hashtblP->cursors, 1);
+  /*
+   * A resize started before the cursor was counted is completed, every element is then in the current buckets
+   */
+  hashtable_uint64_ts_walk_begin (hashtblP);
+  hashtable_uint64_ts_resize_step (hashtblP, hashtblP->old_size);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Copy up to max_elementsP keys and elements into keysP and elementsP, any of them may be NULL.
+   Buckets are not split between two calls unless one does not fit in max_elementsP.
+   Returns the number of elements copied, 0 once the walk is over.
+*/
+int
+hashtable_uint64_ts_cursor_next (
+  hash_table_uint64_ts_t * const hashtblP,
+  hashtable_ts_cursor_t * const cursorP,
+  hash_key_t * const keysP,
+  uint64_t * const elementsP,
+  const int max_elementsP)
+{
+  hash_node_uint64_t                     *node = NULL;
+  hash_size_t                             count = 0;
+  hash_size_t                             skip = 0;
+  int                                     n = 0;
+
+  if ((!hashtblP) || (!cursorP)) {
+    return 0;
+  }
+
+  hashtable_epoch_enter ();
+  while ((n < max_elementsP) && (cursorP->bucket < hashtblP->size)) {
+    if (n) {
+      for (count = 0, node = hashtblP->nodes[cursorP->bucket]; node; node = node->next) {
+        count++;
+      }
+      if ((count - cursorP->skip) > (hash_size_t)(max_elementsP - n)) {
+        break;
+      }
+    }
+
+    skip = 0;
+    for (node = hashtblP->nodes[cursorP->bucket]; (node) && (n < max_elementsP); node = node->next) {
+      if (skip++ < cursorP->skip) {
+        continue;
+      }
+      if (keysP) {
+        keysP[n] = node->key;
+      }
+      if (elementsP) {
+        elementsP[n] = node->data;
+      }
+      n++;
+    }
+
+    if (node) {
+      cursorP->skip = skip;
+    } else {
+      cursorP->bucket++;
+      cursorP->skip = 0;
+    }
+  }
+  hashtable_epoch_exit ();
+  return n;
+}
+
+//------------------------------------------------------------------------------
+void
+hashtable_uint64_ts_cursor_close (
+  hash_table_uint64_ts_t * const hashtblP,
+  hashtable_ts_cursor_t * const cursorP)
+{
+  if (!hashtblP) {
+    return;
+  }
+
+  cursorP->bucket = hashtblP->size;
+  if (__sync_sub_and_fetch (&hashtblP->cursors, 1) == 0) {
+    /*
+     * Start the resize that may have been deferred
+     */
+    pthread_rwlock_rdlock (&hashtblP->resize_lock);
+    hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
+  }
+}
+
 //------------------------------------------------------------------------------
 hashtable_rc_t
 hashtable_uint64_ts_dump_content (
   const hash_table_uint64_ts_t * const hashtblP,
   bstring str)
 {
+  hash_table_uint64_ts_t                 *hashtbl = (hash_table_uint64_ts_t *)hashtblP;
   hash_node_uint64_t                     *node = NULL;
   unsigned int                            i = 0;
 
@@ -557,6 +1066,7 @@ hashtable_uint64_ts_dump_content (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
+  hashtable_uint64_ts_walk_begin (hashtbl);
   while (i < hashtblP->size) {
     if (hashtblP->nodes[i] != NULL) {
       pthread_mutex_lock(&hashtblP->lock_nodes[i]);
@@ -577,6 +1087,7 @@ hashtable_uint64_ts_dump_content (
     }
     i += 1;
   }
+  hashtable_uint64_ts_resize_step (hashtbl, hashtblP->old_size);
   return HASH_TABLE_OK;
 }
 
@@ -585,7 +1096,7 @@ hashtable_uint64_ts_dump_content (
 //------------------------------------------------------------------------------
 /*
    Adding a new element
-   To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   The table grows (doubles) before its load factor exceeds HASH_TABLE_MAX_LOAD_EIGHTHS / 8.
 */
 hashtable_rc_t
 hashtable_uint64_insert (
@@ -593,45 +1104,45 @@ hashtable_uint64_insert (
   const hash_key_t keyP,
   const uint64_t dataP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  hash_size_t                             hash = 0;
+  hash_slot_uint64_t                     *slot = NULL;
+  hash_size_t                             index = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data != dataP) {
-        node->data = dataP;
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-        return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
-      }
-      node->data = dataP;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-      return HASH_TABLE_OK;
+  if (hashtable_uint64_find_slot (hashtblP, keyP, &index)) {
+    slot = &hashtblP->slots[index];
+    if (slot->data != dataP) {
+      slot->data = dataP;
+      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
     }
-
-    node = node->next;
+    slot->data = dataP;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_OK;
   }
 
-  if (!(node = malloc (sizeof (hash_node_uint64_t))))
-    return -1;
-
-  node->key = keyP;
-  node->data = dataP;
+  if (((hashtblP->num_elements + 1) * 8) > (hashtblP->size * HASH_TABLE_MAX_LOAD_EIGHTHS)) {
+    if ((rc = hashtable_uint64_rehash (hashtblP, hashtblP->size << 1)) != HASH_TABLE_OK) {
+      return rc;
+    }
+  }
 
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
+  while (!hashtable_uint64_can_place (hashtblP, keyP)) {
+    /*
+     * Growing does not help a hash function returning too few distinct values
+     */
+    if (((hashtblP->num_elements * 4) < hashtblP->size) ||
+        (hashtable_uint64_rehash (hashtblP, hashtblP->size << 1) != HASH_TABLE_OK)) {
+      OAILOG_ERROR (LOG_UTIL, "Hashtable %s: too many colliding keys, key 0x%"PRIx64" not inserted, check the hash function\n", bdata(hashtblP->name), keyP);
+      return HASH_TABLE_SYSTEM_ERROR;
+    }
   }
 
-  hashtblP->nodes[hash] = node;
   hashtblP->num_elements += 1;
+  hashtable_uint64_place (hashtblP, keyP, dataP);
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
   return HASH_TABLE_OK;
@@ -642,6 +1153,7 @@ hashtable_uint64_insert (
 /*
    Adding a new element
    To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   The table grows when it holds more than HASH_TABLE_TS_MAX_LOAD elements per bucket.
 */
 hashtable_rc_t
 hashtable_uint64_ts_insert (
@@ -656,8 +1168,8 @@ hashtable_uint64_ts_insert (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  hash = hashtable_uint64_ts_lock_bucket (hashtblP, keyP);
   node = hashtblP->nodes[hash];
 
   while (node) {
@@ -665,11 +1177,13 @@ hashtable_uint64_ts_insert (
       if (node->data != dataP) {
         node->data = dataP;
         pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+        pthread_rwlock_unlock (&hashtblP->resize_lock);
         PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
         return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
       }
       node->data = dataP;
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_rwlock_unlock (&hashtblP->resize_lock);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
       return HASH_TABLE_OK;
     }
@@ -677,8 +1191,11 @@ hashtable_uint64_ts_insert (
     node = node->next;
   }
 
-  if (!(node = malloc (sizeof (hash_node_uint64_t))))
-    return -1;
+  if (!(node = malloc (sizeof (hash_node_uint64_t)))) {
+    pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+    pthread_rwlock_unlock (&hashtblP->resize_lock);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
 
   node->key = keyP;
   node->data = dataP;
@@ -689,10 +1206,15 @@ hashtable_uint64_ts_insert (
     node->next = NULL;
   }
 
+  /*
+   * Lock-free readers must not see the node before its content
+   */
+  __sync_synchronize ();
   hashtblP->nodes[hash] = node;
   __sync_fetch_and_add (&hashtblP->num_elements, 1);
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) next %p return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, node->next);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") next %p return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, node->next);
+  hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
   return HASH_TABLE_OK;
 }
 
@@ -700,40 +1222,24 @@ hashtable_uint64_ts_insert (
 
 //------------------------------------------------------------------------------
 /*
-   To free_wrapper an element from the hash table, we just search for it in the linked list for that hash value,
-   and free_wrapper it if it is found. If it was not found, it is an error and -1 is returned.
+   To free_wrapper an element from the hash table, we just search for it in the probe sequence of its home slot,
+   and free_wrapper it if it is found. If it was not found, HASH_TABLE_KEY_NOT_EXISTS is returned.
 */
 hashtable_rc_t
 hashtable_uint64_free (
   hash_table_uint64_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t                     *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  hash_size_t                             index = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  if (hashtable_uint64_find_slot (hashtblP, keyP, &index)) {
+    hashtable_uint64_delete_slot (hashtblP, index);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
@@ -745,6 +1251,7 @@ hashtable_uint64_free (
 /*
    To free_wrapper an element from the hash table, we just search for it in the linked list for that hash value,
    and free_wrapper it if it is found. If it was not found, it is an error and -1 is returned.
+   The table shrinks when it holds less than 1/HASH_TABLE_TS_MIN_LOAD_INVERSE element per bucket.
 */
 hashtable_rc_t
 hashtable_uint64_ts_free (
@@ -759,8 +1266,8 @@ hashtable_uint64_ts_free (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  hash = hashtable_uint64_ts_lock_bucket (hashtblP, keyP);
   node = hashtblP->nodes[hash];
 
   while (node) {
@@ -770,9 +1277,10 @@ hashtable_uint64_ts_free (
       else
         hashtblP->nodes[hash] = node->next;
 
-      free_wrapper ((void**)&node);
+      hashtable_epoch_retire (node, free_wrapper);
       __sync_fetch_and_sub (&hashtblP->num_elements, 1);
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
       return HASH_TABLE_OK;
     }
@@ -782,6 +1290,7 @@ hashtable_uint64_ts_free (
   }
 
    pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+   pthread_rwlock_unlock (&hashtblP->resize_lock);
    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -790,40 +1299,24 @@ hashtable_uint64_ts_free (
 
 //------------------------------------------------------------------------------
 /*
-   To remove an element from the hash table, we just search for it in the linked list for that hash value,
-   and remove it if it is found. If it was not found, it is an error and -1 is returned.
+   To remove an element from the hash table, we just search for it in the probe sequence of its home slot,
+   and remove it if it is found. If it was not found, HASH_TABLE_KEY_NOT_EXISTS is returned.
 */
 hashtable_rc_t
 hashtable_uint64_remove (
   hash_table_uint64_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t                     *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  hash_size_t                             index = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  if (hashtable_uint64_find_slot (hashtblP, keyP, &index)) {
+    hashtable_uint64_delete_slot (hashtblP, index);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
@@ -835,6 +1328,7 @@ hashtable_uint64_remove (
 /*
    To remove an element from the hash table, we just search for it in the linked list for that hash value,
    and remove it if it is found. If it was not found, it is an error and -1 is returned.
+   The table shrinks when it holds less than 1/HASH_TABLE_TS_MIN_LOAD_INVERSE element per bucket.
 */
 hashtable_rc_t
 hashtable_uint64_ts_remove (
@@ -849,8 +1343,8 @@ hashtable_uint64_ts_remove (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  hash = hashtable_uint64_ts_lock_bucket (hashtblP, keyP);
   node = hashtblP->nodes[hash];
 
   while (node) {
@@ -860,9 +1354,10 @@ hashtable_uint64_ts_remove (
       else
         hashtblP->nodes[hash] = node->next;
 
-      free_wrapper ((void**)&node);
+      hashtable_epoch_retire (node, free_wrapper);
       __sync_fetch_and_sub (&hashtblP->num_elements, 1);
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
       return HASH_TABLE_OK;
     }
@@ -871,6 +1366,7 @@ hashtable_uint64_ts_remove (
     node = node->next;
   }
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -879,8 +1375,8 @@ hashtable_uint64_ts_remove (
 
 //------------------------------------------------------------------------------
 /*
-   Searching for an element is easy. We just search through the linked list for the corresponding hash value.
-   NULL is returned if we didn't find it.
+   Searching for an element: the probe sequence starting at the home slot of the key is scanned until a slot holding
+   a key closer to its own home slot is met.
 */
 hashtable_rc_t
 hashtable_uint64_get (
@@ -888,24 +1384,16 @@ hashtable_uint64_get (
   const hash_key_t keyP,
   uint64_t * const dataP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  hash_size_t                             hash = 0;
+  hash_size_t                             index = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  if (hashtable_uint64_find_slot (hashtblP, keyP, &index)) {
+    *dataP = hashtblP->slots[index].data;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
@@ -924,22 +1412,32 @@ hashtable_uint64_ts_get (
   const hash_key_t keyP,
   uint64_t * const dataP)
 {
+  hash_table_uint64_ts_t                 *hashtbl = (hash_table_uint64_ts_t *)hashtblP;
   hash_node_uint64_t                     *node = NULL;
   hash_size_t                             hash = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
+  hashtable_epoch_enter ();
+  if (hashtable_uint64_ts_lookup (hashtblP, keyP, dataP, &rc)) {
+    hashtable_epoch_exit ();
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, hashtable_rc_code2string(rc));
+    return rc;
+  }
+  hashtable_epoch_exit ();
 
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtbl->resize_lock);
+  hash = hashtable_uint64_ts_lock_bucket (hashtbl, keyP);
   node = hashtblP->nodes[hash];
 
   while (node) {
     if (node->key == keyP) {
       *dataP = node->data;
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_rwlock_unlock (&hashtbl->resize_lock);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
       return HASH_TABLE_OK;
     }
@@ -947,6 +1445,7 @@ hashtable_uint64_ts_get (
     node = node->next;
   }
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtbl->resize_lock);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -954,13 +1453,10 @@ hashtable_uint64_ts_get (
 //------------------------------------------------------------------------------
 /*
    Resizing
-   The number of elements in a hash table is not always known when creating the table.
-   If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
-   If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
-   Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_uint64_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_uint64_insert() and hashtable_uint64_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
+   The tables grow by themselves when they fill up, but they never shrink; the number of elements in a hash table is not always known
+   when creating the table either. That is why we provide a function for resizing the table.
+   All the elements are moved to new slots arrays of the requested size (rounded up to a power of two and large enough to keep the load
+   factor below HASH_TABLE_MAX_LOAD_EIGHTHS / 8).
 */
 
 hashtable_rc_t
@@ -968,66 +1464,20 @@ hashtable_uint64_resize (
   hash_table_uint64_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_uint64_t                     newtbl;
-  hash_size_t                             n;
-  hash_node_uint64_t                     *node,
-                                         *next;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_uint64_t *))))
-    return -1;
-
-
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_uint64_remove (hashtblP, node->key);
-      hashtable_uint64_insert (&newtbl, node->key, node->data);
-    }
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->size = newtbl.size;
-  return HASH_TABLE_OK;
+  return hashtable_uint64_rehash (hashtblP, sizeP);
 }
 
 
 //------------------------------------------------------------------------------
 /*
    Resizing
-   The number of elements in a hash table is not always known when creating the table.
-   If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
-   If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
-   Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_uint64_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_uint64_insert() and hashtable_uint64_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
-   Dangerous not really thread safe.
+   The thread safe tables resize by themselves with their load factor, this function only forces a new size (rounded up to a power of two).
+   The resize is incremental: the new bucket array is swapped in at once, then each operation on the table moves the elements of
+   the old buckets it touches and each insert/remove moves HASH_TABLE_REHASH_BUCKETS_PER_OP more old buckets.
+   HASH_TABLE_SYSTEM_ERROR is returned if another resize is still in progress or if the new buckets cannot be allocated.
 */
 
 hashtable_rc_t
@@ -1035,61 +1485,10 @@ hashtable_uint64_ts_resize (
   hash_table_uint64_ts_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_uint64_ts_t                  newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n      = 0;
-  hash_node_uint64_t                     *node   = NULL,
-                                         *next   = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_uint64_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_uint64_ts_remove (hashtblP, node->key);
-      hashtable_uint64_ts_insert (&newtbl, node->key, node->data);
-    }
-  }
+  hash_size_t size = hashtable_round_size (sizeP);
 
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper ((void**)&hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
-  return HASH_TABLE_OK;
+  return hashtable_uint64_ts_start_rehash (hashtblP, size);
 }
@@ -56,6 +56,20 @@ typedef struct obj_hash_table_s {
     void              (*freedatafunc)(void**);
     bstring             name;
     bool                log_enabled;
+    /* Incremental resize of the thread safe functions, see hashtable.h */
+    pthread_rwlock_t    resize_lock;
+    hash_size_t         min_size;
+    hash_size_t         old_size;
+    struct obj_hash_node_s **old_nodes;
+    pthread_mutex_t     *old_lock_nodes;
+    hash_size_t         rehash_index;
+    hash_size_t         rehashed_buckets;
+    /* Lock-free readers retry when a bucket array swap or a bucket migration ran meanwhile */
+    volatile uint64_t   rehash_seq_begin;
+    volatile uint64_t   rehash_seq_end;
+    hash_size_t         next_size;
+    struct obj_hash_node_s **next_nodes;
+    pthread_mutex_t     *next_lock_nodes;
 } obj_hash_table_t;
 
 typedef struct obj_hash_table_uint64_s {
@@ -68,6 +82,20 @@ typedef struct obj_hash_table_uint64_s {
     void              (*freekeyfunc)(void**);
     bstring             name;
     bool                log_enabled;
+    /* Incremental resize of the thread safe functions, see hashtable.h */
+    pthread_rwlock_t    resize_lock;
+    hash_size_t         min_size;
+    hash_size_t         old_size;
+    struct obj_hash_node_uint64_s **old_nodes;
+    pthread_mutex_t     *old_lock_nodes;
+    hash_size_t         rehash_index;
+    hash_size_t         rehashed_buckets;
+    /* Lock-free readers retry when a bucket array swap or a bucket migration ran meanwhile */
+    volatile uint64_t   rehash_seq_begin;
+    volatile uint64_t   rehash_seq_end;
+    hash_size_t         next_size;
+    struct obj_hash_node_uint64_s **next_nodes;
+    pthread_mutex_t     *next_lock_nodes;
 } obj_hash_table_uint64_t;
 
 void                obj_hashtable_no_free_key_callback(void* param);
@@ -32,10 +32,12 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <sched.h>
 
 #include "bstrlib.h"
 
 #include "obj_hashtable.h"
+#include "hashtable_epoch.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
 
@@ -160,6 +162,300 @@ obj_hashtable_uint64_create (
   return obj_hashtable_uint64_init(hashtbl, sizeP, hashfuncP, freekeyfuncP, display_name_pP);
 }
 
+//------------------------------------------------------------------------------
+/*
+   Incremental resize helpers of the thread safe functions, see hashtable.h.
+   Except obj_hashtable_uint64_ts_start_rehash() and obj_hashtable_uint64_ts_end_rehash(), they are called with resize_lock held for reading,
+   so the bucket arrays cannot be swapped under their feet.
+*/
+static hashtable_rc_t obj_hashtable_uint64_ts_alloc_buckets (const hash_size_t sizeP, obj_hash_node_uint64_t *** const nodesP, pthread_mutex_t ** const lock_nodesP)
+{
+  hash_size_t                             n = 0;
+
+  if (!(*nodesP = calloc (sizeP, sizeof (obj_hash_node_uint64_t *)))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if (!(*lock_nodesP = calloc (sizeP, sizeof (pthread_mutex_t)))) {
+    free_wrapper ((void**)nodesP);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  for (n = 0; n < sizeP; n++) {
+    pthread_mutex_init (&(*lock_nodesP)[n], NULL);
+  }
+  return HASH_TABLE_OK;
+}
+
+static void obj_hashtable_uint64_ts_free_buckets (const hash_size_t sizeP, obj_hash_node_uint64_t *** const nodesP, pthread_mutex_t ** const lock_nodesP)
+{
+  hash_size_t                             n = 0;
+
+  for (n = 0; n < sizeP; n++) {
+    pthread_mutex_destroy (&(*lock_nodesP)[n]);
+  }
+  free_wrapper ((void**)nodesP);
+  free_wrapper ((void**)lock_nodesP);
+}
+
+/*
+   Never block on resize_lock: a walk callback may access the table it walks. Readers hold it only for one operation,
+   yield to them a few times before giving up, the next insert/remove will try again.
+*/
+static bool obj_hashtable_uint64_ts_try_write_lock (obj_hash_table_uint64_t * const hashtblP)
+{
+  int                                     tries = 0;
+
+  while (pthread_rwlock_trywrlock (&hashtblP->resize_lock)) {
+    if (++tries >= HASH_TABLE_RESIZE_LOCK_TRIES) {
+      return false;
+    }
+    sched_yield ();
+  }
+  return true;
+}
+
+/*
+   Move the nodes of an old bucket to the current bucket array.
+   Old buckets are never inserted into, once migrated they stay empty.
+   A lock-free reader may be walking the moved nodes, rehash_seq_begin/rehash_seq_end tell it to retry a miss.
+*/
+static void obj_hashtable_uint64_ts_migrate_bucket (obj_hash_table_uint64_t * const hashtblP, const hash_size_t old_hashP)
+{
+  obj_hash_node_uint64_t                 *node = NULL;
+  obj_hash_node_uint64_t                 *next = NULL;
+  hash_size_t                             hash = 0;
+
+  if (!__atomic_load_n (&hashtblP->old_nodes[old_hashP], __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  pthread_mutex_lock (&hashtblP->old_lock_nodes[old_hashP]);
+  __sync_fetch_and_add (&hashtblP->rehash_seq_begin, 1);
+  while ((node = hashtblP->old_nodes[old_hashP])) {
+    hash = hashtblP->hashfunc (node->key, node->key_size) % hashtblP->size;
+    pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
+    /*
+     * Unlink the node only once it is in its new bucket: the check of an empty old bucket above is done without its lock,
+     * the current bucket of a key must then already hold the node.
+     */
+    next = node->next;
+    node->next = hashtblP->nodes[hash];
+    __sync_synchronize ();
+    hashtblP->nodes[hash] = node;
+    __atomic_store_n (&hashtblP->old_nodes[old_hashP], next, __ATOMIC_RELEASE);
+    pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+  }
+  __sync_fetch_and_add (&hashtblP->rehash_seq_end, 1);
+  pthread_mutex_unlock (&hashtblP->old_lock_nodes[old_hashP]);
+}
+
+/*
+   Lock the bucket of a key in the current bucket array, once its old bucket has been migrated.
+*/
+static hash_size_t obj_hashtable_uint64_ts_lock_bucket (obj_hash_table_uint64_t * const hashtblP, const void * const keyP, const int key_sizeP)
+{
+  hash_size_t                             hash = hashtblP->hashfunc (keyP, key_sizeP);
+
+  if (hashtblP->old_nodes) {
+    obj_hashtable_uint64_ts_migrate_bucket (hashtblP, hash % hashtblP->old_size);
+  }
+  hash = hash % hashtblP->size;
+  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
+  return hash;
+}
+
+/*
+   Migrate the next nb_bucketsP old buckets, each one is claimed by a single thread.
+*/
+static void obj_hashtable_uint64_ts_rehash_buckets (obj_hash_table_uint64_t * const hashtblP, const hash_size_t nb_bucketsP)
+{
+  hash_size_t                             n = 0;
+  hash_size_t                             old_hash = 0;
+
+  for (n = 0; n < nb_bucketsP; n++) {
+    old_hash = __sync_fetch_and_add (&hashtblP->rehash_index, 1);
+    if (old_hash >= hashtblP->old_size) {
+      return;
+    }
+    obj_hashtable_uint64_ts_migrate_bucket (hashtblP, old_hash);
+    __sync_fetch_and_add (&hashtblP->rehashed_buckets, 1);
+  }
+}
+
+/*
+   Swap in a bucket array of sizeP buckets, its allocation is kept for the next try if resize_lock is busy.
+*/
+static hashtable_rc_t obj_hashtable_uint64_ts_start_rehash (obj_hash_table_uint64_t * const hashtblP, const hash_size_t sizeP)
+{
+  if (pthread_mutex_trylock (&hashtblP->mutex)) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if ((hashtblP->next_nodes) && (hashtblP->next_size != sizeP)) {
+    obj_hashtable_uint64_ts_free_buckets (hashtblP->next_size, &hashtblP->next_nodes, &hashtblP->next_lock_nodes);
+  }
+  if (!hashtblP->next_nodes) {
+    if (obj_hashtable_uint64_ts_alloc_buckets (sizeP, &hashtblP->next_nodes, &hashtblP->next_lock_nodes) != HASH_TABLE_OK) {
+      pthread_mutex_unlock (&hashtblP->mutex);
+      return HASH_TABLE_SYSTEM_ERROR;
+    }
+    hashtblP->next_size = sizeP;
+  }
+  if (!obj_hashtable_uint64_ts_try_write_lock (hashtblP)) {
+    pthread_mutex_unlock (&hashtblP->mutex);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  if (hashtblP->old_nodes) {
+    pthread_rwlock_unlock (&hashtblP->resize_lock);
+    pthread_mutex_unlock (&hashtblP->mutex);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  __sync_fetch_and_add (&hashtblP->rehash_seq_begin, 1);
+  hashtblP->old_size = hashtblP->size;
+  hashtblP->old_nodes = hashtblP->nodes;
+  hashtblP->old_lock_nodes = hashtblP->lock_nodes;
+  hashtblP->size = hashtblP->next_size;
+  hashtblP->nodes = hashtblP->next_nodes;
+  hashtblP->lock_nodes = hashtblP->next_lock_nodes;
+  __sync_fetch_and_add (&hashtblP->rehash_seq_end, 1);
+  hashtblP->rehash_index = 0;
+  hashtblP->rehashed_buckets = 0;
+  hashtblP->next_size = 0;
+  hashtblP->next_nodes = NULL;
+  hashtblP->next_lock_nodes = NULL;
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
+  pthread_mutex_unlock (&hashtblP->mutex);
+  PRINT_HASHTABLE (hashtblP, "%s(%s) resizing from %zu to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->old_size, sizeP);
+  return HASH_TABLE_OK;
+}
+
+/*
+   Release the old bucket array once all its buckets have been migrated, retried by the next insert/remove if resize_lock is busy.
+   Its buckets are empty but lock-free readers may still be looking at them, the array itself is retired.
+*/
+static void obj_hashtable_uint64_ts_end_rehash (obj_hash_table_uint64_t * const hashtblP)
+{
+  obj_hash_node_uint64_t                **old_nodes = NULL;
+  pthread_mutex_t                        *old_lock_nodes = NULL;
+  hash_size_t                             old_size = 0;
+  hash_size_t                             n = 0;
+
+  if (!obj_hashtable_uint64_ts_try_write_lock (hashtblP)) {
+    return;
+  }
+  if ((hashtblP->old_nodes) && (hashtblP->rehashed_buckets >= hashtblP->old_size)) {
+    old_size = hashtblP->old_size;
+    old_nodes = hashtblP->old_nodes;
+    old_lock_nodes = hashtblP->old_lock_nodes;
+    hashtblP->old_size = 0;
+    hashtblP->old_nodes = NULL;
+    hashtblP->old_lock_nodes = NULL;
+  }
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
+
+  if (old_nodes) {
+    for (n = 0; n < old_size; n++) {
+      pthread_mutex_destroy (&old_lock_nodes[n]);
+    }
+    free_wrapper ((void**)&old_lock_nodes);
+    hashtable_epoch_retire (old_nodes, free_wrapper);
+    PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->size);
+  }
+}
+
+/*
+   Called after an insert/remove or a walk with resize_lock held for reading, releases it.
+   Moves a resize forward, or starts one if the load factor is out of bounds.
+*/
+static void obj_hashtable_uint64_ts_resize_step (obj_hash_table_uint64_t * const hashtblP, const hash_size_t nb_bucketsP)
+{
+  bool                                    rehash_done = false;
+  hash_size_t                             size = 0;
+
+  if (hashtblP->old_nodes) {
+    obj_hashtable_uint64_ts_rehash_buckets (hashtblP, nb_bucketsP);
+    rehash_done = (hashtblP->rehashed_buckets >= hashtblP->old_size);
+  } else if (hashtblP->num_elements > (hashtblP->size * HASH_TABLE_TS_MAX_LOAD)) {
+    size = hashtblP->size << 1;
+  } else if ((hashtblP->size > hashtblP->min_size) && ((hashtblP->num_elements * HASH_TABLE_TS_MIN_LOAD_INVERSE) < hashtblP->size)) {
+    size = hashtblP->size >> 1;
+  }
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
+
+  if (rehash_done) {
+    obj_hashtable_uint64_ts_end_rehash (hashtblP);
+  } else if (size) {
+    obj_hashtable_uint64_ts_start_rehash (hashtblP, size);
+  }
+}
+
+/*
+   Walking the whole table: migrate the remaining old buckets first so that every element is seen once.
+   Returns with resize_lock held for reading, released by obj_hashtable_uint64_ts_resize_step().
+*/
+static void obj_hashtable_uint64_ts_walk_begin (obj_hash_table_uint64_t * const hashtblP)
+{
+  hash_size_t                             n = 0;
+
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  if (hashtblP->old_nodes) {
+    for (n = 0; n < hashtblP->old_size; n++) {
+      obj_hashtable_uint64_ts_migrate_bucket (hashtblP, n);
+    }
+  }
+}
+
+/*
+   Lock-free lookup, called inside an epoch section. The old bucket of the key is searched before the current one since nodes
+   only move from old to current buckets. A hit is always right, a miss only if no bucket array swap or migration ran meanwhile.
+   Writers bump the sequence counters with full barriers, acquire ordering is enough here.
+   Returns false if resizes kept interfering, the caller then takes the locks.
+*/
+static bool obj_hashtable_uint64_ts_lookup (const obj_hash_table_uint64_t * const hashtblP, const void * const keyP, const int key_sizeP, uint64_t * const dataP, hashtable_rc_t * const rcP)
+{
+  obj_hash_node_uint64_t                **nodes = NULL;
+  obj_hash_node_uint64_t                **old_nodes = NULL;
+  obj_hash_node_uint64_t                 *node = NULL;
+  hash_size_t                             size = 0;
+  hash_size_t                             old_size = 0;
+  hash_size_t                             hash = hashtblP->hashfunc (keyP, key_sizeP);
+  uint64_t                                seq = 0;
+  int                                     tries = 0;
+
+  for (tries = 0; tries < HASH_TABLE_LOCK_FREE_READ_TRIES; tries++) {
+    seq = __atomic_load_n (&hashtblP->rehash_seq_end, __ATOMIC_ACQUIRE);
+    size = hashtblP->size;
+    nodes = hashtblP->nodes;
+    old_size = hashtblP->old_size;
+    old_nodes = hashtblP->old_nodes;
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if (hashtblP->rehash_seq_begin != seq) {
+      continue;
+    }
+
+    if (old_nodes) {
+      for (node = old_nodes[hash % old_size]; node; node = node->next) {
+        if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
+          *dataP = node->data;
+          *rcP = HASH_TABLE_OK;
+          return true;
+        }
+      }
+    }
+    for (node = nodes[hash % size]; node; node = node->next) {
+      if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
+        *dataP = node->data;
+        *rcP = HASH_TABLE_OK;
+        return true;
+      }
+    }
+
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if (hashtblP->rehash_seq_begin == seq) {
+      *rcP = HASH_TABLE_KEY_NOT_EXISTS;
+      return true;
+    }
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
@@ -205,6 +501,8 @@ obj_hashtable_uint64_ts_init (
   for (int i = 0; i < size; i++) {
     pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
   }
+  pthread_rwlock_init(&hashtblP->resize_lock, NULL);
+  hashtblP->min_size = size;
 
   hashtblP->log_enabled = true;
   return hashtblP;
@@ -295,6 +593,8 @@ obj_hashtable_uint64_ts_destroy (
   obj_hash_node_uint64_t                 *node,
                                          *oldnode;
 
+  obj_hashtable_uint64_ts_walk_begin (hashtblP);
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
   for (n = 0; n < hashtblP->size; ++n) {
     pthread_mutex_lock (&hashtblP->lock_nodes[n]);
     node = hashtblP->nodes[n];
@@ -306,11 +606,16 @@ obj_hashtable_uint64_ts_destroy (
       free_wrapper ((void**)&oldnode);
     }
     pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
   }
 
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper((void**)&hashtblP->lock_nodes);
+  obj_hashtable_uint64_ts_free_buckets (hashtblP->size, &hashtblP->nodes, &hashtblP->lock_nodes);
+  if (hashtblP->old_nodes) {
+    obj_hashtable_uint64_ts_free_buckets (hashtblP->old_size, &hashtblP->old_nodes, &hashtblP->old_lock_nodes);
+  }
+  if (hashtblP->next_nodes) {
+    obj_hashtable_uint64_ts_free_buckets (hashtblP->next_size, &hashtblP->next_nodes, &hashtblP->next_lock_nodes);
+  }
+  pthread_rwlock_destroy (&hashtblP->resize_lock);
   bdestroy_wrapper (&hashtblP->name);
   free_wrapper ((void**)&hashtblP);
   return HASH_TABLE_OK;
@@ -362,8 +667,11 @@ obj_hashtable_uint64_ts_is_key_exists (
   const void *const keyP,
   const int key_sizeP)
 {
+  obj_hash_table_uint64_t                *hashtbl = (obj_hash_table_uint64_t *)hashtblP;
   obj_hash_node_uint64_t                 *node;
   hash_size_t                             hash;
+  uint64_t                                data = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -374,19 +682,30 @@ obj_hashtable_uint64_ts_is_key_exists (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
+  hashtable_epoch_enter ();
+  if (obj_hashtable_uint64_ts_lookup (hashtblP, keyP, key_sizeP, &data, &rc)) {
+    hashtable_epoch_exit ();
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) return %s\n", __FUNCTION__,
+              bdata(hashtblP->name), keyP, key_sizeP, hashtable_rc_code2string(rc));
+    return rc;
+  }
+  hashtable_epoch_exit ();
+
+  pthread_rwlock_rdlock (&hashtbl->resize_lock);
+  hash = obj_hashtable_uint64_ts_lock_bucket (hashtbl, keyP, key_sizeP);
   node = hashtblP->nodes[hash];
 
   while (node) {
     if (node->key == keyP) {
       pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+      pthread_rwlock_unlock (&hashtbl->resize_lock);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return OK\n", __FUNCTION__,
               bdata(hashtblP->name), keyP, key_sizeP, hash);
       return HASH_TABLE_OK;
     } else if (node->key_size == key_sizeP) {
       if (memcmp (node->key, keyP, key_sizeP) == 0) {
         pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+        pthread_rwlock_unlock (&hashtbl->resize_lock);
         PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return OK\n", __FUNCTION__,
                 bdata(hashtblP->name), keyP, key_sizeP, hash);
         return HASH_TABLE_OK;
@@ -396,6 +715,7 @@ obj_hashtable_uint64_ts_is_key_exists (
     node = node->next;
   }
   pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtbl->resize_lock);
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__,
           bdata(hashtblP->name), keyP, key_sizeP, hash);
@@ -442,6 +762,7 @@ obj_hashtable_uint64_ts_dump_content (
   const obj_hash_table_uint64_t * const hashtblP,
   bstring str)
 {
+  obj_hash_table_uint64_t                *hashtbl = (obj_hash_table_uint64_t *)hashtblP;
   obj_hash_node_uint64_t                 *node = NULL;
   unsigned int                            i = 0;
 
@@ -450,6 +771,7 @@ obj_hashtable_uint64_ts_dump_content (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
+  obj_hashtable_uint64_ts_walk_begin (hashtbl);
   while (i < hashtblP->size) {
     if (hashtblP->nodes[i] != NULL) {
       pthread_mutex_lock(&hashtblP->lock_nodes[i]);
@@ -469,6 +791,7 @@ obj_hashtable_uint64_ts_dump_content (
     }
     i += 1;
   }
+  obj_hashtable_uint64_ts_resize_step (hashtbl, hashtbl->old_size);
   return HASH_TABLE_OK;
 }
 
@@ -565,8 +888,8 @@ obj_hashtable_uint64_ts_insert (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  hash = obj_hashtable_uint64_ts_lock_bucket (hashtblP, keyP, key_sizeP);
   node = hashtblP->nodes[hash];
 
   while (node) {
@@ -576,11 +899,13 @@ obj_hashtable_uint64_ts_insert (
         node->key_size = key_sizeP;
         // no waste of memory here because if node->key == keyP, it is a reuse of the same key
         pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+        pthread_rwlock_unlock (&hashtblP->resize_lock);
         PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
         return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
       }
       node->data = dataP;
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_rwlock_unlock (&hashtblP->resize_lock);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return ok\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
       return HASH_TABLE_OK;
 
@@ -591,6 +916,7 @@ obj_hashtable_uint64_ts_insert (
 
   if (!(node = calloc (1, sizeof (obj_hash_node_uint64_t)))) {
     pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+    pthread_rwlock_unlock (&hashtblP->resize_lock);
     PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
     return HASH_TABLE_SYSTEM_ERROR;
   }
@@ -598,6 +924,7 @@ obj_hashtable_uint64_ts_insert (
   if (!(node->key = calloc (1, key_sizeP))) {
     free_wrapper ((void**)&node);
     pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+    pthread_rwlock_unlock (&hashtblP->resize_lock);
     PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
     return HASH_TABLE_SYSTEM_ERROR;
   }
@@ -613,9 +940,14 @@ obj_hashtable_uint64_ts_insert (
     node->next = NULL;
   }
 
+  /*
+   * Lock-free readers must not see the node before its content
+   */
+  __sync_synchronize ();
   hashtblP->nodes[hash] = node;
   __sync_fetch_and_add (&hashtblP->num_elements, 1);
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  obj_hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %"PRIx64") hash %lx return OK\n", __FUNCTION__,
           bdata(hashtblP->name), keyP, key_sizeP, dataP, hash);
   return HASH_TABLE_OK;
@@ -694,8 +1026,8 @@ obj_hashtable_uint64_ts_free (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  hash = obj_hashtable_uint64_ts_lock_bucket (hashtblP, keyP, key_sizeP);
   node = hashtblP->nodes[hash];
 
   while (node) {
@@ -706,10 +1038,14 @@ obj_hashtable_uint64_ts_free (
         hashtblP->nodes[hash] = node->next;
       }
 
-      hashtblP->freekeyfunc (&node->key);
-      free_wrapper ((void**)&node);
+      /*
+       * Lock-free readers may still compare the key of the unlinked node
+       */
+      hashtable_epoch_retire (node->key, hashtblP->freekeyfunc);
+      hashtable_epoch_retire (node, free_wrapper);
       __sync_fetch_and_sub (&hashtblP->num_elements, 1);
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      obj_hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
       return HASH_TABLE_OK;
     }
@@ -718,6 +1054,7 @@ obj_hashtable_uint64_ts_free (
     node = node->next;
   }
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
 
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -795,8 +1132,8 @@ obj_hashtable_uint64_ts_remove (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_rdlock (&hashtblP->resize_lock);
+  hash = obj_hashtable_uint64_ts_lock_bucket (hashtblP, keyP, key_sizeP);
   node = hashtblP->nodes[hash];
 
   while (node) {
@@ -807,10 +1144,14 @@ obj_hashtable_uint64_ts_remove (
         hashtblP->nodes[hash] = node->next;
       }
 
-      hashtblP->freekeyfunc (&node->key);
-      free_wrapper ((void**)&node);
+      /*
+       * Lock-free readers may still compare the key of the unlinked node
+       */
+      hashtable_epoch_retire (node->key, hashtblP->freekeyfunc);
+      hashtable_epoch_retire (node, free_wrapper);
       __sync_fetch_and_sub (&hashtblP->num_elements, 1);
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      obj_hashtable_uint64_ts_resize_step (hashtblP, HASH_TABLE_REHASH_BUCKETS_PER_OP);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
       return HASH_TABLE_OK;
     }
@@ -819,6 +1160,7 @@ obj_hashtable_uint64_ts_remove (
     node = node->next;
   }
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtblP->resize_lock);
 
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -882,8 +1224,10 @@ obj_hashtable_uint64_ts_get (
   const int key_sizeP,
   uint64_t  * const dataP)
 {
+  obj_hash_table_uint64_t                *hashtbl = (obj_hash_table_uint64_t *)hashtblP;
   obj_hash_node_uint64_t                        *node;
   hash_size_t                             hash;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -894,14 +1238,24 @@ obj_hashtable_uint64_ts_get (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
+  hashtable_epoch_enter ();
+  if (obj_hashtable_uint64_ts_lookup (hashtblP, keyP, key_sizeP, dataP, &rc)) {
+    hashtable_epoch_exit ();
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %"PRIx64") return %s\n", __FUNCTION__,
+              bdata(hashtblP->name), keyP, key_sizeP, *dataP, hashtable_rc_code2string(rc));
+    return rc;
+  }
+  hashtable_epoch_exit ();
+
+  pthread_rwlock_rdlock (&hashtbl->resize_lock);
+  hash = obj_hashtable_uint64_ts_lock_bucket (hashtbl, keyP, key_sizeP);
   node = hashtblP->nodes[hash];
 
   while (node) {
     if (node->key == keyP) {
       *dataP = node->data;
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_rwlock_unlock (&hashtbl->resize_lock);
       PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %"PRIx64") hash %lx return OK\n", __FUNCTION__,
               bdata(hashtblP->name), keyP, key_sizeP, *dataP, hash);
       return HASH_TABLE_OK;
@@ -909,6 +1263,7 @@ obj_hashtable_uint64_ts_get (
       if (memcmp (node->key, keyP, key_sizeP) == 0) {
         *dataP = node->data;
         pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+        pthread_rwlock_unlock (&hashtbl->resize_lock);
         PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %"PRIx64") hash %lx return OK\n", __FUNCTION__,
                 bdata(hashtblP->name), keyP, key_sizeP, *dataP, hash);
         return HASH_TABLE_OK;
@@ -919,6 +1274,7 @@ obj_hashtable_uint64_ts_get (
   }
 
   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_rwlock_unlock (&hashtbl->resize_lock);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__,
           bdata(hashtblP->name), keyP, key_sizeP, hash);
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -971,6 +1327,7 @@ obj_hashtable_uint64_ts_get_keys (
   void **keysP,
   unsigned int *sizeP)
 {
+  obj_hash_table_uint64_t                *hashtbl = (obj_hash_table_uint64_t *)hashtblP;
   size_t                                  n = 0;
   obj_hash_node_uint64_t                 *node = NULL;
   obj_hash_node_uint64_t                 *next = NULL;
@@ -983,6 +1340,7 @@ obj_hashtable_uint64_ts_get_keys (
   *sizeP = 0;
   keysP = calloc (hashtblP->num_elements,  sizeof (void *));
 
+  obj_hashtable_uint64_ts_walk_begin (hashtbl);
   if (keysP) {
     for (n = 0; n < hashtblP->size; ++n) {
       pthread_mutex_lock (&hashtblP->lock_nodes[n]);
@@ -993,9 +1351,11 @@ obj_hashtable_uint64_ts_get_keys (
       pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
     }
 
+    obj_hashtable_uint64_ts_resize_step (hashtbl, hashtbl->old_size);
     PRINT_HASHTABLE (hashtblP, "return OK\n");
     return HASH_TABLE_OK;
   }
+  obj_hashtable_uint64_ts_resize_step (hashtbl, hashtbl->old_size);
   PRINT_HASHTABLE (hashtblP, "return SYSTEM_ERROR\n");
   return HASH_TABLE_SYSTEM_ERROR;
 }
@@ -1067,24 +1427,16 @@ obj_hashtable_uint64_resize (
 //------------------------------------------------------------------------------
 /*
    Resizing
-   The number of elements in a hash table is not always known when creating the table.
-   If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
-   If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
-   Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary obj_hash_table_uint64_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse obj_hashtable_uint64_insert() and obj_hashtable_uint64_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
+   The thread safe tables resize by themselves with their load factor, this function only forces a new size (rounded up to a power of two).
+   The resize is incremental: the new bucket array is swapped in at once, then each operation on the table moves the elements of
+   the old buckets it touches and each insert/remove moves HASH_TABLE_REHASH_BUCKETS_PER_OP more old buckets.
+   HASH_TABLE_SYSTEM_ERROR is returned if another resize is still in progress or if the new buckets cannot be allocated.
 */
 hashtable_rc_t
 obj_hashtable_uint64_ts_resize (
   obj_hash_table_uint64_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  obj_hash_table_uint64_t                        newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n;
-  obj_hash_node_uint64_t                        *node,
-                                         *next;
-
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
@@ -1107,35 +1459,5 @@ obj_hashtable_uint64_ts_resize (
   size |= size >> 16;
   size++;
 
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (obj_hash_node_uint64_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      obj_hashtable_uint64_ts_remove (hashtblP, node->key, node->key_size);
-      obj_hashtable_uint64_insert (&newtbl, node->key, node->key_size, node->data);
-    }
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper ((void**)&hashtblP->nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
-  PRINT_HASHTABLE (hashtblP, "return OK\n");
-  return HASH_TABLE_OK;
+  return obj_hashtable_uint64_ts_start_rehash (hashtblP, size);
 }
@@ -47,6 +47,7 @@
 #include "timer.h"
 #include "log.h"
 #include "shared_ts_log.h"
+#include "log_ring.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
 
@@ -108,19 +109,29 @@ typedef struct oai_log_s {
   char                                    log_level2str[MAX_LOG_LEVEL][LOG_LEVEL_NAME_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   char                                    log_level2ansi[MAX_LOG_LEVEL][ANSI_CODE_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   int                                     log_start_time_second;                                       /*!< \brief Logging utility reference time              */
-  log_level_t                             log_level[MAX_LOG_PROTOS];                                   /*!< \brief Loglevel id of each client (protocol/layer) */
+  log_level_t                             saved_log_level[MAX_LOG_PROTOS];                             /*!< \brief Loglevels restored by log_toggle_levels() */
+  bool                                    is_log_level_toggled;                                        /*!< \brief log_toggle_levels() raised all loglevels */
 
   log_message_number_t                    log_message_number;                                          /*!< \brief Counter of log message        */
   hash_table_ts_t                           *thread_context_htbl;                                         /*!< \brief Container for log_thread_ctxt_t */
+
+  volatile bool                           is_ring_enabled;                                             /*!< \brief log_message() records in the per-thread log rings, TASK_LOG formats */
+  bstring                                 ring_line;                                                   /*!< \brief Message formatted from a log ring, used by TASK_LOG only */
+  bstring                                 ring_body;                                                   /*!< \brief Text of the message formatted from a log ring, used by TASK_LOG only */
 } oai_log_t;
 
 static oai_log_t g_oai_log={0};    /*!< \brief  logging utility internal variables global var definition*/
+log_level_t     g_oai_log_level[MAX_LOG_PROTOS] = {0};    /*!< \brief Loglevel id of each client (protocol/layer) */
+
+static void log_ring_output (const log_ring_header_t * const header, const_bstring body);
+static void log_ring_dropped_output (const pthread_t tid, const uint64_t nb_dropped);
 
 //------------------------------------------------------------------------------
 void* log_task (__attribute__ ((unused)) void *args_p)
 {
   MessageDef                             *received_message_p = NULL;
   long                                    timer_id = 0;
+  long                                    ring_timer_id = -1;
   int                                     rc = 0;
 
   itti_mark_task_ready (TASK_LOG);
@@ -129,6 +140,19 @@ void* log_task (__attribute__ ((unused)) void *args_p)
                LOG_FLUSH_PERIOD_MICRO_SEC,
                TASK_LOG, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
 
+  /*
+   * From now on log_message() only records messages in the log ring of the calling thread, they are formatted here
+   */
+  g_oai_log.ring_line = bfromcstralloc (LOG_MESSAGE_MIN_ALLOC_SIZE, "");
+  g_oai_log.ring_body = bfromcstralloc (LOG_MESSAGE_MIN_ALLOC_SIZE, "");
+  if (timer_setup (LOG_FLUSH_PERIOD_SEC,
+                   LOG_FLUSH_PERIOD_MICRO_SEC,
+                   TASK_LOG, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &ring_timer_id) == 0) {
+    g_oai_log.is_ring_enabled = true;
+  } else {
+    OAI_FPRINTF_ERR("Could not start the log ring flush timer, log rings disabled\n");
+  }
+
   while (1) {
     itti_receive_msg (TASK_LOG, &received_message_p);
 
@@ -136,8 +160,11 @@ void* log_task (__attribute__ ((unused)) void *args_p)
 
       switch (ITTI_MSG_ID (received_message_p)) {
       case TIMER_HAS_EXPIRED:{
+          if (TIMER_HAS_EXPIRED (received_message_p).timer_id == ring_timer_id) {
+            log_ring_flush (log_ring_output, log_ring_dropped_output, g_oai_log.ring_body);
+          }
           // if tcp logging is enabled
-          if (LOG_TCP_STATE_NOT_CONNECTED == g_oai_log.tcp_state) {
+          else if (LOG_TCP_STATE_NOT_CONNECTED == g_oai_log.tcp_state) {
             log_connect_to_server();
             timer_setup (LOG_CONNECT_PERIOD_SEC,
                          LOG_CONNECT_PERIOD_MICRO_SEC,
@@ -148,6 +175,11 @@ void* log_task (__attribute__ ((unused)) void *args_p)
 
       case TERMINATE_MESSAGE:{
           timer_remove (timer_id, NULL);
+          if (g_oai_log.is_ring_enabled) {
+            timer_remove (ring_timer_id, NULL);
+            g_oai_log.is_ring_enabled = false;
+            log_ring_flush (log_ring_output, log_ring_dropped_output, g_oai_log.ring_body);
+          }
           log_exit ();
 
           MessageDef   *terminate_message_p = itti_alloc_new_message (TASK_LOG, TERMINATE_MESSAGE);
@@ -238,30 +270,30 @@ void log_connect_to_server(void)
 void log_set_config(const log_config_t * const config)
 {
   if (config) {
-    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log.log_level[LOG_UDP] = config->udp_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log.log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log.log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
-    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log.log_level[LOG_SCTP]     = config->sctp_log_level;
-    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log.log_level[LOG_S1AP]     = config->s1ap_log_level;
-    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log.log_level[LOG_MME_APP]  = config->mme_app_log_level;
+    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log_level[LOG_UDP] = config->udp_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
+    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log_level[LOG_SCTP]     = config->sctp_log_level;
+    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log_level[LOG_S1AP]     = config->s1ap_log_level;
+    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log_level[LOG_MME_APP]  = config->mme_app_log_level;
     if ((MAX_LOG_LEVEL > config->nas_log_level) && (MIN_LOG_LEVEL <= config->nas_log_level)) {
-      g_oai_log.log_level[LOG_NAS]      = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_EMM]  = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_ESM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS]      = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_EMM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_ESM]  = config->nas_log_level;
     }
-    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log.log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
-    if ((MAX_LOG_LEVEL > config->s10_log_level) && (MIN_LOG_LEVEL <= config->s10_log_level))           g_oai_log.log_level[LOG_S10]      = config->s10_log_level;
-    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log.log_level[LOG_S11]      = config->s11_log_level;
-    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log.log_level[LOG_S6A]      = config->s6a_log_level;
-    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log.log_level[LOG_SECU]     = config->secu_log_level;
-    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log.log_level[LOG_UTIL]     = config->util_log_level;
-    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log.log_level[LOG_MSC]      = config->msc_log_level;
-    if ((MAX_LOG_LEVEL > config->xml_log_level) && (MIN_LOG_LEVEL <= config->xml_log_level))           g_oai_log.log_level[LOG_XML]      = config->xml_log_level;
+    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
+    if ((MAX_LOG_LEVEL > config->s10_log_level) && (MIN_LOG_LEVEL <= config->s10_log_level))           g_oai_log_level[LOG_S10]      = config->s10_log_level;
+    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log_level[LOG_S11]      = config->s11_log_level;
+    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log_level[LOG_S6A]      = config->s6a_log_level;
+    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log_level[LOG_SECU]     = config->secu_log_level;
+    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log_level[LOG_UTIL]     = config->util_log_level;
+    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log_level[LOG_MSC]      = config->msc_log_level;
+    if ((MAX_LOG_LEVEL > config->xml_log_level) && (MIN_LOG_LEVEL <= config->xml_log_level))           g_oai_log_level[LOG_XML]      = config->xml_log_level;
     if ((MAX_LOG_LEVEL > config->mme_scenario_player_log_level) && (MIN_LOG_LEVEL <= config->mme_scenario_player_log_level))
-      g_oai_log.log_level[LOG_MME_SCENARIO_PLAYER]      = config->mme_scenario_player_log_level;
-    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log.log_level[LOG_ITTI]     = config->itti_log_level;
+      g_oai_log_level[LOG_MME_SCENARIO_PLAYER]      = config->mme_scenario_player_log_level;
+    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log_level[LOG_ITTI]     = config->itti_log_level;
     if ((MAX_LOG_LEVEL > config->async_system_log_level) && (MIN_LOG_LEVEL <= config->async_system_log_level))
-      g_oai_log.log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
+      g_oai_log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
 
 
     g_oai_log.is_output_fd_buffered = config->is_output_thread_safe;
@@ -307,6 +339,44 @@ void log_set_config(const log_config_t * const config)
   }
 }
 
+//------------------------------------------------------------------------------
+/*
+   Can be called at any time from any thread, the loglevel is read without lock by the OAILOG macros.
+*/
+void log_set_level(const log_proto_t protoP, const log_level_t log_levelP)
+{
+  if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
+    return;
+  }
+  if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
+    return;
+  }
+  __atomic_store_n (&g_oai_log_level[protoP], log_levelP, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Raise the loglevel of all protocols to the least severe level compiled in, or restore the
+   previous loglevels if already raised (see SIGUSR2 in signals.c).
+   Not reentrant, called from a single thread.
+*/
+void log_toggle_levels(void)
+{
+  log_level_t                             log_level = (LOG_OAI_COMPILED_LEVEL < MAX_LOG_LEVEL) ? LOG_OAI_COMPILED_LEVEL : OAILOG_LEVEL_TRACE;
+  int                                     i = 0;
+
+  for (i = MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
+    if (g_oai_log.is_log_level_toggled) {
+      log_set_level (i, g_oai_log.saved_log_level[i]);
+    } else {
+      g_oai_log.saved_log_level[i] = __atomic_load_n (&g_oai_log_level[i], __ATOMIC_RELAXED);
+      log_set_level (i, log_level);
+    }
+  }
+  g_oai_log.is_log_level_toggled = !g_oai_log.is_log_level_toggled;
+  OAI_FPRINTF_INFO("Log levels %s\n", (g_oai_log.is_log_level_toggled) ? "raised" : "restored");
+}
+
 //------------------------------------------------------------------------------
 const char * log_level_int2str(const log_level_t log_level)
 {
@@ -421,7 +491,7 @@ log_init (
   snprintf (&g_oai_log.log_level2ansi[OAILOG_LEVEL_EMERGENCY][0], ANSI_CODE_MAX_LENGTH, ANSI_COLOR_FG_REV_RED);
 
   for (i=MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
-    g_oai_log.log_level[i] = default_log_levelP;
+    g_oai_log_level[i] = default_log_levelP;
   }
   // did not check return value of snprintf...
   for (i=MIN_LOG_LEVEL; i < MAX_LOG_LEVEL; i++) {
@@ -464,15 +534,15 @@ void log_start_use (void)
 }
 
 //------------------------------------------------------------------------------
-void log_flush_message (struct shared_log_queue_item_s *item_p)
+static void log_output (const int log_levelP, const_bstring bstr)
 {
   int                                     rv = 0;
   int                                     rv_put = 0;
 
-  if (blength(item_p->bstr) > 0) {
+  if (blength(bstr) > 0) {
     if (g_oai_log.is_output_is_fd) {
       if (g_oai_log.log_fd) {
-        rv_put = fputs ((const char *)item_p->bstr->data, g_oai_log.log_fd);
+        rv_put = fputs ((const char *)bstr->data, g_oai_log.log_fd);
 
         if (rv_put < 0) {
           // error occured
@@ -491,11 +561,64 @@ void log_flush_message (struct shared_log_queue_item_s *item_p)
         fflush (g_oai_log.log_fd);
       }
     } else {
-      syslog (item_p->u_app_log.log.log_level ,"%s", bdata(item_p->bstr));
+      syslog (log_levelP ,"%s", bdata(bstr));
     }
   }
 }
 
+//------------------------------------------------------------------------------
+void log_flush_message (struct shared_log_queue_item_s *item_p)
+{
+  log_output (item_p->u_app_log.log.log_level, item_p->bstr);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Called by TASK_LOG for each message recorded in a log ring, same layout as log_message().
+*/
+static void log_ring_output (const log_ring_header_t * const header, const_bstring body)
+{
+  int                                     filename_length = strlen (header->source_file);
+  const char                             *source_file = header->source_file;
+
+  btrunc (g_oai_log.ring_line, 0);
+  if (g_oai_log.is_ansi_codes) {
+    bcatcstr (g_oai_log.ring_line, &g_oai_log.log_level2ansi[header->log_level][0]);
+  }
+  if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
+    source_file = &source_file[filename_length - LOG_DISPLAYED_FILENAME_MAX_LENGTH];
+  }
+  bformata (g_oai_log.ring_line, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
+      header->number, header->elapsed_time.tv_sec, header->elapsed_time.tv_usec,
+      header->tid,
+      LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[header->log_level][0],
+      LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[header->protocol][0],
+      LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_file, header->line,
+      header->indent, " ");
+  bconcat (g_oai_log.ring_line, body);
+  if (g_oai_log.is_ansi_codes) {
+    bcatcstr (g_oai_log.ring_line, ANSI_COLOR_RESET);
+  }
+  log_output (header->log_level, g_oai_log.ring_line);
+}
+
+//------------------------------------------------------------------------------
+static void log_ring_dropped_output (const pthread_t tid, const uint64_t nb_dropped)
+{
+  log_ring_header_t                       header = {0};
+
+  header.number = __sync_fetch_and_add (&g_oai_log.log_message_number, 1);
+  shared_log_get_elapsed_time_since_start (&header.elapsed_time);
+  header.tid = tid;
+  header.source_file = __FILE__;
+  header.line = __LINE__;
+  header.log_level = OAILOG_LEVEL_WARNING;
+  header.protocol = LOG_UTIL;
+  btrunc (g_oai_log.ring_body, 0);
+  bformata (g_oai_log.ring_body, "%" PRIu64 " messages dropped, log ring of the thread full\n", nb_dropped);
+  log_ring_output (&header, g_oai_log.ring_body);
+}
+
 //------------------------------------------------------------------------------
 void log_exit (void)
 {
@@ -521,6 +644,8 @@ void log_exit (void)
   hashtable_ts_destroy (g_oai_log.thread_context_htbl);
   bdestroy_wrapper(&g_oai_log.bserver_address);
   bdestroy_wrapper(&g_oai_log.bserver_port);
+  bdestroy_wrapper(&g_oai_log.ring_line);
+  bdestroy_wrapper(&g_oai_log.ring_body);
   OAI_FPRINTF_INFO("[TRACE] Leaving %s\n", __FUNCTION__);
 }
 
@@ -696,7 +821,7 @@ void log_message_start (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > __atomic_load_n (&g_oai_log_level[protoP], __ATOMIC_RELAXED)) {
     return;
   }
 
@@ -842,7 +967,7 @@ log_message (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > __atomic_load_n (&g_oai_log_level[protoP], __ATOMIC_RELAXED)) {
     return;
   }
   if (NULL == thread_ctxt){
@@ -856,6 +981,22 @@ log_message (
     }
   }
 
+  if (g_oai_log.is_ring_enabled) {
+    log_ring_header_t                     header;
+
+    header.number = __sync_fetch_and_add (&g_oai_log.log_message_number, 1);
+    shared_log_get_elapsed_time_since_start (&header.elapsed_time);
+    header.source_file = source_fileP;
+    header.line = line_numP;
+    header.indent = thread_ctxt->indent;
+    header.log_level = log_levelP;
+    header.protocol = protoP;
+    va_start (args, format);
+    log_ring_record (&header, format, args);
+    va_end (args);
+    return;
+  }
+
   new_item_p = get_new_log_queue_item(SH_TS_LOG_TXT);
 
   if (new_item_p) {
@@ -202,10 +202,30 @@ typedef struct log_config_s {
   bool          color;              /*!< \brief use of ANSI styling codes or no */
 } log_config_t;
 
+/*
+ * Least severe level compiled in, as a log_level_t value (0 EMERGENCY .. 6 INFO, 7 DEBUG, 8 TRACE).
+ * The OAILOG_DEBUG, OAILOG_TRACE and OAILOG_FUNC_* call sites of a less severe level are removed by the
+ * preprocessor, the other ones are removed by the compiler.
+ */
+#if !defined(LOG_OAI_COMPILED_LEVEL)
+#  if TRACE_IS_ON
+#    define LOG_OAI_COMPILED_LEVEL                                      8
+#  elif DEBUG_IS_ON
+#    define LOG_OAI_COMPILED_LEVEL                                      7
+#  else
+#    define LOG_OAI_COMPILED_LEVEL                                      6
+#  endif
+#endif
+
 # if LOG_OAI
 
+/* Current level of each protocol, read without lock by OAILOG_IS_ENABLED(), written by log_set_level() */
+extern log_level_t g_oai_log_level[MAX_LOG_PROTOS];
+
 void log_connect_to_server(void);
 void log_set_config(const log_config_t * const config);
+void log_set_level(const log_proto_t protoP, const log_level_t log_levelP);
+void log_toggle_levels(void);
 const char * log_level_int2str(const log_level_t log_level);
 log_level_t log_level_str2int(const char * const log_level_str);
 
@@ -285,42 +305,52 @@ void log_message (
 int log_get_start_time_sec (void);
 
 #    define OAILOG_SET_CONFIG                                           log_set_config
+#    define OAILOG_SET_LEVEL                                            log_set_level
+#    define OAILOG_TOGGLE_LEVELS()                                      log_toggle_levels()
 #    define OAILOG_LEVEL_STR2INT                                        log_level_str2int
 #    define OAILOG_LEVEL_INT2STR                                        log_level_int2str
 #    define OAILOG_INIT                                                 log_init
 #    define OAILOG_ITTI_CONNECT                                         log_itti_connect
 #    define OAILOG_EXIT()                                               log_exit()
-#    define OAILOG_SPEC(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief 3GPP trace on specifications */
-#    define OAILOG_EMERGENCY(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_EMERGENCY,pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief system is unusable */
-#    define OAILOG_ALERT(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ALERT,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief action must be taken immediately */
-#    define OAILOG_CRITICAL(pRoTo, ...)                                 do { log_message(NULL, OAILOG_LEVEL_CRITICAL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief critical conditions */
-#    define OAILOG_ERROR(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ERROR,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief error conditions */
-#    define OAILOG_WARNING(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_WARNING,  pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief warning conditions */
-#    define OAILOG_NOTICE(pRoTo, ...)                                   do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief normal but significant condition */
-#    define OAILOG_INFO(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_INFO,     pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief informational */
+/*! \brief true if a message of this level and protocol would be logged, to be tested before building costly arguments or dumps */
+#    define OAILOG_IS_ENABLED(lOgLeVeL, pRoTo)                          (((lOgLeVeL) <= LOG_OAI_COMPILED_LEVEL) && ((lOgLeVeL) <= __atomic_load_n (&g_oai_log_level[pRoTo], __ATOMIC_RELAXED)))
+#    define OAILOG_LOG(lOgLeVeL, pRoTo, ...)                            do { if (OAILOG_IS_ENABLED(lOgLeVeL, pRoTo)) log_message(NULL, lOgLeVeL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
+#    define OAILOG_SPEC(pRoTo, ...)                                     OAILOG_LOG(OAILOG_LEVEL_NOTICE,    pRoTo, ##__VA_ARGS__) /*!< \brief 3GPP trace on specifications */
+#    define OAILOG_EMERGENCY(pRoTo, ...)                                OAILOG_LOG(OAILOG_LEVEL_EMERGENCY, pRoTo, ##__VA_ARGS__) /*!< \brief system is unusable */
+#    define OAILOG_ALERT(pRoTo, ...)                                    OAILOG_LOG(OAILOG_LEVEL_ALERT,     pRoTo, ##__VA_ARGS__) /*!< \brief action must be taken immediately */
+#    define OAILOG_CRITICAL(pRoTo, ...)                                 OAILOG_LOG(OAILOG_LEVEL_CRITICAL,  pRoTo, ##__VA_ARGS__) /*!< \brief critical conditions */
+#    define OAILOG_ERROR(pRoTo, ...)                                    OAILOG_LOG(OAILOG_LEVEL_ERROR,     pRoTo, ##__VA_ARGS__) /*!< \brief error conditions */
+#    define OAILOG_WARNING(pRoTo, ...)                                  OAILOG_LOG(OAILOG_LEVEL_WARNING,   pRoTo, ##__VA_ARGS__) /*!< \brief warning conditions */
+#    define OAILOG_NOTICE(pRoTo, ...)                                   OAILOG_LOG(OAILOG_LEVEL_NOTICE,    pRoTo, ##__VA_ARGS__) /*!< \brief normal but significant condition */
+#    define OAILOG_INFO(pRoTo, ...)                                     OAILOG_LOG(OAILOG_LEVEL_INFO,      pRoTo, ##__VA_ARGS__) /*!< \brief informational */
 #    define OAILOG_MESSAGE_START(lOgLeVeL, pRoTo, cOnTeXt, ...)         do { log_message_start(NULL, lOgLeVeL, pRoTo, cOnTeXt, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief when need to log only 1 message with many char messages, ex formating a dumped struct */
 #    define OAILOG_MESSAGE_ADD(cOnTeXt, ...)                            do { log_message_add(cOnTeXt, ##__VA_ARGS__); } while(0) /*!< \brief can be called as many times as needed after OAILOG_MESSAGE_START() */
 #    define OAILOG_MESSAGE_FINISH(cOnTeXt)                              do { log_message_finish(cOnTeXt); } while(0) /*!< \brief Send the message built by OAILOG_MESSAGE_START() n*LOG_MESSAGE_ADD() (n=0..N) */
 #    define OAILOG_STREAM_HEX(lOgLeVeL, pRoTo, mEsSaGe, sTrEaM, sIzE)   do { \
+                                                                   if (OAILOG_IS_ENABLED(lOgLeVeL, pRoTo)) { \
                                                                    OAI_GCC_DIAG_OFF(pointer-sign); \
                                                                    log_stream_hex(lOgLeVeL, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE);\
                                                                    OAI_GCC_DIAG_ON(pointer-sign); \
+                                                                   } \
                                                                  } while(0); /*!< \brief trace buffer content */
-#    if DEBUG_IS_ON
-#      define OAILOG_DEBUG(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_DEBUG,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief debug informations */
-#      if TRACE_IS_ON
-#        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   do { log_message(NULL, lOgLeVeL       ,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
-#        define OAILOG_TRACE(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_TRACE,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief most detailled informations, struct dumps */
-#        define OAILOG_FUNC_IN(pRoTo)                                   do { log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
-#        define OAILOG_FUNC_OUT(pRoTo)                                  do { log_func(false, pRoTo, __FILE__, __LINE__, __FUNCTION__); return;} while(0) /*!< \brief informational */
-#        define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                   do { log_func_return(pRoTo, __FILE__, __LINE__, __FUNCTION__, (long)rEtUrNcOdE); return rEtUrNcOdE;} while(0) /*!< \brief informational */
-#        define OAILOG_STREAM_HEX_ARRAY(pRoTo, mEsSaGe, sTrEaM, sIzE)       do { log_stream_hex_array(OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE); } while(0) /*!< \brief trace buffer content with indexes */
+#    if LOG_OAI_COMPILED_LEVEL >= 7
+#      define OAILOG_DEBUG(pRoTo, ...)                                  OAILOG_LOG(OAILOG_LEVEL_DEBUG,     pRoTo, ##__VA_ARGS__) /*!< \brief debug informations */
+#      if LOG_OAI_COMPILED_LEVEL >= 8
+#        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   OAILOG_LOG(lOgLeVeL,               pRoTo, ##__VA_ARGS__)
+#        define OAILOG_TRACE(pRoTo, ...)                                OAILOG_LOG(OAILOG_LEVEL_TRACE,     pRoTo, ##__VA_ARGS__) /*!< \brief most detailled informations, struct dumps */
+#        define OAILOG_FUNC_IN(pRoTo)                                   do { if (OAILOG_IS_ENABLED(OAILOG_LEVEL_TRACE, pRoTo)) log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
+#        define OAILOG_FUNC_OUT(pRoTo)                                  do { if (OAILOG_IS_ENABLED(OAILOG_LEVEL_TRACE, pRoTo)) log_func(false, pRoTo, __FILE__, __LINE__, __FUNCTION__); return;} while(0) /*!< \brief informational */
+#        define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                   do { if (OAILOG_IS_ENABLED(OAILOG_LEVEL_TRACE, pRoTo)) log_func_return(pRoTo, __FILE__, __LINE__, __FUNCTION__, (long)rEtUrNcOdE); return rEtUrNcOdE;} while(0) /*!< \brief informational */
+#        define OAILOG_STREAM_HEX_ARRAY(pRoTo, mEsSaGe, sTrEaM, sIzE)       do { if (OAILOG_IS_ENABLED(OAILOG_LEVEL_TRACE, pRoTo)) log_stream_hex_array(OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE); } while(0) /*!< \brief trace buffer content with indexes */
 #      endif
 #    endif
 #    include "shared_ts_log.h"
 #  else
 #    define OAILOG_SPEC(...)
 #    define OAILOG_SET_CONFIG(a)
+#    define OAILOG_SET_LEVEL(a,b)
+#    define OAILOG_TOGGLE_LEVELS()
+#    define OAILOG_IS_ENABLED(...)                                      (0)
 #    define OAILOG_LEVEL_STR2INT(a)                                     OAILOG_LEVEL_EMERGENCY
 #    define OAILOG_LEVEL_INT2STR(a)                                     "EMERGENCY"
 #    define OAILOG_INIT(a,b,c)                                          0
@@ -0,0 +1,648 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+/*! \file log_ring.c
+  \brief Binary per-thread log rings, see log_ring.h.
+         The format string is parsed twice: by the logging thread to know
+         which arguments to copy, by the consumer to format them again one
+         conversion at a time.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "log_ring.h"
+
+//-------------------------------
+#define LOG_RING_MAX_CONVERSION_LENGTH          32
+#define LOG_RING_FLAG_PADDING                   0x1
+#define LOG_RING_ALIGN(sIzE)                    (((sIzE) + 7) & ~((size_t)7))
+//-------------------------------
+
+typedef enum {
+  LOG_RING_ARG_NONE = 0,   /* %% */
+  LOG_RING_ARG_INT,
+  LOG_RING_ARG_LONG,
+  LOG_RING_ARG_LLONG,
+  LOG_RING_ARG_INTMAX,
+  LOG_RING_ARG_SIZE,
+  LOG_RING_ARG_PTRDIFF,
+  LOG_RING_ARG_DOUBLE,
+  LOG_RING_ARG_LDOUBLE,
+  LOG_RING_ARG_POINTER,
+  LOG_RING_ARG_STRING,
+  LOG_RING_ARG_UNSUPPORTED /* %n, %m, positional or wide arguments */
+} log_ring_arg_t;
+
+typedef struct log_ring_conversion_s {
+  const char                             *start;
+  size_t                                  length;
+  log_ring_arg_t                          arg;
+  bool                                    star_width;
+  bool                                    star_precision;
+  int                                     precision;   /* written in the format, -1 if none or star_precision */
+} log_ring_conversion_t;
+
+typedef struct log_ring_s {
+  volatile uint64_t                       head;        /* written by the logging thread only */
+  volatile uint64_t                       dropped;     /* written by the logging thread only */
+  volatile uint64_t                       tail __attribute__ ((aligned (64))); /* written by the consumer only */
+  uint64_t                                reported_dropped;
+  pthread_t                               tid;
+  volatile int                            in_use;
+  struct log_ring_s                      *next;
+  uint8_t                                *buffer;
+  uint8_t                                 scratch[LOG_RING_MAX_MESSAGE_SIZE] __attribute__ ((aligned (8)));
+} log_ring_t;
+
+/* Rings are never freed, the ring of a thread that exited is reused by a new thread once drained */
+static log_ring_t * volatile            log_rings = NULL;
+static __thread log_ring_t             *log_ring_self = NULL;
+static pthread_key_t                    log_ring_key;
+static pthread_once_t                   log_ring_key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t                  log_ring_flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+static void log_ring_thread_exit (void *ringP)
+{
+  log_ring_t                             *ring = (log_ring_t *) ringP;
+
+  __atomic_store_n (&ring->in_use, 0, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+static void log_ring_key_create (void)
+{
+  AssertFatal (pthread_key_create (&log_ring_key, log_ring_thread_exit) == 0, "Cannot create the log ring key!\n");
+}
+
+//------------------------------------------------------------------------------
+static log_ring_t *log_ring_register (void)
+{
+  log_ring_t                             *ring = NULL;
+
+  pthread_once (&log_ring_key_once, log_ring_key_create);
+
+  for (ring = __atomic_load_n (&log_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+    if ((!__atomic_load_n (&ring->in_use, __ATOMIC_ACQUIRE))
+        && (__atomic_load_n (&ring->head, __ATOMIC_RELAXED) == __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE))
+        && (__sync_bool_compare_and_swap (&ring->in_use, 0, 1))) {
+      break;
+    }
+  }
+
+  if (!ring) {
+    ring = calloc (1, sizeof (log_ring_t));
+    AssertFatal (ring != NULL, "Cannot allocate a log ring!\n");
+    ring->buffer = malloc (LOG_RING_SIZE);
+    AssertFatal (ring->buffer != NULL, "Cannot allocate a log ring of %d bytes!\n", LOG_RING_SIZE);
+    ring->in_use = 1;
+    do {
+      ring->next = log_rings;
+    } while (!__sync_bool_compare_and_swap (&log_rings, ring->next, ring));
+  }
+
+  ring->tid = pthread_self ();
+  pthread_setspecific (log_ring_key, ring);
+  log_ring_self = ring;
+  return ring;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Return the next conversion of the format string in conversionP, or NULL if there is none.
+*/
+static const char *log_ring_parse (const char *formatP, log_ring_conversion_t * const conversionP)
+{
+  const char                             *p = NULL;
+  bool                                    is_digits = false;
+  int                                     length_modifier = 0;
+
+  if (!(formatP = strchr (formatP, '%'))) {
+    return NULL;
+  }
+
+  memset (conversionP, 0, sizeof (*conversionP));
+  conversionP->start = formatP;
+  conversionP->arg = LOG_RING_ARG_UNSUPPORTED;
+  conversionP->precision = -1;
+  p = formatP + 1;
+
+  while ((*p) && (strchr ("-+ #0'I", *p))) {
+    p++;
+  }
+  if ('*' == *p) {
+    conversionP->star_width = true;
+    p++;
+  } else {
+    while ((*p >= '0') && (*p <= '9')) {
+      is_digits = true;
+      p++;
+    }
+  }
+  if ((is_digits) && ('$' == *p)) {
+    conversionP->length = p + 1 - formatP;
+    return formatP;
+  }
+  if ('.' == *p) {
+    p++;
+    if ('*' == *p) {
+      conversionP->star_precision = true;
+      p++;
+    } else {
+      conversionP->precision = 0;
+      while ((*p >= '0') && (*p <= '9')) {
+        if (conversionP->precision < (INT32_MAX / 10) - 1) {
+          conversionP->precision = (conversionP->precision * 10) + (*p - '0');
+        }
+        p++;
+      }
+    }
+  }
+
+  /*
+   * Length modifier, 'H' for hh, 'Q' for ll
+   */
+  switch (*p) {
+  case 'h':
+    length_modifier = ('h' == p[1]) ? 'H' : 'h';
+    break;
+  case 'l':
+    length_modifier = ('l' == p[1]) ? 'Q' : 'l';
+    break;
+  case 'q':
+    length_modifier = 'Q';
+    break;
+  case 'L': case 'j': case 'z': case 'Z': case 't':
+    length_modifier = *p;
+    break;
+  default:
+    break;
+  }
+  if (length_modifier) {
+    p += (('H' == length_modifier) || (('Q' == length_modifier) && ('q' != *p))) ? 2 : 1;
+  }
+
+  switch (*p) {
+  case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+    if (('c' == *p) && (length_modifier)) {
+      break;
+    }
+    switch (length_modifier) {
+    case 'l':            conversionP->arg = LOG_RING_ARG_LONG;    break;
+    case 'Q':            conversionP->arg = LOG_RING_ARG_LLONG;   break;
+    case 'j':            conversionP->arg = LOG_RING_ARG_INTMAX;  break;
+    case 'z': case 'Z':  conversionP->arg = LOG_RING_ARG_SIZE;    break;
+    case 't':            conversionP->arg = LOG_RING_ARG_PTRDIFF; break;
+    case 'L':                                                     break;
+    default:             conversionP->arg = LOG_RING_ARG_INT;     break;
+    }
+    break;
+
+  case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+    conversionP->arg = ('L' == length_modifier) ? LOG_RING_ARG_LDOUBLE : LOG_RING_ARG_DOUBLE;
+    break;
+
+  case 'p':
+    conversionP->arg = LOG_RING_ARG_POINTER;
+    break;
+
+  case 's':
+    if (!length_modifier) {
+      conversionP->arg = LOG_RING_ARG_STRING;
+    }
+    break;
+
+  case '%':
+    conversionP->arg = LOG_RING_ARG_NONE;
+    break;
+
+  default:
+    break;
+  }
+
+  conversionP->length = (*p) ? (size_t)(p + 1 - formatP) : (size_t)(p - formatP);
+  if (conversionP->length > LOG_RING_MAX_CONVERSION_LENGTH) {
+    conversionP->arg = LOG_RING_ARG_UNSUPPORTED;
+  }
+  return formatP;
+}
+
+//------------------------------------------------------------------------------
+static inline bool log_ring_put (uint8_t * const scratchP, size_t * const offsetP, const void * const valueP, const size_t sizeP)
+{
+  if ((*offsetP + LOG_RING_ALIGN (sizeP)) > LOG_RING_MAX_MESSAGE_SIZE) {
+    return false;
+  }
+  memcpy (&scratchP[*offsetP], valueP, sizeP);
+  *offsetP += LOG_RING_ALIGN (sizeP);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Copy the lengthP first characters of strP, then a terminating NUL: with a precision strP may not be NUL terminated.
+*/
+static inline bool log_ring_put_string (uint8_t * const scratchP, size_t * const offsetP, const char * const strP, const uint32_t lengthP)
+{
+  if ((*offsetP + LOG_RING_ALIGN ((size_t)lengthP + 1)) > LOG_RING_MAX_MESSAGE_SIZE) {
+    return false;
+  }
+  memcpy (&scratchP[*offsetP], strP, lengthP);
+  scratchP[*offsetP + lengthP] = '\0';
+  *offsetP += LOG_RING_ALIGN ((size_t)lengthP + 1);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Copy the arguments of the format string, strings included, after the header in the scratch buffer of the ring.
+   Returns the size of the message, 0 if it cannot be carried by the ring.
+*/
+static size_t log_ring_encode (log_ring_t * const ringP, const char * const formatP, va_list args)
+{
+  log_ring_conversion_t                   conversion;
+  const char                             *p = formatP;
+  size_t                                  offset = LOG_RING_ALIGN (sizeof (log_ring_header_t));
+  int64_t                                 i64 = 0;
+  double                                  d = 0;
+  long double                             ld = 0;
+  void                                   *ptr = NULL;
+  const char                             *str = NULL;
+  uint32_t                                length = 0;
+  int64_t                                 precision = -1;
+  bool                                    ok = true;
+
+  while ((ok) && ((p = log_ring_parse (p, &conversion)))) {
+    p += conversion.length;
+    precision = conversion.precision;
+    if (conversion.star_width) {
+      i64 = va_arg (args, int);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+    }
+    if ((ok) && (conversion.star_precision)) {
+      precision = va_arg (args, int);
+      ok = log_ring_put (ringP->scratch, &offset, &precision, sizeof (precision));
+    }
+    if (!ok) {
+      break;
+    }
+
+    switch (conversion.arg) {
+    case LOG_RING_ARG_NONE:
+      break;
+    case LOG_RING_ARG_INT:
+      i64 = va_arg (args, int);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+      break;
+    case LOG_RING_ARG_LONG:
+      i64 = va_arg (args, long);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+      break;
+    case LOG_RING_ARG_LLONG:
+      i64 = va_arg (args, long long);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+      break;
+    case LOG_RING_ARG_INTMAX:
+      i64 = va_arg (args, intmax_t);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+      break;
+    case LOG_RING_ARG_SIZE:
+      i64 = va_arg (args, size_t);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+      break;
+    case LOG_RING_ARG_PTRDIFF:
+      i64 = va_arg (args, ptrdiff_t);
+      ok = log_ring_put (ringP->scratch, &offset, &i64, sizeof (i64));
+      break;
+    case LOG_RING_ARG_DOUBLE:
+      d = va_arg (args, double);
+      ok = log_ring_put (ringP->scratch, &offset, &d, sizeof (d));
+      break;
+    case LOG_RING_ARG_LDOUBLE:
+      ld = va_arg (args, long double);
+      ok = log_ring_put (ringP->scratch, &offset, &ld, sizeof (ld));
+      break;
+    case LOG_RING_ARG_POINTER:
+      ptr = va_arg (args, void *);
+      ok = log_ring_put (ringP->scratch, &offset, &ptr, sizeof (ptr));
+      break;
+    case LOG_RING_ARG_STRING:
+      str = va_arg (args, const char *);
+      /*
+       * As printf, no more than precision characters are read (%.*s of bstrings and PDUs), a negative precision is none
+       */
+      if (!str) {
+        length = UINT32_MAX;
+      } else if ((precision >= 0) && (precision < LOG_RING_MAX_MESSAGE_SIZE)) {
+        length = strnlen (str, precision);
+      } else {
+        length = strnlen (str, LOG_RING_MAX_MESSAGE_SIZE);
+      }
+      ok = log_ring_put (ringP->scratch, &offset, &length, sizeof (length));
+      if ((ok) && (str)) {
+        ok = log_ring_put_string (ringP->scratch, &offset, str, length);
+      }
+      break;
+    default:
+      ok = false;
+      break;
+    }
+  }
+  return (ok) ? offset : 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Format the message in the scratch buffer of the ring, as the string argument of a "%s" format, for the formats
+   and arguments log_ring_encode() cannot copy (%m, %n, positional arguments, too long strings). The text is
+   truncated to the size of a message in the ring. Returns the size of the message.
+*/
+static size_t log_ring_encode_text (log_ring_t * const ringP, const char * const formatP, va_list args)
+{
+  size_t                                  offset = LOG_RING_ALIGN (sizeof (log_ring_header_t));
+  size_t                                  text_offset = offset + LOG_RING_ALIGN (sizeof (uint32_t));
+  size_t                                  max_length = LOG_RING_MAX_MESSAGE_SIZE - text_offset - 1;
+  char                                   *text = (char *)&ringP->scratch[text_offset];
+  uint32_t                                length = 0;
+  int                                     rv = 0;
+
+  rv = vsnprintf (text, max_length + 1, formatP, args);
+  if (rv < 0) {
+    text[0] = '\0';
+  } else if ((size_t)rv > max_length) {
+    length = max_length;
+    text[length - 1] = '\n';
+  } else {
+    length = rv;
+  }
+  memcpy (&ringP->scratch[offset], &length, sizeof (length));
+  return text_offset + LOG_RING_ALIGN ((size_t)length + 1);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Called by the logging thread.
+*/
+log_ring_rc_t
+log_ring_record (
+  log_ring_header_t * const headerP,
+  const char * const formatP,
+  va_list args)
+{
+  log_ring_t                             *ring = log_ring_self;
+  uint64_t                                head = 0;
+  uint64_t                                tail = 0;
+  size_t                                  size = 0;
+  size_t                                  contiguous = 0;
+  log_ring_header_t                      *padding = NULL;
+  va_list                                 text_args;
+
+  if (!ring) {
+    ring = log_ring_register ();
+  }
+
+  /*
+   * Messages the ring cannot carry are formatted here rather than output by the logging thread: they stay in order
+   * with the other messages of the thread and TASK_LOG still does the output
+   */
+  va_copy (text_args, args);
+  if ((size = log_ring_encode (ring, formatP, args))) {
+    headerP->format = formatP;
+  } else {
+    size = log_ring_encode_text (ring, formatP, text_args);
+    headerP->format = "%s";
+  }
+  va_end (text_args);
+  headerP->size = size;
+  headerP->flags = 0;
+  headerP->tid = ring->tid;
+  memcpy (ring->scratch, headerP, sizeof (log_ring_header_t));
+
+  head = ring->head;
+  tail = __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE);
+  contiguous = LOG_RING_SIZE - (head & (LOG_RING_SIZE - 1));
+  if ((LOG_RING_SIZE - (head - tail)) < (size + ((contiguous < size) ? contiguous : 0))) {
+    __atomic_store_n (&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+    return LOG_RING_DROPPED;
+  }
+
+  if (contiguous < size) {
+    /*
+     * A message is never split, skip the end of the buffer
+     */
+    padding = (log_ring_header_t *) &ring->buffer[head & (LOG_RING_SIZE - 1)];
+    padding->size = contiguous;
+    padding->flags = LOG_RING_FLAG_PADDING;
+    head += contiguous;
+  }
+  memcpy (&ring->buffer[head & (LOG_RING_SIZE - 1)], ring->scratch, size);
+  __atomic_store_n (&ring->head, head + size, __ATOMIC_RELEASE);
+  return LOG_RING_RECORDED;
+}
+
+//------------------------------------------------------------------------------
+static inline const uint8_t *log_ring_get (const uint8_t * const valueP, void * const dataP, const size_t sizeP)
+{
+  memcpy (dataP, valueP, sizeP);
+  return valueP + LOG_RING_ALIGN (sizeP);
+}
+
+#define LOG_RING_FORMAT(bStR, cOnV, sPeC, wIdTh, pReCiSiOn, vAlUe) \
+  do { \
+    if ((cOnV)->star_width && (cOnV)->star_precision) { \
+      bformata ((bStR), (sPeC), (wIdTh), (pReCiSiOn), (vAlUe)); \
+    } else if ((cOnV)->star_width) { \
+      bformata ((bStR), (sPeC), (wIdTh), (vAlUe)); \
+    } else if ((cOnV)->star_precision) { \
+      bformata ((bStR), (sPeC), (pReCiSiOn), (vAlUe)); \
+    } else { \
+      bformata ((bStR), (sPeC), (vAlUe)); \
+    } \
+  } while (0)
+
+//------------------------------------------------------------------------------
+/*
+   Format the message the logging thread recorded, conversion by conversion.
+*/
+static void log_ring_decode (const log_ring_header_t * const headerP, bstring bstr)
+{
+  log_ring_conversion_t                   conversion;
+  const char                             *p = headerP->format;
+  const char                             *conversion_start = NULL;
+  const uint8_t                          *value = (const uint8_t *)headerP + LOG_RING_ALIGN (sizeof (log_ring_header_t));
+  char                                    spec[LOG_RING_MAX_CONVERSION_LENGTH + 1];
+  int64_t                                 width = 0;
+  int64_t                                 precision = 0;
+  int64_t                                 i64 = 0;
+  double                                  d = 0;
+  long double                             ld = 0;
+  void                                   *ptr = NULL;
+  uint32_t                                length = 0;
+
+  btrunc (bstr, 0);
+  while ((conversion_start = log_ring_parse (p, &conversion))) {
+    bcatblk (bstr, p, conversion_start - p);
+    p = conversion_start + conversion.length;
+    memcpy (spec, conversion.start, conversion.length);
+    spec[conversion.length] = '\0';
+    if (conversion.star_width) {
+      value = log_ring_get (value, &width, sizeof (width));
+    }
+    if (conversion.star_precision) {
+      value = log_ring_get (value, &precision, sizeof (precision));
+    }
+
+    switch (conversion.arg) {
+    case LOG_RING_ARG_NONE:
+      bconchar (bstr, '%');
+      break;
+    case LOG_RING_ARG_INT:
+      value = log_ring_get (value, &i64, sizeof (i64));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (int)i64);
+      break;
+    case LOG_RING_ARG_LONG:
+      value = log_ring_get (value, &i64, sizeof (i64));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (long)i64);
+      break;
+    case LOG_RING_ARG_LLONG:
+      value = log_ring_get (value, &i64, sizeof (i64));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (long long)i64);
+      break;
+    case LOG_RING_ARG_INTMAX:
+      value = log_ring_get (value, &i64, sizeof (i64));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (intmax_t)i64);
+      break;
+    case LOG_RING_ARG_SIZE:
+      value = log_ring_get (value, &i64, sizeof (i64));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (size_t)i64);
+      break;
+    case LOG_RING_ARG_PTRDIFF:
+      value = log_ring_get (value, &i64, sizeof (i64));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (ptrdiff_t)i64);
+      break;
+    case LOG_RING_ARG_DOUBLE:
+      value = log_ring_get (value, &d, sizeof (d));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, d);
+      break;
+    case LOG_RING_ARG_LDOUBLE:
+      value = log_ring_get (value, &ld, sizeof (ld));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, ld);
+      break;
+    case LOG_RING_ARG_POINTER:
+      value = log_ring_get (value, &ptr, sizeof (ptr));
+      LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, ptr);
+      break;
+    case LOG_RING_ARG_STRING:
+      value = log_ring_get (value, &length, sizeof (length));
+      if (UINT32_MAX == length) {
+        LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, "(null)");
+      } else {
+        LOG_RING_FORMAT (bstr, &conversion, spec, (int)width, (int)precision, (const char *)value);
+        value += LOG_RING_ALIGN (length + 1);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  bcatcstr (bstr, p);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Called with log_ring_flush_mutex held.
+*/
+static int log_ring_drain (
+  log_ring_t * const ringP,
+  void (*output_cb) (const log_ring_header_t * const, const_bstring),
+  void (*dropped_cb) (const pthread_t, const uint64_t),
+  bstring scratch)
+{
+  log_ring_header_t                      *header = NULL;
+  uint64_t                                head = 0;
+  uint64_t                                tail = 0;
+  uint64_t                                dropped = 0;
+  int                                     count = 0;
+
+  tail = ringP->tail;
+  head = __atomic_load_n (&ringP->head, __ATOMIC_ACQUIRE);
+  while (tail != head) {
+    header = (log_ring_header_t *) &ringP->buffer[tail & (LOG_RING_SIZE - 1)];
+    if (!(header->flags & LOG_RING_FLAG_PADDING)) {
+      log_ring_decode (header, scratch);
+      output_cb (header, scratch);
+      count++;
+    }
+    tail += header->size;
+    __atomic_store_n (&ringP->tail, tail, __ATOMIC_RELEASE);
+  }
+
+  dropped = __atomic_load_n (&ringP->dropped, __ATOMIC_RELAXED);
+  if (dropped != ringP->reported_dropped) {
+    if (dropped_cb) {
+      dropped_cb (ringP->tid, dropped - ringP->reported_dropped);
+    }
+    ringP->reported_dropped = dropped;
+  }
+  return count;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Format the messages of all rings with output_cb, report the messages dropped since the last call with dropped_cb.
+   Returns the number of messages formatted.
+*/
+int
+log_ring_flush (
+  void (*output_cb) (const log_ring_header_t * const, const_bstring),
+  void (*dropped_cb) (const pthread_t, const uint64_t),
+  bstring scratch)
+{
+  log_ring_t                             *ring = NULL;
+  int                                     count = 0;
+
+  pthread_mutex_lock (&log_ring_flush_mutex);
+  for (ring = __atomic_load_n (&log_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+    count += log_ring_drain (ring, output_cb, dropped_cb, scratch);
+  }
+  pthread_mutex_unlock (&log_ring_flush_mutex);
+  return count;
+}
+
+//------------------------------------------------------------------------------
+uint64_t log_ring_dropped (void)
+{
+  log_ring_t                             *ring = NULL;
+  uint64_t                                dropped = 0;
+
+  for (ring = __atomic_load_n (&log_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+    dropped += __atomic_load_n (&ring->dropped, __ATOMIC_RELAXED);
+  }
+  return dropped;
+}
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file log_ring.h
+  \brief Binary per-thread log rings.
+         A thread logging a message only copies its header, the address of
+         its format string and its raw arguments into a ring of its own,
+         strings arguments are copied. The messages are formatted later by
+         the single consumer calling log_ring_flush(), TASK_LOG. A format
+         or arguments the ring cannot copy (%m, too long strings, ...) are
+         formatted by the logging thread and recorded as text.
+         Each ring has one producer and one consumer and takes no lock, a
+         message that does not fit in a full ring is dropped and counted.
+*/
+
+#ifndef FILE_LOG_RING_SEEN
+#define FILE_LOG_RING_SEEN
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "bstrlib.h"
+
+/* Bytes of the ring of each logging thread, a power of 2 */
+#define LOG_RING_SIZE                        (256 * 1024)
+/* Bytes of one message in a ring, header and arguments included */
+#define LOG_RING_MAX_MESSAGE_SIZE            (2048)
+
+typedef enum {
+  LOG_RING_RECORDED = 0,
+  LOG_RING_DROPPED,        /*!< \brief the ring of the thread is full */
+} log_ring_rc_t;
+
+/*! \struct  log_ring_header_t
+* \brief Fixed part of a message in a ring, filled by the logging thread.
+*/
+typedef struct log_ring_header_s {
+  uint32_t                                size;        /*!< \brief set by the ring */
+  uint32_t                                flags;       /*!< \brief set by the ring */
+  uint64_t                                number;
+  struct timeval                          elapsed_time;
+  pthread_t                               tid;
+  const char                             *source_file; /*!< \brief must be a string literal */
+  const char                             *format;      /*!< \brief must be a string literal */
+  unsigned int                            line;
+  int                                     indent;
+  int                                     log_level;
+  int                                     protocol;
+} log_ring_header_t;
+
+log_ring_rc_t   log_ring_record (log_ring_header_t * const header, const char * const format, va_list args);
+int             log_ring_flush (void (*output_cb) (const log_ring_header_t * const, const_bstring),
+                                void (*dropped_cb) (const pthread_t, const uint64_t),
+                                bstring scratch);
+uint64_t        log_ring_dropped (void);
+
+#endif /* FILE_LOG_RING_SEEN */
@@ -63,6 +63,29 @@
 #define SCTP_OUT_STREAMS      (32)
 #define SCTP_IN_STREAMS       (32)
 #define SCTP_MAX_ATTEMPTS     (5)
+#define SCTP_LISTEN_BACKLOG   (128)
+#define SCTP_RECEIVER_THREADS (1)    ///< Default number of epoll receiver threads per listening socket
+#define SCTP_MAX_EPOLL_EVENTS (64)   ///< Events handled per epoll_wait() by a receiver thread
+#define SCTP_ASSOC_HASHTABLE_SIZE (1024) ///< Initial size of the association tables, they grow with the number of eNBs
+/* Bytes of a PDU received in place in its SCTP_DATA_IND message, bigger PDUs are copied.
+   With the default size the message fits the built-in 1000 bytes ITTI memory pool. */
+#define SCTP_DATA_IND_BUFFER_SIZE     (896)
+#define SCTP_DATA_IND_BUFFER_SIZE_MIN (512)
+#define SCTP_DATA_IND_BUFFER_SIZE_MAX (32768)
+/* Per association send queues, rings of PDUs doubled when full up to the maximum */
+#define SCTP_SEND_QUEUE_INITIAL_SIZE  (16)
+#define SCTP_SEND_QUEUE_MAX_SIZE      (4096)
+#define SCTP_SEND_BATCH_SIZE          (32)   ///< PDUs sent per sendmmsg()
+
+/*******************************************************************************
+ * UDP Constants
+ ******************************************************************************/
+
+#define UDP_RECV_BATCH_SIZE           (32)   ///< Datagrams received per recvmmsg(), each one in its own UDP_DATA_IND
+#define UDP_SEND_BATCH_SIZE           (32)   ///< Datagrams sent per sendmmsg()
+/* SO_REUSEPORT sockets bound to each local port, each one read by its own thread.
+   With 1 the socket is read by TASK_UDP. */
+#define UDP_RECEIVER_THREADS          (1)
 
 /*******************************************************************************
  * MME global definitions
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file udp_buffer.c
+  \brief Pool of the reference counted datagram buffers, see udp_buffer.h
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "udp_buffer.h"
+
+/* Buffers are taken and returned by TASK_UDP and its receiver threads, TASK_S11 and TASK_S10 */
+static pthread_mutex_t                  udp_buffer_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static udp_buffer_t                    *udp_buffer_pool = NULL;
+static uint32_t                         udp_buffer_pool_size = 0;
+
+//------------------------------------------------------------------------------
+udp_buffer_t *
+udp_buffer_alloc (
+  void)
+{
+  udp_buffer_t                           *buffer = NULL;
+
+  pthread_mutex_lock (&udp_buffer_pool_mutex);
+  if ((buffer = udp_buffer_pool)) {
+    udp_buffer_pool = buffer->next;
+    udp_buffer_pool_size--;
+  }
+  pthread_mutex_unlock (&udp_buffer_pool_mutex);
+
+  if ((buffer == NULL) && ((buffer = malloc (sizeof (udp_buffer_t))) == NULL)) {
+    return NULL;
+  }
+  buffer->refs = 1;
+  buffer->next = NULL;
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+void
+udp_buffer_unref (
+  udp_buffer_t ** const buffer)
+{
+  udp_buffer_t                           *last = *buffer;
+
+  *buffer = NULL;
+  if ((last == NULL) || (__sync_sub_and_fetch (&last->refs, 1) != 0)) {
+    return;
+  }
+
+  pthread_mutex_lock (&udp_buffer_pool_mutex);
+  if (udp_buffer_pool_size < UDP_BUFFER_POOL_MAX_SIZE) {
+    last->next = udp_buffer_pool;
+    udp_buffer_pool = last;
+    udp_buffer_pool_size++;
+    last = NULL;
+  }
+  pthread_mutex_unlock (&udp_buffer_pool_mutex);
+  free (last);
+}
@@ -0,0 +1,71 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file udp_buffer.h
+  \brief Reference counted datagram buffers shared by TASK_UDP, TASK_S11,
+         TASK_S10 and their nwgtpv2c stacks.
+         TASK_UDP receives a datagram in a buffer and hands its reference
+         over in UDP_DATA_IND, the stack parses the message in place.
+         A message encoded by the stack lives in a buffer, a reference is
+         handed over to TASK_UDP in UDP_DATA_REQ and released once sent.
+         Every owner holds a reference, the last one returns the buffer to
+         a pool shared by all the threads.
+*/
+
+#ifndef FILE_UDP_BUFFER_SEEN
+#define FILE_UDP_BUFFER_SEEN
+
+#include <stdint.h>
+
+/* Biggest datagram, a GTPv2-C message including its header */
+#define UDP_BUFFER_SIZE                  (4096)
+/* Free buffers kept in the pool, the next ones are freed */
+#define UDP_BUFFER_POOL_MAX_SIZE         (4096)
+
+typedef struct udp_buffer_s {
+  volatile uint32_t                       refs;
+  struct udp_buffer_s                    *next;      /*!< \brief in the pool */
+  uint8_t                                 data[UDP_BUFFER_SIZE];
+} udp_buffer_t;
+
+/*! \fn udp_buffer_t *udp_buffer_alloc(void)
+ * \brief Get a buffer from the pool, the caller holds its only reference.
+ * \return NULL if out of memory
+ */
+udp_buffer_t *udp_buffer_alloc (void);
+
+/*! \fn udp_buffer_t *udp_buffer_ref(udp_buffer_t *buffer)
+ * \brief Take one more reference on buffer, for another owner.
+ * \return buffer
+ */
+static inline udp_buffer_t *udp_buffer_ref (udp_buffer_t * const buffer)
+{
+  __sync_fetch_and_add (&buffer->refs, 1);
+  return buffer;
+}
+
+/*! \fn void udp_buffer_unref(udp_buffer_t **buffer)
+ * \brief Release the reference of the caller, *buffer is set to NULL.
+ *        The last reference returns the buffer to the pool.
+ */
+void udp_buffer_unref (udp_buffer_t ** const buffer);
+
+#endif /* FILE_UDP_BUFFER_SEEN */